@@ -0,0 +1,230 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <cstring>
+
+#include "arduinodecoder.h"
+
+
+/*!
+ * \brief ArduinoDecoder::ArduinoDecoder Incremental decoder of the Arduino frames
+ *
+ * An Arduino frame is: startMarker, length (of the whole encoded frame),
+ * command, data..., endMarker. Data bytes greater or equal to specialByte
+ * are sent as specialByte followed by (byte - specialByte).
+ * The received bytes are written into a fixed ring buffer and decoded
+ * one at a time by a state machine into a fixed frame buffer: nothing is
+ * allocated nor moved. A frame with a wrong length, an unexpected marker
+ * or a bad escape sequence is dropped and the decoder resynchronizes
+ * on the next startMarker.
+ * The decoded frame has the same layout returned by the old
+ * decodeResponse(): size, command, data... where size is the
+ * decoded size (i.e. length-2 when nothing was escaped).
+ */
+ArduinoDecoder::ArduinoDecoder() {
+    reset();
+}
+
+
+/*!
+ * \brief ArduinoDecoder::reset Discard all the received data
+ */
+void
+ArduinoDecoder::reset() {
+    head           = 0;
+    tail           = 0;
+    state          = waitStart;
+    nFrameBytes    = 0;
+    nWireBytes     = 0;
+    expectedLength = 0;
+    nFrames        = 0;
+    nResyncs       = 0;
+}
+
+
+/*!
+ * \brief ArduinoDecoder::writePointer Where to write the new serial data
+ * \param pFree [out] The contiguous free space
+ * \return A pointer inside the ring buffer
+ *
+ * To read the port straight into the ring buffer.
+ * Call commitWrite() with the number of bytes written.
+ */
+char*
+ArduinoDecoder::writePointer(int *pFree) {
+    quint32 iWrite = head & (DECODER_RING_SIZE-1);
+    quint32 nFree  = DECODER_RING_SIZE - (head-tail);
+    *pFree = int(qMin(nFree, quint32(DECODER_RING_SIZE)-iWrite));
+    return reinterpret_cast<char*>(&ring[iWrite]);
+}
+
+
+/*!
+ * \brief ArduinoDecoder::commitWrite
+ * \param nBytes The bytes written at writePointer()
+ */
+void
+ArduinoDecoder::commitWrite(int nBytes) {
+    head += quint32(nBytes);
+}
+
+
+/*!
+ * \brief ArduinoDecoder::feed Copy the data into the ring buffer
+ * \param data The serial data
+ * \param nBytes Their number
+ * \return The bytes accepted (limited by the free space)
+ */
+int
+ArduinoDecoder::feed(const char *data, int nBytes) {
+    int nWritten = 0;
+    while(nWritten < nBytes) {
+        int nFree;
+        char* pWrite = writePointer(&nFree);
+        if(nFree == 0)
+            break;
+        int nChunk = qMin(nFree, nBytes-nWritten);
+        memcpy(pWrite, data+nWritten, size_t(nChunk));
+        commitWrite(nChunk);
+        nWritten += nChunk;
+    }
+    return nWritten;
+}
+
+
+/*!
+ * \brief ArduinoDecoder::nextFrame Decode the data received up to the next frame
+ * \return true if a new frame is available in frame()
+ */
+bool
+ArduinoDecoder::nextFrame() {
+    while(tail != head) {
+        quint8 byte = ring[tail & (DECODER_RING_SIZE-1)];
+        tail++;
+        switch(state) {
+        case waitStart:
+            if(byte == startMarker) {
+                nWireBytes = 1;
+                state = waitLength;
+            }
+            break;
+        case waitLength:
+            if(byte == startMarker)
+                break;// Repeated start: keep waiting for the length
+            if((byte < 4) || (byte > MAX_FRAME_SIZE)) {
+                resync();
+                break;
+            }
+            expectedLength = byte;
+            nWireBytes     = 2;
+            nFrameBytes    = 1;// frameBuffer[0] is the decoded size
+            state = inFrame;
+            break;
+        case inFrame:
+            nWireBytes++;
+            if(byte == startMarker) {// A new frame started here
+                resync();
+                nWireBytes = 1;
+                state = waitLength;
+            }
+            else if(byte == endMarker) {
+                if(nWireBytes != expectedLength) {
+                    resync();
+                    break;
+                }
+                frameBuffer[0] = quint8(nFrameBytes);
+                state = waitStart;
+                nFrames++;
+                return true;
+            }
+            else if(nWireBytes >= expectedLength)
+                resync();// The end marker is missing
+            else if(byte == specialByte)
+                state = inEscape;
+            else
+                frameBuffer[nFrameBytes++] = byte;
+            break;
+        case inEscape:
+            nWireBytes++;
+            if(byte == startMarker) {
+                resync();
+                nWireBytes = 1;
+                state = waitLength;
+            }
+            else if((byte > (0xFF-specialByte)) || (nWireBytes >= expectedLength))
+                resync();
+            else {
+                frameBuffer[nFrameBytes++] = quint8(specialByte+byte);
+                state = inFrame;
+            }
+            break;
+        }
+    }
+    return false;
+}
+
+
+/*!
+ * \brief ArduinoDecoder::resync Drop the current frame and look for the next one
+ */
+void
+ArduinoDecoder::resync() {
+    nResyncs++;
+    nFrameBytes = 0;
+    state = waitStart;
+}
+
+
+/*!
+ * \brief ArduinoDecoder::frame
+ * \return The last decoded frame (valid until the next call to nextFrame())
+ */
+const quint8*
+ArduinoDecoder::frame() const {
+    return frameBuffer;
+}
+
+
+/*!
+ * \brief ArduinoDecoder::frameSize
+ * \return The size of the last decoded frame
+ */
+int
+ArduinoDecoder::frameSize() const {
+    return nFrameBytes;
+}
+
+
+/*!
+ * \brief ArduinoDecoder::frames
+ * \return The number of frames decoded since the last reset()
+ */
+quint64
+ArduinoDecoder::frames() const {
+    return nFrames;
+}
+
+
+/*!
+ * \brief ArduinoDecoder::resyncs
+ * \return How many times the decoder lost the synchronization
+ */
+quint64
+ArduinoDecoder::resyncs() const {
+    return nResyncs;
+}
@@ -0,0 +1,70 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef ARDUINODECODER_H
+#define ARDUINODECODER_H
+
+#include <QtGlobal>
+
+
+#define DECODER_RING_SIZE 512 // Must be a power of 2
+#define MAX_FRAME_SIZE    64  // Max (encoded) length of an Arduino frame
+
+
+class ArduinoDecoder
+{
+public:
+    ArduinoDecoder();
+    void          reset();
+    char*         writePointer(int *pFree);
+    void          commitWrite(int nBytes);
+    int           feed(const char *data, int nBytes);
+    bool          nextFrame();
+    const quint8* frame() const;
+    int           frameSize() const;
+    quint64       frames() const;
+    quint64       resyncs() const;
+
+private:
+    void          resync();
+
+private:
+    enum decoderState {
+        waitStart,
+        waitLength,
+        inFrame,
+        inEscape
+    };
+
+    static const quint8 startMarker = 0xFF;
+    static const quint8 endMarker   = 0xFE;
+    static const quint8 specialByte = 0xFD;
+
+    quint8        ring[DECODER_RING_SIZE];
+    quint32       head;// Next byte to write (free running)
+    quint32       tail;// Next byte to decode (free running)
+    decoderState  state;
+    quint8        frameBuffer[MAX_FRAME_SIZE];
+    int           nFrameBytes;
+    int           nWireBytes;
+    int           expectedLength;
+    quint64       nFrames;
+    quint64       nResyncs;
+};
+
+#endif // ARDUINODECODER_H
@@ -0,0 +1,319 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QSettings>
+
+#include "arduinoprober.h"
+#include "utility.h"
+
+
+static const char startMarker = char(0xFF);
+static const char endMarker   = char(0xFE);
+
+
+/*!
+ * \brief ArduinoProber::ArduinoProber Look for the Arduino among the serial ports
+ * \param myLogFile The File for message logging (if any)
+ * \param parent The parent object
+ *
+ * All the candidate ports are opened at once and asked AreYouThere
+ * once the Arduino bootloader is over. The first port giving the right
+ * answer wins and is handed over (still open) with the arduinoFound()
+ * signal. The winner USB Vendor and Product Ids are remembered so that,
+ * at the next start, the ports with the same Ids are probed first.
+ * Only those (or the port just plugged in) are asked repeatedly: the
+ * other serial devices get a single question.
+ */
+ArduinoProber::ArduinoProber(QFile *myLogFile, QObject *parent)
+    : QObject(parent)
+    , logFile(myLogFile)
+    , bRepeatAsk(false)
+{
+    askTimer.setSingleShot(true);
+    connect(&askTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToAsk()));
+    replyTimer.setSingleShot(true);
+    connect(&replyTimer, SIGNAL(timeout()),
+            this, SLOT(onReplyTimeout()));
+}
+
+
+/*!
+ * \brief ArduinoProber::~ArduinoProber
+ */
+ArduinoProber::~ArduinoProber() {
+    closeProbes();
+}
+
+
+/*!
+ * \brief ArduinoProber::startProbing Start looking for the Arduino
+ * \param sPortName The only port to probe (if not empty)
+ * \param bJustPlugged true if sPortName has just been plugged in
+ *
+ * It returns immediately: the result is signalled asynchronously.
+ * A port name (or path) is needed for the ports that are not
+ * enumerated by QSerialPortInfo, like the pseudo terminal of the
+ * Arduino simulator (tools/arduinosim).
+ */
+void
+ArduinoProber::startProbing(QString sPortName, bool bJustPlugged) {
+    otherPorts.clear();
+    if(!sPortName.isEmpty()) {
+        QSerialPort* pPort = new QSerialPort(this);
+        pPort->setPortName(sPortName);
+        QSerialPortInfo portInfo(sPortName);
+        if(!probePort(pPort)) {
+            LOG_ERROR(LOG_SERIAL,
+                      logFile,
+                      QString("Error: No Arduino ready to use !"));
+            emit arduinoNotFound();
+            return;
+        }
+        if(!portInfo.isNull())
+            probeInfo.insert(pPort, portInfo);
+        startAsking(true, bJustPlugged);
+        return;
+    }
+
+    QList<QSerialPortInfo> candidates;
+    const QList<QSerialPortInfo> availablePorts = QSerialPortInfo::availablePorts();
+    for(const QSerialPortInfo& portInfo : availablePorts) {
+        if(portInfo.portName().contains("tty"))
+            candidates.append(portInfo);
+    }
+    if(candidates.isEmpty()) {
+        LOG_INFO(LOG_SERIAL,
+                 logFile,
+                 QString("No serial port available"));
+        emit arduinoNotFound();
+        return;
+    }
+
+    // Ports with the Ids of the last Arduino found are tried first
+    QSettings settings("Gabriele Salvato", "Score Panel");
+    quint16 vendorId  = quint16(settings.value("arduino/vendorId", 0).toUInt());
+    quint16 productId = quint16(settings.value("arduino/productId", 0).toUInt());
+    QList<QSerialPortInfo> preferred;
+    for(const QSerialPortInfo& portInfo : candidates) {
+        if(portInfo.hasVendorIdentifier() && portInfo.hasProductIdentifier() &&
+           (portInfo.vendorIdentifier() == vendorId) &&
+           (portInfo.productIdentifier() == productId))
+            preferred.append(portInfo);
+        else
+            otherPorts.append(portInfo);
+    }
+    if(!preferred.isEmpty() && probePorts(preferred, true))
+        return;
+    QList<QSerialPortInfo> remaining = otherPorts;
+    otherPorts.clear();
+    if(probePorts(remaining, false))
+        return;
+    LOG_ERROR(LOG_SERIAL,
+              logFile,
+              QString("Error: No Arduino ready to use !"));
+    emit arduinoNotFound();
+}
+
+
+/*!
+ * \brief ArduinoProber::probePorts Open all the given ports at once
+ * \param candidates The ports to probe
+ * \param bRepeat true to ask them repeatedly (likely Arduino ports)
+ * \return false if none of them could be opened
+ */
+bool
+ArduinoProber::probePorts(const QList<QSerialPortInfo>& candidates, bool bRepeat) {
+    for(const QSerialPortInfo& portInfo : candidates) {
+        QSerialPort* pPort = new QSerialPort(portInfo, this);
+        if(probePort(pPort))
+            probeInfo.insert(pPort, portInfo);
+    }
+    if(probes.isEmpty())
+        return false;
+    startAsking(bRepeat);
+    return true;
+}
+
+
+/*!
+ * \brief ArduinoProber::startAsking Ask the open ports for the Arduino
+ * \param bRepeat true to repeat the question until the Arduino answers
+ * \param bJustPlugged true to start asking at once (a port just plugged in)
+ *
+ * Arduino will be reset upon a serial connection: nothing is written
+ * during its bootloader window. For the likely Arduino ports the
+ * question is then repeated every ARDUINO_RETRY_TIME ms until it answers
+ * (no need to wait for the worst case reset time); the others are asked
+ * once, after the reset time.
+ * A port just plugged in is asked from the start, to resume the game
+ * clock within a second: the questions reaching the bootloader at worst
+ * make it start the sketch earlier, and its replies (if any) do not
+ * decode as Arduino frames, so they are ignored.
+ */
+void
+ArduinoProber::startAsking(bool bRepeat, bool bJustPlugged) {
+    bRepeatAsk = bRepeat;
+    if(bJustPlugged)
+        askTimer.start(ARDUINO_RETRY_TIME);
+    else
+        askTimer.start(bRepeat ? ARDUINO_BOOT_TIME : ARDUINO_RESET_TIME);
+    replyTimer.start(ARDUINO_RESET_TIME+ARDUINO_REPLY_TIME);
+}
+
+
+/*!
+ * \brief ArduinoProber::probePort Open a port to be probed
+ * \param pPort The port (deleted if it cannot be opened)
+ * \return false if the port could not be opened
+ */
+bool
+ArduinoProber::probePort(QSerialPort* pPort) {
+    pPort->setBaudRate(QSerialPort::Baud115200);
+    pPort->setDataBits(QSerialPort::Data8);
+    if(!pPort->open(QIODevice::ReadWrite)) {
+        LOG_DEBUG(LOG_SERIAL,
+                  logFile,
+                  QString("Unable to open %1 because %2")
+                  .arg(pPort->portName())
+                  .arg(pPort->errorString()));
+        delete pPort;
+        return false;
+    }
+    LOG_DEBUG(LOG_SERIAL,
+              logFile,
+              QString("Trying connection to %1")
+              .arg(pPort->portName()));
+    connect(pPort, SIGNAL(readyRead()),
+            this, SLOT(onProbeDataAvailable()));
+    probes.insert(pPort, ArduinoDecoder());
+    return true;
+}
+
+
+/*!
+ * \brief ArduinoProber::onTimeToAsk Ask all the open ports for the Arduino
+ */
+void
+ArduinoProber::onTimeToAsk() {
+    QByteArray request;
+    request.append(startMarker);
+    request.append(char(4));
+    request.append(char(AreYouThere));
+    request.append(endMarker);
+    const QList<QSerialPort*> ports = probes.keys();
+    for(QSerialPort* pPort : ports)
+        pPort->write(request);
+    if(bRepeatAsk)
+        askTimer.start(ARDUINO_RETRY_TIME);
+}
+
+
+/*!
+ * \brief ArduinoProber::onProbeDataAvailable Check the answers of the probed ports
+ *
+ * The answers are decoded (escapes included) by the same
+ * ArduinoDecoder used by the SerialLink.
+ */
+void
+ArduinoProber::onProbeDataAvailable() {
+    QSerialPort* pPort = qobject_cast<QSerialPort*>(sender());
+    if(!pPort || !probes.contains(pPort))
+        return;
+    ArduinoDecoder& decoder = probes[pPort];
+    while(pPort->bytesAvailable() > 0) {
+        int nFree;
+        char* pWrite = decoder.writePointer(&nFree);
+        qint64 nRead = pPort->read(pWrite, nFree);
+        if(nRead <= 0)
+            break;
+        decoder.commitWrite(int(nRead));
+        while(decoder.nextFrame()) {
+            // frame(): size, command, data...
+            if((decoder.frameSize() < 2) || (decoder.frame()[1] != quint8(AreYouThere)))
+                continue;
+            askTimer.stop();
+            replyTimer.stop();
+            LOG_DEBUG(LOG_SERIAL,
+                      logFile,
+                      QString("Arduino found at: %1")
+                      .arg(pPort->portName()));
+            saveWinner(pPort);
+            closeProbes(pPort);
+            pPort->disconnect(this);
+            pPort->setParent(Q_NULLPTR);
+            emit arduinoFound(pPort);
+            return;
+        }
+    }
+}
+
+
+/*!
+ * \brief ArduinoProber::onReplyTimeout No Arduino answered in the due time
+ */
+void
+ArduinoProber::onReplyTimeout() {
+    askTimer.stop();
+    closeProbes();
+    // The preferred ports did not answer: try all the others
+    if(!otherPorts.isEmpty()) {
+        QList<QSerialPortInfo> remaining = otherPorts;
+        otherPorts.clear();
+        if(probePorts(remaining, false))
+            return;
+    }
+    LOG_ERROR(LOG_SERIAL,
+              logFile,
+              QString("Error: No Arduino ready to use !"));
+    emit arduinoNotFound();
+}
+
+
+/*!
+ * \brief ArduinoProber::closeProbes Close the probed ports
+ * \param pKeep The port to leave open (if any)
+ */
+void
+ArduinoProber::closeProbes(QSerialPort* pKeep) {
+    const QList<QSerialPort*> ports = probes.keys();
+    for(QSerialPort* pPort : ports) {
+        if(pPort == pKeep)
+            continue;
+        pPort->disconnect(this);
+        pPort->close();
+        pPort->deleteLater();
+    }
+    probes.clear();
+    probeInfo.clear();
+}
+
+
+/*!
+ * \brief ArduinoProber::saveWinner Remember the USB Ids of the Arduino found
+ * \param pPort The port that answered
+ */
+void
+ArduinoProber::saveWinner(QSerialPort* pPort) {
+    QSerialPortInfo portInfo = probeInfo.value(pPort);
+    if(!portInfo.hasVendorIdentifier() || !portInfo.hasProductIdentifier())
+        return;
+    QSettings settings("Gabriele Salvato", "Score Panel");
+    settings.setValue("arduino/vendorId",  portInfo.vendorIdentifier());
+    settings.setValue("arduino/productId", portInfo.productIdentifier());
+}
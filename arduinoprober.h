@@ -0,0 +1,75 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef ARDUINOPROBER_H
+#define ARDUINOPROBER_H
+
+#include <QObject>
+#include <QSerialPort>
+#include <QSerialPortInfo>
+#include <QTimer>
+#include <QMap>
+
+#include "arduinodecoder.h"
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+
+
+#define ARDUINO_BOOT_TIME  2000 // In msec (bootloader window after the reset: nothing is written)
+#define ARDUINO_RESET_TIME 3000 // In msec (Arduino resets when the port is opened)
+#define ARDUINO_REPLY_TIME 1000 // In msec (max time for the AreYouThere answer)
+#define ARDUINO_RETRY_TIME  250 // In msec (AreYouThere repetition while resetting)
+
+
+class ArduinoProber : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ArduinoProber(QFile *myLogFile=Q_NULLPTR, QObject *parent=Q_NULLPTR);
+    ~ArduinoProber();
+    void startProbing(QString sPortName=QString(), bool bJustPlugged=false);
+
+signals:
+    void arduinoFound(QSerialPort* pPort);/*!< Emitted with the (open) port that answered */
+    void arduinoNotFound();/*!< Emitted when no port answered */
+
+private slots:
+    void onTimeToAsk();
+    void onReplyTimeout();
+    void onProbeDataAvailable();
+
+private:
+    bool probePorts(const QList<QSerialPortInfo>& candidates, bool bRepeat);
+    bool probePort(QSerialPort* pPort);
+    void startAsking(bool bRepeat, bool bJustPlugged=false);
+    void closeProbes(QSerialPort* pKeep=Q_NULLPTR);
+    void saveWinner(QSerialPort* pPort);
+
+private:
+    QFile                          *logFile;
+    QList<QSerialPortInfo>          otherPorts;
+    QMap<QSerialPort*, ArduinoDecoder> probes;
+    QMap<QSerialPort*, QSerialPortInfo> probeInfo;
+    QTimer                          askTimer;
+    QTimer                          replyTimer;
+    bool                            bRepeatAsk;
+};
+
+#endif // ARDUINOPROBER_H
@@ -0,0 +1,745 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QFile>
+#include <QDir>
+#include <QDateTime>
+#include <QDataStream>
+#include <QDebug>
+
+#if defined(Q_OS_UNIX)
+    #include <signal.h>
+    #include <unistd.h>
+#endif
+
+#include "asynclogger.h"
+#include "logformat.h"
+
+
+#define LOG_QUEUE_MASK   (LOG_QUEUE_SIZE-1)
+#define WRITER_IDLE_TIME 250  // In msec (max delay of a message on the file)
+#define CRASH_SPIN_COUNT 1000 // Attempts to get the queue on a crash
+#define CRASH_BUFFER_SIZE 4096 // Bytes written at a time on a crash
+
+
+QMutex AsyncLogger::formatMutex;
+QVector<AsyncLogger::logFormat> AsyncLogger::formats;
+
+#if defined(Q_OS_UNIX)
+// Prepared before any crash: the signal handler only uses these
+static const int             crashSignals[]  = { SIGSEGV, SIGABRT, SIGFPE, SIGILL, SIGBUS };
+static const int             nCrashSignals   = int(sizeof(crashSignals)/sizeof(crashSignals[0]));
+static struct sigaction      previousActions[nCrashSignals];
+static AsyncLogger*          pCrashLogger    = Q_NULLPTR;
+static QFile*                pCrashLogFile   = Q_NULLPTR;
+static volatile sig_atomic_t crashFd         = -1;
+static char                  crashBuffer[CRASH_BUFFER_SIZE];
+static int                   crashLength     = 0;
+
+
+/*!
+ * \brief crashFlush Write the crash buffer (async signal safe)
+ */
+static void
+crashFlush() {
+    int nWritten = 0;
+    while(nWritten < crashLength) {
+        ssize_t n = ::write(crashFd, crashBuffer+nWritten, size_t(crashLength-nWritten));
+        if(n <= 0)
+            break;
+        nWritten += int(n);
+    }
+    crashLength = 0;
+}
+
+
+/*!
+ * \brief crashAppend Add bytes to the crash buffer (async signal safe)
+ */
+static void
+crashAppend(const char* sText) {
+    for(; *sText; sText++) {
+        if(crashLength == CRASH_BUFFER_SIZE)
+            crashFlush();
+        crashBuffer[crashLength++] = *sText;
+    }
+}
+
+
+/*!
+ * \brief crashAppendNumber Add a decimal number to the crash buffer (async signal safe)
+ */
+static void
+crashAppendNumber(qint64 value) {
+    char sDigits[24];
+    int i = int(sizeof(sDigits))-1;
+    sDigits[i] = '\0';
+    quint64 absValue = (value < 0) ? quint64(-(value+1))+1 : quint64(value);
+    do {
+        sDigits[--i] = char('0' + absValue%10);
+        absValue /= 10;
+    } while(absValue > 0);
+    if(value < 0)
+        sDigits[--i] = '-';
+    crashAppend(&sDigits[i]);
+}
+
+
+/*!
+ * \brief crashAppendString Add a QString, UTF-8 encoded, to the crash buffer
+ *
+ * Async signal safe: it reads the string data without allocating memory.
+ */
+static void
+crashAppendString(const QString& sText) {
+    const QChar* pChar = sText.constData();
+    int nChars = sText.size();
+    for(int i=0; i<nChars; i++) {
+        uint code = pChar[i].unicode();
+        char sUtf8[5] = { 0, 0, 0, 0, 0 };
+        if(code < 0x80) {
+            sUtf8[0] = char(code);
+        }
+        else if(code < 0x800) {
+            sUtf8[0] = char(0xC0 | (code >> 6));
+            sUtf8[1] = char(0x80 | (code & 0x3F));
+        }
+        else if(pChar[i].isHighSurrogate() && (i+1 < nChars) && pChar[i+1].isLowSurrogate()) {
+            code = QChar::surrogateToUcs4(pChar[i], pChar[i+1]);
+            i++;
+            sUtf8[0] = char(0xF0 | (code >> 18));
+            sUtf8[1] = char(0x80 | ((code >> 12) & 0x3F));
+            sUtf8[2] = char(0x80 | ((code >> 6) & 0x3F));
+            sUtf8[3] = char(0x80 | (code & 0x3F));
+        }
+        else {
+            sUtf8[0] = char(0xE0 | (code >> 12));
+            sUtf8[1] = char(0x80 | ((code >> 6) & 0x3F));
+            sUtf8[2] = char(0x80 | (code & 0x3F));
+        }
+        crashAppend(sUtf8);
+    }
+}
+#endif
+
+
+/*!
+ * \brief AsyncLogger::instance The logger shared by all the threads
+ * \return The (started) logger
+ */
+AsyncLogger*
+AsyncLogger::instance() {
+    static AsyncLogger logger;
+    return &logger;
+}
+
+
+/*!
+ * \brief AsyncLogger::shutdown Write all the pending messages and stop the writer
+ *
+ * To be called before leaving main(). Messages logged later
+ * are written synchronously.
+ */
+void
+AsyncLogger::shutdown() {
+    instance()->stop();
+}
+
+
+/*!
+ * \brief AsyncLogger::registerFormat Give an id to the format of a record
+ * \param sFunctionName The Function logging the record
+ * \param sFormat The message with %1, %2... placeholders
+ * \return The message id
+ *
+ * Called once for each LOG_RECORD() call site.
+ */
+quint32
+AsyncLogger::registerFormat(const char* sFunctionName, const char* sFormat) {
+    QMutexLocker locker(&formatMutex);
+    logFormat newFormat;
+    newFormat.sFunctionName = QString(sFunctionName);
+    newFormat.sFormat       = QString(sFormat);
+    formats.append(newFormat);
+    return quint32(formats.count());// LOG_TEXT_ID is 0
+}
+
+
+/*!
+ * \brief AsyncLogger::rotateFiles Shift the older generations of a log file
+ * \param sFileName The log file name
+ * \param nGenerations The number of old generations to keep
+ *
+ * sFileName becomes sFileName.1, sFileName.1 becomes sFileName.2 and
+ * so on. The oldest generation is removed.
+ */
+void
+AsyncLogger::rotateFiles(const QString& sFileName, int nGenerations) {
+    QDir renamed;
+    if(nGenerations < 1) {
+        renamed.remove(sFileName);
+        return;
+    }
+    renamed.remove(QString("%1.%2").arg(sFileName).arg(nGenerations));
+    for(int i=nGenerations-1; i>0; i--) {
+        renamed.rename(QString("%1.%2").arg(sFileName).arg(i),
+                       QString("%1.%2").arg(sFileName).arg(i+1));
+    }
+    renamed.rename(sFileName, QString("%1.1").arg(sFileName));
+}
+
+
+/*!
+ * \brief AsyncLogger::AsyncLogger Move the log writing out of the logging threads
+ *
+ * The messages are queued in a bounded lock-free multi producer queue
+ * (so the memory used is fixed) and written in batches, with a single
+ * flush, by a low priority thread. When the queue is full the messages
+ * are dropped and counted: the count is written in the log as soon as
+ * there is room again.
+ * On a crash the pending messages can be written before dying
+ * (see installCrashHandler()).
+ */
+AsyncLogger::AsyncLogger()
+    : QThread(Q_NULLPTR)
+    , enqueuePos(0)
+    , dequeuePos(0)
+    , nDropped(0)
+    , nDroppedTotal(0)
+    , bWriterIdle(0)
+    , bStopRequested(0)
+    , drainLock(0)
+    , bBinary(false)
+    , maxFileSize(LOG_MAX_SIZE)
+    , nGenerations(LOG_GENERATIONS)
+{
+    entries = new logEntry[LOG_QUEUE_SIZE];
+    for(quint32 i=0; i<LOG_QUEUE_SIZE; i++) {
+        entries[i].sequence.storeRelease(i);
+        entries[i].logFile   = Q_NULLPTR;
+        entries[i].msecTime  = 0;
+        entries[i].subsystem = -1;
+        entries[i].messageId = LOG_TEXT_ID;
+    }
+    start(QThread::LowPriority);
+}
+
+
+/*!
+ * \brief AsyncLogger::~AsyncLogger
+ */
+AsyncLogger::~AsyncLogger() {
+    stop();
+    delete[] entries;
+}
+
+
+/*!
+ * \brief AsyncLogger::enqueue Queue a message for the writer
+ * \param logFile The file where to write the log (Q_NULLPTR means stdout)
+ * \param sFunctionName The Function which requested to write the message
+ * \param sMessage The informative message
+ * \return false if the queue was full and the message has been dropped
+ *
+ * It never blocks: it can be called from any thread.
+ */
+bool
+AsyncLogger::enqueue(QFile *logFile, const QString& sFunctionName, const QString& sMessage) {
+    return push(logFile, -1, LOG_TEXT_ID, sFunctionName, sMessage, QStringList());
+}
+
+
+/*!
+ * \brief AsyncLogger::enqueueRecord Queue a record for the writer
+ * \param logFile The file where to write the log (Q_NULLPTR means stdout)
+ * \param subsystem The subsystem logging the record
+ * \param messageId The record format (from registerFormat())
+ * \param args The record arguments
+ * \return false if the queue was full and the record has been dropped
+ *
+ * The message text is built by the writer thread, only if the
+ * log is not in the binary format.
+ */
+bool
+AsyncLogger::enqueueRecord(QFile *logFile, int subsystem, quint32 messageId, const QStringList& args) {
+    return push(logFile, subsystem, messageId, QString(), QString(), args);
+}
+
+
+/*!
+ * \brief AsyncLogger::setBinary Select the log file format
+ * \param bBinaryFormat true for the compact binary format (see logformat.h)
+ *
+ * The messages for stdout are always written as text.
+ */
+void
+AsyncLogger::setBinary(bool bBinaryFormat) {
+    lockQueue();
+    bBinary = bBinaryFormat;
+    unlockQueue();
+}
+
+
+/*!
+ * \brief AsyncLogger::setRotation Cap the size of the log files
+ * \param maxSize The size (in bytes) above which a file is rotated (0 means no limit)
+ * \param generations The number of rotated files to keep
+ */
+void
+AsyncLogger::setRotation(qint64 maxSize, int generations) {
+    lockQueue();
+    maxFileSize  = maxSize;
+    nGenerations = generations;
+    unlockQueue();
+}
+
+
+/*!
+ * \brief AsyncLogger::push Put an entry in the queue
+ * \return false if the queue was full
+ */
+bool
+AsyncLogger::push(QFile *logFile, int subsystem, quint32 messageId,
+                  const QString& sFunctionName, const QString& sMessage, const QStringList& args)
+{
+    logEntry* pEntry;
+    quint32 pos = enqueuePos.loadAcquire();
+    for(;;) {
+        pEntry = &entries[pos & LOG_QUEUE_MASK];
+        qint32 diff = qint32(pEntry->sequence.loadAcquire() - pos);
+        if(diff == 0) {
+            if(enqueuePos.testAndSetRelaxed(pos, pos+1))
+                break;
+            pos = enqueuePos.loadAcquire();
+        }
+        else if(diff < 0) {// Queue full
+            nDropped.fetchAndAddRelaxed(1);
+            nDroppedTotal.fetchAndAddRelaxed(1);
+            return false;
+        }
+        else
+            pos = enqueuePos.loadAcquire();
+    }
+    pEntry->logFile       = logFile;
+    pEntry->msecTime      = QDateTime::currentMSecsSinceEpoch();
+    pEntry->sFunctionName = sFunctionName;
+    pEntry->sMessage      = sMessage;
+    pEntry->subsystem     = subsystem;
+    pEntry->messageId     = messageId;
+    pEntry->args          = args;
+    pEntry->sequence.storeRelease(pos+1);
+
+    if(bStopRequested.loadAcquire())
+        drain();
+    // Wake the writer only when a batch is ready: the others
+    // messages will be written when the writer wakes by itself.
+    // The writer checks the queue under the same mutex before
+    // waiting, so that the wake up can not be lost.
+    else if((pos+1) % LOG_BATCH_SIZE == 0) {
+        idleMutex.lock();
+        if(bWriterIdle.loadAcquire())
+            wakeWriter.wakeOne();
+        idleMutex.unlock();
+    }
+    return true;
+}
+
+
+/*!
+ * \brief AsyncLogger::flush Write now all the queued messages
+ */
+void
+AsyncLogger::flush() {
+    drain();
+}
+
+
+/*!
+ * \brief AsyncLogger::droppedMessages
+ * \return The number of messages dropped since the start
+ */
+quint32
+AsyncLogger::droppedMessages() {
+    return nDroppedTotal.loadAcquire();
+}
+
+
+/*!
+ * \brief AsyncLogger::run The writer loop
+ */
+void
+AsyncLogger::run() {
+    while(!bStopRequested.loadAcquire()) {
+        drain();
+        idleMutex.lock();
+        bWriterIdle.storeRelease(1);
+        if(!bStopRequested.loadAcquire() && !isBatchReady())
+            wakeWriter.wait(&idleMutex, WRITER_IDLE_TIME);
+        bWriterIdle.storeRelease(0);
+        idleMutex.unlock();
+    }
+    drain();
+}
+
+
+/*!
+ * \brief AsyncLogger::isBatchReady
+ * \return true if a batch of messages is waiting to be written
+ */
+bool
+AsyncLogger::isBatchReady() {
+    return enqueuePos.loadAcquire()-dequeuePos >= LOG_BATCH_SIZE;
+}
+
+
+/*!
+ * \brief AsyncLogger::stop Stop the writer after it wrote the pending messages
+ */
+void
+AsyncLogger::stop() {
+    if(!isRunning())
+        return;
+    idleMutex.lock();
+    bStopRequested.storeRelease(1);
+    wakeWriter.wakeAll();
+    idleMutex.unlock();
+    wait();
+    drain();
+}
+
+
+/*!
+ * \brief AsyncLogger::lockQueue Get the exclusive use of the queue reader side
+ * \param bForce true to give up after a while (crash)
+ * \return true if the lock has been taken
+ */
+bool
+AsyncLogger::lockQueue(bool bForce) {
+    int nSpin = 0;
+    while(!drainLock.testAndSetAcquire(0, 1)) {
+        if(bForce && ++nSpin > CRASH_SPIN_COUNT)
+            return false;
+        QThread::yieldCurrentThread();
+    }
+    return true;
+}
+
+
+/*!
+ * \brief AsyncLogger::unlockQueue
+ */
+void
+AsyncLogger::unlockQueue() {
+    drainLock.storeRelease(0);
+}
+
+
+/*!
+ * \brief AsyncLogger::drain Write all the messages in the queue
+ * \param bForce true to go on even if the queue can not be locked (crash)
+ *
+ * Consecutive messages for the same file are written with a single
+ * write() and a single flush(). A file growing above the size cap
+ * is rotated.
+ */
+void
+AsyncLogger::drain(bool bForce) {
+    bool bLocked = lockQueue(bForce);
+
+    QFile* pBatchFile = Q_NULLPTR;
+    qint64 batchFileSize = 0;// The bytes already written in pBatchFile
+    QByteArray baBatch;
+    for(;;) {
+        logEntry* pEntry = &entries[dequeuePos & LOG_QUEUE_MASK];
+        qint32 diff = qint32(pEntry->sequence.loadAcquire() - (dequeuePos+1));
+        if(diff < 0)// Queue empty (or the next message not yet complete)
+            break;
+        if(pEntry->logFile != pBatchFile) {
+            writeBatch(pBatchFile, baBatch);
+            baBatch.clear();
+            pBatchFile = pEntry->logFile;
+            batchFileSize = (pBatchFile && pBatchFile->isOpen()) ? pBatchFile->size() : 0;
+        }
+        if(isBinary(pBatchFile)) {
+            if(pEntry->messageId == LOG_TEXT_ID)
+                appendRecord(baBatch, pBatchFile, pEntry->msecTime, pEntry->subsystem, LOG_TEXT_ID,
+                             QStringList() << pEntry->sFunctionName << pEntry->sMessage);
+            else
+                appendRecord(baBatch, pBatchFile, pEntry->msecTime, pEntry->subsystem,
+                             pEntry->messageId, pEntry->args);
+        }
+        else {
+            if(pEntry->messageId == LOG_TEXT_ID)
+                appendText(baBatch, pEntry->msecTime, pEntry->sFunctionName, pEntry->sMessage);
+            else {
+                formatMutex.lock();
+                logFormat format = formats.at(int(pEntry->messageId)-1);
+                formatMutex.unlock();
+                appendText(baBatch, pEntry->msecTime, format.sFunctionName,
+                           formatLogMessage(format.sFormat, pEntry->args));
+            }
+        }
+        // Release the strings now: the queue memory stays bounded
+        pEntry->sFunctionName = QString();
+        pEntry->sMessage      = QString();
+        pEntry->args.clear();
+        pEntry->sequence.storeRelease(dequeuePos+LOG_QUEUE_SIZE);
+        dequeuePos++;
+        if((maxFileSize > 0) && pBatchFile && pBatchFile->isOpen() &&
+           (batchFileSize+baBatch.size() > maxFileSize))
+        {
+            writeBatch(pBatchFile, baBatch);
+            baBatch.clear();
+            rotate(pBatchFile);
+            batchFileSize = pBatchFile->isOpen() ? pBatchFile->size() : 0;
+        }
+    }
+    quint32 nLost = nDropped.fetchAndStoreRelaxed(0);
+    if(nLost > 0) {
+        QString sMessage = QString("%1 messages dropped (queue full)").arg(nLost);
+        if(isBinary(pBatchFile))
+            appendRecord(baBatch, pBatchFile, QDateTime::currentMSecsSinceEpoch(), -1, LOG_TEXT_ID,
+                         QStringList() << QString(Q_FUNC_INFO) << sMessage);
+        else
+            appendText(baBatch, QDateTime::currentMSecsSinceEpoch(), QString(Q_FUNC_INFO), sMessage);
+    }
+    writeBatch(pBatchFile, baBatch);
+
+    if(bLocked)
+        unlockQueue();
+}
+
+
+/*!
+ * \brief AsyncLogger::isBinary
+ * \param logFile The log file
+ * \return true if the messages for logFile have to be written in binary format
+ */
+bool
+AsyncLogger::isBinary(QFile *logFile) {
+    return bBinary && logFile && logFile->isOpen();
+}
+
+
+/*!
+ * \brief AsyncLogger::appendText Add a text line to a batch
+ */
+void
+AsyncLogger::appendText(QByteArray& baBatch, qint64 msecTime,
+                        const QString& sFunctionName, const QString& sMessage)
+{
+    QString sDebugMessage = QDateTime::fromMSecsSinceEpoch(msecTime).toString() +
+                            QString(" - ") +
+                            sFunctionName +
+                            QString(" - ") +
+                            sMessage;
+    baBatch.append(sDebugMessage.toUtf8());
+    baBatch.append('\n');
+}
+
+
+/*!
+ * \brief AsyncLogger::appendRecord Add a binary record to a batch
+ *
+ * The record format is written before its first use in each file.
+ */
+void
+AsyncLogger::appendRecord(QByteArray& baBatch, QFile *logFile, qint64 msecTime,
+                          int subsystem, quint32 messageId, const QStringList& args)
+{
+    QDataStream out(&baBatch, QIODevice::WriteOnly | QIODevice::Append);
+    out.setByteOrder(QDataStream::LittleEndian);
+    if((messageId != LOG_TEXT_ID) && !definedFormats[logFile].contains(messageId)) {
+        formatMutex.lock();
+        logFormat format = formats.at(int(messageId)-1);
+        formatMutex.unlock();
+        out << LOG_RECORD_FORMAT
+            << messageId
+            << format.sFunctionName.toUtf8()
+            << format.sFormat.toUtf8();
+        definedFormats[logFile].insert(messageId);
+    }
+    out << LOG_RECORD_MESSAGE
+        << msecTime
+        << quint8(subsystem < 0 ? LOG_NO_SUBSYSTEM : quint8(subsystem))
+        << messageId
+        << quint8(qMin(args.count(), 255));
+    for(int i=0; i<qMin(args.count(), 255); i++)
+        out << args.at(i).toUtf8();
+}
+
+
+/*!
+ * \brief AsyncLogger::writeBatch Write a batch of messages
+ * \param logFile The file where to write the log (Q_NULLPTR means stdout)
+ * \param baBatch The newline terminated messages (or the binary records)
+ */
+void
+AsyncLogger::writeBatch(QFile *logFile, const QByteArray& baBatch) {
+    if(baBatch.isEmpty())
+        return;
+    if(logFile && logFile->isOpen()) {
+        if(bBinary && (logFile->size() == 0))
+            logFile->write(LOG_BINARY_MAGIC, qstrlen(LOG_BINARY_MAGIC));
+        logFile->write(baBatch);
+        logFile->flush();
+    }
+    else {
+        for(const QByteArray& baLine : baBatch.split('\n')) {
+            if(!baLine.isEmpty())
+                qDebug() << QString::fromUtf8(baLine);
+        }
+    }
+}
+
+
+/*!
+ * \brief AsyncLogger::rotate Start a new generation of a log file
+ * \param logFile The log file (it remains open)
+ */
+void
+AsyncLogger::rotate(QFile *logFile) {
+    QString sFileName = logFile->fileName();
+    logFile->close();
+    rotateFiles(sFileName, nGenerations);
+    logFile->open(QIODevice::WriteOnly);
+    definedFormats.remove(logFile);
+#if defined(Q_OS_UNIX)
+    if(logFile == pCrashLogFile)
+        setCrashFile(logFile);
+#endif
+}
+
+
+/*!
+ * \brief AsyncLogger::installCrashHandler Write the pending messages on a crash
+ * \param logFile The log file (Q_NULLPTR to write them on stderr)
+ *
+ * To be called once, after the log file has been opened.
+ * On SIGSEGV, SIGABRT, SIGFPE, SIGILL and SIGBUS the messages still in
+ * the queue are written to the log file, then the previous handlers
+ * are restored and the signal raised again.
+ */
+void
+AsyncLogger::installCrashHandler(QFile *logFile) {
+#if defined(Q_OS_UNIX)
+    if(pCrashLogger)
+        return;// The previous handlers must not be our own
+    pCrashLogger = instance();
+    setCrashFile(logFile);
+    struct sigaction action;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags   = 0;
+    action.sa_handler = AsyncLogger::onCrash;
+    for(int i=0; i<nCrashSignals; i++)
+        sigaction(crashSignals[i], &action, &previousActions[i]);
+#else
+    Q_UNUSED(logFile)
+#endif
+}
+
+
+/*!
+ * \brief AsyncLogger::setCrashFile Prepare the file descriptor written on a crash
+ * \param logFile The log file (Q_NULLPTR or binary log means stderr)
+ *
+ * The descriptor is a duplicate, so that it stays valid whatever
+ * happens to the QFile. It is prepared again after each rotation.
+ */
+void
+AsyncLogger::setCrashFile(QFile *logFile) {
+#if defined(Q_OS_UNIX)
+    pCrashLogFile = logFile;
+    // The text lines would corrupt a binary log
+    bool bText = logFile && logFile->isOpen() && !pCrashLogger->bBinary;
+    int newFd = ::dup(bText ? logFile->handle() : STDERR_FILENO);
+    int oldFd = crashFd;
+    crashFd = newFd;
+    if(oldFd >= 0)
+        ::close(oldFd);
+#else
+    Q_UNUSED(logFile)
+#endif
+}
+
+
+/*!
+ * \brief AsyncLogger::dumpPending Write the messages still in the queue (on a crash)
+ *
+ * Async signal safe: the messages are neither formatted nor released,
+ * their text is just copied into the crash buffer.
+ */
+void
+AsyncLogger::dumpPending() {
+#if defined(Q_OS_UNIX)
+    for(quint32 pos=dequeuePos; pos!=dequeuePos+LOG_QUEUE_SIZE; pos++) {
+        logEntry* pEntry = &entries[pos & LOG_QUEUE_MASK];
+        if(qint32(pEntry->sequence.loadAcquire() - (pos+1)) < 0)
+            break;
+        crashAppendNumber(pEntry->msecTime);
+        crashAppend(" - ");
+        if(pEntry->messageId == LOG_TEXT_ID) {
+            crashAppendString(pEntry->sFunctionName);
+            crashAppend(" - ");
+            crashAppendString(pEntry->sMessage);
+        }
+        else {
+            crashAppend("Record ");
+            crashAppendNumber(pEntry->messageId);
+            for(int i=0; i<pEntry->args.count(); i++) {
+                crashAppend(i == 0 ? " - " : ", ");
+                crashAppendString(pEntry->args.at(i));
+            }
+        }
+        crashAppend("\n");
+    }
+#endif
+}
+
+
+/*!
+ * \brief AsyncLogger::onCrash Write the pending messages and die
+ * \param signalNumber The fatal signal received
+ *
+ * Only async signal safe calls: the messages are copied into a static
+ * buffer and written with write(2) on the descriptor prepared by
+ * setCrashFile(). If the queue can not be taken (i.e. the crash happened
+ * while writing the log) the pending messages are given up.
+ */
+void
+AsyncLogger::onCrash(int signalNumber) {
+#if defined(Q_OS_UNIX)
+    crashLength = 0;
+    crashAppend("*** Fatal signal ");
+    crashAppendNumber(signalNumber);
+    crashAppend(": the messages not yet written follow\n");
+    // The queue is never unlocked: the writer must not release the messages
+    if(pCrashLogger && pCrashLogger->lockQueue(true))
+        pCrashLogger->dumpPending();
+    else
+        crashAppend("*** Log queue busy: the pending messages are lost\n");
+    crashFlush();
+    for(int i=0; i<nCrashSignals; i++) {
+        if(crashSignals[i] == signalNumber)
+            sigaction(signalNumber, &previousActions[i], Q_NULLPTR);
+    }
+    raise(signalNumber);
+#else
+    Q_UNUSED(signalNumber)
+#endif
+}
@@ -0,0 +1,121 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef ASYNCLOGGER_H
+#define ASYNCLOGGER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInteger>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+
+
+#define LOG_QUEUE_SIZE  4096 // Messages (must be a power of two)
+#define LOG_BATCH_SIZE  64   // Messages queued before waking the writer
+#define LOG_MAX_SIZE    (4*1024*1024) // Bytes of a log file before rotating it
+#define LOG_GENERATIONS 5    // Rotated log files kept
+
+
+class AsyncLogger : public QThread
+{
+    Q_OBJECT
+
+public:
+    static AsyncLogger* instance();
+    static void shutdown();
+    static quint32 registerFormat(const char* sFunctionName, const char* sFormat);
+    static void rotateFiles(const QString& sFileName, int nGenerations);
+    static void installCrashHandler(QFile *logFile);
+    bool enqueue(QFile *logFile, const QString& sFunctionName, const QString& sMessage);
+    bool enqueueRecord(QFile *logFile, int subsystem, quint32 messageId, const QStringList& args);
+    void setBinary(bool bBinaryFormat);
+    void setRotation(qint64 maxSize, int generations);
+    void flush();
+    quint32 droppedMessages();
+
+protected:
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    AsyncLogger();
+    ~AsyncLogger();
+    void stop();
+    bool push(QFile *logFile, int subsystem, quint32 messageId,
+              const QString& sFunctionName, const QString& sMessage, const QStringList& args);
+    bool lockQueue(bool bForce=false);
+    void unlockQueue();
+    void drain(bool bForce=false);
+    bool isBatchReady();
+    void dumpPending();
+    bool isBinary(QFile *logFile);
+    void appendText(QByteArray& baBatch, qint64 msecTime, const QString& sFunctionName, const QString& sMessage);
+    void appendRecord(QByteArray& baBatch, QFile *logFile, qint64 msecTime,
+                      int subsystem, quint32 messageId, const QStringList& args);
+    void writeBatch(QFile *logFile, const QByteArray& baBatch);
+    void rotate(QFile *logFile);
+    static void setCrashFile(QFile *logFile);
+    static void onCrash(int signalNumber);
+
+private:
+    /*!
+     * \brief A slot of the message queue
+     */
+    struct logEntry {
+        QAtomicInteger<quint32> sequence;     /*!< \brief the slot turn (Vyukov bounded queue) */
+        QFile                  *logFile;      /*!< \brief where the message goes */
+        qint64                  msecTime;     /*!< \brief when the message was logged */
+        QString                 sFunctionName;/*!< \brief who logged the message */
+        QString                 sMessage;     /*!< \brief the message */
+        qint32                  subsystem;    /*!< \brief LOG_DISCOVERY ... LOG_PANEL or -1 */
+        quint32                 messageId;    /*!< \brief the format of a record (LOG_TEXT_ID for a message) */
+        QStringList             args;         /*!< \brief the arguments of a record */
+    };
+    /*!
+     * \brief A registered record format
+     */
+    struct logFormat {
+        QString sFunctionName;/*!< \brief who logs the record */
+        QString sFormat;      /*!< \brief the message with %1, %2... placeholders */
+    };
+    logEntry                *entries;
+    QAtomicInteger<quint32>  enqueuePos;
+    quint32                  dequeuePos;
+    QAtomicInteger<quint32>  nDropped;
+    QAtomicInteger<quint32>  nDroppedTotal;
+    QAtomicInt               bWriterIdle;
+    QAtomicInt               bStopRequested;
+    QAtomicInt               drainLock;
+    QMutex                   idleMutex;
+    QWaitCondition           wakeWriter;
+    bool                     bBinary;
+    qint64                   maxFileSize;
+    int                      nGenerations;
+    QHash<QFile*, QSet<quint32> > definedFormats;
+    static QMutex            formatMutex;
+    static QVector<logFormat> formats;
+};
+
+#endif // ASYNCLOGGER_H
@@ -0,0 +1,209 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QSerialPortInfo>
+#include <QSocketNotifier>
+#include <QFile>
+
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+    // The kernel uevents tell us when a device is plugged or unplugged
+    #include <sys/socket.h>
+    #include <linux/netlink.h>
+    #include <unistd.h>
+    #include <errno.h>
+    #include <string.h>
+#endif
+
+#include "devicemonitor.h"
+#include "utility.h"
+
+
+#define DEVICE_POLL_TIME 2000 // In msec
+
+
+/*!
+ * \brief DeviceMonitor::DeviceMonitor Watch the serial devices being plugged and unplugged
+ * \param myLogFile The File for message logging (if any)
+ * \param parent The parent object
+ *
+ * On Linux it listens to the kernel uevents (the same udev gets) for the
+ * tty subsystem: nothing is done until a device is added or removed.
+ * Elsewhere, or if the uevent socket can't be opened, it falls back
+ * to periodically comparing the list of the available serial ports.
+ */
+DeviceMonitor::DeviceMonitor(QFile *myLogFile, QObject *parent)
+    : QObject(parent)
+    , logFile(myLogFile)
+    , ueventSocket(-1)
+    , pUeventNotifier(Q_NULLPTR)
+{
+    connect(&pollTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToPoll()));
+}
+
+
+/*!
+ * \brief DeviceMonitor::~DeviceMonitor
+ */
+DeviceMonitor::~DeviceMonitor() {
+    pollTimer.stop();
+    if(pUeventNotifier) {
+        pUeventNotifier->setEnabled(false);
+        delete pUeventNotifier;
+        pUeventNotifier = Q_NULLPTR;
+    }
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+    if(ueventSocket >= 0)
+        ::close(ueventSocket);
+#endif
+    ueventSocket = -1;
+}
+
+
+/*!
+ * \brief DeviceMonitor::start Start monitoring the serial devices
+ */
+void
+DeviceMonitor::start() {
+    if(openUeventSocket())
+        return;
+    LOG_INFO(LOG_SERIAL,
+             logFile,
+             QString("Polling the serial ports every %1 ms")
+             .arg(DEVICE_POLL_TIME));
+    knownPorts = serialPortNames();
+    pollTimer.start(DEVICE_POLL_TIME);
+}
+
+
+/*!
+ * \brief DeviceMonitor::openUeventSocket Subscribe to the kernel uevents
+ * \return true if the subscription succeeded
+ */
+bool
+DeviceMonitor::openUeventSocket() {
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+    ueventSocket = ::socket(AF_NETLINK, SOCK_RAW|SOCK_NONBLOCK|SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if(ueventSocket < 0) {
+        LOG_ERROR(LOG_SERIAL,
+                  logFile,
+                  QString("Unable to open the uevent socket: %1")
+                  .arg(strerror(errno)));
+        return false;
+    }
+    struct sockaddr_nl address;
+    memset(&address, 0, sizeof(address));
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = 1;// The kernel events group
+    if(::bind(ueventSocket, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) < 0) {
+        LOG_ERROR(LOG_SERIAL,
+                  logFile,
+                  QString("Unable to bind the uevent socket: %1")
+                  .arg(strerror(errno)));
+        ::close(ueventSocket);
+        ueventSocket = -1;
+        return false;
+    }
+    pUeventNotifier = new QSocketNotifier(ueventSocket, QSocketNotifier::Read, this);
+    connect(pUeventNotifier, SIGNAL(activated(int)),
+            this, SLOT(onUeventActivated()));
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+/*!
+ * \brief DeviceMonitor::onUeventActivated Invoked asynchronously when
+ * the kernel sent some device events
+ *
+ * Each event is "ACTION@DEVPATH" followed by KEY=VALUE strings,
+ * all '\0' terminated. Only the tty add and remove are of interest.
+ */
+void
+DeviceMonitor::onUeventActivated() {
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+    char buffer[4096];
+    for(;;) {
+        ssize_t received = ::recv(ueventSocket, buffer, sizeof(buffer)-1, MSG_DONTWAIT);
+        if(received <= 0)
+            break;
+        buffer[received] = '\0';
+        QByteArray baAction, baSubsystem, baDevName;
+        for(ssize_t i=0; i<received; i+=ssize_t(strlen(buffer+i))+1) {
+            const char* pField = buffer+i;
+            if(strncmp(pField, "ACTION=", 7) == 0)
+                baAction = QByteArray(pField+7);
+            else if(strncmp(pField, "SUBSYSTEM=", 10) == 0)
+                baSubsystem = QByteArray(pField+10);
+            else if(strncmp(pField, "DEVNAME=", 8) == 0)
+                baDevName = QByteArray(pField+8);
+        }
+        if(baSubsystem != QByteArray("tty") || baDevName.isEmpty())
+            continue;
+        // DEVNAME may be relative to /dev or a path
+        QString sPortName = QString::fromLocal8Bit(baDevName).section('/', -1);
+        if(baAction == QByteArray("add")) {
+            LOG_DEBUG(LOG_SERIAL,
+                      logFile,
+                      QString("Serial port %1 added").arg(sPortName));
+            emit serialPortAdded(sPortName);
+        }
+        else if(baAction == QByteArray("remove")) {
+            LOG_DEBUG(LOG_SERIAL,
+                      logFile,
+                      QString("Serial port %1 removed").arg(sPortName));
+            emit serialPortRemoved(sPortName);
+        }
+    }
+#endif
+}
+
+
+/*!
+ * \brief DeviceMonitor::onTimeToPoll Periodic check (when the uevents are not available)
+ */
+void
+DeviceMonitor::onTimeToPoll() {
+    const QStringList currentPorts = serialPortNames();
+    const QStringList previousPorts = knownPorts;
+    knownPorts = currentPorts;
+    for(const QString& sPortName : previousPorts) {
+        if(!currentPorts.contains(sPortName))
+            emit serialPortRemoved(sPortName);
+    }
+    for(const QString& sPortName : currentPorts) {
+        if(!previousPorts.contains(sPortName))
+            emit serialPortAdded(sPortName);
+    }
+}
+
+
+/*!
+ * \brief DeviceMonitor::serialPortNames
+ * \return The names of the available serial ports
+ */
+QStringList
+DeviceMonitor::serialPortNames() {
+    QStringList portNames;
+    const QList<QSerialPortInfo> availablePorts = QSerialPortInfo::availablePorts();
+    for(const QSerialPortInfo& portInfo : availablePorts)
+        portNames.append(portInfo.portName());
+    return portNames;
+}
@@ -0,0 +1,60 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef DEVICEMONITOR_H
+#define DEVICEMONITOR_H
+
+#include <QObject>
+#include <QTimer>
+#include <QStringList>
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+QT_FORWARD_DECLARE_CLASS(QSocketNotifier)
+
+
+class DeviceMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DeviceMonitor(QFile *myLogFile=Q_NULLPTR, QObject *parent=Q_NULLPTR);
+    ~DeviceMonitor();
+    void start();
+
+signals:
+    void serialPortAdded(QString sPortName);  /*!< \brief emitted when a tty device appears */
+    void serialPortRemoved(QString sPortName);/*!< \brief emitted when a tty device disappears */
+
+private slots:
+    void onUeventActivated();
+    void onTimeToPoll();
+
+private:
+    bool openUeventSocket();
+    QStringList serialPortNames();
+
+private:
+    QFile           *logFile;
+    int              ueventSocket;
+    QSocketNotifier *pUeventNotifier;
+    QTimer           pollTimer;
+    QStringList      knownPorts;
+};
+
+#endif // DEVICEMONITOR_H
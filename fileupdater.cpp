@@ -22,8 +22,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QTimer>
 
 #include "utility.h"
+#include "statssampler.h"
+#include "mediastore.h"
 
 #define CHUNK_SIZE 512*1024
+#define MEDIA_LOCK_WAIT 300000 // In msec (max wait for a file another Panel is downloading)
+#define MEDIA_LOCK_POLL    500 // In msec (check interval of a file another Panel is downloading)
 
 
 /*!
@@ -45,6 +49,13 @@ FileUpdater::FileUpdater(QString sName, QUrl myServerUrl, QFile *myLogFile, QObj
 {
     sMyName = sName;
     pUpdateSocket = Q_NULLPTR;
+    pMediaStore = Q_NULLPTR;
+    lockWaited = 0;
+    // A child: it moves with the FileUpdater to its thread
+    pLockPollTimer = new QTimer(this);
+    pLockPollTimer->setSingleShot(true);
+    connect(pLockPollTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToPollLock()));
     destinationDir = QString(".");
     bytesReceived = 0;
 }
@@ -64,15 +75,15 @@ FileUpdater::setDestination(QString myDstinationDir, QString sExtensions) {
     sFileExtensions = sExtensions;
     QDir outDir(destinationDir);
     if(!outDir.exists()) {
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Creating new directory: %1")
-                   .arg(destinationDir));
+        LOG_INFO(LOG_UPDATER,
+                 logFile,
+                 QString("Creating new directory: %1")
+                 .arg(destinationDir));
         if(!outDir.mkdir(destinationDir)) {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Unable to create directory: %1")
-                       .arg(destinationDir));
+            LOG_ERROR(LOG_UPDATER,
+                      logFile,
+                      QString("Unable to create directory: %1")
+                      .arg(destinationDir));
             return false;
         }
     }
@@ -80,19 +91,42 @@ FileUpdater::setDestination(QString myDstinationDir, QString sExtensions) {
 }
 
 
+/*!
+ * \brief FileUpdater::setMediaStore Share the files with the other Panels of the host
+ * \param sStoreDir The media store folder (empty for private files only)
+ *
+ * Must be called before moving the FileUpdater to its thread.
+ */
+void
+FileUpdater::setMediaStore(QString sStoreDir) {
+    delete pMediaStore;
+    pMediaStore = Q_NULLPTR;
+    if(sStoreDir.isEmpty())
+        return;
+    pMediaStore = new MediaStore(sStoreDir, logFile, this);
+    if(!pMediaStore->isValid()) {
+        LOG_ERROR(LOG_UPDATER,
+                  logFile,
+                  sMyName +
+                  QString(" Media store %1 not usable: files will not be shared")
+                  .arg(sStoreDir));
+        delete pMediaStore;
+        pMediaStore = Q_NULLPTR;
+    }
+}
+
+
 /*!
  * \brief FileUpdater::startUpdate
  * Try to connect asynchronously to the File Server
  */
 void
 FileUpdater::startUpdate() {
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               sMyName +
-               QString(" Connecting to file server: %1")
-               .arg(serverUrl.toString()));
-#endif
+    LOG_DEBUG(LOG_UPDATER,
+              logFile,
+              sMyName +
+              QString(" Connecting to file server: %1")
+              .arg(serverUrl.toString()));
     // Initialize the socket...
     pUpdateSocket = new QWebSocket();
     // And connect its various signals with the local slots
@@ -106,6 +140,10 @@ FileUpdater::startUpdate() {
             this,SLOT(onProcessBinaryFrame(QByteArray, bool)));
     connect(pUpdateSocket, SIGNAL(disconnected()),
             this, SLOT(onServerDisconnected()));
+    // The downloads reserved in the media store end with the thread
+    if(pMediaStore)
+        connect(thread(), SIGNAL(finished()),
+                pMediaStore, SLOT(unlockAll()), Qt::DirectConnection);
     // To silent some diagnostic messages...
     pUpdateSocket->ignoreSslErrors();
     // Let's try to open the connection
@@ -121,13 +159,11 @@ FileUpdater::startUpdate() {
  */
 void
 FileUpdater::onUpdateSocketConnected() {
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               sMyName +
-               QString(" Connected to: %1")
-               .arg(pUpdateSocket->peerAddress().toString()));
-#endif
+    LOG_DEBUG(LOG_UPDATER,
+              logFile,
+              sMyName +
+              QString(" Connected to: %1")
+              .arg(pUpdateSocket->peerAddress().toString()));
     // Query the file's list
     askFileList();
 }
@@ -144,24 +180,22 @@ FileUpdater::askFileList() {
         sMessage = QString("<send_file_list>1</send_file_list>");
         qint64 bytesSent = pUpdateSocket->sendTextMessage(sMessage);
         if(bytesSent != sMessage.length()) {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       sMyName +
-                       QString(" Unable to ask for file list"));
+            LOG_ERROR(LOG_UPDATER,
+                      logFile,
+                      sMyName +
+                      QString(" Unable to ask for file list"));
             returnCode = ERROR_SOCKET;
             thread()->exit(returnCode);
             return;
         }
-#ifdef LOG_MESG
         else {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       sMyName +
-                       QString(" Sent %1 to %2")
-                       .arg(sMessage)
-                       .arg(pUpdateSocket->peerAddress().toString()));
+            LOG_INFO(LOG_UPDATER,
+                     logFile,
+                     sMyName +
+                     QString(" Sent %1 to %2")
+                     .arg(sMessage)
+                     .arg(pUpdateSocket->peerAddress().toString()));
         }
-#endif
     }
 }
 
@@ -174,11 +208,11 @@ FileUpdater::askFileList() {
  */
 void
 FileUpdater::onServerDisconnected() {
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               sMyName +
-               QString(" WebSocket disconnected from: %1")
-               .arg(pUpdateSocket->peerAddress().toString()));
+    LOG_INFO(LOG_UPDATER,
+             logFile,
+             sMyName +
+             QString(" WebSocket disconnected from: %1")
+             .arg(pUpdateSocket->peerAddress().toString()));
     returnCode = SERVER_DISCONNECTED;
     thread()->exit(returnCode);
 }
@@ -193,13 +227,13 @@ FileUpdater::onServerDisconnected() {
  */
 void
 FileUpdater::onUpdateSocketError(QAbstractSocket::SocketError error) {
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               sMyName +
-               QString(" %1 %2 Error %3")
-               .arg(pUpdateSocket->localAddress().toString())
-               .arg(pUpdateSocket->errorString())
-               .arg(error));
+    LOG_ERROR(LOG_UPDATER,
+              logFile,
+              sMyName +
+              QString(" %1 %2 Error %3")
+              .arg(pUpdateSocket->localAddress().toString())
+              .arg(pUpdateSocket->errorString())
+              .arg(error));
     returnCode = ERROR_SOCKET;
     thread()->exit(returnCode);
 }
@@ -216,14 +250,15 @@ FileUpdater::onProcessBinaryFrame(QByteArray baMessage, bool isLastFrame) {
     QString sMessage;
     // Check if the file transfer must be stopped
     if(thread()->isInterruptionRequested()) {
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   sMyName +
-                   QString(" Received an Exit Request"));
+        LOG_INFO(LOG_UPDATER,
+                 logFile,
+                 sMyName +
+                 QString(" Received an Exit Request"));
         returnCode = TRANSFER_DONE;
         thread()->exit(returnCode);
         return;
     }
+    StatsSampler::addTransferredBytes(baMessage.size());
     if(bytesReceived == 0) {// It's a new file...
         // Get the header...
         QByteArray header = baMessage.left(1024);
@@ -246,22 +281,22 @@ FileUpdater::onProcessBinaryFrame(QByteArray baMessage, bool isLastFrame) {
             qint64 written = file.write(baMessage.mid(1024));
             bytesReceived += written;
             if(len != written) {
-                logMessage(logFile,
-                           Q_FUNC_INFO,
-                           sMyName +
-                           QString(" Writing File %1 Error: bytes written(%2/%3)")
-                           .arg(sCurrentFileName)
-                           .arg(written)
-                           .arg(len));
+                LOG_ERROR(LOG_UPDATER,
+                          logFile,
+                          sMyName +
+                          QString(" Writing File %1 Error: bytes written(%2/%3)")
+                          .arg(sCurrentFileName)
+                          .arg(written)
+                          .arg(len));
                 handleWriteFileError();
                 return;
             }
         } else {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       sMyName +
-                       QString(" Unable to open file: %1")
-                       .arg(sCurrentFileName));
+            LOG_ERROR(LOG_UPDATER,
+                      logFile,
+                      sMyName +
+                      QString(" Unable to open file: %1")
+                      .arg(sCurrentFileName));
             handleOpenFileError();
             return;
         }
@@ -271,23 +306,22 @@ FileUpdater::onProcessBinaryFrame(QByteArray baMessage, bool isLastFrame) {
         qint64 written = file.write(baMessage);
         bytesReceived += written;
         if(len != written) {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       sMyName +
-                       QString(" Writing File %1 Error: bytes written(%2/%3)")
-                       .arg(sCurrentFileName)
-                       .arg(written)
-                       .arg(len));
+            LOG_ERROR(LOG_UPDATER,
+                      logFile,
+                      sMyName +
+                      QString(" Writing File %1 Error: bytes written(%2/%3)")
+                      .arg(sCurrentFileName)
+                      .arg(written)
+                      .arg(len));
             handleWriteFileError();
             return;
         }
     }
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               sMyName +
-               QString(" Received %1 bytes").arg(bytesReceived));
-#endif
+    LOG_RECORD(LOG_LEVEL_DEBUG, LOG_UPDATER,
+               logFile,
+               "%1 Received %2 bytes",
+               sMyName,
+               bytesReceived);
     if(isLastFrame) {
         if(bytesReceived < queryList.last().fileSize) {// File length mismatch !!!!
             sMessage = QString("<get>%1,%2,%3</get>")
@@ -296,82 +330,47 @@ FileUpdater::onProcessBinaryFrame(QByteArray baMessage, bool isLastFrame) {
                        .arg(CHUNK_SIZE);
             qint64 written = pUpdateSocket->sendTextMessage(sMessage);
             if(written != sMessage.length()) {
-                logMessage(logFile,
-                           Q_FUNC_INFO,
-                           sMyName +
-                           QString(" Error writing %1").arg(sMessage));
+                LOG_ERROR(LOG_UPDATER,
+                          logFile,
+                          sMyName +
+                          QString(" Error writing %1").arg(sMessage));
                 returnCode = ERROR_SOCKET;
                 thread()->exit(returnCode);
                 return;
             }
-#ifdef LOG_VERBOSE
             else {
-                logMessage(logFile,
-                           Q_FUNC_INFO,
-                           sMyName +
-                           QString(" Sent %1 to: %2")
-                           .arg(sMessage)
-                           .arg(pUpdateSocket->peerAddress().toString()));
+                LOG_RECORD(LOG_LEVEL_DEBUG, LOG_UPDATER,
+                           logFile,
+                           "%1 Sent %2 to: %3",
+                           sMyName,
+                           sMessage,
+                           pUpdateSocket->peerAddress().toString());
             }
-#endif
         }// if(File length Mismatch !!!!)
         else {// OK: File length Match
             file.close();
             QDir renamed;// Remove the .temp exstension
             renamed.rename(destinationDir + sCurrentFileName + QString(".temp"),
                            destinationDir + sCurrentFileName);
+            // Share the file with the other Panels
+            // (unless it is still locked by someone else)
+            if(pMediaStore && !privateFiles.contains(queryList.last().fileName)) {
+                pMediaStore->publish(destinationDir + queryList.last().fileName,
+                                     queryList.last().fileName,
+                                     queryList.last().fileSize);
+                pMediaStore->unlock(queryList.last().fileName,
+                                    queryList.last().fileSize);
+            }
             // Go to transfer the next file (if any)
             queryList.removeLast();
-            if(!queryList.isEmpty()) {
-                bytesReceived = 0;
-                QFile tempFile;
-                sCurrentFileName = destinationDir + queryList.last().fileName;
-                tempFile.setFileName(sCurrentFileName + QString(".temp"));
-                if(tempFile.exists()) {
-                    bytesReceived = tempFile.size();
-                    file.setFileName(sCurrentFileName + QString(".temp"));
-                    if(!file.open(QIODevice::Append)) {
-                        logMessage(logFile,
-                                   Q_FUNC_INFO,
-                                   sMyName +
-                                   QString(" Unable to open file: %1")
-                                   .arg(sCurrentFileName + QString(".temp")));
-                        handleOpenFileError();
-                        return;
-                    }
-                }
-                QString sMessage = QString("<get>%1,%2,%3</get>")
-                                   .arg(queryList.last().fileName)
-                                   .arg(bytesReceived)
-                                   .arg(CHUNK_SIZE);
-                qint64 written = pUpdateSocket->sendTextMessage(sMessage);
-                if(written != sMessage.length()) {
-                    logMessage(logFile,
-                               Q_FUNC_INFO,
-                               sMyName +
-                               QString(" Error writing %1").arg(sMessage));
-                    returnCode = ERROR_SOCKET;
-                    thread()->exit(returnCode);
-                    return;
-                }
-#ifdef LOG_VERBOSE
-                else {
-                    logMessage(logFile,
-                               Q_FUNC_INFO,
-                               sMyName +
-                               QString(" Sent %1 to: %2")
-                               .arg(sMessage)
-                               .arg(pUpdateSocket->peerAddress().toString()));
-                }
-#endif
+            if(!queryList.isEmpty() || !deferredList.isEmpty()) {
+                askFirstFile();
             }
             else {
-#ifdef LOG_VERBOSE
-                logMessage(logFile,
-                           Q_FUNC_INFO,
-                           sMyName +
-                           QString(" No more file to transfer"));
-#endif
+                LOG_DEBUG(LOG_UPDATER,
+                          logFile,
+                          sMyName +
+                          QString(" No more file to transfer"));
                 returnCode = TRANSFER_DONE;
                 thread()->exit(returnCode);
                 return;
@@ -387,10 +386,10 @@ FileUpdater::onProcessBinaryFrame(QByteArray baMessage, bool isLastFrame) {
 void
 FileUpdater::handleWriteFileError() {
     file.close();
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("Error writing File: %1")
-               .arg(file.fileName()));
+    LOG_ERROR(LOG_UPDATER,
+              logFile,
+              QString("Error writing File: %1")
+              .arg(file.fileName()));
     returnCode = FILE_ERROR;
     thread()->exit(returnCode);
 }
@@ -401,10 +400,10 @@ FileUpdater::handleWriteFileError() {
  */
 void
 FileUpdater::handleOpenFileError() {
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("Error Opening File: %1")
-               .arg(file.fileName()));
+    LOG_ERROR(LOG_UPDATER,
+              logFile,
+              QString("Error Opening File: %1")
+              .arg(file.fileName()));
     returnCode = FILE_ERROR;
     thread()->exit(returnCode);
 }
@@ -422,13 +421,11 @@ FileUpdater::onProcessTextMessage(QString sMessage) {
     QString sToken;
     QString sNoData = QString("NoData");
     sToken = XML_Parse(sMessage, "file_list");
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               sMyName +
-               " " +
-               sToken);
-#endif
+    LOG_DEBUG(LOG_UPDATER,
+              logFile,
+              sMyName +
+              " " +
+              sToken);
     if(sToken != sNoData) {
         QStringList tmpFileList = QStringList(sToken.split(",", QString::SkipEmptyParts));
         remoteFileList.clear();
@@ -445,12 +442,10 @@ FileUpdater::onProcessTextMessage(QString sMessage) {
         updateFiles();
     }// file_list
     else {
-#ifdef LOG_VERBOSE
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   sMyName +
-                   QString(" Nessun file da trasferire"));
-#endif
+        LOG_DEBUG(LOG_UPDATER,
+                  logFile,
+                  sMyName +
+                  QString(" Nessun file da trasferire"));
         returnCode = TRANSFER_DONE;
         thread()->exit(returnCode);
     }
@@ -509,20 +504,25 @@ FileUpdater::updateFiles() {
         }
         if(!bFound) {
             QFile::remove(localFileInfoList.at(j).absoluteFilePath());
-#ifdef LOG_VERBOSE
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Removed %1").arg(localFileInfoList.at(j).absoluteFilePath()));
-#endif
+            LOG_DEBUG(LOG_UPDATER,
+                      logFile,
+                      QString("Removed %1").arg(localFileInfoList.at(j).absoluteFilePath()));
+        }
+    }
+    // The files already downloaded by another Panel are just linked
+    deferredList = QList<files>();
+    privateFiles.clear();
+    if(pMediaStore) {
+        for(int i=queryList.count()-1; i>=0; i--) {
+            if(pMediaStore->linkInto(queryList.at(i).fileName, queryList.at(i).fileSize, destinationDir))
+                queryList.removeAt(i);
         }
     }
     if(queryList.isEmpty()) {
-#ifdef LOG_VERBOSE
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   sMyName +
-                   QString(" All files are up to date !"));
-#endif
+        LOG_DEBUG(LOG_UPDATER,
+                  logFile,
+                  sMyName +
+                  QString(" All files are up to date !"));
         returnCode = TRANSFER_DONE;
         thread()->exit(returnCode);
         return;
@@ -539,6 +539,8 @@ FileUpdater::updateFiles() {
  */
 void
 FileUpdater::askFirstFile() {
+    if(pMediaStore && !lockNextFile())
+        return;
     bytesReceived = 0;
     QFile tempFile;
     sCurrentFileName = queryList.last().fileName;
@@ -547,11 +549,11 @@ FileUpdater::askFirstFile() {
         bytesReceived = tempFile.size();
         file.setFileName(destinationDir + sCurrentFileName + QString(".temp"));
         if(!file.open(QIODevice::Append)) {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       sMyName +
-                       QString(" Unable to open file: %1")
-                       .arg(sCurrentFileName + QString(".temp")));
+            LOG_ERROR(LOG_UPDATER,
+                      logFile,
+                      sMyName +
+                      QString(" Unable to open file: %1")
+                      .arg(sCurrentFileName + QString(".temp")));
             handleOpenFileError();
             return;
         }
@@ -562,22 +564,103 @@ FileUpdater::askFirstFile() {
                            .arg(CHUNK_SIZE);
     qint64 written = pUpdateSocket->sendTextMessage(sMessage);
     if(written != sMessage.length()) {
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   sMyName +
-                   QString(" Error writing %1").arg(sMessage));
+        LOG_ERROR(LOG_UPDATER,
+                  logFile,
+                  sMyName +
+                  QString(" Error writing %1").arg(sMessage));
         returnCode = ERROR_SOCKET;
         thread()->exit(returnCode);
         return;
     }
-#ifdef LOG_VERBOSE
     else {
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   sMyName +
-                   QString(" Sent %1 to: %2")
-                   .arg(sMessage)
-                   .arg(pUpdateSocket->peerAddress().toString()));
+        LOG_RECORD(LOG_LEVEL_DEBUG, LOG_UPDATER,
+                   logFile,
+                   "%1 Sent %2 to: %3",
+                   sMyName,
+                   sMessage,
+                   pUpdateSocket->peerAddress().toString());
+    }
+}
+
+
+/*!
+ * \brief FileUpdater::lockNextFile Reserve, in the media store, the next file to transfer
+ * \return true if there is a file to ask for now
+ *
+ * The files that other Panels are downloading are put aside. When all
+ * the others are done they are waited for (see onTimeToPollLock()).
+ */
+bool
+FileUpdater::lockNextFile() {
+    while(!queryList.isEmpty()) {
+        if(privateFiles.contains(queryList.last().fileName))
+            return true;
+        if(pMediaStore->tryLock(queryList.last().fileName, queryList.last().fileSize))
+            return true;
+        LOG_INFO(LOG_UPDATER,
+                 logFile,
+                 sMyName +
+                 QString(" %1 is being downloaded by another Panel")
+                 .arg(queryList.last().fileName));
+        deferredList.append(queryList.takeLast());
+    }
+    if(!deferredList.isEmpty()) {
+        // Wait without blocking the event loop (and the socket)
+        lockWaited = 0;
+        pLockPollTimer->start(MEDIA_LOCK_POLL);
+        return false;
+    }
+    LOG_DEBUG(LOG_UPDATER,
+              logFile,
+              sMyName +
+              QString(" No more file to transfer"));
+    returnCode = TRANSFER_DONE;
+    thread()->exit(returnCode);
+    return false;
+}
+
+
+/*!
+ * \brief FileUpdater::onTimeToPollLock Check if another Panel completed a deferred file
+ *
+ * When the other Panel is done the file is linked from the store
+ * (or transferred here if the other Panel did not complete it).
+ * After MEDIA_LOCK_WAIT ms (e.g. a lock left by a crashed Panel of
+ * another user, that cannot be removed) the files still locked are
+ * transferred here without using the store.
+ */
+void
+FileUpdater::onTimeToPollLock() {
+    if(thread()->isInterruptionRequested()) {
+        returnCode = TRANSFER_DONE;
+        thread()->exit(returnCode);
+        return;
+    }
+    files deferredFile = deferredList.first();
+    if(!pMediaStore->tryLock(deferredFile.fileName, deferredFile.fileSize)) {
+        lockWaited += MEDIA_LOCK_POLL;
+        if(lockWaited < MEDIA_LOCK_WAIT) {
+            pLockPollTimer->start(MEDIA_LOCK_POLL);
+            return;
+        }
+        // All the deferred files have been waited for that long
+        while(!deferredList.isEmpty()) {
+            deferredFile = deferredList.takeFirst();
+            LOG_ERROR(LOG_UPDATER,
+                      logFile,
+                      sMyName +
+                      QString(" Timeout waiting for %1: downloading a private copy")
+                      .arg(deferredFile.fileName));
+            privateFiles.append(deferredFile.fileName);
+            queryList.append(deferredFile);
+        }
+    }
+    else {
+        deferredList.removeFirst();
+        if(pMediaStore->linkInto(deferredFile.fileName, deferredFile.fileSize, destinationDir))
+            pMediaStore->unlock(deferredFile.fileName, deferredFile.fileSize);
+        else
+            queryList.append(deferredFile);
     }
-#endif
+    askFirstFile();
 }
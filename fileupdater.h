@@ -25,9 +25,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QWidget>
 #include <QFile>
 #include <QFileInfoList>
+#include <QTimer>
+#include <QStringList>
 
 
 QT_FORWARD_DECLARE_CLASS(QWebSocket)
+QT_FORWARD_DECLARE_CLASS(MediaStore)
 
 
 /*!
@@ -45,6 +48,7 @@ class FileUpdater : public QObject
 public:
     explicit FileUpdater(QString sName, QUrl myServerUrl, QFile *myLogFile = Q_NULLPTR, QObject *parent = Q_NULLPTR);
     bool setDestination(QString myDstinationDir, QString sExtensions);
+    void setMediaStore(QString sStoreDir);
     void askFileList();
 
     static const int TRANSFER_DONE       =  0;
@@ -61,13 +65,14 @@ private slots:
     void onServerDisconnected();
     void onProcessTextMessage(QString sMessage);
     void onProcessBinaryFrame(QByteArray baMessage, bool isLastFrame);
+    void onTimeToPollLock();
 
 private:
     void handleWriteFileError();
     void handleOpenFileError();
-    bool isConnectedToNetwork();
     void updateFiles();
     void askFirstFile();
+    bool lockNextFile();
 
 public:
     int returnCode;
@@ -85,6 +90,11 @@ private:
 
     QList<files> queryList;
     QList<files> remoteFileList;
+    QList<files> deferredList;/*!< The files other Panels are downloading */
+    QStringList  privateFiles;/*!< The files downloaded without the media store */
+    MediaStore  *pMediaStore;
+    QTimer      *pLockPollTimer;
+    int          lockWaited;
 };
 
 #endif // FILEUPDATER_H
@@ -0,0 +1,176 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <algorithm>
+
+#include "latencymonitor.h"
+#include "utility.h"
+
+
+#define MAX_PAINT_WAIT 1000000000 // In nsec (messages that did not change the Panel)
+
+
+/*!
+ * \brief LatencyMonitor::LatencyMonitor Measure how fast the Server messages reach the screen
+ * \param parent The parent object
+ *
+ * For each message carrying a <seq> sequence number it records the
+ * arrival time, the end of its parsing and dispatching and the end
+ * of the first repaint that follows. Messages not followed by
+ * a repaint within a second are discarded (they did not change the Panel).
+ * The Server can add <stamp>1</stamp> to a message to be notified
+ * (with <painted>seq</painted>) when it has been painted.
+ */
+LatencyMonitor::LatencyMonitor(QObject *parent)
+    : QObject(parent)
+    , iSample(0)
+    , lastSeq(-1)
+    , nLostSeq(0)
+    , nExpired(0)
+{
+    receiveToDispatch.resize(LATENCY_SAMPLES);
+    dispatchToPaint.resize(LATENCY_SAMPLES);
+    receiveToPaint.resize(LATENCY_SAMPLES);
+    clock.start();
+}
+
+
+/*!
+ * \brief LatencyMonitor::onTextMessageReceived Record the arrival time
+ * \param sMessage The Server message
+ *
+ * To be connected before any other slot handling the message.
+ */
+void
+LatencyMonitor::onTextMessageReceived(QString sMessage) {
+    QString sToken = XML_Parse(sMessage, "seq");
+    if(sToken == QString("NoData"))
+        return;
+    bool ok;
+    int seq = sToken.toInt(&ok);
+    if(!ok)
+        return;
+    if((lastSeq >= 0) && (seq > lastSeq+1))
+        nLostSeq += seq-lastSeq-1;
+    lastSeq = seq;
+    pendingMessage newMessage;
+    newMessage.seq          = seq;
+    newMessage.bAck         = (XML_Parse(sMessage, "stamp") != QString("NoData"));
+    newMessage.receiveTime  = clock.nsecsElapsed();
+    newMessage.dispatchTime = 0;
+    pendingMessages.append(newMessage);
+}
+
+
+/*!
+ * \brief LatencyMonitor::dispatchDone The message has been parsed and dispatched
+ */
+void
+LatencyMonitor::dispatchDone() {
+    if(pendingMessages.isEmpty())
+        return;
+    if(pendingMessages.last().dispatchTime == 0)
+        pendingMessages.last().dispatchTime = clock.nsecsElapsed();
+}
+
+
+/*!
+ * \brief LatencyMonitor::paintDone The Panel has been repainted
+ * \return The sequence numbers to be acknowledged to the Server
+ */
+QVector<int>
+LatencyMonitor::paintDone() {
+    QVector<int> acks;
+    if(pendingMessages.isEmpty())
+        return acks;
+    qint64 paintTime = clock.nsecsElapsed();
+    for(const pendingMessage& message : pendingMessages) {
+        if(message.dispatchTime == 0)
+            continue;
+        if(paintTime-message.receiveTime > MAX_PAINT_WAIT) {
+            nExpired++;
+            continue;
+        }
+        int i = iSample % LATENCY_SAMPLES;
+        receiveToDispatch[i] = message.dispatchTime-message.receiveTime;
+        dispatchToPaint[i]   = paintTime-message.dispatchTime;
+        receiveToPaint[i]    = paintTime-message.receiveTime;
+        iSample++;
+        if(message.bAck)
+            acks.append(message.seq);
+    }
+    pendingMessages.clear();
+    return acks;
+}
+
+
+/*!
+ * \brief LatencyMonitor::percentile
+ * \param samples The samples
+ * \param iPercent The requested percentile
+ * \return The percentile (in nsec) of the collected samples
+ */
+qint64
+LatencyMonitor::percentile(const QVector<qint64>& samples, int iPercent) {
+    int nSamples = qMin(iSample, LATENCY_SAMPLES);
+    if(nSamples == 0)
+        return 0;
+    QVector<qint64> sorted = samples.mid(0, nSamples);
+    std::sort(sorted.begin(), sorted.end());
+    return sorted.at(qMin(nSamples-1, nSamples*iPercent/100));
+}
+
+
+/*!
+ * \brief LatencyMonitor::report The answer to the Server <getLatency> request
+ * \return "samples,receive->dispatch p50,p99,dispatch->paint p50,p99,
+ * receive->paint p50,p99,lost sequence numbers" (times in usec)
+ */
+QString
+LatencyMonitor::report() {
+    return QString("%1,%2,%3,%4,%5,%6,%7,%8")
+            .arg(qMin(iSample, LATENCY_SAMPLES))
+            .arg(percentile(receiveToDispatch, 50)/1000)
+            .arg(percentile(receiveToDispatch, 99)/1000)
+            .arg(percentile(dispatchToPaint, 50)/1000)
+            .arg(percentile(dispatchToPaint, 99)/1000)
+            .arg(percentile(receiveToPaint, 50)/1000)
+            .arg(percentile(receiveToPaint, 99)/1000)
+            .arg(nLostSeq);
+}
+
+
+/*!
+ * \brief LatencyMonitor::overlayText The text of the debug overlay
+ */
+QString
+LatencyMonitor::overlayText() {
+    return QString(" msg %1  lost %2  unpainted %3 \n"
+                   " recv->disp  p50 %4 ms  p99 %5 ms \n"
+                   " disp->paint p50 %6 ms  p99 %7 ms \n"
+                   " recv->paint p50 %8 ms  p99 %9 ms ")
+            .arg(iSample)
+            .arg(nLostSeq)
+            .arg(nExpired)
+            .arg(double(percentile(receiveToDispatch, 50))*1.0e-6, 0, 'f', 2)
+            .arg(double(percentile(receiveToDispatch, 99))*1.0e-6, 0, 'f', 2)
+            .arg(double(percentile(dispatchToPaint, 50))*1.0e-6, 0, 'f', 2)
+            .arg(double(percentile(dispatchToPaint, 99))*1.0e-6, 0, 'f', 2)
+            .arg(double(percentile(receiveToPaint, 50))*1.0e-6, 0, 'f', 2)
+            .arg(double(percentile(receiveToPaint, 99))*1.0e-6, 0, 'f', 2);
+}
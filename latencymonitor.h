@@ -0,0 +1,68 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef LATENCYMONITOR_H
+#define LATENCYMONITOR_H
+
+#include <QObject>
+#include <QVector>
+#include <QElapsedTimer>
+
+
+#define LATENCY_SAMPLES 1024 // Samples kept for each measure
+
+
+class LatencyMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LatencyMonitor(QObject *parent=Q_NULLPTR);
+    void dispatchDone();
+    QVector<int> paintDone();
+    QString report();
+    QString overlayText();
+
+public slots:
+    void onTextMessageReceived(QString sMessage);
+
+private:
+    qint64 percentile(const QVector<qint64>& samples, int iPercent);
+
+private:
+    /*!
+     * \brief A message waiting to be painted
+     */
+    struct pendingMessage {
+        int    seq;         /*!< \brief the Server sequence number */
+        bool   bAck;        /*!< \brief the Server wants to know when it has been painted */
+        qint64 receiveTime; /*!< \brief nsec */
+        qint64 dispatchTime;/*!< \brief nsec (0 while still dispatching) */
+    };
+    QVector<pendingMessage> pendingMessages;
+    QVector<qint64>         receiveToDispatch;
+    QVector<qint64>         dispatchToPaint;
+    QVector<qint64>         receiveToPaint;
+    QElapsedTimer           clock;
+    int                     iSample;
+    int                     lastSeq;
+    int                     nLostSeq;
+    int                     nExpired;
+};
+
+#endif // LATENCYMONITOR_H
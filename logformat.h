@@ -0,0 +1,73 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef LOGFORMAT_H
+#define LOGFORMAT_H
+
+#include <QtGlobal>
+#include <QString>
+#include <QStringList>
+
+
+// The binary log file is made of a LOG_BINARY_MAGIC header followed
+// by records (QDataStream, little endian) starting with a quint8 type:
+//   LOG_RECORD_FORMAT:  quint32 message id, QByteArray function, QByteArray format
+//                       (written before the first message with that id)
+//   LOG_RECORD_MESSAGE: qint64 msec since epoch, quint8 subsystem,
+//                       quint32 message id, quint8 argc, argc x QByteArray
+// Strings are UTF-8. The message id LOG_TEXT_ID is for the plain
+// logMessage() calls: its arguments are the function and the message.
+// Every file generation is self contained.
+#define LOG_BINARY_MAGIC   "SPLOG1"
+#define LOG_RECORD_FORMAT  quint8(0)
+#define LOG_RECORD_MESSAGE quint8(1)
+#define LOG_TEXT_ID        quint32(0)
+#define LOG_NO_SUBSYSTEM   quint8(0xFF)
+
+
+static const char* const logSubsystemNames[] = {
+    "discovery", "updater", "slides", "serial", "panel", "startup"
+};
+
+
+// The text of a message: the arguments replace the placeholders in a
+// single pass (%1 in an argument is not replaced again)
+inline QString
+formatLogMessage(const QString& sFormat, const QStringList& args) {
+    const QStringList a = args.mid(0, 9);
+    QString sMessage;
+    switch(a.count()) {
+    case 0: sMessage = sFormat; break;
+    case 1: sMessage = sFormat.arg(a[0]); break;
+    case 2: sMessage = sFormat.arg(a[0], a[1]); break;
+    case 3: sMessage = sFormat.arg(a[0], a[1], a[2]); break;
+    case 4: sMessage = sFormat.arg(a[0], a[1], a[2], a[3]); break;
+    case 5: sMessage = sFormat.arg(a[0], a[1], a[2], a[3], a[4]); break;
+    case 6: sMessage = sFormat.arg(a[0], a[1], a[2], a[3], a[4], a[5]); break;
+    case 7: sMessage = sFormat.arg(a[0], a[1], a[2], a[3], a[4], a[5], a[6]); break;
+    case 8: sMessage = sFormat.arg(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]); break;
+    default: sMessage = sFormat.arg(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], a[8]); break;
+    }
+    // Only the (rare) messages with more than 9 arguments get here
+    for(int i=9; i<args.count(); i++)
+        sMessage = sMessage.arg(args.at(i));
+    return sMessage;
+}
+
+
+#endif // LOGFORMAT_H
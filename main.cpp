@@ -17,6 +17,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *
 */
 #include "myapplication.h"
+#include "asynclogger.h"
+#include "startuptrace.h"
 
 /*!
  * \mainpage The Score Panels
@@ -71,10 +73,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 int
 main(int argc, char *argv[]) {
+    // The time to the first score is measured from here
+    StartupTrace::start();
     QString sVersion = QString("1.2");
     QApplication::setApplicationVersion(sVersion);
 
     MyApplication a(argc, argv);
     int result = a.exec();
+    // Write the pending log messages
+    AsyncLogger::shutdown();
     return result;
 }
@@ -0,0 +1,342 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QSaveFile>
+#include <QCryptographicHash>
+
+#if defined(Q_OS_UNIX)
+    #include <unistd.h>
+    #include <sys/stat.h>
+#endif
+
+#include "mediastore.h"
+#include "utility.h"
+
+
+/*!
+ * \brief MediaStore::MediaStore A media store shared by all the Panels of a host
+ * \param sDir The store folder (created if it does not exist)
+ * \param myLogFile The File for message logging (if any)
+ * \param parent The parent object
+ *
+ * The Spots and the Slides are kept only once, whatever the number of
+ * Panels (and of users) on the host:
+ * <pre>
+ * blobs/&lt;sha1&gt;          the file contents, named by their hash
+ * index/&lt;size&gt;_&lt;name&gt;   the hash of the Server file with that name and size
+ * locks/&lt;size&gt;_&lt;name&gt;   taken while a Panel is downloading that file
+ * </pre>
+ * Each Panel sees the files in its own folders as hard links
+ * (or symbolic links when a hard link is not possible) to the blobs.
+ * The folders are shared by all the users (with the sticky bit, so
+ * that nobody can replace the files of the others) and nothing read
+ * from them is trusted: a blob is linked only if it is read only and
+ * its content matches its name.
+ */
+MediaStore::MediaStore(QString sDir, QFile *myLogFile, QObject *parent)
+    : QObject(parent)
+    , logFile(myLogFile)
+    , sStoreDir(sDir)
+    , bValid(true)
+{
+    if(!sStoreDir.endsWith(QString("/"))) sStoreDir+= QString("/");
+    QStringList subDirs = QStringList() << "blobs" << "index" << "locks";
+    for(int i=0; i<subDirs.count(); i++) {
+        QString sSubDir = sStoreDir + subDirs.at(i);
+        if(!QDir(sSubDir).exists()) {
+            if(!QDir().mkpath(sSubDir)) {
+                LOG_ERROR(LOG_UPDATER,
+                          logFile,
+                          QString("Unable to create directory: %1")
+                          .arg(sSubDir));
+                bValid = false;
+                continue;
+            }
+            // The Panels may run as different users
+#if defined(Q_OS_UNIX)
+            ::chmod(QFile::encodeName(sSubDir).constData(), S_ISVTX|S_IRWXU|S_IRWXG|S_IRWXO);
+#else
+            QFile::setPermissions(sSubDir, QFile::ReadOwner|QFile::WriteOwner|QFile::ExeOwner|
+                                           QFile::ReadGroup|QFile::WriteGroup|QFile::ExeGroup|
+                                           QFile::ReadOther|QFile::WriteOther|QFile::ExeOther);
+#endif
+        }
+        if(!QFileInfo(sSubDir).isWritable()) {
+            LOG_ERROR(LOG_UPDATER,
+                      logFile,
+                      QString("Media store directory not writable: %1")
+                      .arg(sSubDir));
+            bValid = false;
+        }
+    }
+}
+
+
+/*!
+ * \brief MediaStore::~MediaStore Release the locks still held
+ */
+MediaStore::~MediaStore() {
+    unlockAll();
+}
+
+
+/*!
+ * \brief MediaStore::isValid
+ * \return true if the store folders are usable
+ */
+bool
+MediaStore::isValid() const {
+    return bValid;
+}
+
+
+/*!
+ * \brief MediaStore::key The store name of a Server file
+ * \param sFileName The file name
+ * \param fileSize Its size (in bytes)
+ * \return The name of its index and lock files
+ */
+QString
+MediaStore::key(QString sFileName, qint64 fileSize) const {
+    return QString("%1_%2").arg(fileSize).arg(sFileName);
+}
+
+
+/*!
+ * \brief MediaStore::linkInto Show a stored file in a Panel folder
+ * \param sFileName The Server file name
+ * \param fileSize Its size (in bytes)
+ * \param sDestinationDir The Panel folder
+ * \return true if the file was already in the store (no need to download it)
+ */
+bool
+MediaStore::linkInto(QString sFileName, qint64 fileSize, QString sDestinationDir) {
+    QFile indexFile(sStoreDir + QString("index/") + key(sFileName, fileSize));
+    if(!indexFile.open(QIODevice::ReadOnly))
+        return false;
+    QString sHash = QString(indexFile.read(64)).trimmed();
+    indexFile.close();
+    if(!isValidBlob(sHash, fileSize))
+        return false;
+    QString sBlob = sStoreDir + QString("blobs/") + sHash;
+    QString sView = sDestinationDir + sFileName;
+    QFile::remove(sView);
+    QFile::remove(sView + QString(".temp"));
+    if(!makeView(sBlob, sView))
+        return false;
+    LOG_DEBUG(LOG_UPDATER,
+              logFile,
+              QString("%1 taken from the media store")
+              .arg(sFileName));
+    return true;
+}
+
+
+/*!
+ * \brief MediaStore::tryLock Reserve the download of a file
+ * \param sFileName The Server file name
+ * \param fileSize Its size (in bytes)
+ * \param msecTimeout The maximum wait time (in msec)
+ * \return true if no other Panel is downloading it
+ */
+bool
+MediaStore::tryLock(QString sFileName, qint64 fileSize, int msecTimeout) {
+    QString sKey = key(sFileName, fileSize);
+    if(locks.contains(sKey))
+        return true;
+    QLockFile* pLock = new QLockFile(sStoreDir + QString("locks/") + sKey + QString(".lock"));
+    // A download may last long: the lock is abandoned only if its process died
+    pLock->setStaleLockTime(0);
+    if(!pLock->tryLock(msecTimeout)) {
+        delete pLock;
+        return false;
+    }
+    locks.insert(sKey, pLock);
+    return true;
+}
+
+
+/*!
+ * \brief MediaStore::unlock Release the download reservation of a file
+ * \param sFileName The Server file name
+ * \param fileSize Its size (in bytes)
+ */
+void
+MediaStore::unlock(QString sFileName, qint64 fileSize) {
+    delete locks.take(key(sFileName, fileSize));// The QLockFile unlocks when deleted
+}
+
+
+/*!
+ * \brief MediaStore::unlockAll Release all the download reservations
+ */
+void
+MediaStore::unlockAll() {
+    qDeleteAll(locks);
+    locks.clear();
+}
+
+
+/*!
+ * \brief MediaStore::blobHash The hash of a file content
+ * \param sFilePath The file
+ * \return The hexadecimal hash (empty on error)
+ */
+QString
+MediaStore::blobHash(QString sFilePath) const {
+    QFile blobFile(sFilePath);
+    if(!blobFile.open(QIODevice::ReadOnly))
+        return QString();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if(!hash.addData(&blobFile))
+        return QString();
+    return QString(hash.result().toHex());
+}
+
+
+/*!
+ * \brief MediaStore::isHashName
+ * \param sHash The name to check
+ * \return true if it is a hash name (and nothing else, like a path)
+ */
+bool
+MediaStore::isHashName(const QString& sHash) const {
+    if(sHash.length() != 40)
+        return false;
+    for(const QChar& c : sHash) {
+        ushort code = c.unicode();
+        if(!((code >= '0' && code <= '9') || (code >= 'a' && code <= 'f')))
+            return false;
+    }
+    return true;
+}
+
+
+/*!
+ * \brief MediaStore::isValidBlob Check a blob before trusting it
+ * \param sHash The blob name
+ * \param fileSize The expected size (in bytes)
+ * \return true if the blob is a read only regular file with the right content
+ */
+bool
+MediaStore::isValidBlob(QString sHash, qint64 fileSize) const {
+    if(!isHashName(sHash))
+        return false;
+    QString sBlob = sStoreDir + QString("blobs/") + sHash;
+    QFileInfo blobInfo(sBlob);
+    if(blobInfo.isSymLink() || !blobInfo.isFile() || (blobInfo.size() != fileSize))
+        return false;
+    // Its owner could change it later (and our hard link with it)
+    if(blobInfo.permission(QFile::WriteOwner) ||
+       blobInfo.permission(QFile::WriteGroup) ||
+       blobInfo.permission(QFile::WriteOther))
+        return false;
+    if(blobHash(sBlob) != sHash) {
+        LOG_ERROR(LOG_UPDATER,
+                  logFile,
+                  QString("Media store blob %1 does not match its content")
+                  .arg(sBlob));
+        return false;
+    }
+    return true;
+}
+
+
+/*!
+ * \brief MediaStore::publish Move a downloaded file into the store
+ * \param sFilePath The downloaded file (replaced by a link to the blob)
+ * \param sFileName The Server file name
+ * \param fileSize Its size (in bytes)
+ * \return true if the file is now in the store
+ *
+ * If a file with the same content is already in the store
+ * the downloaded copy is dropped.
+ */
+bool
+MediaStore::publish(QString sFilePath, QString sFileName, qint64 fileSize) {
+    QString sHash = blobHash(sFilePath);
+    if(sHash.isEmpty()) {
+        LOG_ERROR(LOG_UPDATER,
+                  logFile,
+                  QString("Unable to hash %1")
+                  .arg(sFilePath));
+        return false;
+    }
+    QString sBlob = sStoreDir + QString("blobs/") + sHash;
+    if(!isValidBlob(sHash, fileSize)) {
+        // Possible only for our own blobs (sticky folder)
+        QFile::remove(sBlob);
+        // Rename if on the same file system, copy otherwise
+        if(!QFile::rename(sFilePath, sBlob) && !QFile::copy(sFilePath, sBlob)) {
+            LOG_ERROR(LOG_UPDATER,
+                      logFile,
+                      QString("Unable to store %1")
+                      .arg(sFilePath));
+            return false;
+        }
+        // A Panel must not change, through its link, the files of the others
+        QFile::setPermissions(sBlob, QFile::ReadOwner|QFile::ReadGroup|QFile::ReadOther);
+    }
+    QSaveFile indexFile(sStoreDir + QString("index/") + key(sFileName, fileSize));
+    if(!indexFile.open(QIODevice::WriteOnly) ||
+       (indexFile.write(sHash.toLatin1()) != sHash.length()) ||
+       !indexFile.commit())
+    {
+        LOG_ERROR(LOG_UPDATER,
+                  logFile,
+                  QString("Unable to index %1")
+                  .arg(sFileName));
+    }
+    if(QFile::exists(sFilePath))
+        QFile::remove(sFilePath);
+    if(!makeView(sBlob, sFilePath)) {
+        // Keep at least a private copy
+        QFile::copy(sBlob, sFilePath);
+        return false;
+    }
+    return true;
+}
+
+
+/*!
+ * \brief MediaStore::makeView Show a blob with the name of the Server file
+ * \param sBlob The stored file
+ * \param sView The file name in the Panel folder
+ * \return true if done
+ */
+bool
+MediaStore::makeView(QString sBlob, QString sView) {
+#if defined(Q_OS_UNIX)
+    // A hard link survives to the removal of the store
+    if(::link(QFile::encodeName(sBlob).constData(), QFile::encodeName(sView).constData()) == 0)
+        return true;
+#endif
+    // i.e. the store is on another file system or the blob belongs to another user
+    if(QFile::link(sBlob, sView))
+        return true;
+    LOG_ERROR(LOG_UPDATER,
+              logFile,
+              QString("Unable to link %1 to %2")
+              .arg(sView)
+              .arg(sBlob));
+    return false;
+}
@@ -0,0 +1,60 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef MEDIASTORE_H
+#define MEDIASTORE_H
+
+#include <QObject>
+#include <QHash>
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+QT_FORWARD_DECLARE_CLASS(QLockFile)
+
+
+class MediaStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MediaStore(QString sDir, QFile *myLogFile=Q_NULLPTR, QObject *parent=Q_NULLPTR);
+    ~MediaStore();
+    bool isValid() const;
+    bool linkInto(QString sFileName, qint64 fileSize, QString sDestinationDir);
+    bool tryLock(QString sFileName, qint64 fileSize, int msecTimeout=0);
+    void unlock(QString sFileName, qint64 fileSize);
+    bool publish(QString sFilePath, QString sFileName, qint64 fileSize);
+
+public slots:
+    void unlockAll();
+
+private:
+    QString key(QString sFileName, qint64 fileSize) const;
+    QString blobHash(QString sFilePath) const;
+    bool isHashName(const QString& sHash) const;
+    bool isValidBlob(QString sHash, qint64 fileSize) const;
+    bool makeView(QString sBlob, QString sView);
+
+private:
+    QFile                     *logFile;
+    QString                    sStoreDir;
+    bool                       bValid;
+    QHash<QString, QLockFile*> locks;
+};
+
+#endif // MEDIASTORE_H
@@ -0,0 +1,116 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include "messagerecorder.h"
+#include "utility.h"
+
+
+#define FLUSH_EVERY 64 // Records
+
+
+/*!
+ * \brief MessageRecorder::MessageRecorder Capture the messages received from the Server
+ * \param sFileName The capture file (new sessions are appended)
+ * \param myLogFile The File for message logging (if any)
+ * \param parent The parent object
+ *
+ * Every text and binary message is stored with its arrival time
+ * so that a match can be later replayed by the MessageReplayer.
+ */
+MessageRecorder::MessageRecorder(QString sFileName, QFile *myLogFile, QObject *parent)
+    : QObject(parent)
+    , logFile(myLogFile)
+    , nUnflushed(0)
+{
+    file.setFileName(sFileName);
+    if(!file.open(QIODevice::Append)) {
+        LOG_ERROR(LOG_PANEL,
+                  logFile,
+                  QString("Unable to open %1: %2")
+                  .arg(sFileName)
+                  .arg(file.errorString()));
+        return;
+    }
+    stream.setDevice(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    if(file.size() == 0)
+        stream.writeRawData(RECORD_MAGIC, int(qstrlen(RECORD_MAGIC)));
+    clock.start();
+    writeRecord(RECORD_SESSION, QByteArray());
+}
+
+
+/*!
+ * \brief MessageRecorder::~MessageRecorder
+ */
+MessageRecorder::~MessageRecorder() {
+    if(file.isOpen()) {
+        file.flush();
+        file.close();
+    }
+}
+
+
+/*!
+ * \brief MessageRecorder::isOpen
+ * \return true if the capture file is ready
+ */
+bool
+MessageRecorder::isOpen() {
+    return file.isOpen();
+}
+
+
+/*!
+ * \brief MessageRecorder::onTextMessageReceived Record a text message
+ * \param sMessage The received message
+ */
+void
+MessageRecorder::onTextMessageReceived(QString sMessage) {
+    writeRecord(RECORD_TEXT, sMessage.toUtf8());
+}
+
+
+/*!
+ * \brief MessageRecorder::onBinaryMessageReceived Record a binary message
+ * \param baMessage The received message
+ */
+void
+MessageRecorder::onBinaryMessageReceived(QByteArray baMessage) {
+    writeRecord(RECORD_BINARY, baMessage);
+}
+
+
+/*!
+ * \brief MessageRecorder::writeRecord Append a record to the capture file
+ * \param kind The record kind
+ * \param baPayload The record payload
+ */
+void
+MessageRecorder::writeRecord(quint8 kind, const QByteArray& baPayload) {
+    if(!file.isOpen())
+        return;
+    stream << quint64(clock.nsecsElapsed());
+    stream << kind;
+    stream << quint32(baPayload.size());
+    stream.writeRawData(baPayload.constData(), baPayload.size());
+    if(++nUnflushed >= FLUSH_EVERY) {
+        file.flush();
+        nUnflushed = 0;
+    }
+}
@@ -0,0 +1,64 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef MESSAGERECORDER_H
+#define MESSAGERECORDER_H
+
+#include <QObject>
+#include <QFile>
+#include <QDataStream>
+#include <QElapsedTimer>
+
+
+// The capture file is made of a RECORD_MAGIC header followed by records:
+//   quint64 nsec since the session start (monotonic)
+//   quint8  kind (RECORD_TEXT, RECORD_BINARY or RECORD_SESSION)
+//   quint32 payload size
+//   payload (UTF-8 for the text messages)
+// All in little endian. Each new session appends a RECORD_SESSION record.
+#define RECORD_MAGIC   "SPREC1"
+#define RECORD_TEXT    quint8(0)
+#define RECORD_BINARY  quint8(1)
+#define RECORD_SESSION quint8(0xFF)
+
+
+class MessageRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MessageRecorder(QString sFileName, QFile *myLogFile=Q_NULLPTR, QObject *parent=Q_NULLPTR);
+    ~MessageRecorder();
+    bool isOpen();
+
+public slots:
+    void onTextMessageReceived(QString sMessage);
+    void onBinaryMessageReceived(QByteArray baMessage);
+
+private:
+    void writeRecord(quint8 kind, const QByteArray& baPayload);
+
+private:
+    QFile         *logFile;
+    QFile          file;
+    QDataStream    stream;
+    QElapsedTimer  clock;
+    int            nUnflushed;
+};
+
+#endif // MESSAGERECORDER_H
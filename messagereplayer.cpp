@@ -0,0 +1,241 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QFile>
+#include <algorithm>
+
+#include "messagereplayer.h"
+#include "messagerecorder.h"
+#include "utility.h"
+
+
+/*!
+ * \brief percentile Utility function
+ * \param values The sorted samples
+ * \param iPercent The percentile requested
+ * \return The sample at the requested percentile
+ */
+static qint64
+percentile(const QVector<qint64>& values, int iPercent) {
+    if(values.isEmpty())
+        return 0;
+    return values.at(qMin(values.count()-1, values.count()*iPercent/100));
+}
+
+
+/*!
+ * \brief MessageReplayer::MessageReplayer Feed a capture back into a ScorePanel
+ * \param myTarget The ScorePanel receiving the messages
+ * \param myLogFile The File for message logging (if any)
+ * \param parent The parent object
+ *
+ * The messages recorded by the MessageRecorder are delivered to
+ * the onTextMessageReceived() and onBinaryMessageReceived() slots
+ * of the target, either at the recorded pace or as fast as possible,
+ * measuring the cost of parsing, dispatching and widget updating.
+ */
+MessageReplayer::MessageReplayer(QObject *myTarget, QFile *myLogFile, QObject *parent)
+    : QObject(parent)
+    , pTarget(myTarget)
+    , logFile(myLogFile)
+    , iCurrent(0)
+{
+    replayTimer.setSingleShot(true);
+    replayTimer.setTimerType(Qt::PreciseTimer);
+    connect(&replayTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToReplay()));
+}
+
+
+/*!
+ * \brief MessageReplayer::load Read a capture file
+ * \param sFileName The capture file
+ * \return true if the file is a valid capture
+ *
+ * The times of the appended sessions are made consecutive.
+ */
+bool
+MessageReplayer::load(QString sFileName) {
+    QFile file(sFileName);
+    if(!file.open(QIODevice::ReadOnly)) {
+        LOG_ERROR(LOG_PANEL,
+                  logFile,
+                  QString("Unable to open %1: %2")
+                  .arg(sFileName)
+                  .arg(file.errorString()));
+        return false;
+    }
+    QByteArray baMagic = file.read(int(qstrlen(RECORD_MAGIC)));
+    if(baMagic != QByteArray(RECORD_MAGIC)) {
+        LOG_ERROR(LOG_PANEL,
+                  logFile,
+                  QString("%1 is not a capture file").arg(sFileName));
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    records.clear();
+    qint64 sessionBase = 0;
+    qint64 lastTime = 0;
+    while(!stream.atEnd()) {
+        quint64 nsecTime;
+        quint8  kind;
+        quint32 size;
+        stream >> nsecTime >> kind >> size;
+        // A truncated header or payload ends the capture: the
+        // size is not trusted beyond the bytes left in the file
+        if((stream.status() != QDataStream::Ok) ||
+           (qint64(size) > file.size()-file.pos()))
+        {
+            LOG_INFO(LOG_PANEL,
+                     logFile,
+                     QString("Truncated record at the end of %1: %2 records kept")
+                     .arg(sFileName)
+                     .arg(records.count()));
+            break;
+        }
+        record newRecord;
+        newRecord.kind = kind;
+        newRecord.baPayload.resize(int(size));
+        if((stream.readRawData(newRecord.baPayload.data(), int(size)) != int(size)) ||
+           (stream.status() != QDataStream::Ok))
+        {
+            LOG_INFO(LOG_PANEL,
+                     logFile,
+                     QString("Truncated record at the end of %1: %2 records kept")
+                     .arg(sFileName)
+                     .arg(records.count()));
+            break;
+        }
+        if(kind == RECORD_SESSION) {
+            sessionBase = lastTime;
+            continue;
+        }
+        newRecord.nsecTime = sessionBase + qint64(nsecTime);
+        lastTime = newRecord.nsecTime;
+        records.append(newRecord);
+    }
+    LOG_INFO(LOG_PANEL,
+             logFile,
+             QString("Loaded %1 messages from %2")
+             .arg(records.count())
+             .arg(sFileName));
+    return true;
+}
+
+
+/*!
+ * \brief MessageReplayer::start Start the replay
+ * \param bAtMaxSpeed true to replay as fast as possible
+ */
+void
+MessageReplayer::start(bool bAtMaxSpeed) {
+    iCurrent = 0;
+    dispatchTimes.clear();
+    updateTimes.clear();
+    clock.start();
+    if(bAtMaxSpeed) {
+        for(iCurrent=0; iCurrent<records.count(); iCurrent++)
+            replayRecord(iCurrent);
+        report();
+        emit replayDone();
+        return;
+    }
+    onTimeToReplay();
+}
+
+
+/*!
+ * \brief MessageReplayer::onTimeToReplay Replay the records that are due
+ * and wait for the next one
+ */
+void
+MessageReplayer::onTimeToReplay() {
+    while(iCurrent < records.count() &&
+          records.at(iCurrent).nsecTime <= clock.nsecsElapsed()) {
+        replayRecord(iCurrent);
+        iCurrent++;
+    }
+    if(iCurrent >= records.count()) {
+        report();
+        emit replayDone();
+        return;
+    }
+    qint64 msecDelay = (records.at(iCurrent).nsecTime-clock.nsecsElapsed())/1000000;
+    replayTimer.start(int(qMax(qint64(0), msecDelay)));
+}
+
+
+/*!
+ * \brief MessageReplayer::replayRecord Deliver a record to the target
+ * \param iRecord The record index
+ *
+ * The dispatch time is the time spent in the target slot, the update
+ * time is the time needed to process the events (repaints included)
+ * that the slot generated.
+ */
+void
+MessageReplayer::replayRecord(int iRecord) {
+    const record& current = records.at(iRecord);
+    qint64 t0 = clock.nsecsElapsed();
+    if(current.kind == RECORD_TEXT) {
+        QMetaObject::invokeMethod(pTarget, "onTextMessageReceived", Qt::DirectConnection,
+                                  Q_ARG(QString, QString::fromUtf8(current.baPayload)));
+    }
+    else if(current.kind == RECORD_BINARY) {
+        QMetaObject::invokeMethod(pTarget, "onBinaryMessageReceived", Qt::DirectConnection,
+                                  Q_ARG(QByteArray, current.baPayload));
+    }
+    qint64 t1 = clock.nsecsElapsed();
+    QCoreApplication::processEvents();
+    qint64 t2 = clock.nsecsElapsed();
+    dispatchTimes.append(t1-t0);
+    updateTimes.append(t2-t1);
+}
+
+
+/*!
+ * \brief MessageReplayer::report Log the collected timings
+ */
+void
+MessageReplayer::report() {
+    QVector<qint64> dispatch = dispatchTimes;
+    QVector<qint64> update   = updateTimes;
+    std::sort(dispatch.begin(), dispatch.end());
+    std::sort(update.begin(), update.end());
+    LOG_INFO(LOG_PANEL,
+             logFile,
+             QString("%1: %2 messages in %3 ms")
+             .arg(pTarget->metaObject()->className())
+             .arg(dispatch.count())
+             .arg(double(clock.nsecsElapsed())*1.0e-6, 0, 'f', 1));
+    LOG_INFO(LOG_PANEL,
+             logFile,
+             QString("Dispatch [us]: p50=%1 p99=%2 max=%3")
+             .arg(double(percentile(dispatch, 50))*1.0e-3, 0, 'f', 1)
+             .arg(double(percentile(dispatch, 99))*1.0e-3, 0, 'f', 1)
+             .arg(double(percentile(dispatch, 100))*1.0e-3, 0, 'f', 1));
+    LOG_INFO(LOG_PANEL,
+             logFile,
+             QString("Update [us]: p50=%1 p99=%2 max=%3")
+             .arg(double(percentile(update, 50))*1.0e-3, 0, 'f', 1)
+             .arg(double(percentile(update, 99))*1.0e-3, 0, 'f', 1)
+             .arg(double(percentile(update, 100))*1.0e-3, 0, 'f', 1));
+}
@@ -0,0 +1,69 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef MESSAGEREPLAYER_H
+#define MESSAGEREPLAYER_H
+
+#include <QObject>
+#include <QVector>
+#include <QTimer>
+#include <QElapsedTimer>
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+
+
+class MessageReplayer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MessageReplayer(QObject *myTarget, QFile *myLogFile=Q_NULLPTR, QObject *parent=Q_NULLPTR);
+    bool load(QString sFileName);
+    void start(bool bAtMaxSpeed);
+
+signals:
+    void replayDone();/*!< \brief emitted when all the records have been replayed */
+
+private slots:
+    void onTimeToReplay();
+
+private:
+    void replayRecord(int iRecord);
+    void report();
+
+private:
+    /*!
+     * \brief A captured message
+     */
+    struct record {
+        qint64     nsecTime; /*!< \brief arrival time since the session start */
+        quint8     kind;     /*!< \brief RECORD_TEXT, RECORD_BINARY or RECORD_SESSION */
+        QByteArray baPayload;/*!< \brief the message */
+    };
+    QObject          *pTarget;
+    QFile            *logFile;
+    QVector<record>   records;
+    QVector<qint64>   dispatchTimes;
+    QVector<qint64>   updateTimes;
+    QTimer            replayTimer;
+    QElapsedTimer     clock;
+    int               iCurrent;
+};
+
+#endif // MESSAGEREPLAYER_H
@@ -25,6 +25,18 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 
 #define MOVE_TIME 2000
+#define MAX_CARDS   16 // The message cards kept rendered
+
+
+/*!
+ * \brief MessageWindow::cardCache The message cards already rendered
+ *
+ * Shared by all the MessageWindows: the same few messages are shown
+ * again and again while waiting for the network or the Server.
+ * The key is the (already translated) text so that each language
+ * has its own cards.
+ */
+QHash<QString, QPixmap> MessageWindow::cardCache;
 
 
 /*!
@@ -48,32 +60,16 @@ MessageWindow::MessageWindow(QWidget *parent)
     // Set the used palette
     setPalette(pal);
 
-    // The Label with the message.
-    // Since it has a No Parent it is a QWidget that we can move !
-    pMyLabel = new QLabel(Q_NULLPTR);
-    QString sNewText = tr("No Text");
-    QFont font(pMyLabel->font());
-    font.setPixelSize(12);
-    QFontMetrics f(font);
-    int rW = f.horizontalAdvance(sNewText);
-    QPixmap logo(":/myLogo.png");
-    rW = (logo.width()-rW)/2;
-    QPainter painter(&logo);
-    painter.setPen(QColor(255,255,255,255));
-    painter.setFont(font);
-    painter.drawText(QPoint(rW, 12), sNewText);
-    rW = f.horizontalAdvance(sProducer);
-    rW = (logo.width()-rW)/2;
-    painter.setPen(QColor(255,34,255,255));
-    painter.drawText(QPoint(rW, logo.height()-12), sProducer);
-    pMyLabel->setPixmap(logo);
-    pMyLabel->move(newLabelPosition());
+    // The Label with the message: it is just moved around
+    pMyLabel = new QLabel(this);
+    setDisplayedText(tr("No Text"));
 
     // Initialize the random number generator
     QTime time(QTime::currentTime());
     qsrand(uint(time.msecsSinceStartOfDay()));
 
-    // The "Move Label" Timer
+    // The "Move Label" Timer (no need to be punctual)
+    moveTimer.setTimerType(Qt::VeryCoarseTimer);
     connect(&moveTimer, SIGNAL(timeout()),
             this, SLOT(onTimeToMoveLabel()));
     moveTimer.start(MOVE_TIME);
@@ -117,9 +113,7 @@ MessageWindow::hideEvent(QHideEvent *event) {
  */
 void
 MessageWindow::onTimeToMoveLabel() {
-    QPoint newPoint = newLabelPosition();
-    pMyLabel->move(newPoint);
-    pMyLabel->show();
+    pMyLabel->move(newLabelPosition());
 }
 
 
@@ -152,28 +146,49 @@ MessageWindow::keyPressEvent(QKeyEvent *event) {
 /*!
  * \brief MessageWindow::setDisplayedText
  * \param [in] sNewText: the new text to show in the window
+ *
+ * Nothing is done if the text is already shown.
  */
 void
 MessageWindow::setDisplayedText(QString sNewText) {
-    delete pMyLabel;
-    // The Label with the message
-    pMyLabel = new QLabel(sNewText, this);
+    if(sNewText == sDisplayedText)
+        return;
+    sDisplayedText = sNewText;
+    pMyLabel->setPixmap(messageCard(sNewText));
+    pMyLabel->adjustSize();
+    pMyLabel->move(newLabelPosition());
+}
+
+
+/*!
+ * \brief MessageWindow::messageCard The logo with the message and the producer
+ * \param sText The message
+ * \return The (cached) rendered card
+ */
+QPixmap
+MessageWindow::messageCard(QString sText) {
+    QHash<QString, QPixmap>::const_iterator it = cardCache.constFind(sText);
+    if(it != cardCache.constEnd())
+        return it.value();
     QFont font(pMyLabel->font());
     font.setPixelSize(12);
     QFontMetrics f(font);
-    int rW = f.horizontalAdvance(sNewText);
+    int rW = f.horizontalAdvance(sText);
     QPixmap logo(":/myLogo.png");
     rW = (logo.width()-rW)/2;
     QPainter painter(&logo);
     painter.setPen(QColor(255,255,255,255));
     painter.setFont(font);
-    painter.drawText(QPoint(rW, 12), sNewText);
+    painter.drawText(QPoint(rW, 12), sText);
     rW = f.horizontalAdvance(sProducer);
     rW = (logo.width()-rW)/2;
     painter.setPen(QColor(255,34,255,255));
     painter.drawText(QPoint(rW, logo.height()-12), sProducer);
-    pMyLabel->setPixmap(logo);
-    pMyLabel->move(newLabelPosition());
+    painter.end();
+    if(cardCache.count() >= MAX_CARDS)
+        cardCache.clear();
+    cardCache.insert(sText, logo);
+    return logo;
 }
 
 
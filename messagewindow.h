@@ -22,6 +22,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QTimer>
 #include <QWidget>
 #include <QLabel>
+#include <QHash>
+#include <QPixmap>
 #include <qevent.h>
 
 #if (QT_VERSION < QT_VERSION_CHECK(5, 11, 0))
@@ -47,11 +49,14 @@ public:
 
 private:
     QPoint newLabelPosition();
+    QPixmap messageCard(QString sText);
     QPalette pal;
 
 private:
     QLabel *pMyLabel;
+    QString sDisplayedText;
     QTimer moveTimer;
+    static QHash<QString, QPixmap> cardCache;
     const QString sProducer = QString("© Salvato Family - 2018");
 
 };
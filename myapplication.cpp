@@ -16,20 +16,29 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *
 */
-#include <QNetworkInterface>
 #include <QFile>
 #include <QMessageBox>
 #include <QDir>
 #include <QStandardPaths>
 #include <QSettings>
+#include <QCommandLineParser>
 
 #include "myapplication.h"
 #include "serverdiscoverer.h"
 #include "messagewindow.h"
+#include "networkmonitor.h"
+#include "messagereplayer.h"
+#include "asynclogger.h"
+#include "stallwatchdog.h"
+#include "segnapuntivolley.h"
+#include "segnapuntibasket.h"
+#include "segnapuntihandball.h"
+#include "startuptrace.h"
 #include "utility.h"
 
 
-#define NETWORK_CHECK_TIME    3000 // In msec
+#define NETWORK_CHECK_TIME    3000 // In msec (retry time after a Discovery failure)
+#define REPLAY_START_DELAY    1000 // In msec (time for the Panel to be shown)
 
 /*!
  * \brief MyApplication::MyApplication The client part of the ScorePanel System.
@@ -39,26 +48,58 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
  * It is responsible to start the "Server Discovery" process.
  * It allows the client to connect to the Server without knowing
  * its network address;
- * It wait until a Network connection is Up and Ready and then
- * allows to start the panel requested by the Server.
+ * It wait until a Network connection is Up and Ready (as signaled by
+ * the NetworkMonitor) and then allows to start the panel requested
+ * by the Server.
+ *
+ * Command line options:
+ * --record file: append the messages received from the Server to file.
+ * --replay file: no Server: replay a recorded match on the panel given
+ * with --panel (volley, basket or handball) at the recorded pace or,
+ * with --replay-speed max, as fast as possible and log the timings.
+ * --log levels: the log level of each subsystem (see setLogLevels()),
+ * the default is taken from the "log/levels" setting.
+ * --screens n: show the panel on n screens (0 for all the screens),
+ * the default is taken from the "panel/screens" setting.
  */
 MyApplication::MyApplication(int& argc, char ** argv)
     : QApplication(argc, argv)
+    , nScreens(1)
+    , pStallWatchdog(Q_NULLPTR)
     , logFile(Q_NULLPTR)
     , pServerDiscoverer(Q_NULLPTR)
     , pNoNetWindow(Q_NULLPTR)
+    , pNetworkMonitor(Q_NULLPTR)
+    , pReplayPanel(Q_NULLPTR)
+    , pReplayer(Q_NULLPTR)
+    , bReplayAtMaxSpeed(false)
+    , bWaitingNetwork(true)
 {
     pSettings = new QSettings("Gabriele Salvato", "Score Panel");
+
+    // On Android, no Log Files !
+    #ifndef Q_OS_ANDROID
+        QString sBaseDir;
+        sBaseDir = QDir::homePath();
+        if(!sBaseDir.endsWith(QString("/"))) sBaseDir+= QString("/");
+        logFileName = QString("%1score_panel.txt").arg(sBaseDir);
+        PrepareLogFile();
+    #endif
+    // On a crash the messages not yet written go to the log file (or stderr)
+    AsyncLogger::installCrashHandler(logFile);
+
+    parseArguments();
+    StartupTrace::mark(logFile, QString("Application created"));
+
     sLanguage = pSettings->value("language/current",  QString("Italiano")).toString();
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("Initial Language: %1").arg(sLanguage));
-#endif
+    LOG_DEBUG(LOG_PANEL,
+              logFile,
+              QString("Initial Language: %1").arg(sLanguage));
     if(sLanguage == QString("English")) {
         Translator.load(":/panelChooser_en");
         QCoreApplication::installTranslator(&Translator);
     }
+    StartupTrace::mark(logFile, QString("Translator loaded"));
 
     // We want the cursor set for all widgets,
     // even when outside the window then:
@@ -68,23 +109,28 @@ MyApplication::MyApplication(int& argc, char ** argv)
     QTime time(QTime::currentTime());
     qsrand(uint(time.msecsSinceStartOfDay()));
 
-    // Starts a timer to check for a ready network connection
+    // A timer to retry when the Discovery could not be started
+    networkReadyTimer.setSingleShot(true);
     connect(&networkReadyTimer, SIGNAL(timeout()),
             this, SLOT(onTimeToCheckNetwork()));
 
-    // On Android, no Log Files !
-    #ifndef Q_OS_ANDROID
-        QString sBaseDir;
-        sBaseDir = QDir::homePath();
-        if(!sBaseDir.endsWith(QString("/"))) sBaseDir+= QString("/");
-        logFileName = QString("%1score_panel.txt").arg(sBaseDir);
-        PrepareLogFile();
-    #endif
+    // Watch for the GUI event loop stalls
+    pStallWatchdog = new StallWatchdog(logFile, this);
+    connect(this, SIGNAL(aboutToQuit()),
+            pStallWatchdog, SLOT(stop()));
+    pStallWatchdog->start();
+
+    // When replaying a recorded match we do not need the network
+    if(!sReplayFileName.isEmpty()) {
+        startReplay();
+        return;
+    }
 
     // Create a message window
     pNoNetWindow = new MessageWindow(Q_NULLPTR);
     pNoNetWindow->setDisplayedText(tr("In Attesa della Connessione con la Rete"));
     pNoNetWindow->showFullScreen();
+    StartupTrace::mark(logFile, QString("Waiting window shown"));
 
     // Create a "PanelServer Discovery Service" but not start it
     // until we are sure that there is an active network connection
@@ -94,8 +140,12 @@ MyApplication::MyApplication(int& argc, char ** argv)
 
     // When the network becomes available we will start the
     // "PanelServer Discovery Service".
-    // Let's start the periodic check for the network
-    networkReadyTimer.start(NETWORK_CHECK_TIME);
+    // Let's start watching the network interfaces
+    pNetworkMonitor = new NetworkMonitor(logFile, this);
+    connect(pNetworkMonitor, SIGNAL(networkUp()),
+            this, SLOT(onTimeToCheckNetwork()));
+    pNetworkMonitor->start();
+    StartupTrace::mark(logFile, QString("Network monitor started"));
 
     // And now it is time to check if the Network
     // is already up and working
@@ -104,14 +154,18 @@ MyApplication::MyApplication(int& argc, char ** argv)
 
 
 /*!
- * \brief MyApplication::onTimeToCheckNetwork Periodic "Network Available" check.
+ * \brief MyApplication::onTimeToCheckNetwork "Network Available" check.
  *
- * Start the "ServerDiscovery" Service when the Network is Up
+ * Invoked when the NetworkMonitor signals the Network is Up (or to
+ * retry a failed Discovery): start the "ServerDiscovery" Service.
  */
 void
 MyApplication::onTimeToCheckNetwork() {
     networkReadyTimer.stop();
-    if(isConnectedToNetwork()) {
+    // Nothing to do if we are already talking with the Server
+    if(!bWaitingNetwork)
+        return;
+    if(pNetworkMonitor->isNetworkUp()) {
         // Let's start the "Server Discovery Service"
         if(!pServerDiscoverer->Discover()) {
             if(pNoNetWindow == Q_NULLPTR)
@@ -123,11 +177,13 @@ MyApplication::onTimeToCheckNetwork() {
             networkReadyTimer.start(NETWORK_CHECK_TIME);
         }
         else {
+            bWaitingNetwork = false;
+            StartupTrace::mark(logFile, QString("Server discovery started"));
             delete pNoNetWindow;
             pNoNetWindow = Q_NULLPTR;
         }
     }
-    else {// The network connection is down !
+    else {// The network connection is down: wait for the NetworkMonitor
         if(pNoNetWindow == Q_NULLPTR)
             pNoNetWindow = new MessageWindow();
         pNoNetWindow->setDisplayedText(tr("In Attesa della Connessione con la Rete"));
@@ -141,53 +197,101 @@ MyApplication::onTimeToCheckNetwork() {
  * \brief MyApplication::onRecheckNetwork Invoked when the Server disconnect
  *
  * Invoked by the "ServerDiscover" Service if the Server
- * disconnected, in order to restart the periodic check for
- * network interfaces Up and Ready.
+ * disconnected, in order to wait again for network
+ * interfaces Up and Ready.
  */
 void
 MyApplication::onRecheckNetwork() {
+    bWaitingNetwork = true;
     if(pNoNetWindow == Q_NULLPTR)
         pNoNetWindow = new MessageWindow(Q_NULLPTR);
     pNoNetWindow->setDisplayedText(tr("In Attesa della Connessione con la Rete"));
     // No other window should obscure this one
     pNoNetWindow->showFullScreen();
-    networkReadyTimer.start(NETWORK_CHECK_TIME);
+    // If the Network is still Up we retry later, otherwise
+    // we wait for the NetworkMonitor to tell us it is back
+    if(pNetworkMonitor->isNetworkUp())
+        networkReadyTimer.start(NETWORK_CHECK_TIME);
 }
 
 
 /*!
- * \brief MyApplication::isConnectedToNetwork
- * \return true if the Network is Up and Running.
- *
- * It checks if there are network interfaces ready to
- * connect to a server.
+ * \brief MyApplication::parseArguments Read the command line options
  */
-bool
-MyApplication::isConnectedToNetwork() {
-    QList<QNetworkInterface> ifaces = QNetworkInterface::allInterfaces();
-    bool result = false;
-
-    for(int i=0; i<ifaces.count(); i++) {
-        QNetworkInterface iface = ifaces.at(i);
-        if(iface.flags().testFlag(QNetworkInterface::IsUp) &&
-           iface.flags().testFlag(QNetworkInterface::IsRunning) &&
-           iface.flags().testFlag(QNetworkInterface::CanMulticast) &&
-          !iface.flags().testFlag(QNetworkInterface::IsLoopBack))
-        {
-            for(int j=0; j<iface.addressEntries().count(); j++) {
-                // we have an interface that is up, and has an ip address
-                // therefore the link is present
-                if(result == false)
-                    result = true;
-            }
-        }
+void
+MyApplication::parseArguments() {
+    QCommandLineParser parser;
+    QCommandLineOption recordOption("record", "Record the Server messages.", "file");
+    QCommandLineOption replayOption("replay", "Replay a recorded match.", "file");
+    QCommandLineOption speedOption("replay-speed", "max or recorded.", "speed", "recorded");
+    QCommandLineOption panelOption("panel", "volley, basket or handball.", "panel", "volley");
+    QCommandLineOption logOption("log", "Log levels, e.g. all=error,serial=debug.", "levels");
+    QCommandLineOption arduinoOption("arduino", "The Arduino serial port (e.g. the simulator one).", "port");
+    QCommandLineOption pigpiodOption("pigpiod", "The pigpio daemon driving the camera servos.", "host[:port]");
+    QCommandLineOption screensOption("screens", "The number of screens showing the panel (0 for all).", "n");
+    parser.addOption(recordOption);
+    parser.addOption(replayOption);
+    parser.addOption(speedOption);
+    parser.addOption(panelOption);
+    parser.addOption(logOption);
+    parser.addOption(arduinoOption);
+    parser.addOption(pigpiodOption);
+    parser.addOption(screensOption);
+    // Unknown options are simply ignored
+    parser.parse(arguments());
+    // The log levels on the command line override the saved ones
+    QString sLogLevels = pSettings->value("log/levels", QString()).toString();
+    if(parser.isSet(logOption))
+        sLogLevels = parser.value(logOption);
+    if(!setLogLevels(sLogLevels)) {
+        LOG_ERROR(LOG_PANEL,
+                  logFile,
+                  QString("Invalid log levels: %1").arg(sLogLevels));
     }
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               result ? QString("true") : QString("false"));
-#endif
-    return result;
+    sRecordFileName   = parser.value(recordOption);
+    sReplayFileName   = parser.value(replayOption);
+    sReplayPanel      = parser.value(panelOption);
+    bReplayAtMaxSpeed = (parser.value(speedOption) == QString("max"));
+    sArduinoPort      = parser.value(arduinoOption);
+    sPigpiodHost      = parser.value(pigpiodOption);
+    nScreens          = pSettings->value("panel/screens", 1).toInt();
+    if(parser.isSet(screensOption))
+        nScreens = parser.value(screensOption).toInt();
+}
+
+
+/*!
+ * \brief MyApplication::startReplay Show the Panel that will replay the match
+ */
+void
+MyApplication::startReplay() {
+    // An empty Url: the Panel will not try to connect to a Server
+    if(sReplayPanel == QString("basket"))
+        pReplayPanel = new SegnapuntiBasket(QString(), logFile);
+    else if(sReplayPanel == QString("handball"))
+        pReplayPanel = new SegnapuntiHandball(QString(), logFile);
+    else
+        pReplayPanel = new SegnapuntiVolley(QString(), logFile);
+    pReplayPanel->showFullScreen();
+    StartupTrace::mark(logFile, QString("Panel shown"));
+
+    pReplayer = new MessageReplayer(pReplayPanel, logFile, this);
+    connect(pReplayer, SIGNAL(replayDone()),
+            this, SLOT(quit()));
+    QTimer::singleShot(REPLAY_START_DELAY, this, SLOT(onStartReplay()));
+}
+
+
+/*!
+ * \brief MyApplication::onStartReplay Replay the recorded match
+ */
+void
+MyApplication::onStartReplay() {
+    if(!pReplayer->load(sReplayFileName)) {
+        quit();
+        return;
+    }
+    pReplayer->start(bReplayAtMaxSpeed);
 }
 
 
@@ -197,15 +301,25 @@ MyApplication::isConnectedToNetwork() {
  *
  * This function create the file only if enabled at compilation time
  * by defining the macro LOG_MSG.
+ * The previous sessions are kept in "log/generations" older files and
+ * the file is rotated when it grows above "log/maxSize" bytes.
+ * With "log/binary" set the log is written in the compact binary format
+ * (score_panel.bin) to be read with the logdecoder tool.
  */
 bool
 MyApplication::PrepareLogFile() {
 #ifdef LOG_MESG
+    int nGenerations = pSettings->value("log/generations", LOG_GENERATIONS).toInt();
+    qint64 maxSize   = pSettings->value("log/maxSize", LOG_MAX_SIZE).toLongLong();
+    bool bBinary     = pSettings->value("log/binary", false).toBool();
+    if(bBinary)
+        logFileName = QFileInfo(logFileName).path() + QString("/score_panel.bin");
+    AsyncLogger::instance()->setBinary(bBinary);
+    AsyncLogger::instance()->setRotation(maxSize, nGenerations);
+
     QFileInfo checkFile(logFileName);
     if(checkFile.exists() && checkFile.isFile()) {
-        QDir renamed;
-        renamed.remove(logFileName+QString(".bkp"));
-        renamed.rename(logFileName, logFileName+QString(".bkp"));
+        AsyncLogger::rotateFiles(logFileName, nGenerations);
     }
     logFile = new QFile(logFileName);
     if (!logFile->open(QIODevice::WriteOnly)) {
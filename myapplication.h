@@ -27,7 +27,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 QT_FORWARD_DECLARE_CLASS(QSettings)
 QT_FORWARD_DECLARE_CLASS(ServerDiscoverer)
 QT_FORWARD_DECLARE_CLASS(MessageWindow)
+QT_FORWARD_DECLARE_CLASS(NetworkMonitor)
 QT_FORWARD_DECLARE_CLASS(QFile)
+QT_FORWARD_DECLARE_CLASS(ScorePanel)
+QT_FORWARD_DECLARE_CLASS(MessageReplayer)
+QT_FORWARD_DECLARE_CLASS(StallWatchdog)
 
 
 class MyApplication : public QApplication
@@ -40,22 +44,36 @@ public:
 private slots:
     void onTimeToCheckNetwork();
     void onRecheckNetwork();
+    void onStartReplay();
 
 private:
-    bool isConnectedToNetwork();
     bool PrepareLogFile();
+    void parseArguments();
+    void startReplay();
 
 public:
     QTranslator        Translator;
+    QString            sRecordFileName;
+    QString            sArduinoPort;
+    QString            sPigpiodHost;
+    int                nScreens;
+    StallWatchdog     *pStallWatchdog;
 
 private:
     QSettings         *pSettings;
     QFile             *logFile;
     ServerDiscoverer  *pServerDiscoverer;
     MessageWindow     *pNoNetWindow;
+    NetworkMonitor    *pNetworkMonitor;
+    ScorePanel        *pReplayPanel;
+    MessageReplayer   *pReplayer;
+    QString            sReplayFileName;
+    QString            sReplayPanel;
+    bool               bReplayAtMaxSpeed;
     QString            sLanguage;
     QString            logFileName;
     QTimer             networkReadyTimer;
+    bool               bWaitingNetwork;
 };
 
 #endif // MYAPPLICATION_H
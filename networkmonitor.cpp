@@ -0,0 +1,239 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QNetworkInterface>
+#include <QSocketNotifier>
+#include <QFile>
+
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+    // rtnetlink is used to be notified of the network changes
+    #include <sys/socket.h>
+    #include <linux/netlink.h>
+    #include <linux/rtnetlink.h>
+    #include <unistd.h>
+    #include <errno.h>
+    #include <string.h>
+#endif
+
+#include "networkmonitor.h"
+#include "utility.h"
+
+
+#define NETWORK_POLL_TIME 3000 // In msec
+
+
+/*!
+ * \brief NetworkMonitor::NetworkMonitor Watch the network interfaces
+ * \param myLogFile The File for message logging (if any)
+ * \param parent The parent object
+ *
+ * On Linux it subscribes to the rtnetlink link and address events so
+ * that the interfaces are checked only when something changed (and
+ * immediately when an interface gets its address).
+ * Elsewhere, or if the netlink socket can't be opened, it falls back
+ * to periodically polling the interfaces.
+ */
+NetworkMonitor::NetworkMonitor(QFile *myLogFile, QObject *parent)
+    : QObject(parent)
+    , logFile(myLogFile)
+    , netlinkSocket(-1)
+    , pNetlinkNotifier(Q_NULLPTR)
+    , bNetworkUp(false)
+{
+    connect(&pollTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToPoll()));
+}
+
+
+/*!
+ * \brief NetworkMonitor::~NetworkMonitor
+ */
+NetworkMonitor::~NetworkMonitor() {
+    pollTimer.stop();
+    if(pNetlinkNotifier) {
+        pNetlinkNotifier->setEnabled(false);
+        delete pNetlinkNotifier;
+        pNetlinkNotifier = Q_NULLPTR;
+    }
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+    if(netlinkSocket >= 0)
+        ::close(netlinkSocket);
+#endif
+    netlinkSocket = -1;
+}
+
+
+/*!
+ * \brief NetworkMonitor::start Start monitoring the network
+ */
+void
+NetworkMonitor::start() {
+    bNetworkUp = isConnectedToNetwork();
+    if(openNetlinkSocket())
+        return;
+    LOG_INFO(LOG_DISCOVERY,
+             logFile,
+             QString("Polling the network interfaces every %1 ms")
+             .arg(NETWORK_POLL_TIME));
+    pollTimer.start(NETWORK_POLL_TIME);
+}
+
+
+/*!
+ * \brief NetworkMonitor::isNetworkUp
+ * \return true if, at the last check, the network was Up and Running
+ */
+bool
+NetworkMonitor::isNetworkUp() {
+    return bNetworkUp;
+}
+
+
+/*!
+ * \brief NetworkMonitor::isConnectedToNetwork
+ * \return true if the Network is Up and Running.
+ *
+ * It checks if there are network interfaces ready to
+ * connect to a server.
+ */
+bool
+NetworkMonitor::isConnectedToNetwork() {
+    QList<QNetworkInterface> ifaces = QNetworkInterface::allInterfaces();
+    for(int i=0; i<ifaces.count(); i++) {
+        QNetworkInterface iface = ifaces.at(i);
+        if(iface.flags().testFlag(QNetworkInterface::IsUp) &&
+           iface.flags().testFlag(QNetworkInterface::IsRunning) &&
+           iface.flags().testFlag(QNetworkInterface::CanMulticast) &&
+          !iface.flags().testFlag(QNetworkInterface::IsLoopBack))
+        {
+            // we have an interface that is up, and has an ip address
+            // therefore the link is present
+            if(!iface.addressEntries().isEmpty())
+                return true;
+        }
+    }
+    return false;
+}
+
+
+/*!
+ * \brief NetworkMonitor::openNetlinkSocket Subscribe to the rtnetlink events
+ * \return true if the subscription succeeded
+ */
+bool
+NetworkMonitor::openNetlinkSocket() {
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+    netlinkSocket = ::socket(AF_NETLINK, SOCK_RAW|SOCK_NONBLOCK|SOCK_CLOEXEC, NETLINK_ROUTE);
+    if(netlinkSocket < 0) {
+        LOG_ERROR(LOG_DISCOVERY,
+                  logFile,
+                  QString("Unable to open the netlink socket: %1")
+                  .arg(strerror(errno)));
+        return false;
+    }
+    struct sockaddr_nl address;
+    memset(&address, 0, sizeof(address));
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+    if(::bind(netlinkSocket, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) < 0) {
+        LOG_ERROR(LOG_DISCOVERY,
+                  logFile,
+                  QString("Unable to bind the netlink socket: %1")
+                  .arg(strerror(errno)));
+        ::close(netlinkSocket);
+        netlinkSocket = -1;
+        return false;
+    }
+    pNetlinkNotifier = new QSocketNotifier(netlinkSocket, QSocketNotifier::Read, this);
+    connect(pNetlinkNotifier, SIGNAL(activated(int)),
+            this, SLOT(onNetlinkActivated()));
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+/*!
+ * \brief NetworkMonitor::onNetlinkActivated Invoked asynchronously when
+ * the kernel sent some network events
+ *
+ * All the pending events are drained and the interfaces are checked
+ * only once for the whole burst.
+ */
+void
+NetworkMonitor::onNetlinkActivated() {
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+    quint32 buffer[2048];// quint32 to have the nlmsghdr aligned
+    bool bChanged = false;
+    for(;;) {
+        ssize_t received = ::recv(netlinkSocket, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if(received < 0) {
+            // We lost some events: better to check anyway
+            if(errno == ENOBUFS)
+                bChanged = true;
+            break;
+        }
+        if(received == 0)
+            break;
+        int len = int(received);
+        for(struct nlmsghdr *pHeader = reinterpret_cast<struct nlmsghdr *>(buffer);
+            NLMSG_OK(pHeader, len);
+            pHeader = NLMSG_NEXT(pHeader, len))
+        {
+            if(pHeader->nlmsg_type == RTM_NEWADDR ||
+               pHeader->nlmsg_type == RTM_DELADDR ||
+               pHeader->nlmsg_type == RTM_NEWLINK ||
+               pHeader->nlmsg_type == RTM_DELLINK)
+            {
+                bChanged = true;
+            }
+        }
+    }
+    if(bChanged)
+        checkNetwork();
+#endif
+}
+
+
+/*!
+ * \brief NetworkMonitor::onTimeToPoll Periodic check (when netlink is not available)
+ */
+void
+NetworkMonitor::onTimeToPoll() {
+    checkNetwork();
+}
+
+
+/*!
+ * \brief NetworkMonitor::checkNetwork Check the interfaces and signal any change
+ */
+void
+NetworkMonitor::checkNetwork() {
+    bool bUp = isConnectedToNetwork();
+    if(bUp == bNetworkUp)
+        return;
+    bNetworkUp = bUp;
+    LOG_DEBUG(LOG_DISCOVERY,
+              logFile,
+              bNetworkUp ? QString("Network Up") : QString("Network Down"));
+    if(bNetworkUp)
+        emit networkUp();
+    else
+        emit networkDown();
+}
@@ -0,0 +1,61 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef NETWORKMONITOR_H
+#define NETWORKMONITOR_H
+
+#include <QObject>
+#include <QTimer>
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+QT_FORWARD_DECLARE_CLASS(QSocketNotifier)
+
+
+class NetworkMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NetworkMonitor(QFile *myLogFile=Q_NULLPTR, QObject *parent=Q_NULLPTR);
+    ~NetworkMonitor();
+    void start();
+    bool isNetworkUp();
+    static bool isConnectedToNetwork();
+
+signals:
+    void networkUp();  /*!< \brief emitted when an interface becomes ready to reach the Server */
+    void networkDown();/*!< \brief emitted when no more interfaces are ready */
+
+private slots:
+    void onNetlinkActivated();
+    void onTimeToPoll();
+
+private:
+    bool openNetlinkSocket();
+    void checkNetwork();
+
+private:
+    QFile           *logFile;
+    int              netlinkSocket;
+    QSocketNotifier *pNetlinkNotifier;
+    QTimer           pollTimer;
+    bool             bNetworkUp;
+};
+
+#endif // NETWORKMONITOR_H
@@ -68,6 +68,24 @@ SOURCES += serverdiscoverer.cpp
 SOURCES += fileupdater.cpp
 SOURCES += utility.cpp
 SOURCES += timedscorepanel.cpp
+SOURCES += panelconnection.cpp
+SOURCES += networkmonitor.cpp
+SOURCES += messagerecorder.cpp
+SOURCES += messagereplayer.cpp
+SOURCES += asynclogger.cpp
+SOURCES += latencymonitor.cpp
+SOURCES += stallwatchdog.cpp
+SOURCES += statssampler.cpp
+SOURCES += arduinoprober.cpp
+SOURCES += seriallink.cpp
+SOURCES += arduinodecoder.cpp
+SOURCES += devicemonitor.cpp
+SOURCES += settingsstore.cpp
+SOURCES += pantiltcontroller.cpp
+SOURCES += scoredigits.cpp
+SOURCES += panelcompositor.cpp
+SOURCES += startuptrace.cpp
+SOURCES += mediastore.cpp
 contains(QMAKE_HOST.arch, "x86_64") {
     SOURCES += slidewindow.cpp
 }
@@ -86,11 +104,36 @@ HEADERS += fileupdater.h
 HEADERS += utility.h
 HEADERS += timedscorepanel.h
 HEADERS += panelorientation.h
+HEADERS += panelconnection.h
+HEADERS += networkmonitor.h
+HEADERS += messagerecorder.h
+HEADERS += messagereplayer.h
+HEADERS += asynclogger.h
+HEADERS += logformat.h
+HEADERS += latencymonitor.h
+HEADERS += stallwatchdog.h
+HEADERS += statssampler.h
+HEADERS += arduinoprober.h
+HEADERS += seriallink.h
+HEADERS += arduinodecoder.h
+HEADERS += devicemonitor.h
+HEADERS += settingsstore.h
+HEADERS += pantiltcontroller.h
+HEADERS += scoredigits.h
+HEADERS += panelcompositor.h
+HEADERS += startuptrace.h
+HEADERS += mediastore.h
 contains(QMAKE_HOST.arch, "x86_64") {
     HEADERS += slidewindow.h
 }
 
 
+linux:!android {
+    # The stall watchdog backtraces need the symbol names
+    QMAKE_LFLAGS += -rdynamic
+}
+
+
 CONFIG += mobility
 MOBILITY = 
 contains(QMAKE_HOST.arch, "x86_64") {
@@ -103,7 +146,6 @@ contains(QMAKE_HOST.arch, "armv7l") || contains(QMAKE_HOST.arch, "armv6l"): {
     DBUS_INTERFACES += slidewindow.xml
     CONFIG += c++11
     INCLUDEPATH += /usr/local/include
-    LIBS += -L"/usr/local/lib" -lpigpiod_if2 # To include libpigpiod_if2.so from /usr/local/lib
 }
 
 
@@ -0,0 +1,259 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QGridLayout>
+#include <QLabel>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QStyle>
+
+#include "panelcompositor.h"
+#include "scoredigits.h"
+
+
+/*!
+ * \brief PanelCompositor::PanelCompositor A panel drawn into a single backing image
+ * \param parent The parent widget
+ *
+ * The alternative (optional) way of showing the panel fields: instead
+ * of a grid of independent widgets, each one repainting itself, the
+ * fields are rendered (only when changed) into the cells of a single
+ * backing image. Each change marks its cell as dirty and the next
+ * paint pushes only the union of the dirty cells to the screen.
+ * The field widgets are kept (hidden) just as the holders of the
+ * values to show: the panels update them as usual and then ask for
+ * a refresh().
+ * The normal and reflected cells of every field are precomputed:
+ * reflecting the panel is just a matter of choosing the other set.
+ */
+PanelCompositor::PanelCompositor(QWidget *parent)
+    : QWidget(parent)
+    , nRows(1)
+    , nColumns(1)
+    , iSlotMap(0)
+    , bRefreshPending(false)
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+
+/*!
+ * \brief PanelCompositor::~PanelCompositor
+ */
+PanelCompositor::~PanelCompositor() {
+}
+
+
+/*!
+ * \brief PanelCompositor::setFields Take the fields of a panel layout
+ * \param pLayout The panel layout (deleted when done)
+ *
+ * Every widget keeps its grid position and alignment but the grid
+ * has rows and columns of the same size: each field gets a fixed cell.
+ */
+void
+PanelCompositor::setFields(QGridLayout *pLayout) {
+    fields.clear();
+    nRows    = qMax(1, pLayout->rowCount());
+    nColumns = qMax(1, pLayout->columnCount());
+    for(int i=0; i<pLayout->count(); i++) {
+        QLayoutItem* pItem = pLayout->itemAt(i);
+        if(!pItem->widget())
+            continue;
+        field panelField;
+        pLayout->getItemPosition(i, &panelField.row, &panelField.column,
+                                 &panelField.rowSpan, &panelField.columnSpan);
+        panelField.pWidget      = pItem->widget();
+        panelField.alignment[0] = pItem->alignment();
+        // The reflected field is aligned to the other side
+        panelField.alignment[1] = pItem->alignment() & ~(Qt::AlignLeft|Qt::AlignRight);
+        if(pItem->alignment() & Qt::AlignLeft)
+            panelField.alignment[1] |= Qt::AlignRight;
+        if(pItem->alignment() & Qt::AlignRight)
+            panelField.alignment[1] |= Qt::AlignLeft;
+        fields.append(panelField);
+    }
+    delete pLayout;
+    for(int i=0; i<fields.count(); i++) {
+        fields[i].pWidget->setParent(this);
+        fields[i].pWidget->hide();
+    }
+    computeCells();
+}
+
+
+/*!
+ * \brief PanelCompositor::setMirrored Reflect (or not) the panel horizontally
+ * \param bMirrored true to reflect the panel
+ */
+void
+PanelCompositor::setMirrored(bool bMirrored) {
+    int iNewMap = bMirrored ? 1 : 0;
+    if(iNewMap == iSlotMap)
+        return;
+    iSlotMap = iNewMap;
+    renderAll();
+}
+
+
+/*!
+ * \brief PanelCompositor::scheduleRefresh Refresh as soon as the
+ * present event has been handled
+ *
+ * Many fields may change while handling a single Server message:
+ * they are all rendered together.
+ */
+void
+PanelCompositor::scheduleRefresh() {
+    if(bRefreshPending)
+        return;
+    bRefreshPending = true;
+    QMetaObject::invokeMethod(this, "refresh", Qt::QueuedConnection);
+}
+
+
+/*!
+ * \brief PanelCompositor::refresh Render the fields that changed
+ */
+void
+PanelCompositor::refresh() {
+    bRefreshPending = false;
+    if(backingStore.isNull())
+        return;
+    for(int i=0; i<fields.count(); i++) {
+        if(signature(fields[i].pWidget) != fields[i].sSignature) {
+            renderField(fields[i]);
+            update(fields[i].cell[iSlotMap]);// Qt joins the dirty cells in a single paint
+        }
+    }
+}
+
+
+/*!
+ * \brief PanelCompositor::signature What a field shows
+ * \param pWidget The field widget
+ * \return A string that changes when the field has to be rendered again
+ */
+QString
+PanelCompositor::signature(QWidget *pWidget) {
+    // A new palette (new colors) needs a new rendering too
+    QString sPalette = QString::number(pWidget->palette().cacheKey()) + QChar('\n');
+    QLabel* pLabel = qobject_cast<QLabel*>(pWidget);
+    if(pLabel)
+        return sPalette + pLabel->text() + QChar('\n') + pLabel->styleSheet() + QChar('\n') + pLabel->font().toString();
+    ScoreDigits* pDigits = qobject_cast<ScoreDigits*>(pWidget);
+    if(pDigits)
+        return sPalette + QString::number(pDigits->intValue());
+    return sPalette;// Static field
+}
+
+
+/*!
+ * \brief PanelCompositor::computeCells Compute the field cells and render them all
+ */
+void
+PanelCompositor::computeCells() {
+    if(width() <= 0 || height() <= 0)
+        return;
+    if(backingStore.size() != size())
+        backingStore = QImage(size(), QImage::Format_RGB32);
+    for(int i=0; i<fields.count(); i++) {
+        field& panelField = fields[i];
+        int left   = panelField.column*width()/nColumns;
+        int top    = panelField.row*height()/nRows;
+        int right  = (panelField.column+panelField.columnSpan)*width()/nColumns;
+        int bottom = (panelField.row+panelField.rowSpan)*height()/nRows;
+        panelField.cell[0] = QRect(left, top, right-left, bottom-top);
+        panelField.cell[1] = QRect(width()-right, top, right-left, bottom-top);
+    }
+    renderAll();
+}
+
+
+/*!
+ * \brief PanelCompositor::renderAll Render all the fields in their present cells
+ */
+void
+PanelCompositor::renderAll() {
+    if(backingStore.isNull())
+        return;
+    backingStore.fill(palette().color(QPalette::Window));
+    for(int i=0; i<fields.count(); i++)
+        renderField(fields[i]);
+    update();
+}
+
+
+/*!
+ * \brief PanelCompositor::renderField Draw a field into its cell
+ * \param panelField The field to draw
+ */
+void
+PanelCompositor::renderField(field& panelField) {
+    QWidget* pWidget = panelField.pWidget;
+    const QRect& cell = panelField.cell[iSlotMap];
+    Qt::Alignment alignment = panelField.alignment[iSlotMap];
+    QSize fieldSize = cell.size();
+    if(alignment != 0)
+        fieldSize = pWidget->sizeHint().boundedTo(cell.size());
+    if(pWidget->size() != fieldSize)
+        pWidget->resize(fieldSize);
+    QRect area = QStyle::alignedRect(Qt::LeftToRight,
+                                     alignment ? alignment : Qt::AlignCenter,
+                                     fieldSize,
+                                     cell);
+    QPainter painter(&backingStore);
+    painter.fillRect(cell, palette().color(QPalette::Window));
+    painter.end();
+    pWidget->render(&backingStore, area.topLeft(), QRegion(),
+                    QWidget::DrawWindowBackground | QWidget::DrawChildren);
+    panelField.sSignature = signature(pWidget);
+}
+
+
+/*!
+ * \brief PanelCompositor::resizeEvent A new size needs new cells
+ * \param event Unused
+ */
+void
+PanelCompositor::resizeEvent(QResizeEvent *event) {
+    Q_UNUSED(event)
+    computeCells();
+}
+
+
+/*!
+ * \brief PanelCompositor::paintEvent Push the dirty part of the backing image
+ * \param event The area to repaint
+ */
+void
+PanelCompositor::paintEvent(QPaintEvent *event) {
+    QPainter painter(this);
+    if(backingStore.isNull()) {
+        painter.fillRect(event->rect(), palette().color(QPalette::Window));
+        return;
+    }
+    // QRegion is iterable only since Qt 5.8
+#if (QT_VERSION < QT_VERSION_CHECK(5, 8, 0))
+    const QVector<QRect> dirty = event->region().rects();
+#else
+    const QRegion dirty = event->region();
+#endif
+    for(const QRect& rect : dirty)
+        painter.drawImage(rect, backingStore, rect);
+}
@@ -0,0 +1,73 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef PANELCOMPOSITOR_H
+#define PANELCOMPOSITOR_H
+
+#include <QWidget>
+#include <QImage>
+#include <QVector>
+
+
+QT_FORWARD_DECLARE_CLASS(QGridLayout)
+
+
+class PanelCompositor : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit PanelCompositor(QWidget *parent = Q_NULLPTR);
+    ~PanelCompositor();
+    void setFields(QGridLayout *pLayout);
+    void setMirrored(bool bMirrored);
+    void scheduleRefresh();
+
+public slots:
+    void refresh();
+
+protected:
+    void paintEvent(QPaintEvent *event) Q_DECL_OVERRIDE;
+    void resizeEvent(QResizeEvent *event) Q_DECL_OVERRIDE;
+
+private:
+    struct field {
+        QWidget       *pWidget;
+        int            row;
+        int            column;
+        int            rowSpan;
+        int            columnSpan;
+        Qt::Alignment  alignment[2];/*!< Normal and reflected alignment */
+        QRect          cell[2];     /*!< Normal and reflected fixed area of the field */
+        QString        sSignature;  /*!< What was last rendered */
+    };
+    void computeCells();
+    void renderAll();
+    void renderField(field& panelField);
+    static QString signature(QWidget *pWidget);
+
+private:
+    QVector<field>  fields;
+    QImage          backingStore;
+    int             nRows;
+    int             nColumns;
+    int             iSlotMap; /*!< 0 = normal, 1 = reflected */
+    bool            bRefreshPending;
+};
+
+#endif // PANELCOMPOSITOR_H
@@ -0,0 +1,314 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QFile>
+
+#include "panelconnection.h"
+#include "utility.h"
+
+
+#define RECONNECT_MIN_DELAY     500 // In msec
+#define RECONNECT_MAX_DELAY   16000 // In msec
+#define MAX_RECONNECT_ATTEMPTS   10
+
+
+/*!
+ * \brief PanelConnection::PanelConnection The transport between a ScorePanel and its Server
+ * \param myServerUrl The Panel Server URL to connect to
+ * \param myLogFile The File for message logging (if any)
+ * \param parent The parent object
+ *
+ * It owns the WebSocket talking to the Panel Server and, when the
+ * connection drops, it replaces the socket with a new one retrying
+ * with an exponential backoff (with random jitter, to avoid all the
+ * panels of a hall hitting the Server at the same instant).
+ * The ScorePanel keeps talking to the same PanelConnection object
+ * so that it does not need to be rebuilt upon a Server reconnection.
+ * Only when all the attempts failed connectionLost() is emitted.
+ */
+PanelConnection::PanelConnection(const QUrl& myServerUrl, QFile *myLogFile, QObject *parent)
+    : QObject(parent)
+    , logFile(myLogFile)
+    , pSocket(Q_NULLPTR)
+    , serverUrl(myServerUrl)
+    , serverAddress(myServerUrl.host())
+    , iAttempt(0)
+    , bConnected(false)
+    , bClosing(false)
+{
+    reconnectTimer.setSingleShot(true);
+    connect(&reconnectTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToReconnect()));
+}
+
+
+/*!
+ * \brief PanelConnection::~PanelConnection
+ */
+PanelConnection::~PanelConnection() {
+    reconnectTimer.disconnect();
+    reconnectTimer.stop();
+    if(pSocket) {
+        pSocket->disconnect();
+        delete pSocket;
+    }
+    pSocket = Q_NULLPTR;
+}
+
+
+/*!
+ * \brief PanelConnection::open Open the connection with the Panel Server
+ */
+void
+PanelConnection::open() {
+    bClosing = false;
+    iAttempt = 0;
+    createSocket();
+}
+
+
+/*!
+ * \brief PanelConnection::reconnect Drop the present socket and start the
+ * reconnection process (e.g. when the Server stopped answering)
+ */
+void
+PanelConnection::reconnect() {
+    if(bClosing)
+        return;
+    destroySocket();
+    if(bConnected) {
+        bConnected = false;
+        emit disconnected();
+    }
+    if(!reconnectTimer.isActive())
+        scheduleReconnect();
+}
+
+
+/*!
+ * \brief PanelConnection::close Close the connection without reconnecting
+ * \param closeCode The WebSocket close code
+ * \param sReason The reason sent to the Server
+ */
+void
+PanelConnection::close(QWebSocketProtocol::CloseCode closeCode, const QString& sReason) {
+    bClosing = true;
+    reconnectTimer.stop();
+    if(pSocket) {
+        pSocket->disconnect();
+        pSocket->close(closeCode, sReason);
+        pSocket->deleteLater();
+    }
+    pSocket = Q_NULLPTR;
+    bConnected = false;
+}
+
+
+/*!
+ * \brief PanelConnection::sendTextMessage
+ * \param sMessage The message to send
+ * \return The number of characters sent (-1 if there is no connection)
+ */
+qint64
+PanelConnection::sendTextMessage(const QString& sMessage) {
+    if(!pSocket || !bConnected)
+        return -1;
+    return pSocket->sendTextMessage(sMessage);
+}
+
+
+/*!
+ * \brief PanelConnection::isValid
+ * \return true if the connection with the Server is up
+ */
+bool
+PanelConnection::isValid() {
+    return pSocket && bConnected && pSocket->isValid();
+}
+
+
+/*!
+ * \brief PanelConnection::isReconnecting
+ * \return true if a reconnection attempt is pending
+ */
+bool
+PanelConnection::isReconnecting() {
+    return !bConnected && !bClosing;
+}
+
+
+/*!
+ * \brief PanelConnection::peerAddress
+ * \return The Server address (it remains valid during reconnections)
+ */
+QHostAddress
+PanelConnection::peerAddress() {
+    if(pSocket && bConnected)
+        return pSocket->peerAddress();
+    return serverAddress;
+}
+
+
+/*!
+ * \brief PanelConnection::requestUrl
+ * \return The Server URL
+ */
+QUrl
+PanelConnection::requestUrl() {
+    return serverUrl;
+}
+
+
+/*!
+ * \brief PanelConnection::errorString
+ * \return The last socket error (if any)
+ */
+QString
+PanelConnection::errorString() {
+    if(pSocket)
+        return pSocket->errorString();
+    return QString();
+}
+
+
+/*!
+ * \brief PanelConnection::createSocket Utility function to create a new socket
+ * and start the connection process
+ */
+void
+PanelConnection::createSocket() {
+    destroySocket();
+    pSocket = new QWebSocket();
+    connect(pSocket, SIGNAL(connected()),
+            this, SLOT(onSocketConnected()));
+    connect(pSocket, SIGNAL(disconnected()),
+            this, SLOT(onSocketDisconnected()));
+    connect(pSocket, SIGNAL(error(QAbstractSocket::SocketError)),
+            this, SLOT(onSocketError(QAbstractSocket::SocketError)));
+    connect(pSocket, SIGNAL(textMessageReceived(QString)),
+            this, SIGNAL(textMessageReceived(QString)));
+    connect(pSocket, SIGNAL(binaryMessageReceived(QByteArray)),
+            this, SIGNAL(binaryMessageReceived(QByteArray)));
+    // To silent some warnings
+    pSocket->ignoreSslErrors();
+    pSocket->open(serverUrl);
+}
+
+
+/*!
+ * \brief PanelConnection::destroySocket Utility function to get rid of the present socket
+ */
+void
+PanelConnection::destroySocket() {
+    if(pSocket) {
+        pSocket->disconnect();
+        pSocket->abort();
+        // deleteLater() to Allow for the processing of
+        // already queued events.
+        pSocket->deleteLater();
+    }
+    pSocket = Q_NULLPTR;
+}
+
+
+/*!
+ * \brief PanelConnection::scheduleReconnect Schedule the next connection attempt
+ *
+ * The delay doubles at every failed attempt (up to RECONNECT_MAX_DELAY)
+ * and only the upper half of it is randomized.
+ */
+void
+PanelConnection::scheduleReconnect() {
+    if(iAttempt >= MAX_RECONNECT_ATTEMPTS) {
+        LOG_INFO(LOG_PANEL,
+                 logFile,
+                 QString("Giving up after %1 attempts").arg(iAttempt));
+        emit connectionLost();
+        return;
+    }
+    int msecDelay = RECONNECT_MIN_DELAY << qMin(iAttempt, 5);
+    msecDelay = qMin(msecDelay, RECONNECT_MAX_DELAY);
+    msecDelay = msecDelay/2 + qrand()%(msecDelay/2+1);
+    iAttempt++;
+    LOG_DEBUG(LOG_PANEL,
+              logFile,
+              QString("Reconnection attempt %1 in %2 ms")
+              .arg(iAttempt)
+              .arg(msecDelay));
+    reconnectTimer.start(msecDelay);
+    emit reconnecting(iAttempt, msecDelay);
+}
+
+
+/*!
+ * \brief PanelConnection::onTimeToReconnect Time for a new connection attempt
+ */
+void
+PanelConnection::onTimeToReconnect() {
+    if(bClosing)
+        return;
+    createSocket();
+}
+
+
+/*!
+ * \brief PanelConnection::onSocketConnected Invoked asynchronously upon the Server connection
+ */
+void
+PanelConnection::onSocketConnected() {
+    reconnectTimer.stop();
+    if(iAttempt > 0) {
+        LOG_INFO(LOG_PANEL,
+                 logFile,
+                 QString("Reconnected to %1 after %2 attempts")
+                 .arg(serverUrl.toString())
+                 .arg(iAttempt));
+    }
+    iAttempt = 0;
+    bConnected = true;
+    serverAddress = pSocket->peerAddress();
+    emit connected();
+}
+
+
+/*!
+ * \brief PanelConnection::onSocketDisconnected Invoked asynchronously upon the Server disconnection
+ */
+void
+PanelConnection::onSocketDisconnected() {
+    LOG_DEBUG(LOG_PANEL,
+              logFile,
+              QString("Server %1 disconnected").arg(serverUrl.toString()));
+    reconnect();
+}
+
+
+/*!
+ * \brief PanelConnection::onSocketError Invoked asynchronously upon a socket error
+ * \param error The socket error
+ */
+void
+PanelConnection::onSocketError(QAbstractSocket::SocketError error) {
+    LOG_ERROR(LOG_PANEL,
+              logFile,
+              QString("%1 %2 Error %3")
+              .arg(serverUrl.toString())
+              .arg(pSocket ? pSocket->errorString() : QString())
+              .arg(error));
+    reconnect();
+}
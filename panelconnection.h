@@ -0,0 +1,79 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef PANELCONNECTION_H
+#define PANELCONNECTION_H
+
+#include <QObject>
+#include <QUrl>
+#include <QTimer>
+#include <QHostAddress>
+#include <QWebSocket>
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+
+
+class PanelConnection : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PanelConnection(const QUrl& myServerUrl, QFile *myLogFile=Q_NULLPTR, QObject *parent=Q_NULLPTR);
+    ~PanelConnection();
+    void open();
+    void reconnect();
+    void close(QWebSocketProtocol::CloseCode closeCode, const QString& sReason);
+    qint64 sendTextMessage(const QString& sMessage);
+    bool isValid();
+    bool isReconnecting();
+    QHostAddress peerAddress();
+    QUrl requestUrl();
+    QString errorString();
+
+signals:
+    void connected();   /*!< \brief emitted every time the connection with the Server is (re)established */
+    void disconnected();/*!< \brief emitted when the connection with the Server has been lost */
+    void reconnecting(int attempt, int msecDelay);/*!< \brief emitted when a new connection attempt is scheduled */
+    void connectionLost();/*!< \brief emitted when all the reconnection attempts failed */
+    void textMessageReceived(QString sMessage);/*!< \brief a text message arrived from the Server */
+    void binaryMessageReceived(QByteArray baMessage);/*!< \brief a binary message arrived from the Server */
+
+private slots:
+    void onSocketConnected();
+    void onSocketDisconnected();
+    void onSocketError(QAbstractSocket::SocketError error);
+    void onTimeToReconnect();
+
+private:
+    void createSocket();
+    void destroySocket();
+    void scheduleReconnect();
+
+private:
+    QFile        *logFile;
+    QWebSocket   *pSocket;
+    QUrl          serverUrl;
+    QHostAddress  serverAddress;
+    QTimer        reconnectTimer;
+    int           iAttempt;
+    bool          bConnected;
+    bool          bClosing;
+};
+
+#endif // PANELCONNECTION_H
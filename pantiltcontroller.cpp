@@ -0,0 +1,378 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QTcpSocket>
+#include <QtEndian>
+
+#include "pantiltcontroller.h"
+#include "utility.h"
+
+
+// The pigpiod socket commands used (see pigpio.h)
+#define PI_CMD_PFS   7 // Set the PWM frequency
+#define PI_CMD_SERVO 8 // Set the servo pulse width
+
+#define PIGPIOD_MESSAGE_SIZE 16 // cmd, p1, p2, p3 (or result) as 32 bit integers
+
+#define PWM_FREQUENCY      50     // In Hz
+#define PULSE_WIDTH_AT_M90 600.0  // In us
+#define PULSE_WIDTH_AT_P90 2200.0 // In us
+
+
+/*!
+ * \brief PanTiltController::PanTiltController Drive the camera Pan & Tilt servos
+ * \param myHost The host running the pigpio daemon
+ * \param myPort The pigpio daemon port
+ * \param myPanPin The Pan servo GPIO (BCM number)
+ * \param myTiltPin The Tilt servo GPIO (BCM number)
+ * \param myLogFile The File for message logging (if any)
+ *
+ * To be moved to its own thread: the pigpio daemon is spoken to
+ * directly through its socket, without waiting for the answers.
+ * The Server pan and tilt values are just new targets: every
+ * MOTION_STEP_TIME ms the servos are moved toward them at the slew
+ * rate and all the commands of a step are sent in a single write.
+ * While the daemon has not answered the previous step no new
+ * commands are sent, so that they can't pile up.
+ */
+PanTiltController::PanTiltController(QString myHost, quint16 myPort, unsigned myPanPin, unsigned myTiltPin, QFile *myLogFile)
+    : QObject(Q_NULLPTR)
+    , logFile(myLogFile)
+    , sHost(myHost)
+    , port(myPort)
+    , pSocket(Q_NULLPTR)
+    , pStepTimer(Q_NULLPTR)
+    , pReconnectTimer(Q_NULLPTR)
+    , slewRate(DEFAULT_SLEW_RATE)
+    , nPendingReplies(0)
+    , bErrorReported(false)
+    , nBatches(0)
+    , nCommands(0)
+    , nTargets(0)
+{
+    pan.pin      = myPanPin;
+    pan.current  = 0.0;
+    pan.target   = 0.0;
+    pan.bActive  = false;
+    pan.bJump    = true;
+    tilt.pin     = myTiltPin;
+    tilt.current = 0.0;
+    tilt.target  = 0.0;
+    tilt.bActive = false;
+    tilt.bJump   = true;
+}
+
+
+/*!
+ * \brief PanTiltController::~PanTiltController
+ */
+PanTiltController::~PanTiltController() {
+}
+
+
+/*!
+ * \brief PanTiltController::start Executed when the thread starts
+ */
+void
+PanTiltController::start() {
+    pStepTimer = new QTimer(this);
+    connect(pStepTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToStep()));
+    pReconnectTimer = new QTimer(this);
+    pReconnectTimer->setSingleShot(true);
+    connect(pReconnectTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToReconnect()));
+    pSocket = new QTcpSocket(this);
+    pSocket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    connect(pSocket, SIGNAL(connected()),
+            this, SLOT(onConnected()));
+    connect(pSocket, SIGNAL(error(QAbstractSocket::SocketError)),
+            this, SLOT(onSocketError(QAbstractSocket::SocketError)));
+    connect(pSocket, SIGNAL(readyRead()),
+            this, SLOT(onReplyAvailable()));
+    pSocket->connectToHost(sHost, port);
+}
+
+
+/*!
+ * \brief PanTiltController::stop Stop the servos PWM and close the connection
+ */
+void
+PanTiltController::stop() {
+    if(pStepTimer)
+        pStepTimer->stop();
+    if(pReconnectTimer)
+        pReconnectTimer->stop();
+    if(!pSocket)
+        return;
+    pSocket->disconnect(this);
+    if(pSocket->state() == QAbstractSocket::ConnectedState) {
+        if(pan.bActive)
+            appendCommand(PI_CMD_PFS, pan.pin, 0);
+        if(tilt.bActive)
+            appendCommand(PI_CMD_PFS, tilt.pin, 0);
+        sendBatch();
+        pSocket->waitForBytesWritten(500);
+    }
+    pSocket->abort();
+    LOG_DEBUG(LOG_PANEL,
+              logFile,
+              QString("Camera: %1 targets, %2 batches, %3 commands")
+              .arg(nTargets)
+              .arg(nBatches)
+              .arg(nCommands));
+}
+
+
+/*!
+ * \brief PanTiltController::setPosition Move the camera without interpolation
+ * \param panAngle The Pan angle (degrees)
+ * \param tiltAngle The Tilt angle (degrees)
+ *
+ * To be used when the present servo position is unknown (i.e. at startup).
+ */
+void
+PanTiltController::setPosition(double panAngle, double tiltAngle) {
+    pan.target  = qBound(-90.0, panAngle, 90.0);
+    pan.bJump   = true;
+    tilt.target = qBound(-90.0, tiltAngle, 90.0);
+    tilt.bJump  = true;
+    startMotion();
+}
+
+
+/*!
+ * \brief PanTiltController::setPanTarget A new Pan angle to reach
+ * \param panAngle The Pan angle (degrees)
+ */
+void
+PanTiltController::setPanTarget(double panAngle) {
+    nTargets++;
+    pan.target = qBound(-90.0, panAngle, 90.0);
+    startMotion();
+}
+
+
+/*!
+ * \brief PanTiltController::setTiltTarget A new Tilt angle to reach
+ * \param tiltAngle The Tilt angle (degrees)
+ */
+void
+PanTiltController::setTiltTarget(double tiltAngle) {
+    nTargets++;
+    tilt.target = qBound(-90.0, tiltAngle, 90.0);
+    startMotion();
+}
+
+
+/*!
+ * \brief PanTiltController::setSlewRate
+ * \param degreesPerSecond The max servo speed
+ */
+void
+PanTiltController::setSlewRate(double degreesPerSecond) {
+    if(degreesPerSecond > 0.0)
+        slewRate = degreesPerSecond;
+}
+
+
+/*!
+ * \brief PanTiltController::startMotion Start stepping toward the targets (if not yet)
+ */
+void
+PanTiltController::startMotion() {
+    if(!pStepTimer || pStepTimer->isActive())
+        return;
+    if(!pSocket || (pSocket->state() != QAbstractSocket::ConnectedState))
+        return;// The targets will be reached when connected
+    stepClock.restart();
+    pStepTimer->start(MOTION_STEP_TIME);
+}
+
+
+/*!
+ * \brief PanTiltController::onTimeToStep Move the servos one step toward their targets
+ */
+void
+PanTiltController::onTimeToStep() {
+    // The daemon is still busy with the previous step:
+    // the next one will be longer (but not too long)
+    if(nPendingReplies > 0)
+        return;
+    qint64 elapsed = qMin(stepClock.restart(), qint64(4*MOTION_STEP_TIME));
+    double maxStep = slewRate*double(elapsed)/1000.0;
+    bool bPanMoving  = stepAxis(pan, maxStep);
+    bool bTiltMoving = stepAxis(tilt, maxStep);
+    sendBatch();
+    if(!bPanMoving && !bTiltMoving)
+        pStepTimer->stop();
+}
+
+
+/*!
+ * \brief PanTiltController::stepAxis Prepare the commands for moving a servo
+ * \param servo The servo to move
+ * \param maxStep The max angle change allowed (degrees)
+ * \return true if the servo has not yet reached its target
+ */
+bool
+PanTiltController::stepAxis(axis& servo, double maxStep) {
+    if(!servo.bJump && !servo.bActive && (servo.current == servo.target))
+        return false;
+    if(!servo.bActive) {
+        appendCommand(PI_CMD_PFS, servo.pin, PWM_FREQUENCY);
+        servo.bActive = true;
+    }
+    double delta = servo.target - servo.current;
+    if(servo.bJump || (qAbs(delta) <= maxStep))
+        servo.current = servo.target;
+    else
+        servo.current += (delta > 0.0) ? maxStep : -maxStep;
+    servo.bJump = false;
+    appendCommand(PI_CMD_SERVO, servo.pin, pulseWidth(servo.current));
+    if(servo.current == servo.target) {
+        appendCommand(PI_CMD_PFS, servo.pin, 0);
+        servo.bActive = false;
+        return false;
+    }
+    return true;
+}
+
+
+/*!
+ * \brief PanTiltController::pulseWidth
+ * \param angle The servo angle (degrees)
+ * \return The corresponding pulse width (us)
+ */
+quint32
+PanTiltController::pulseWidth(double angle) {
+    return quint32(PULSE_WIDTH_AT_M90 + (PULSE_WIDTH_AT_P90-PULSE_WIDTH_AT_M90)/180.0*(angle+90.0));
+}
+
+
+/*!
+ * \brief PanTiltController::appendCommand Queue a command for the next batch
+ * \param command The pigpiod command code
+ * \param p1 The first parameter
+ * \param p2 The second parameter
+ */
+void
+PanTiltController::appendCommand(quint32 command, quint32 p1, quint32 p2) {
+    quint32 message[4];
+    message[0] = qToLittleEndian(command);
+    message[1] = qToLittleEndian(p1);
+    message[2] = qToLittleEndian(p2);
+    message[3] = 0;// No extension
+    batch.append(reinterpret_cast<const char*>(message), PIGPIOD_MESSAGE_SIZE);
+}
+
+
+/*!
+ * \brief PanTiltController::sendBatch Send all the queued commands at once
+ */
+void
+PanTiltController::sendBatch() {
+    if(batch.isEmpty())
+        return;
+    if(!pSocket || (pSocket->state() != QAbstractSocket::ConnectedState)) {
+        batch.clear();
+        return;
+    }
+    int nMessages = batch.size()/PIGPIOD_MESSAGE_SIZE;
+    pSocket->write(batch);
+    batch.clear();
+    nPendingReplies += nMessages;
+    nCommands += nMessages;
+    nBatches++;
+}
+
+
+/*!
+ * \brief PanTiltController::onReplyAvailable Check the pigpiod answers
+ */
+void
+PanTiltController::onReplyAvailable() {
+    replies.append(pSocket->readAll());
+    while(replies.size() >= PIGPIOD_MESSAGE_SIZE) {
+        const uchar* pReply = reinterpret_cast<const uchar*>(replies.constData());
+        quint32 command = qFromLittleEndian<quint32>(pReply);
+        qint32  result  = qFromLittleEndian<qint32>(pReply+12);
+        if(result < 0) {
+            LOG_ERROR(LOG_PANEL,
+                      logFile,
+                      QString("pigpiod command %1 failed (%2)")
+                      .arg(command)
+                      .arg(result));
+        }
+        replies.remove(0, PIGPIOD_MESSAGE_SIZE);
+        if(nPendingReplies > 0)
+            nPendingReplies--;
+    }
+}
+
+
+/*!
+ * \brief PanTiltController::onConnected Connected to the pigpio daemon
+ *
+ * The servo positions are unknown: move them to the targets at once.
+ */
+void
+PanTiltController::onConnected() {
+    LOG_DEBUG(LOG_PANEL,
+              logFile,
+              QString("Connected to pigpiod at %1:%2")
+              .arg(sHost)
+              .arg(port));
+    bErrorReported  = false;
+    nPendingReplies = 0;
+    replies.clear();
+    pan.bActive  = false;
+    pan.bJump    = true;
+    tilt.bActive = false;
+    tilt.bJump   = true;
+    startMotion();
+}
+
+
+/*!
+ * \brief PanTiltController::onSocketError The pigpio daemon is not reachable
+ * \param error Unused
+ */
+void
+PanTiltController::onSocketError(QAbstractSocket::SocketError error) {
+    Q_UNUSED(error)
+    if(!bErrorReported) {
+        LOG_ERROR(LOG_PANEL,
+                  logFile,
+                  QString("Non riesco ad inizializzare la GPIO: %1")
+                  .arg(pSocket->errorString()));
+        bErrorReported = true;
+    }
+    pStepTimer->stop();
+    pSocket->abort();
+    pReconnectTimer->start(PIGPIOD_RETRY_TIME);
+}
+
+
+/*!
+ * \brief PanTiltController::onTimeToReconnect Try again to reach the pigpio daemon
+ */
+void
+PanTiltController::onTimeToReconnect() {
+    pSocket->connectToHost(sHost, port);
+}
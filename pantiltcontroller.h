@@ -0,0 +1,96 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef PANTILTCONTROLLER_H
+#define PANTILTCONTROLLER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QAbstractSocket>
+#include <QByteArray>
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+QT_FORWARD_DECLARE_CLASS(QTcpSocket)
+
+
+#define PIGPIOD_PORT       8888  // The pigpio daemon socket port
+#define PIGPIOD_RETRY_TIME 5000  // In msec
+#define MOTION_STEP_TIME   20    // In msec (servo position update period)
+#define DEFAULT_SLEW_RATE  90.0  // In degrees per second
+
+
+class PanTiltController : public QObject
+{
+    Q_OBJECT
+
+public:
+    PanTiltController(QString myHost, quint16 myPort, unsigned myPanPin, unsigned myTiltPin, QFile *myLogFile=Q_NULLPTR);
+    ~PanTiltController();
+
+public slots:
+    void start();
+    void stop();
+    void setPosition(double panAngle, double tiltAngle);
+    void setPanTarget(double panAngle);
+    void setTiltTarget(double tiltAngle);
+    void setSlewRate(double degreesPerSecond);
+
+private slots:
+    void onConnected();
+    void onSocketError(QAbstractSocket::SocketError error);
+    void onReplyAvailable();
+    void onTimeToStep();
+    void onTimeToReconnect();
+
+private:
+    struct axis {
+        unsigned pin;
+        double   current;
+        double   target;
+        bool     bActive; /*!< true while the PWM is running */
+        bool     bJump;   /*!< true to move without interpolation */
+    };
+    void startMotion();
+    bool stepAxis(axis& servo, double maxStep);
+    void appendCommand(quint32 command, quint32 p1, quint32 p2);
+    void sendBatch();
+    quint32 pulseWidth(double angle);
+
+private:
+    QFile         *logFile;
+    QString        sHost;
+    quint16        port;
+    QTcpSocket    *pSocket;
+    QTimer        *pStepTimer;
+    QTimer        *pReconnectTimer;
+    QElapsedTimer  stepClock;
+    axis           pan;
+    axis           tilt;
+    double         slewRate;
+    QByteArray     batch;
+    QByteArray     replies;
+    int            nPendingReplies;
+    bool           bErrorReported;
+    int            nBatches;
+    int            nCommands;
+    int            nTargets;
+};
+
+#endif // PANTILTCONTROLLER_H
@@ -0,0 +1,335 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QPainter>
+#include <QPaintEvent>
+#include <QPolygon>
+#include <QHash>
+
+#include "scoredigits.h"
+
+
+#define BLANK_GLYPH  10
+#define MINUS_GLYPH  11
+#define N_GLYPHS     12
+#define MAX_ATLASES  32 // Cached atlases (all the panel digit sizes)
+
+
+// The segments of each glyph: bit 0 = a (top) ... bit 6 = g (middle)
+static const quint8 glyphSegments[N_GLYPHS] = {
+    0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F, // 0-9
+    0x00,                                                       // blank
+    0x40                                                        // minus
+};
+
+// The glyph atlases shared by all the widgets with the same geometry and colors
+static QHash<QString, QPixmap> atlasCache;
+static int nAtlasRendered = 0;
+
+
+/*!
+ * \brief ScoreDigits::ScoreDigits A seven segments number display
+ * \param nDigits The number of digits
+ * \param parent The parent widget
+ *
+ * It looks like a QLCDNumber (and has the same geometry) but the
+ * segments are drawn only once per size, palette and style into an
+ * atlas of the 0-9 glyphs: a repaint is just a blit of the digits that
+ * changed. The atlases are shared among all the widgets having the
+ * same digit size.
+ */
+ScoreDigits::ScoreDigits(int nDigits, QWidget *parent)
+    : QFrame(parent)
+    , nDigits(qMax(1, nDigits))
+    , value(0)
+    , style(Outline)
+    , segLen(0)
+    , xAdvance(0)
+    , xOffset(0)
+    , yOffset(0)
+{
+    sDigits = QString(this->nDigits, QChar(' '));
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+
+/*!
+ * \brief ScoreDigits::~ScoreDigits
+ */
+ScoreDigits::~ScoreDigits() {
+}
+
+
+/*!
+ * \brief ScoreDigits::setSegmentStyle
+ * \param newStyle Outline or Filled segments
+ */
+void
+ScoreDigits::setSegmentStyle(SegmentStyle newStyle) {
+    if(newStyle == style)
+        return;
+    style = newStyle;
+    updateGeometryCache();
+}
+
+
+/*!
+ * \brief ScoreDigits::intValue
+ * \return The value displayed
+ */
+int
+ScoreDigits::intValue() const {
+    return value;
+}
+
+
+/*!
+ * \brief ScoreDigits::sizeHint
+ * \return The same size hint of a QLCDNumber
+ */
+QSize
+ScoreDigits::sizeHint() const {
+    return QSize(10 + 9*(nDigits-1), 23);
+}
+
+
+/*!
+ * \brief ScoreDigits::atlasCount
+ * \return The number of glyph atlases rendered so far
+ */
+int
+ScoreDigits::atlasCount() {
+    return nAtlasRendered;
+}
+
+
+/*!
+ * \brief ScoreDigits::display Show a new value
+ * \param iValue The value to show (ignored if it does not fit)
+ *
+ * Only the digits that changed are repainted.
+ */
+void
+ScoreDigits::display(int iValue) {
+    QString sNew = QString::number(iValue);
+    if(sNew.length() > nDigits)
+        return;// Overflow: like QLCDNumber, leave the display as it is
+    value = iValue;
+    sNew = sNew.rightJustified(nDigits, QChar(' '));
+    for(int i=0; i<nDigits; i++) {
+        if(sNew.at(i) != sDigits.at(i))
+            update(digitRect(i));
+    }
+    sDigits = sNew;
+}
+
+
+/*!
+ * \brief ScoreDigits::resizeEvent A new size needs new glyphs
+ * \param event
+ */
+void
+ScoreDigits::resizeEvent(QResizeEvent *event) {
+    QFrame::resizeEvent(event);
+    updateGeometryCache();
+}
+
+
+/*!
+ * \brief ScoreDigits::changeEvent A new palette needs new glyphs
+ * \param event
+ */
+void
+ScoreDigits::changeEvent(QEvent *event) {
+    QFrame::changeEvent(event);
+    if(event->type() == QEvent::PaletteChange)
+        updateGeometryCache();
+}
+
+
+/*!
+ * \brief ScoreDigits::updateGeometryCache Compute the digits geometry
+ * (as QLCDNumber does) and get the corresponding glyph atlas
+ */
+void
+ScoreDigits::updateGeometryCache() {
+    QRect contents = contentsRect();
+    int xSegLen = contents.width()*5/(nDigits*(5+1)+1);
+    int ySegLen = contents.height()*5/12;
+    segLen   = qMax(0, qMin(xSegLen, ySegLen));
+    xAdvance = segLen*(5+1)/5;
+    xOffset  = (contents.width() - nDigits*xAdvance + segLen/5)/2;
+    yOffset  = (contents.height() - segLen*2)/2;
+    if((xAdvance <= 0) || (contents.height() <= 0)) {
+        atlas = QPixmap();
+        sAtlasKey.clear();
+        return;
+    }
+    QString sKey = QString("%1:%2:%3:%4:%5:%6")
+                   .arg(segLen)
+                   .arg(contents.height())
+                   .arg(yOffset)
+                   .arg(palette().color(foregroundRole()).rgba())
+                   .arg(palette().color(backgroundRole()).rgba())
+                   .arg(int(style));
+    if(sKey != sAtlasKey) {
+        sAtlasKey = sKey;
+        QHash<QString, QPixmap>::const_iterator it = atlasCache.constFind(sKey);
+        if(it != atlasCache.constEnd()) {
+            atlas = it.value();
+        }
+        else {
+            atlas = renderAtlas();
+            if(atlasCache.count() >= MAX_ATLASES)
+                atlasCache.clear();// The widgets keep their own copy
+            atlasCache.insert(sKey, atlas);
+        }
+    }
+    update();
+}
+
+
+/*!
+ * \brief ScoreDigits::digitRect
+ * \param iDigit The digit position (0 is the leftmost)
+ * \return The area covered by the digit
+ */
+QRect
+ScoreDigits::digitRect(int iDigit) const {
+    QRect contents = contentsRect();
+    return QRect(contents.left()+xOffset+iDigit*xAdvance,
+                 contents.top(),
+                 xAdvance,
+                 contents.height());
+}
+
+
+/*!
+ * \brief ScoreDigits::renderAtlas Draw all the glyphs, side by side
+ * \return The glyph atlas
+ */
+QPixmap
+ScoreDigits::renderAtlas() const {
+    QPixmap newAtlas(N_GLYPHS*xAdvance, contentsRect().height());
+    newAtlas.fill(palette().color(backgroundRole()));
+    QPainter painter(&newAtlas);
+    painter.setRenderHint(QPainter::Antialiasing);
+    QColor foreground = palette().color(foregroundRole());
+    if(style == Filled) {
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(foreground);
+    }
+    else {
+        painter.setPen(QPen(foreground, 1));
+        painter.setBrush(Qt::NoBrush);
+    }
+    int halfWidth = qMax(1, segLen/10);
+    for(int i=0; i<N_GLYPHS; i++)
+        drawGlyph(&painter, i, i*xAdvance+halfWidth, yOffset, segLen);
+    nAtlasRendered++;
+    return newAtlas;
+}
+
+
+/*!
+ * \brief ScoreDigits::drawGlyph Draw the segments of a glyph
+ * \param painter The painter to use
+ * \param iGlyph The glyph (0-9, blank or minus)
+ * \param x The left of the glyph
+ * \param y The top of the glyph
+ * \param segLen The segment length
+ */
+void
+ScoreDigits::drawGlyph(QPainter *painter, int iGlyph, int x, int y, int segLen) {
+    int h   = qMax(1, segLen/10);// Half of the segment width
+    int gap = qMax(1, segLen/25);
+    // The segment end points (a, b, c, d, e, f, g)
+    const QPoint from[7] = {
+        QPoint(x,        y),          QPoint(x+segLen, y),
+        QPoint(x+segLen, y+segLen),   QPoint(x,        y+2*segLen),
+        QPoint(x,        y+segLen),   QPoint(x,        y),
+        QPoint(x,        y+segLen)
+    };
+    const QPoint to[7] = {
+        QPoint(x+segLen, y),          QPoint(x+segLen, y+segLen),
+        QPoint(x+segLen, y+2*segLen), QPoint(x+segLen, y+2*segLen),
+        QPoint(x,        y+2*segLen), QPoint(x,        y+segLen),
+        QPoint(x+segLen, y+segLen)
+    };
+    quint8 segments = glyphSegments[iGlyph];
+    for(int iSeg=0; iSeg<7; iSeg++) {
+        if(!(segments & (1 << iSeg)))
+            continue;
+        QPolygon segment;
+        if(from[iSeg].y() == to[iSeg].y()) {// Horizontal
+            int x0 = from[iSeg].x()+gap;
+            int x1 = to[iSeg].x()-gap;
+            int yc = from[iSeg].y();
+            segment << QPoint(x0, yc)   << QPoint(x0+h, yc-h)
+                    << QPoint(x1-h, yc-h) << QPoint(x1, yc)
+                    << QPoint(x1-h, yc+h) << QPoint(x0+h, yc+h);
+        }
+        else {// Vertical
+            int y0 = from[iSeg].y()+gap;
+            int y1 = to[iSeg].y()-gap;
+            int xc = from[iSeg].x();
+            segment << QPoint(xc, y0)   << QPoint(xc+h, y0+h)
+                    << QPoint(xc+h, y1-h) << QPoint(xc, y1)
+                    << QPoint(xc-h, y1-h) << QPoint(xc-h, y0+h);
+        }
+        painter->drawPolygon(segment);
+    }
+}
+
+
+/*!
+ * \brief ScoreDigits::paintEvent Blit the glyphs of the digits to repaint
+ * \param event The area to repaint
+ */
+void
+ScoreDigits::paintEvent(QPaintEvent *event) {
+    QPainter painter(this);
+    QRect contents = contentsRect();
+    QColor background = palette().color(backgroundRole());
+    // The margins around the digits
+    QRect digits(contents.left()+xOffset, contents.top(), nDigits*xAdvance, contents.height());
+    QRect left(contents.left(), contents.top(), qMax(0, xOffset), contents.height());
+    QRect right(digits.right()+1, contents.top(), qMax(0, contents.right()-digits.right()), contents.height());
+    if(left.intersects(event->rect()))
+        painter.fillRect(left & event->rect(), background);
+    if(right.intersects(event->rect()))
+        painter.fillRect(right & event->rect(), background);
+    if(atlas.isNull()) {
+        painter.fillRect(digits & event->rect(), background);
+    }
+    else {
+        for(int i=0; i<nDigits; i++) {
+            QRect cell = digitRect(i);
+            if(!cell.intersects(event->rect()))
+                continue;
+            QChar digit = sDigits.at(i);
+            int iGlyph = BLANK_GLYPH;
+            if(digit.isDigit())
+                iGlyph = digit.digitValue();
+            else if(digit == QChar('-'))
+                iGlyph = MINUS_GLYPH;
+            painter.drawPixmap(cell.topLeft(), atlas, QRect(iGlyph*xAdvance, 0, xAdvance, cell.height()));
+        }
+    }
+    drawFrame(&painter);
+}
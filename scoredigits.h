@@ -0,0 +1,70 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef SCOREDIGITS_H
+#define SCOREDIGITS_H
+
+#include <QFrame>
+#include <QPixmap>
+#include <QString>
+
+
+class ScoreDigits : public QFrame
+{
+    Q_OBJECT
+
+public:
+    enum SegmentStyle {
+        Outline,/*!< As QLCDNumber::Outline */
+        Filled  /*!< As QLCDNumber::Filled */
+    };
+    explicit ScoreDigits(int nDigits, QWidget *parent = Q_NULLPTR);
+    ~ScoreDigits();
+    void setSegmentStyle(SegmentStyle newStyle);
+    int intValue() const;
+    QSize sizeHint() const Q_DECL_OVERRIDE;
+    static int atlasCount();
+
+public slots:
+    void display(int iValue);
+
+protected:
+    void paintEvent(QPaintEvent *event) Q_DECL_OVERRIDE;
+    void resizeEvent(QResizeEvent *event) Q_DECL_OVERRIDE;
+    void changeEvent(QEvent *event) Q_DECL_OVERRIDE;
+
+private:
+    void updateGeometryCache();
+    QRect digitRect(int iDigit) const;
+    QPixmap renderAtlas() const;
+    static void drawGlyph(QPainter *painter, int iGlyph, int x, int y, int segLen);
+
+private:
+    int           nDigits;
+    int           value;
+    QString       sDigits;  /*!< The digits shown, right aligned (' ' for blanks) */
+    SegmentStyle  style;
+    int           segLen;   /*!< The segment length (as in QLCDNumber) */
+    int           xAdvance; /*!< The digit pitch */
+    int           xOffset;
+    int           yOffset;
+    QString       sAtlasKey;
+    QPixmap       atlas;    /*!< The 0-9 and blank glyphs, side by side */
+};
+
+#endif // SCOREDIGITS_H
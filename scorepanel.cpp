@@ -27,11 +27,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QDebug>
 
 
-#if defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
-    // The libraries for using GPIO pins on Raspberry
-    #include "pigpiod_if2.h"
-#endif
-
 #if defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
     #include "slidewindow_interface.h"
 #else
@@ -43,6 +38,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "utility.h"
 #include "panelorientation.h"
 #include "myapplication.h"
+#include "messagerecorder.h"
+#include "stallwatchdog.h"
+#include "statssampler.h"
+#include "settingsstore.h"
+#include "pantiltcontroller.h"
+#include "panelcompositor.h"
+#include "startuptrace.h"
 
 
 /*! \todo Do we have to send the port numbers to use with
@@ -50,6 +52,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #define SPOT_UPDATE_PORT      45455
 #define SLIDE_UPDATE_PORT     45456
+#define LATENCY_OVERLAY_TIME  1000 // In msec
+#define SERVICES_START_DELAY  5000 // In msec (max wait for the first score)
+#define FIRST_FONT_SIZE         12
+#define MEDIA_STORE_DIR       "/var/tmp/panelChooser/"
 
 #define PAN_PIN  14 // GPIO Numbers are Broadcom (BCM) numbers
 #define TILT_PIN 26 // GPIO Numbers are Broadcom (BCM) numbers
@@ -74,8 +80,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
  * \param serverUrl The Panel Server URL to connect to
  * \param myLogFile The File for message logging (if any)
  * \param parent The parent Widget pointer
+ * \param pPrimary The primary panel (only for the secondary panels)
+ *
+ * A secondary panel is fed by the primary one: it has no Server
+ * connection, settings or latency accounting of its own.
  */
-ScorePanel::ScorePanel(const QString &serverUrl, QFile *myLogFile, QWidget *parent)
+ScorePanel::ScorePanel(const QString &serverUrl, QFile *myLogFile, QWidget *parent, ScorePanel *pPrimary)
     : QWidget(parent)
     , isMirrored(false)
     , isScoreOnly(false)
@@ -86,27 +96,45 @@ ScorePanel::ScorePanel(const QString &serverUrl, QFile *myLogFile, QWidget *pare
     , cameraPlayer(Q_NULLPTR)
     , panPin(PAN_PIN)  // BCM14 is Pin  8 in the 40 pin GPIO connector.
     , tiltPin(TILT_PIN)// BCM26 IS Pin 37 in the 40 pin GPIO connector.
-    , gpioHostHandle(-1)
+    , pCameraThread(Q_NULLPTR)
+    , pCameraController(Q_NULLPTR)
+    , pStatsThread(Q_NULLPTR)
+    , pStatsSampler(Q_NULLPTR)
+    , bServicesStarted(false)
+    , pPrimaryPanel(pPrimary)
+    , bHasServer(!serverUrl.isEmpty() && !pPrimary)
 {
     iCurrentSpot  = 0;
     iCurrentSlide = 0;
 
     pMySlideWindow = Q_NULLPTR;
 
-    pPanel = new QWidget(this);
+    pPanel      = new QWidget(this);
+    pCompositor = Q_NULLPTR;
+    pPanelGrid  = Q_NULLPTR;
+    bGridMirrored = false;
+
+    // A small label shown, on top of the panel, while
+    // we are trying to reconnect to the Panel Server
+    pReconnectionLabel = new QLabel(this);
+    pReconnectionLabel->setStyleSheet("background:black;color:red;");
+    pReconnectionLabel->setFont(QFont("Arial", 16, QFont::Black));
+    pReconnectionLabel->setText(tr(" Riconnessione al Server... "));
+    pReconnectionLabel->adjustSize();
+    pReconnectionLabel->hide();
+
+    // The latency debug overlay (toggled with the 'L' key)
+    pLatencyLabel = new QLabel(this);
+    pLatencyLabel->setStyleSheet("background:black;color:yellow;");
+    pLatencyLabel->setFont(QFont("Courier", 12, QFont::Bold));
+    pLatencyLabel->hide();
+    connect(&latencyOverlayTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToUpdateLatencyOverlay()));
 
     // Turns off the default window title hints.
     // We don't want windows decorations
     setWindowFlags(Qt::CustomizeWindowHint);
 
-    pSettings = new QSettings("Gabriele Salvato", "Score Panel");
-#if defined(Q_OS_ANDROID)
-    setScoreOnly(true);
-#else
-    isScoreOnly = pSettings->value("panel/scoreOnly",  false).toBool();
-#endif
-    isMirrored  = pSettings->value("panel/orientation",  false).toBool();
-
     QString sBaseDir;
 #ifdef Q_OS_ANDROID
     sBaseDir = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
@@ -133,10 +161,190 @@ ScorePanel::ScorePanel(const QString &serverUrl, QFile *myLogFile, QWidget *pare
             this, SLOT(onCreateSlideUpdaterThread()));
     sSlideDir= QString("%1slides/").arg(sBaseDir);
 
-    // Camera management
+    if(pPrimaryPanel) {
+        // Nothing else is needed to show the primary panel score
+        pSettings       = Q_NULLPTR;
+        pLatencyMonitor = Q_NULLPTR;
+        bUseCompositor  = pPrimaryPanel->bUseCompositor;
+        return;
+    }
+
+    // The settings changed by the Server are written in batches
+    pSettings = new SettingsStore("Gabriele Salvato", "Score Panel", logFile);
+    // Whatever the way out, the pending changes are not lost
+    connect(qApp, SIGNAL(aboutToQuit()),
+            pSettings, SLOT(flush()));
+#if defined(Q_OS_ANDROID)
+    setScoreOnly(true);
+#else
+    isScoreOnly = pSettings->value("panel/scoreOnly",  false).toBool();
+#endif
+    isMirrored  = pSettings->value("panel/orientation",  false).toBool();
+    // Optionally the panel fields are drawn into a single image
+    bUseCompositor = pSettings->value("panel/compositor", false).toBool();
+
+    // The Spots and the Slides are shared with the other Panels
+    // of the host through a common media store (if any)
+#ifdef Q_OS_ANDROID
+    sMediaStoreDir = pSettings->value("media/store", QString()).toString();
+#else
+    sMediaStoreDir = pSettings->value("media/store", QString(MEDIA_STORE_DIR)).toString();
+#endif
+
+    // Get the initial camera position from the past stored values
+    cameraPanAngle  = pSettings->value("camera/panAngle",  0.0).toDouble();
+    cameraTiltAngle = pSettings->value("camera/tiltAngle", 0.0).toDouble();
+
+    // Camera, Slides, Spots and Stats are not needed to show the
+    // score: they are started when the first score has been shown
+    // (or, without a Server, after a while)
+    servicesTimer.setSingleShot(true);
+    connect(&servicesTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToStartServices()));
+    servicesTimer.start(SERVICES_START_DELAY);
+
+    // We are ready to connect to the remote Panel Server.
+    // The connection survives to the Server disconnections
+    // so that the Panel has not to be rebuilt each time.
+    pPanelServerSocket = new PanelConnection(QUrl(serverUrl), logFile);
+
+    connect(pPanelServerSocket, SIGNAL(connected()),
+            this, SLOT(onPanelServerConnected()));
+    connect(pPanelServerSocket, SIGNAL(disconnected()),
+            this, SLOT(onPanelServerDisconnected()));
+    connect(pPanelServerSocket, SIGNAL(reconnecting(int, int)),
+            this, SLOT(onPanelServerReconnecting(int, int)));
+    connect(pPanelServerSocket, SIGNAL(connectionLost()),
+            this, SLOT(onPanelServerLost()));
+
+    // The latency monitor must see the messages before the Panel slots
+    pLatencyMonitor = new LatencyMonitor(this);
+    connect(pPanelServerSocket, SIGNAL(textMessageReceived(QString)),
+            pLatencyMonitor, SLOT(onTextMessageReceived(QString)));
+
+    // If requested, capture the Server messages for a later replay.
+    // The recorder is connected before the Panel slots so that
+    // it sees the messages first (only the panels with a Server
+    // connection: the secondary ones are fed by the primary).
+    MyApplication* application = static_cast<MyApplication *>(QApplication::instance());
+    if(!application->sRecordFileName.isEmpty() && !serverUrl.isEmpty()) {
+        MessageRecorder* pRecorder = new MessageRecorder(application->sRecordFileName, logFile, this);
+        connect(pPanelServerSocket, SIGNAL(textMessageReceived(QString)),
+                pRecorder, SLOT(onTextMessageReceived(QString)));
+        connect(pPanelServerSocket, SIGNAL(binaryMessageReceived(QByteArray)),
+                pRecorder, SLOT(onBinaryMessageReceived(QByteArray)));
+    }
+
+    // Open the Server connection to talk to
+    // (no Server when replaying a recorded match)
+    if(!serverUrl.isEmpty())
+        pPanelServerSocket->open();
+
+    // Connect the refreshTimer timeout with its SLOT
+    connect(&refreshTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToRefreshStatus()));
+    StartupTrace::mark(logFile, QString("Panel connection started"));
+}
+
+
+/*!
+ * \brief ScorePanel::~ScorePanel The Score Panel destructor
+ */
+ScorePanel::~ScorePanel() {
+    refreshTimer.disconnect();
+    refreshTimer.stop();
+    if(pPanelServerSocket)
+        pPanelServerSocket->disconnect();
+    closeCamera();
+    if(pSettings) delete pSettings;
+    pSettings = Q_NULLPTR;
+
+    doProcessCleanup();
+
+    if(pStatsThread) {
+        pStatsThread->quit();
+        pStatsThread->wait();
+        delete pStatsThread;
+    }
+    pStatsThread = Q_NULLPTR;
+
+    if(pPanelServerSocket)
+        delete pPanelServerSocket;
+    pPanelServerSocket = Q_NULLPTR;
+}
+
+
+/*!
+ * \brief ScorePanel::onTimeToStartServices Start what is not needed to show the score
+ */
+void
+ScorePanel::onTimeToStartServices() {
+    if(bServicesStarted)
+        return;
+    bServicesStarted = true;
+    servicesTimer.stop();
+    startServices();
+    StartupTrace::finish(logFile);
+}
+
+
+/*!
+ * \brief ScorePanel::startServices Start the Camera, Slides, Spots and Stats services
+ *
+ * The derived panels start here their own services too.
+ */
+void
+ScorePanel::startServices() {
     initCamera();
+    StartupTrace::mark(logFile, QString("Camera started"));
+    initStatsSampler();
+    StartupTrace::mark(logFile, QString("Stats sampler started"));
+    // The Slide Window is created anyway when a Slide Show is requested
+    if(!isScoreOnly) {
+        initSlideWindow();
+        StartupTrace::mark(logFile, QString("Slide window started"));
+    }
+#if !defined(Q_OS_ANDROID)
+    if(pPanelServerSocket->isValid()) {
+        if(!pSpotUpdaterThread) {
+            spotUpdaterRestartTimer.stop();
+            onCreateSpotUpdaterThread();
+        }
+        if(!pSlideUpdaterThread) {
+            slideUpdaterRestartTimer.stop();
+            onCreateSlideUpdaterThread();
+        }
+        StartupTrace::mark(logFile, QString("Updaters started"));
+    }
+#endif
+}
+
+
+/*!
+ * \brief ScorePanel::initStatsSampler Start the resource usage sampling
+ *
+ * The samples are used to answer the Server <getStats>.
+ */
+void
+ScorePanel::initStatsSampler() {
+    pStatsThread  = new QThread();
+    pStatsSampler = new StatsSampler(sSpotDir, sSlideDir);
+    pStatsSampler->moveToThread(pStatsThread);
+    connect(pStatsThread, SIGNAL(started()),
+            pStatsSampler, SLOT(startSampling()));
+    connect(pStatsThread, SIGNAL(finished()),
+            pStatsSampler, SLOT(deleteLater()));
+    pStatsThread->start(QThread::LowestPriority);
+}
 
-    // Slide Window
+
+/*!
+ * \brief ScorePanel::initSlideWindow Create the Slide Window (if not yet done)
+ */
+void
+ScorePanel::initSlideWindow() {
+    if(pMySlideWindow)
+        return;
 #if defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
     pMySlideWindow = new org::salvato::gabriele::SlideShowInterface
             ("org.salvato.gabriele.slideshow",// Service name
@@ -154,59 +362,120 @@ ScorePanel::ScorePanel(const QString &serverUrl, QFile *myLogFile, QWidget *pare
     slidePlayer->start(sCommand);
     if(!slidePlayer->waitForStarted(3000)) {
         slidePlayer->terminate();
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Impossibile mandare lo Slide Show."));
+        LOG_ERROR(LOG_PANEL,
+                  logFile,
+                  QString("Impossibile mandare lo Slide Show."));
         delete slidePlayer;
         slidePlayer = Q_NULLPTR;
     }
 #endif
 #if !defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
     pMySlideWindow = new SlideWindow();
+    placeOnPanelScreen(pMySlideWindow);
 #endif
+}
 
-    // We are ready to connect to the remote Panel Server
-    pPanelServerSocket = new QWebSocket();
 
-    connect(pPanelServerSocket, SIGNAL(connected()),
-            this, SLOT(onPanelServerConnected()));
-    connect(pPanelServerSocket, SIGNAL(disconnected()),
-            this, SLOT(onPanelServerDisconnected()));
-    connect(pPanelServerSocket, SIGNAL(error(QAbstractSocket::SocketError)),
-            this, SLOT(onPanelServerSocketError(QAbstractSocket::SocketError)));
+/*!
+ * \brief ScorePanel::followPanel Make this panel a secondary one
+ * \param pPrimary The primary panel, connected to the Server
+ * \param iScreen The screen number (1 for the first secondary screen)
+ *
+ * A secondary panel, on another screen, has no Server connection and
+ * no services of its own: it is fed by the primary panel connection
+ * and shows the same score with its own orientation (by default the
+ * opposite of the primary one, as if on the other side of the field).
+ */
+void
+ScorePanel::followPanel(ScorePanel *pPrimary, int iScreen) {
+    pPrimaryPanel = pPrimary;
+    bServicesStarted = true;
+    servicesTimer.stop();
+    connect(pPrimary->pPanelServerSocket, SIGNAL(textMessageReceived(QString)),
+            this, SLOT(onTextMessageReceived(QString)));
+    connect(pPrimary->pPanelServerSocket, SIGNAL(binaryMessageReceived(QByteArray)),
+            this, SLOT(onBinaryMessageReceived(QByteArray)));
+    connect(pPrimary, SIGNAL(closing()),
+            this, SLOT(close()));
+    isMirrored = pPrimary->pSettings->value(QString("panel/screen%1/orientation").arg(iScreen),
+                                            !pPrimary->isMirrored).toBool();
+    applyOrientation();
+}
 
-    // To silent some warnings
-    pPanelServerSocket->ignoreSslErrors();
-    // Open the Server socket to talk to
-    pPanelServerSocket->open(QUrl(serverUrl));
 
-    // Connect the refreshTimer timeout with its SLOT
-    connect(&refreshTimer, SIGNAL(timeout()),
-            this, SLOT(onTimeToRefreshStatus()));
+/*!
+ * \brief ScorePanel::setPanelScreen Show the panel on a given screen
+ * \param pScreen The screen
+ *
+ * The font sizes depend on the screen width: they are computed
+ * again now and whenever the panel window changes screen.
+ */
+void
+ScorePanel::setPanelScreen(QScreen *pScreen) {
+    setGeometry(pScreen->geometry());
+    create();
+    windowHandle()->setScreen(pScreen);
+    connect(windowHandle(), SIGNAL(screenChanged(QScreen*)),
+            this, SLOT(onPanelScreenChanged(QScreen*)));
+    resizeFonts();
 }
 
 
 /*!
- * \brief ScorePanel::~ScorePanel The Score Panel destructor
+ * \brief ScorePanel::onPanelScreenChanged Invoked when the panel window changes screen
+ * \param pScreen The new screen
  */
-ScorePanel::~ScorePanel() {
-    refreshTimer.disconnect();
-    refreshTimer.stop();
-    if(pPanelServerSocket)
-        pPanelServerSocket->disconnect();
-#if defined(Q_PROCESSOR_ARM) && !defined(Q_OS_ANDROID)
-    if(gpioHostHandle>=0) {
-        pigpio_stop(gpioHostHandle);
-    }
-#endif
-    if(pSettings) delete pSettings;
-    pSettings = Q_NULLPTR;
+void
+ScorePanel::onPanelScreenChanged(QScreen *pScreen) {
+    Q_UNUSED(pScreen)
+    resizeFonts();
+}
 
-    doProcessCleanup();
 
-    if(pPanelServerSocket)
-        delete pPanelServerSocket;
-    pPanelServerSocket = Q_NULLPTR;
+/*!
+ * \brief ScorePanel::resizeFonts Fit the fonts to the panel screen
+ *
+ * The derived panels compute here their font sizes
+ * again and apply them to the panel fields.
+ */
+void
+ScorePanel::resizeFonts() {
+}
+
+
+/*!
+ * \brief ScorePanel::panelScreenGeometry The geometry of the screen showing the panel
+ * \return The panel screen geometry (the primary screen one if not yet known)
+ */
+QRect
+ScorePanel::panelScreenGeometry() {
+    if(windowHandle() && windowHandle()->screen())
+        return windowHandle()->screen()->geometry();
+    return QGuiApplication::primaryScreen()->geometry();
+}
+
+
+/*!
+ * \brief ScorePanel::fitTeamName Set the largest font showing a team name in half a screen
+ * \param pTeam The team name label
+ */
+void
+ScorePanel::fitTeamName(QLabel *pTeam) {
+    int width = panelScreenGeometry().width();
+    int iSize = fittingFontSize("Arial", pTeam->text()+"  ", width/2, 100, 100);
+    pTeam->setFont(QFont("Arial", iSize, QFont::Black));
+}
+
+
+/*!
+ * \brief ScorePanel::placeOnPanelScreen Move a window on the same screen of the panel
+ * \param pWindow The (top level) window
+ */
+void
+ScorePanel::placeOnPanelScreen(QWidget *pWindow) {
+    if(!windowHandle() || !windowHandle()->screen())
+        return;
+    pWindow->setGeometry(windowHandle()->screen()->geometry());
 }
 
 
@@ -216,10 +485,21 @@ ScorePanel::~ScorePanel() {
 void
 ScorePanel::buildLayout() {
     QWidget* oldPanel = pPanel;
-    pPanel = new QWidget(this);
-    QVBoxLayout *panelLayout = new QVBoxLayout();
-    panelLayout->addLayout(createPanel());
-    pPanel->setLayout(panelLayout);
+    // The panels are always created in the normal orientation
+    bGridMirrored = false;
+    if(bUseCompositor) {
+        pPanelGrid  = Q_NULLPTR;
+        pCompositor = new PanelCompositor(this);
+        pCompositor->setFields(createPanel());
+        pPanel = pCompositor;
+    }
+    else {
+        pPanel = new QWidget(this);
+        QVBoxLayout *panelLayout = new QVBoxLayout();
+        pPanelGrid = createPanel();
+        panelLayout->addLayout(pPanelGrid);
+        pPanel->setLayout(panelLayout);
+    }
     if(!layout()) {
         QVBoxLayout *mainLayout = new QVBoxLayout();
         setLayout(mainLayout);
@@ -227,6 +507,48 @@ ScorePanel::buildLayout() {
     layout()->addWidget(pPanel);
     if(oldPanel != Q_NULLPTR)
         delete oldPanel;
+    applyOrientation();
+}
+
+
+/*!
+ * \brief ScorePanel::applyOrientation Reflect (or not) the panel in place
+ *
+ * Nothing is created or destroyed: the grid is just filled starting
+ * from the other corner and the Left/Right alignments are swapped
+ * (the PanelCompositor uses its precomputed reflected cells).
+ */
+void
+ScorePanel::applyOrientation() {
+    mirrorFields();
+    if(pCompositor) {
+        pCompositor->setMirrored(isMirrored);
+        return;
+    }
+    if(!pPanelGrid || (bGridMirrored == isMirrored))
+        return;
+    bGridMirrored = isMirrored;
+    pPanelGrid->setOriginCorner(isMirrored ? Qt::TopRightCorner : Qt::TopLeftCorner);
+    for(int i=0; i<pPanelGrid->count(); i++) {
+        QLayoutItem* pItem = pPanelGrid->itemAt(i);
+        Qt::Alignment alignment = pItem->alignment();
+        if(alignment & (Qt::AlignLeft|Qt::AlignRight))
+            pItem->setAlignment(alignment ^ (Qt::AlignLeft|Qt::AlignRight));
+    }
+    pPanelGrid->invalidate();
+}
+
+
+/*!
+ * \brief ScorePanel::refreshPanel To be called when the panel fields changed
+ *
+ * Needed only when the fields are drawn by a PanelCompositor
+ * (the widgets repaint themselves otherwise).
+ */
+void
+ScorePanel::refreshPanel() {
+    if(pCompositor)
+        pCompositor->scheduleRefresh();
 }
 
 
@@ -239,11 +561,9 @@ ScorePanel::buildLayout() {
  */
 void
 ScorePanel::onCreateSpotUpdaterThread() {
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("Creating a Spot Update Thread"));
-#endif
+    LOG_DEBUG(LOG_UPDATER,
+              logFile,
+              QString("Creating a Spot Update Thread"));
     // Create the Spot Updater Thread
     pSpotUpdaterThread = new QThread();
     connect(pSpotUpdaterThread, SIGNAL(finished()),
@@ -252,16 +572,15 @@ ScorePanel::onCreateSpotUpdaterThread() {
     QString spotUpdateServer;
     spotUpdateServer= QString("ws://%1:%2").arg(pPanelServerSocket->peerAddress().toString()).arg(spotUpdatePort);
     pSpotUpdater = new FileUpdater(QString("SpotUpdater"), spotUpdateServer, logFile);
+    pSpotUpdater->setMediaStore(sMediaStoreDir);
     pSpotUpdater->moveToThread(pSpotUpdaterThread);
     connect(this, SIGNAL(updateSpots()),
             pSpotUpdater, SLOT(startUpdate()));
     pSpotUpdaterThread->start();
     pSpotUpdater->setDestination(sSpotDir, QString("*.mp4 *.MP4"));
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("Spot Update thread started"));
-#endif
+    LOG_DEBUG(LOG_UPDATER,
+              logFile,
+              QString("Spot Update thread started"));
     emit updateSpots();
 }
 
@@ -277,14 +596,14 @@ ScorePanel::closeSpotUpdaterThread() {
         if(pSpotUpdaterThread->isRunning()) {
             pSpotUpdaterThread->requestInterruption();
             if(pSpotUpdaterThread->wait(5000)) {
-                logMessage(logFile,
-                           Q_FUNC_INFO,
-                           QString("Spot Update Thread regularly closed"));
+                LOG_INFO(LOG_UPDATER,
+                         logFile,
+                         QString("Spot Update Thread regularly closed"));
             }
             else {
-                logMessage(logFile,
-                           Q_FUNC_INFO,
-                           QString("Spot Update Thread forced to close"));
+                LOG_INFO(LOG_UPDATER,
+                         logFile,
+                         QString("Spot Update Thread forced to close"));
             }
         }
         delete pSpotUpdaterThread;
@@ -301,41 +620,37 @@ void
 ScorePanel::onSpotUpdaterThreadDone() {
     if(pSpotUpdaterThread)
         pSpotUpdaterThread->disconnect();
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("Spot Updater Thread regularly closed"));
-#endif
+    LOG_DEBUG(LOG_UPDATER,
+              logFile,
+              QString("Spot Updater Thread regularly closed"));
     closeSpotUpdaterThread();
     if(pSpotUpdater->returnCode == FileUpdater::TRANSFER_DONE) {
-#ifdef LOG_VERBOSE
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Spot Updater closed without errors"));
-#endif
+        LOG_DEBUG(LOG_UPDATER,
+                  logFile,
+                  QString("Spot Updater closed without errors"));
     }
     else if(pSpotUpdater->returnCode == FileUpdater::ERROR_SOCKET) {
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Spot Updater closed with errors"));
+        LOG_ERROR(LOG_UPDATER,
+                  logFile,
+                  QString("Spot Updater closed with errors"));
         spotUpdaterRestartTimer.start(qrand()%5000+5000);
     }
     else if(pSpotUpdater->returnCode == FileUpdater::FILE_ERROR) {
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Spot Updater got a File Error"));
+        LOG_ERROR(LOG_UPDATER,
+                  logFile,
+                  QString("Spot Updater got a File Error"));
     }
     else if(pSpotUpdater->returnCode == FileUpdater::SERVER_DISCONNECTED) {
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Spot Updater Server Unexpectedly Closed the Connection"));
+        LOG_INFO(LOG_UPDATER,
+                 logFile,
+                 QString("Spot Updater Server Unexpectedly Closed the Connection"));
         spotUpdaterRestartTimer.start(qrand()%5000+5000);
     }
     else {
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Spot Updater Closed for Unknown Reason: %1")
-                   .arg(pSpotUpdater->returnCode));
+        LOG_INFO(LOG_UPDATER,
+                 logFile,
+                 QString("Spot Updater Closed for Unknown Reason: %1")
+                 .arg(pSpotUpdater->returnCode));
     }
 }
 //========================================
@@ -352,11 +667,9 @@ ScorePanel::onSpotUpdaterThreadDone() {
  */
 void
 ScorePanel::onCreateSlideUpdaterThread() {
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("Creating a Slide Update Thread"));
-#endif
+    LOG_DEBUG(LOG_UPDATER,
+              logFile,
+              QString("Creating a Slide Update Thread"));
     // Create the Slide Updater Thread
     pSlideUpdaterThread = new QThread();
     connect(pSlideUpdaterThread, SIGNAL(finished()),
@@ -365,16 +678,15 @@ ScorePanel::onCreateSlideUpdaterThread() {
     QString slideUpdateServer;
     slideUpdateServer= QString("ws://%1:%2").arg(pPanelServerSocket->peerAddress().toString()).arg(slideUpdatePort);
     pSlideUpdater = new FileUpdater(QString("SlideUpdater"), slideUpdateServer, logFile);
+    pSlideUpdater->setMediaStore(sMediaStoreDir);
     pSlideUpdater->moveToThread(pSlideUpdaterThread);
     connect(this, SIGNAL(updateSlides()),
             pSlideUpdater, SLOT(startUpdate()));
     pSlideUpdaterThread->start();
     pSlideUpdater->setDestination(sSlideDir, QString("*.jpg *.jpeg *.png *.JPG *.JPEG *.PNG"));
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("Slide Update thread started"));
-#endif
+    LOG_DEBUG(LOG_UPDATER,
+              logFile,
+              QString("Slide Update thread started"));
     emit updateSlides();
 }
 
@@ -390,14 +702,14 @@ ScorePanel::closeSlideUpdaterThread() {
         if(pSlideUpdaterThread->isRunning()) {
             pSlideUpdaterThread->requestInterruption();
             if(pSlideUpdaterThread->wait(1000)) {
-                logMessage(logFile,
-                           Q_FUNC_INFO,
-                           QString("Slide Update Thread regularly closed"));
+                LOG_INFO(LOG_UPDATER,
+                         logFile,
+                         QString("Slide Update Thread regularly closed"));
             }
             else {
-                logMessage(logFile,
-                           Q_FUNC_INFO,
-                           QString("Slide Update Thread forced to close"));
+                LOG_INFO(LOG_UPDATER,
+                         logFile,
+                         QString("Slide Update Thread forced to close"));
             }
         }
         delete pSlideUpdaterThread;
@@ -414,41 +726,37 @@ void
 ScorePanel::onSlideUpdaterThreadDone() {
     if(pSlideUpdaterThread)
         pSlideUpdaterThread->disconnect();
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("Slide Update Thread regularly closed"));
-#endif
+    LOG_DEBUG(LOG_UPDATER,
+              logFile,
+              QString("Slide Update Thread regularly closed"));
     closeSlideUpdaterThread();
     if(pSlideUpdater->returnCode == FileUpdater::TRANSFER_DONE) {
-#ifdef LOG_VERBOSE
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Slide Updater closed without errors"));
-#endif
+        LOG_DEBUG(LOG_UPDATER,
+                  logFile,
+                  QString("Slide Updater closed without errors"));
     }
     else if(pSlideUpdater->returnCode == FileUpdater::ERROR_SOCKET) {
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Slide Updater closed with errors"));
+        LOG_ERROR(LOG_UPDATER,
+                  logFile,
+                  QString("Slide Updater closed with errors"));
         slideUpdaterRestartTimer.start(qrand()%5000+5000);
     }
     else if(pSlideUpdater->returnCode == FileUpdater::FILE_ERROR) {
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Slide Updater got a File Error"));
+        LOG_ERROR(LOG_UPDATER,
+                  logFile,
+                  QString("Slide Updater got a File Error"));
     }
     else if(pSlideUpdater->returnCode == FileUpdater::SERVER_DISCONNECTED) {
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Slide Updater Server Suddenly Closed the Connection"));
+        LOG_INFO(LOG_UPDATER,
+                 logFile,
+                 QString("Slide Updater Server Suddenly Closed the Connection"));
         slideUpdaterRestartTimer.start(qrand()%5000+5000);
     }
     else {
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Slide Updater Closed for Unknown Reason %1")
-                   .arg(pSlideUpdater->returnCode));
+        LOG_INFO(LOG_UPDATER,
+                 logFile,
+                 QString("Slide Updater Closed for Unknown Reason %1")
+                 .arg(pSlideUpdater->returnCode));
     }
 }
 //=========================================
@@ -475,11 +783,9 @@ ScorePanel::setScoreOnly(bool bScoreOnly) {
             pMySlideWindow->exitShow();// This gently close the slidePlayer Process...
             system("xrefresh -display :0");
             slidePlayer->close();
-#ifdef LOG_VERBOSE
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Closing Slide Player..."));
-#endif
+            LOG_DEBUG(LOG_PANEL,
+                      logFile,
+                      QString("Closing Slide Player..."));
             slidePlayer->waitForFinished(3000);
             slidePlayer->deleteLater();
             slidePlayer = Q_NULLPTR;
@@ -490,11 +796,9 @@ ScorePanel::setScoreOnly(bool bScoreOnly) {
         }
 #endif
         if(videoPlayer) {
-#ifdef LOG_MESG
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Closing Video Player..."));
-#endif
+            LOG_INFO(LOG_PANEL,
+                     logFile,
+                     QString("Closing Video Player..."));
             videoPlayer->disconnect();
     #if defined(Q_PROCESSOR_ARM) && !defined(Q_OS_ANDROID)
             videoPlayer->write("q", 1);
@@ -531,59 +835,67 @@ ScorePanel::getScoreOnly() {
  */
 void
 ScorePanel::onPanelServerConnected() {
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("Started"));
-#endif
+    LOG_DEBUG(LOG_PANEL,
+              logFile,
+              QString("Started"));
     QString sMessage;
     sMessage = QString("<getStatus>%1</getStatus>").arg(QHostInfo::localHostName());
     qint64 bytesSent = pPanelServerSocket->sendTextMessage(sMessage);
     if(bytesSent != sMessage.length()) {
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Unable to ask the initial status"));
+        LOG_ERROR(LOG_PANEL,
+                  logFile,
+                  QString("Unable to ask the initial status"));
     }
+    showReconnectionOverlay(false);
 #if !defined(Q_OS_ANDROID)
-    onCreateSpotUpdaterThread();
-    onCreateSlideUpdaterThread();
+    // Upon a reconnection the Updaters could be still running
+    // (at startup they wait for the first score to be shown)
+    if(bServicesStarted && !pSpotUpdaterThread) {
+        spotUpdaterRestartTimer.stop();
+        onCreateSpotUpdaterThread();
+    }
+    if(bServicesStarted && !pSlideUpdaterThread) {
+        slideUpdaterRestartTimer.stop();
+        onCreateSlideUpdaterThread();
+    }
 #endif
     bStillConnected = false;
     refreshTimer.start(qrand()%2000+3000);
 }
 
 
+/*!
+ * \brief ScorePanel::onTimeToRefreshStatus
+ * Periodically ask the Server for the Panel status.
+ *
+ * If the Server did not answer since the last request the
+ * connection is restarted (but the Panel is left untouched).
+ */
 void
 ScorePanel::onTimeToRefreshStatus() {
+    // No Server to ask when replaying a recorded match
+    if(!bHasServer) {
+        refreshTimer.stop();
+        return;
+    }
     if(!bStillConnected) {
-#ifdef LOG_VERBOSE
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Panel Server Disconnected"));
-#endif
-        if(pPanelServerSocket)
-            pPanelServerSocket->deleteLater();
-        pPanelServerSocket =Q_NULLPTR;
-        doProcessCleanup();
-        close();
-        emit panelClosed();
+        LOG_DEBUG(LOG_PANEL,
+                  logFile,
+                  QString("Panel Server not responding"));
+        refreshTimer.stop();
+        pPanelServerSocket->reconnect();
         return;
     }
     QString sMessage;
     sMessage = QString("<getStatus>%1</getStatus>").arg(QHostInfo::localHostName());
     qint64 bytesSent = pPanelServerSocket->sendTextMessage(sMessage);
     if(bytesSent != sMessage.length()) {
-#ifdef LOG_VERBOSE
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Unable to refresh the Panel status"));
-#endif
-        if(pPanelServerSocket)
-            pPanelServerSocket->deleteLater();
-        pPanelServerSocket =Q_NULLPTR;
-        doProcessCleanup();
-        close();
-        emit panelClosed();
+        LOG_DEBUG(LOG_PANEL,
+                  logFile,
+                  QString("Unable to refresh the Panel status"));
+        refreshTimer.stop();
+        pPanelServerSocket->reconnect();
+        return;
     }
     bStillConnected = false;
 }
@@ -592,33 +904,80 @@ ScorePanel::onTimeToRefreshStatus() {
 /*!
  * \brief ScorePanel::onPanelServerDisconnected
  * Invoked asynchronously upon the Server disconnection
+ *
+ * The Panel, with all its media, remains as it is while
+ * the connection tries to reach again the Server.
  */
 void
 ScorePanel::onPanelServerDisconnected() {
+    LOG_DEBUG(LOG_PANEL,
+              logFile,
+              QString("Waiting for the Server to come back"));
+    refreshTimer.stop();
+    showReconnectionOverlay(true);
+}
+
+
+/*!
+ * \brief ScorePanel::onPanelServerReconnecting
+ * Invoked asynchronously when a new connection attempt has been scheduled
+ * \param attempt The attempt number
+ * \param msecDelay The delay before the attempt
+ */
+void
+ScorePanel::onPanelServerReconnecting(int attempt, int msecDelay) {
+    Q_UNUSED(msecDelay)
+    pReconnectionLabel->setText(tr(" Riconnessione al Server (%1)... ").arg(attempt));
+    pReconnectionLabel->adjustSize();
+    showReconnectionOverlay(true);
+}
+
+
+/*!
+ * \brief ScorePanel::onPanelServerLost
+ * Invoked asynchronously when the Server could not be reached anymore
+ *
+ * Only now the Panel is closed and the Server Discovery restarted
+ * (the Server could have changed its address).
+ */
+void
+ScorePanel::onPanelServerLost() {
     doProcessCleanup();
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("emitting panelClosed()"));
-#endif
-    if(pPanelServerSocket)
-        pPanelServerSocket->deleteLater();
-    pPanelServerSocket =Q_NULLPTR;
+    LOG_DEBUG(LOG_PANEL,
+              logFile,
+              QString("emitting panelClosed()"));
+    close();// Closes the Widget
     emit panelClosed();
 }
 
 
+/*!
+ * \brief ScorePanel::showReconnectionOverlay Show (or hide) the small
+ * "Reconnecting" label on top of the Panel
+ * \param bShow true to show the label
+ */
+void
+ScorePanel::showReconnectionOverlay(bool bShow) {
+    if(bShow) {
+        pReconnectionLabel->move(0, height()-pReconnectionLabel->height());
+        pReconnectionLabel->raise();
+        pReconnectionLabel->show();
+    }
+    else {
+        pReconnectionLabel->hide();
+    }
+}
+
+
 /*!
  * \brief ScorePanel::doProcessCleanup
  * Responsible to clean all the running processes upon a Server disconnection.
  */
 void
 ScorePanel::doProcessCleanup() {
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("Cleaning all processes"));
-#endif
+    LOG_DEBUG(LOG_PANEL,
+              logFile,
+              QString("Cleaning all processes"));
     refreshTimer.disconnect();
     spotUpdaterRestartTimer.disconnect();
     slideUpdaterRestartTimer.disconnect();
@@ -634,11 +993,9 @@ ScorePanel::doProcessCleanup() {
         pMySlideWindow->exitShow();// This gently close the slidePlayer Process...
         system("xrefresh -display :0");
         slidePlayer->close();
-#ifdef LOG_VERBOSE
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Closing Slide Player..."));
-#endif
+        LOG_DEBUG(LOG_PANEL,
+                  logFile,
+                  QString("Closing Slide Player..."));
         slidePlayer->waitForFinished(3000);
         slidePlayer->deleteLater();
         slidePlayer = Q_NULLPTR;
@@ -656,9 +1013,9 @@ ScorePanel::doProcessCleanup() {
 #else
         videoPlayer->close();
 #endif
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Closing Video Player..."));
+        LOG_INFO(LOG_PANEL,
+                 logFile,
+                 QString("Closing Video Player..."));
         videoPlayer->waitForFinished(3000);
         videoPlayer->deleteLater();
         videoPlayer = Q_NULLPTR;
@@ -673,88 +1030,57 @@ ScorePanel::doProcessCleanup() {
 
 
 /*!
- * \brief ScorePanel::onPanelServerSocketError
- * Invoked asynchronously upon a Server socket error.
- * \param error
+ * \brief ScorePanel::initCamera
+ * Initialize the PWM control of the Pan-Tilt camera servos
+ *
+ * The servos are driven by a PanTiltController in its own thread,
+ * through the pigpio daemon (on the Raspberry or, for testing, on the
+ * host given with the --pigpiod option).
  */
 void
-ScorePanel::onPanelServerSocketError(QAbstractSocket::SocketError error) {
-    Q_UNUSED(error)
-    doProcessCleanup();
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("%1 %2 Error %3")
-               .arg(pPanelServerSocket->peerAddress().toString())
-               .arg(pPanelServerSocket->errorString())
-               .arg(error));
+ScorePanel::initCamera() {
+    MyApplication* application = static_cast<MyApplication *>(QApplication::instance());
+    QString sPigpiodHost = application->sPigpiodHost;
+#if defined(Q_PROCESSOR_ARM) && !defined(Q_OS_ANDROID)
+    if(sPigpiodHost.isEmpty())
+        sPigpiodHost = QString("localhost");
 #endif
-    if(pPanelServerSocket) {
-        pPanelServerSocket->disconnect();
-        if(pPanelServerSocket->isValid())
-            pPanelServerSocket->close();
-        pPanelServerSocket->deleteLater();
+    if(sPigpiodHost.isEmpty())
+        return;
+    quint16 pigpiodPort = PIGPIOD_PORT;
+    if(sPigpiodHost.contains(":")) {
+        pigpiodPort  = quint16(sPigpiodHost.section(':', 1).toUInt());
+        sPigpiodHost = sPigpiodHost.section(':', 0, 0);
     }
-    pPanelServerSocket = Q_NULLPTR;
-    close();// Closes the Widget
-    emit panelClosed();
+    pCameraThread = new QThread();
+    pCameraController = new PanTiltController(sPigpiodHost, pigpiodPort, panPin, tiltPin, logFile);
+    // Not yet running in its thread: it can be set directly
+    pCameraController->setSlewRate(pSettings->value("camera/slewRate", DEFAULT_SLEW_RATE).toDouble());
+    pCameraController->moveToThread(pCameraThread);
+    connect(pCameraThread, SIGNAL(started()),
+            pCameraController, SLOT(start()));
+    connect(pCameraThread, SIGNAL(finished()),
+            pCameraController, SLOT(deleteLater()));
+    pCameraThread->start();
+    QMetaObject::invokeMethod(pCameraController, "setPosition", Qt::QueuedConnection,
+                              Q_ARG(double, cameraPanAngle),
+                              Q_ARG(double, cameraTiltAngle));
 }
 
 
 /*!
- * \brief ScorePanel::initCamera
- * Initialize the PWM control of the Pan-Tilt camera servos
+ * \brief ScorePanel::closeCamera Stop the camera servos and their thread
  */
 void
-ScorePanel::initCamera() {
-    // Get the initial camera position from the past stored values
-    cameraPanAngle  = pSettings->value("camera/panAngle",  0.0).toDouble();
-    cameraTiltAngle = pSettings->value("camera/tiltAngle", 0.0).toDouble();
-
-    PWMfrequency    = 50;     // in Hz
-    pulseWidthAt_90 = 600.0;  // in us
-    pulseWidthAt90  = 2200;   // in us
-
-#if defined(Q_PROCESSOR_ARM) && !defined(Q_OS_ANDROID)
-    gpioHostHandle = pigpio_start((char*)"localhost", (char*)"8888");
-    if(gpioHostHandle < 0) {
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Non riesco ad inizializzare la GPIO."));
-    }
-    int iResult;
-    if(gpioHostHandle >= 0) {
-        iResult = set_PWM_frequency(gpioHostHandle, panPin, PWMfrequency);
-        if(iResult < 0) {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Non riesco a definire la frequenza del PWM per il Pan."));
-        }
-        double pulseWidth = pulseWidthAt_90 +(pulseWidthAt90-pulseWidthAt_90)/180.0 * (cameraPanAngle+90.0);// In us
-        iResult = set_servo_pulsewidth(gpioHostHandle, panPin, u_int32_t(pulseWidth));
-        if(iResult < 0) {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Non riesco a far partire il PWM per il Pan."));
-        }
-        set_PWM_frequency(gpioHostHandle, panPin, 0);
-
-        iResult = set_PWM_frequency(gpioHostHandle, tiltPin, PWMfrequency);
-        if(iResult < 0) {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Non riesco a definire la frequenza del PWM per il Tilt."));
-        }
-        pulseWidth = pulseWidthAt_90 +(pulseWidthAt90-pulseWidthAt_90)/180.0 * (cameraTiltAngle+90.0);// In us
-        iResult = set_servo_pulsewidth(gpioHostHandle, tiltPin, u_int32_t(pulseWidth));
-        if(iResult < 0) {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Non riesco a far partire il PWM per il Tilt."));
-        }
-        set_PWM_frequency(gpioHostHandle, tiltPin, 0);
-    }
-#endif
+ScorePanel::closeCamera() {
+    if(!pCameraThread)
+        return;
+    QMetaObject::invokeMethod(pCameraController, "stop", Qt::BlockingQueuedConnection);
+    pCameraThread->quit();
+    pCameraThread->wait();
+    delete pCameraThread;
+    pCameraThread     = Q_NULLPTR;
+    pCameraController = Q_NULLPTR;
 }
 
 
@@ -764,29 +1090,35 @@ ScorePanel::initCamera() {
  */
 void
 ScorePanel::closeEvent(QCloseEvent *event) {
-    pSettings->setValue("camera/panAngle",  cameraPanAngle);
-    pSettings->setValue("camera/tiltAngle", cameraTiltAngle);
-    pSettings->setValue("panel/orientation", isMirrored);
+    // The settings are written only by the primary panel
+    if(!pPrimaryPanel) {
+        pSettings->setValue("camera/panAngle",  cameraPanAngle);
+        pSettings->setValue("camera/tiltAngle", cameraTiltAngle);
+        pSettings->setValue("panel/orientation", isMirrored);
+        pSettings->flush();
+    }
 
     doProcessCleanup();
+    closeCamera();
 
-#if defined(Q_PROCESSOR_ARM) && !defined(Q_OS_ANDROID)
-    if(gpioHostHandle>=0) {
-        pigpio_stop(gpioHostHandle);
-        gpioHostHandle = -1;
-    }
-#endif
+    emit closing();
     event->accept();
 }
 
 
 /*!
  * \brief ScorePanel::keyPressEvent Close the window following and "Esc" key pressed
+ * (the "L" key toggles the latency debug overlay)
  * \param event The event descriptor
  */
 void
 ScorePanel::keyPressEvent(QKeyEvent *event) {
     if(event->key() == Qt::Key_Escape) {
+        // A secondary panel closes with the primary one
+        if(pPrimaryPanel) {
+            pPrimaryPanel->keyPressEvent(event);
+            return;
+        }
         if(pPanelServerSocket) {
             pPanelServerSocket->disconnect();
             pPanelServerSocket->close(QWebSocketProtocol::CloseCodeNormal,
@@ -794,6 +1126,17 @@ ScorePanel::keyPressEvent(QKeyEvent *event) {
         }
         close();
     }
+    else if(event->key() == Qt::Key_L) {
+        if(pLatencyLabel->isVisible()) {
+            latencyOverlayTimer.stop();
+            pLatencyLabel->hide();
+        }
+        else {
+            onTimeToUpdateLatencyOverlay();
+            pLatencyLabel->show();
+            latencyOverlayTimer.start(LATENCY_OVERLAY_TIME);
+        }
+    }
 }
 
 
@@ -839,19 +1182,17 @@ ScorePanel::onSpotClosed(int exitCode, QProcess::ExitStatus exitStatus) {
         QString sMessage = "<closed_spot>1</closed_spot>";
         qint64 bytesSent = pPanelServerSocket->sendTextMessage(sMessage);
         if(bytesSent != sMessage.length()) {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Unable to send %1")
-                       .arg(sMessage));
+            LOG_ERROR(LOG_SLIDES,
+                      logFile,
+                      QString("Unable to send %1")
+                      .arg(sMessage));
         }
-#ifdef LOG_VERBOSE
         else {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Sent %1")
-                       .arg(sMessage));
+            LOG_DEBUG(LOG_SLIDES,
+                      logFile,
+                      QString("Sent %1")
+                      .arg(sMessage));
         }
-#endif
     }
 }
 
@@ -876,10 +1217,10 @@ ScorePanel::onLiveClosed(int exitCode, QProcess::ExitStatus exitStatus) {
         QString sMessage = "<closed_live>1</closed_live>";
         qint64 bytesSent = pPanelServerSocket->sendTextMessage(sMessage);
         if(bytesSent != sMessage.length()) {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Unable to send %1")
-                       .arg(sMessage));
+            LOG_ERROR(LOG_SLIDES,
+                      logFile,
+                      QString("Unable to send %1")
+                      .arg(sMessage));
         }
     }
 }
@@ -902,11 +1243,9 @@ ScorePanel::onStartNextSpot(int exitCode, QProcess::ExitStatus exitStatus) {
     spotDir.setFilter(QDir::Files);
     spotList = spotDir.entryInfoList();
     if(spotList.count() == 0) {
-#ifdef LOG_VERBOSE
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("No spots available !"));
-#endif
+        LOG_DEBUG(LOG_SLIDES,
+                  logFile,
+                  QString("No spots available !"));
         if(videoPlayer) {
             videoPlayer->disconnect();
             delete videoPlayer;
@@ -914,10 +1253,10 @@ ScorePanel::onStartNextSpot(int exitCode, QProcess::ExitStatus exitStatus) {
             QString sMessage = "<closed_spot>1</closed_spot>";
             qint64 bytesSent = pPanelServerSocket->sendTextMessage(sMessage);
             if(bytesSent != sMessage.length()) {
-                logMessage(logFile,
-                           Q_FUNC_INFO,
-                           QString("Unable to send %1")
-                           .arg(sMessage));
+                LOG_ERROR(LOG_SLIDES,
+                          logFile,
+                          QString("Unable to send %1")
+                          .arg(sMessage));
             }
         }
         //To avoid a blank screen that sometime appear at the end of omxplayer
@@ -939,18 +1278,16 @@ ScorePanel::onStartNextSpot(int exitCode, QProcess::ExitStatus exitStatus) {
         sCommand = "/usr/bin/cvlc --no-osd -f " + spotList.at(iCurrentSpot).absoluteFilePath() + " vlc://quit";
     #endif
     videoPlayer->start(sCommand);
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("Now playing: %1")
-               .arg(spotList.at(iCurrentSpot).absoluteFilePath()));
-#endif
+    LOG_DEBUG(LOG_SLIDES,
+              logFile,
+              QString("Now playing: %1")
+              .arg(spotList.at(iCurrentSpot).absoluteFilePath()));
     iCurrentSpot = (iCurrentSpot+1) % spotList.count();// Prepare Next Spot
     if(!videoPlayer->waitForStarted(3000)) {
         videoPlayer->close();
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Impossibile mandare lo spot"));
+        LOG_ERROR(LOG_SLIDES,
+                  logFile,
+                  QString("Impossibile mandare lo spot"));
         videoPlayer->disconnect();
         delete videoPlayer;
         videoPlayer = Q_NULLPTR;
@@ -967,9 +1304,9 @@ ScorePanel::onStartNextSpot(int exitCode, QProcess::ExitStatus exitStatus) {
  */
 void
 ScorePanel::onBinaryMessageReceived(QByteArray baMessage) {
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("Received %1 bytes").arg(baMessage.size()));
+    LOG_INFO(LOG_PANEL,
+             logFile,
+             QString("Received %1 bytes").arg(baMessage.size()));
 }
 
 
@@ -981,8 +1318,33 @@ ScorePanel::onBinaryMessageReceived(QByteArray baMessage) {
  */
 void
 ScorePanel::onTextMessageReceived(QString sMessage) {
-    refreshTimer.start(qrand()%2000+3000);
-    bStillConnected = true;
+    // The derived panels have already updated their fields
+    refreshPanel();
+    if(pPrimaryPanel) {
+        // A secondary panel shows, on its screen, just the score and the
+        // slides (on the Raspberry the Slide Show is a single process).
+        // The primary panel does everything else.
+#if !defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
+        isScoreOnly = pPrimaryPanel->getScoreOnly();
+        processSlideShowMessage(sMessage);
+#endif
+        return;
+    }
+    // The replayed messages do not prove a Server connection
+    if(bHasServer) {
+        refreshTimer.start(qrand()%2000+3000);
+        bStillConnected = true;
+    }
+    if(!bServicesStarted) {
+        if(!StartupTrace::isFirstScoreShown()) {
+            // Paint now to know when the score is really on the screen
+            if(pCompositor)
+                pCompositor->refresh();
+            repaint();
+            StartupTrace::firstScoreShown(logFile);
+        }
+        servicesTimer.start(0);
+    }
     QString sToken;
     bool ok;
     int iVal;
@@ -1033,22 +1395,7 @@ ScorePanel::onTextMessageReceived(QString sMessage) {
         }
     }// endspoloop
 
-    sToken = XML_Parse(sMessage, "slideshow");
-    if(sToken != sNoData && !isScoreOnly){
-        startSlideShow();
-    }// slideshow
-
-    sToken = XML_Parse(sMessage, "endslideshow");
-    if(sToken != sNoData){
-        #if defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
-        if(pMySlideWindow->isValid()) {
-        #else
-        if(pMySlideWindow) {
-            pMySlideWindow->hide();
-        #endif
-            pMySlideWindow->stopSlideShow();
-        }
-    }// endslideshow
+    processSlideShowMessage(sMessage);
 
     sToken = XML_Parse(sMessage, "live");
     if(sToken != sNoData && !isScoreOnly) {
@@ -1062,51 +1409,33 @@ ScorePanel::onTextMessageReceived(QString sMessage) {
         #if !defined(Q_OS_ANDROID)
         if(cameraPlayer) {
             cameraPlayer->terminate();
-#ifdef LOG_VERBOSE
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Live Show has been closed."));
-#endif
+            LOG_DEBUG(LOG_PANEL,
+                      logFile,
+                      QString("Live Show has been closed."));
         }
         #endif
     }// endlive
 
     sToken = XML_Parse(sMessage, "pan");
     if(sToken != sNoData) {
-#if defined(Q_PROCESSOR_ARM) && !defined(Q_OS_ANDROID)
-    if(gpioHostHandle >= 0) {
+        // Just a new target: the servo moves in the camera thread
+        // (or will start from there when the camera is started)
         cameraPanAngle = sToken.toDouble();
         pSettings->setValue("camera/panAngle",  cameraPanAngle);
-        set_PWM_frequency(gpioHostHandle, panPin, PWMfrequency);
-        double pulseWidth = pulseWidthAt_90 +(pulseWidthAt90-pulseWidthAt_90)/180.0 * (cameraPanAngle+90.0);// In ms
-        int iResult = set_servo_pulsewidth(gpioHostHandle, panPin, u_int32_t(pulseWidth));
-        if(iResult < 0) {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Non riesco a far partire il PWM per il Pan."));
+        if(pCameraController) {
+            QMetaObject::invokeMethod(pCameraController, "setPanTarget", Qt::QueuedConnection,
+                                      Q_ARG(double, cameraPanAngle));
         }
-        set_PWM_frequency(gpioHostHandle, panPin, 0);
-    }
-#endif
     }// pan
 
     sToken = XML_Parse(sMessage, "tilt");
     if(sToken != sNoData) {
-#if defined(Q_PROCESSOR_ARM) && !defined(Q_OS_ANDROID)
-        if(gpioHostHandle >= 0) {
-            cameraTiltAngle = sToken.toDouble();
-            pSettings->setValue("camera/tiltAngle", cameraTiltAngle);
-            set_PWM_frequency(gpioHostHandle, tiltPin, PWMfrequency);
-            double pulseWidth = pulseWidthAt_90 +(pulseWidthAt90-pulseWidthAt_90)/180.0 * (cameraTiltAngle+90.0);// In ms
-            int iResult = set_servo_pulsewidth(gpioHostHandle, tiltPin, u_int32_t(pulseWidth));
-            if(iResult < 0) {
-              logMessage(logFile,
-                         Q_FUNC_INFO,
-                         QString("Non riesco a far partire il PWM per il Tilt."));
-            }
-            set_PWM_frequency(gpioHostHandle, tiltPin, 0);
+        cameraTiltAngle = sToken.toDouble();
+        pSettings->setValue("camera/tiltAngle", cameraTiltAngle);
+        if(pCameraController) {
+            QMetaObject::invokeMethod(pCameraController, "setTiltTarget", Qt::QueuedConnection,
+                                      Q_ARG(double, cameraTiltAngle));
         }
-#endif
     }// tilt
 
     sToken = XML_Parse(sMessage, "getPanTilt");
@@ -1116,9 +1445,9 @@ ScorePanel::onTextMessageReceived(QString sMessage) {
             sMessage = QString("<pan_tilt>%1,%2</pan_tilt>").arg(int(cameraPanAngle)).arg(int(cameraTiltAngle));
             qint64 bytesSent = pPanelServerSocket->sendTextMessage(sMessage);
             if(bytesSent != sMessage.length()) {
-                logMessage(logFile,
-                           Q_FUNC_INFO,
-                           QString("Unable to send pan & tilt values."));
+                LOG_ERROR(LOG_PANEL,
+                          logFile,
+                          QString("Unable to send pan & tilt values."));
             }
         }
     }// getPanTilt
@@ -1133,9 +1462,9 @@ ScorePanel::onTextMessageReceived(QString sMessage) {
                 sMessage = QString("<orientation>%1</orientation>").arg(static_cast<int>(PanelOrientation::Normal));
             qint64 bytesSent = pPanelServerSocket->sendTextMessage(sMessage);
             if(bytesSent != sMessage.length()) {
-                logMessage(logFile,
-                           Q_FUNC_INFO,
-                           QString("Unable to send orientation value."));
+                LOG_ERROR(LOG_PANEL,
+                          logFile,
+                          QString("Unable to send orientation value."));
             }
         }
     }// getOrientation
@@ -1144,28 +1473,33 @@ ScorePanel::onTextMessageReceived(QString sMessage) {
     if(sToken != sNoData) {
         bool ok;
         int iVal = sToken.toInt(&ok);
+        // An illegal value skips just this token: the message
+        // must reach the end (and the latency monitor) anyway
         if(!ok) {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Illegal orientation value received: %1")
-                               .arg(sToken));
-            return;
+            LOG_INFO(LOG_PANEL,
+                     logFile,
+                     QString("Illegal orientation value received: %1")
+                             .arg(sToken));
         }
-        try {
-            PanelOrientation newOrientation = static_cast<PanelOrientation>(iVal);
-            if(newOrientation == PanelOrientation::Reflected)
-                isMirrored = true;
-            else
-                isMirrored = false;
-        } catch(...) {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Illegal orientation value received: %1")
-                               .arg(sToken));
-            return;
+        else {
+            try {
+                PanelOrientation newOrientation = static_cast<PanelOrientation>(iVal);
+                if(newOrientation == PanelOrientation::Reflected)
+                    isMirrored = true;
+                else
+                    isMirrored = false;
+            } catch(...) {
+                LOG_INFO(LOG_PANEL,
+                         logFile,
+                         QString("Illegal orientation value received: %1")
+                                 .arg(sToken));
+                ok = false;
+            }
+        }
+        if(ok) {
+            pSettings->setValue("panel/orientation", isMirrored);
+            applyOrientation();
         }
-        pSettings->setValue("panel/orientation", isMirrored);
-        buildLayout();
     }// setOrientation
 
     sToken = XML_Parse(sMessage, "getScoreOnly");
@@ -1179,19 +1513,20 @@ ScorePanel::onTextMessageReceived(QString sMessage) {
         bool ok;
         int iVal = sToken.toInt(&ok);
         if(!ok) {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Illegal value fo ScoreOnly received: %1")
-                               .arg(sToken));
-            return;
-        }
-        if(iVal==0) {
-            setScoreOnly(false);
+            LOG_INFO(LOG_PANEL,
+                     logFile,
+                     QString("Illegal value fo ScoreOnly received: %1")
+                             .arg(sToken));
         }
         else {
-            setScoreOnly(true);
+            if(iVal==0) {
+                setScoreOnly(false);
+            }
+            else {
+                setScoreOnly(true);
+            }
+            pSettings->setValue("panel/scoreOnly", isScoreOnly);
         }
-        pSettings->setValue("panel/scoreOnly", isScoreOnly);
         #endif
     }// setScoreOnly
 
@@ -1208,13 +1543,125 @@ ScorePanel::onTextMessageReceived(QString sMessage) {
             sToken = QString("Italiano");
         }
         pSettings->setValue("language/current", sToken);
-#ifdef LOG_VERBOSE
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("New language: %1")
-                       .arg(sToken));
-#endif
+            LOG_DEBUG(LOG_PANEL,
+                      logFile,
+                      QString("New language: %1")
+                      .arg(sToken));
     }// language
+
+    sToken = XML_Parse(sMessage, "getLatency");
+    if(sToken != sNoData) {
+        if(pPanelServerSocket->isValid()) {
+            QString sMessage;
+            sMessage = QString("<latency>%1</latency>").arg(pLatencyMonitor->report());
+            qint64 bytesSent = pPanelServerSocket->sendTextMessage(sMessage);
+            if(bytesSent != sMessage.length()) {
+                LOG_ERROR(LOG_PANEL,
+                          logFile,
+                          QString("Unable to send latency values."));
+            }
+        }
+    }// getLatency
+
+    sToken = XML_Parse(sMessage, "getStalls");
+    if(sToken != sNoData) {
+        MyApplication* application = static_cast<MyApplication *>(QApplication::instance());
+        if(pPanelServerSocket->isValid() && application->pStallWatchdog) {
+            QString sMessage;
+            sMessage = QString("<stalls>%1</stalls>").arg(application->pStallWatchdog->report());
+            qint64 bytesSent = pPanelServerSocket->sendTextMessage(sMessage);
+            if(bytesSent != sMessage.length()) {
+                LOG_ERROR(LOG_PANEL,
+                          logFile,
+                          QString("Unable to send stall values."));
+            }
+        }
+    }// getStalls
+
+    sToken = XML_Parse(sMessage, "getStats");
+    if(sToken != sNoData) {
+        MyApplication* application = static_cast<MyApplication *>(QApplication::instance());
+        // No stats until the sampler has been started
+        if(pPanelServerSocket->isValid() && pStatsSampler) {
+            qint64 guiLatency = -1;
+            if(application->pStallWatchdog)
+                guiLatency = application->pStallWatchdog->guiLatency();
+            QString sMessage;
+            sMessage = QString("<stats>%1</stats>").arg(pStatsSampler->report(guiLatency));
+            qint64 bytesSent = pPanelServerSocket->sendTextMessage(sMessage);
+            if(bytesSent != sMessage.length()) {
+                LOG_ERROR(LOG_PANEL,
+                          logFile,
+                          QString("Unable to send stats values."));
+            }
+        }
+    }// getStats
+
+    pLatencyMonitor->dispatchDone();
+}
+
+
+/*!
+ * \brief ScorePanel::event Used to time the Panel repaints
+ * \param event The event
+ * \return true if the event was recognized
+ *
+ * The UpdateRequest of the top level widget repaints (synchronously)
+ * all the widgets changed by the last messages.
+ */
+bool
+ScorePanel::event(QEvent *event) {
+    bool bResult = QWidget::event(event);
+    if(pLatencyMonitor && (event->type() == QEvent::UpdateRequest)) {
+        QVector<int> acks = pLatencyMonitor->paintDone();
+        for(int seq : acks) {
+            QString sMessage = QString("<painted>%1</painted>").arg(seq);
+            pPanelServerSocket->sendTextMessage(sMessage);
+        }
+    }
+    return bResult;
+}
+
+
+/*!
+ * \brief ScorePanel::onTimeToUpdateLatencyOverlay Refresh the latency debug overlay
+ */
+void
+ScorePanel::onTimeToUpdateLatencyOverlay() {
+    // The secondary panels show the primary panel latencies
+    LatencyMonitor *pMonitor = pPrimaryPanel ? pPrimaryPanel->pLatencyMonitor : pLatencyMonitor;
+    pLatencyLabel->setText(pMonitor->overlayText());
+    pLatencyLabel->adjustSize();
+    pLatencyLabel->move(0, height()-pLatencyLabel->height());
+    pLatencyLabel->raise();
+}
+
+
+/*!
+ * \brief ScorePanel::processSlideShowMessage Start or stop the Slide Show as requested
+ * \param sMessage The received message
+ */
+void
+ScorePanel::processSlideShowMessage(QString sMessage) {
+    QString sToken;
+    QString sNoData = QString("NoData");
+
+    sToken = XML_Parse(sMessage, "slideshow");
+    if(sToken != sNoData && !isScoreOnly){
+        startSlideShow();
+    }// slideshow
+
+    sToken = XML_Parse(sMessage, "endslideshow");
+    if(sToken != sNoData){
+        #if defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
+        if(pMySlideWindow && pMySlideWindow->isValid()) {
+        #else
+        if(pMySlideWindow) {
+            pMySlideWindow->hide();
+        #endif
+            pMySlideWindow->stopSlideShow();
+        }
+    }// endslideshow
 }
 
 
@@ -1240,19 +1687,17 @@ ScorePanel::startLiveCamera() {
             cameraPlayer->start(sCommand);
             if(!cameraPlayer->waitForStarted(3000)) {
                 cameraPlayer->close();
-                logMessage(logFile,
-                           Q_FUNC_INFO,
-                           QString("Impossibile mandare lo spot."));
+                LOG_ERROR(LOG_SLIDES,
+                          logFile,
+                          QString("Impossibile mandare lo spot."));
                 delete cameraPlayer;
                 cameraPlayer = Q_NULLPTR;
             }
-#ifdef LOG_VERBOSE
             else {
-                logMessage(logFile,
-                           Q_FUNC_INFO,
-                           QString("Live Show is started."));
+                LOG_DEBUG(LOG_SLIDES,
+                          logFile,
+                          QString("Live Show is started."));
             }
-#endif
         }
     }
 }
@@ -1269,9 +1714,9 @@ ScorePanel::getPanelScoreOnly() {
         sMessage = QString("<isScoreOnly>%1</isScoreOnly>").arg(static_cast<int>(getScoreOnly()));
         qint64 bytesSent = pPanelServerSocket->sendTextMessage(sMessage);
         if(bytesSent != sMessage.length()) {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Unable to send scoreOnly configuration"));
+            LOG_ERROR(LOG_PANEL,
+                      logFile,
+                      QString("Unable to send scoreOnly configuration"));
         }
     }
 }
@@ -1291,11 +1736,9 @@ ScorePanel::startSpotLoop() {
         spotDir.setFilter(QDir::Files);
         spotList = spotDir.entryInfoList();
     }
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("Found %1 spots").arg(spotList.count()));
-#endif
+    LOG_DEBUG(LOG_SLIDES,
+              logFile,
+              QString("Found %1 spots").arg(spotList.count()));
     if(!spotList.isEmpty()) {
         iCurrentSpot = iCurrentSpot % spotList.count();
         if(!videoPlayer) {
@@ -1309,18 +1752,16 @@ ScorePanel::startSpotLoop() {
             sCommand = "/usr/bin/cvlc --no-osd -f " + spotList.at(iCurrentSpot).absoluteFilePath() + " vlc://quit";
             #endif
             videoPlayer->start(sCommand);
-#ifdef LOG_VERBOSE
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Now playing: %1")
-                       .arg(spotList.at(iCurrentSpot).absoluteFilePath()));
-#endif
+            LOG_DEBUG(LOG_SLIDES,
+                      logFile,
+                      QString("Now playing: %1")
+                      .arg(spotList.at(iCurrentSpot).absoluteFilePath()));
             iCurrentSpot = (iCurrentSpot+1) % spotList.count();// Prepare Next Spot
             if(!videoPlayer->waitForStarted(3000)) {
                 videoPlayer->close();
-                logMessage(logFile,
-                           Q_FUNC_INFO,
-                           QString("Impossibile mandare lo spot."));
+                LOG_ERROR(LOG_SLIDES,
+                          logFile,
+                          QString("Impossibile mandare lo spot."));
                 videoPlayer->disconnect();
                 delete videoPlayer;
                 videoPlayer = Q_NULLPTR;
@@ -1338,8 +1779,9 @@ void
 ScorePanel::startSlideShow() {
     if(videoPlayer || cameraPlayer)
         return;// No Slide Show if movies are playing or camera is active
+    initSlideWindow();
 #if defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
-    if(pMySlideWindow->isValid()) {
+    if(pMySlideWindow && pMySlideWindow->isValid()) {
 #else
     if(pMySlideWindow) {
         pMySlideWindow->showFullScreen();
@@ -1348,9 +1790,9 @@ ScorePanel::startSlideShow() {
         pMySlideWindow->startSlideShow();
     }
     else {
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Invalid Slide Window"));
+        LOG_INFO(LOG_SLIDES,
+                 logFile,
+                 QString("Invalid Slide Window"));
     }
 }
 
@@ -1363,3 +1805,82 @@ QGridLayout*
 ScorePanel::createPanel() {
     return new QGridLayout();
 }
+
+
+/*!
+ * \brief textWidth The width of a text (or of nChars of the widest character)
+ */
+static int
+textWidth(const QFont& font, const QString& sText, int nChars) {
+    QFontMetrics f(font);
+    if(sText.isEmpty())
+        return f.maxWidth()*nChars;
+    return f.horizontalAdvance(sText);
+}
+
+
+/*!
+ * \brief largestFontSize Binary search of the largest font fitting a width
+ * \return The font size or defaultSize if even (lastSize-1) fits
+ *
+ * The text width grows with the font size: just a few font
+ * metrics are needed instead of one for every size.
+ */
+static int
+largestFontSize(const QString& sFamily, const QString& sText, int nChars,
+                int maxWidth, int lastSize, int defaultSize) {
+    int low  = FIRST_FONT_SIZE;
+    int high = lastSize;
+    // Look for the first size too large
+    while(low < high) {
+        int size = (low+high)/2;
+        if(textWidth(QFont(sFamily, size, QFont::Black), sText, nChars) > maxWidth)
+            high = size;
+        else
+            low = size+1;
+    }
+    if(low >= lastSize)
+        return defaultSize;
+    return low-1;
+}
+
+
+/*!
+ * \brief ScorePanel::fittingFontSize The largest font size for a text to fit a width
+ * \param sFamily The font family (in Black weight)
+ * \param sText The text to show
+ * \param maxWidth The available width
+ * \param lastSize The sizes tried are below this one
+ * \param defaultSize The size returned if even the largest one fits
+ * \return The font size
+ */
+int
+ScorePanel::fittingFontSize(QString sFamily, QString sText, int maxWidth, int lastSize, int defaultSize) {
+    return largestFontSize(sFamily, sText, 0, maxWidth, lastSize, defaultSize);
+}
+
+
+/*!
+ * \brief ScorePanel::fittingFontSize The largest font size for nChars characters to fit a width
+ * \param sFamily The font family (in Black weight)
+ * \param nChars The number of (widest) characters to show
+ * \param maxWidth The available width
+ * \param lastSize The sizes tried are below this one
+ * \param defaultSize The size returned if even the largest one fits
+ * \return The font size
+ */
+int
+ScorePanel::fittingFontSize(QString sFamily, int nChars, int maxWidth, int lastSize, int defaultSize) {
+    return largestFontSize(sFamily, QString(), nChars, maxWidth, lastSize, defaultSize);
+}
+
+
+/*!
+ * \brief ScorePanel::mirrorFields Invoked when the orientation is applied
+ *
+ * The derived panels update here the fields whose content
+ * (not only position) depends on the panel orientation.
+ */
+void
+ScorePanel::mirrorFields() {
+}
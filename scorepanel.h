@@ -34,6 +34,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
     #include "slidewindow.h"
 #endif
 #include "serverdiscoverer.h"
+#include "panelconnection.h"
+#include "latencymonitor.h"
 
 #if (QT_VERSION < QT_VERSION_CHECK(5, 11, 0))
     #define horizontalAdvance width
@@ -41,14 +43,19 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 
 QT_BEGIN_NAMESPACE
-QT_FORWARD_DECLARE_CLASS(QSettings)
+QT_FORWARD_DECLARE_CLASS(SettingsStore)
+QT_FORWARD_DECLARE_CLASS(PanTiltController)
+QT_FORWARD_DECLARE_CLASS(PanelCompositor)
 QT_FORWARD_DECLARE_CLASS(QFile)
 QT_FORWARD_DECLARE_CLASS(QUdpSocket)
 QT_FORWARD_DECLARE_CLASS(QWebSocket)
+QT_FORWARD_DECLARE_CLASS(QLabel)
+QT_FORWARD_DECLARE_CLASS(QScreen)
 QT_FORWARD_DECLARE_CLASS(SlideWindow)
 QT_FORWARD_DECLARE_CLASS(QGridLayout)
 QT_FORWARD_DECLARE_CLASS(UpdaterThread)
 QT_FORWARD_DECLARE_CLASS(FileUpdater)
+QT_FORWARD_DECLARE_CLASS(StatsSampler)
 QT_END_NAMESPACE
 
 
@@ -57,17 +64,20 @@ class ScorePanel : public QWidget
     Q_OBJECT
 
 public:
-    explicit ScorePanel(const QString& _serverUrl, QFile *myLogFile, QWidget *parent = Q_NULLPTR);
+    explicit ScorePanel(const QString& _serverUrl, QFile *myLogFile, QWidget *parent = Q_NULLPTR, ScorePanel *pPrimary = Q_NULLPTR);
     ~ScorePanel();
     void keyPressEvent(QKeyEvent *event);
     void closeEvent(QCloseEvent *event);
     void setScoreOnly(bool bScoreOnly);
     bool getScoreOnly();
+    virtual void followPanel(ScorePanel *pPrimary, int iScreen);
+    void setPanelScreen(QScreen *pScreen);
 
 signals:
     void updateSpots(); /*!< \brief emitted to start the Spot update process */
     void updateSlides();/*!< \brief emitted to start the Slide update process */
     void panelClosed(); /*!< \brief emitted to signal that the Panel has been closed */
+    void closing();     /*!< \brief emitted when the Panel window is closing */
 
 protected slots:
     void onTextMessageReceived(QString sMessage);
@@ -77,7 +87,8 @@ protected slots:
 private slots:
     void onPanelServerConnected();
     void onPanelServerDisconnected();
-    void onPanelServerSocketError(QAbstractSocket::SocketError error);
+    void onPanelServerReconnecting(int attempt, int msecDelay);
+    void onPanelServerLost();
     void onTimeToRefreshStatus();
     void onSlideShowClosed(int exitCode, QProcess::ExitStatus exitStatus);
     void onSpotClosed(int exitCode, QProcess::ExitStatus exitStatus);
@@ -88,14 +99,29 @@ private slots:
 
     void onSpotUpdaterThreadDone();
     void onSlideUpdaterThreadDone();
+    void onTimeToUpdateLatencyOverlay();
+    void onTimeToStartServices();
+    void onPanelScreenChanged(QScreen *pScreen);
 
 protected:
+    bool event(QEvent *event) Q_DECL_OVERRIDE;
     virtual QGridLayout* createPanel();
+    virtual void mirrorFields();
+    virtual void startServices();
+    virtual void resizeFonts();
+    static int fittingFontSize(QString sFamily, QString sText, int maxWidth, int lastSize, int defaultSize);
+    static int fittingFontSize(QString sFamily, int nChars, int maxWidth, int lastSize, int defaultSize);
 
     void buildLayout();
+    void applyOrientation();
+    void placeOnPanelScreen(QWidget *pWindow);
+    QRect panelScreenGeometry();
+    void fitTeamName(QLabel *pTeam);
+    void refreshPanel();
     void doProcessCleanup();
     void closeSpotUpdaterThread();
     void closeSlideUpdaterThread();
+    void showReconnectionOverlay(bool bShow);
 
 protected:
     /*!
@@ -108,9 +134,9 @@ protected:
      */
     bool               isScoreOnly;
     /*!
-     * \brief pPanelServerSocket The WebSocket to talk with the server
+     * \brief pPanelServerSocket The (reconnecting) connection to talk with the server
      */
-    QWebSocket        *pPanelServerSocket;
+    PanelConnection   *pPanelServerSocket;
     /*!
      * \brief logFile the file for message logging (if any)
      */
@@ -154,6 +180,7 @@ private:
     int                iCurrentSlide;
     QTimer             slideUpdaterRestartTimer;
 
+    QString            sMediaStoreDir;
     QString            logFileName;
 #if defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
     org::salvato::gabriele::SlideShowInterface *pMySlideWindow;
@@ -165,22 +192,37 @@ private:
     unsigned           tiltPin;
     double             cameraPanAngle;
     double             cameraTiltAngle;
-    int                gpioHostHandle;
-    unsigned           PWMfrequency;
-    quint32            dutyCycle;
-    double             pulseWidthAt_90;
-    double             pulseWidthAt90;
+    QThread           *pCameraThread;
+    PanTiltController *pCameraController;
 
 private:
     void               initCamera();
+    void               initSlideWindow();
+    void               initStatsSampler();
+    void               closeCamera();
     void               startLiveCamera();
     void               startSpotLoop();
     void               startSlideShow();
     void               getPanelScoreOnly();
+    void               processSlideShowMessage(QString sMessage);
 
 private:
-    QSettings         *pSettings;
+    SettingsStore     *pSettings;
     QWidget           *pPanel;
+    PanelCompositor   *pCompositor;
+    QGridLayout       *pPanelGrid;
+    bool               bGridMirrored;
+    bool               bUseCompositor;
+    QLabel            *pReconnectionLabel;
+    LatencyMonitor    *pLatencyMonitor;
+    QLabel            *pLatencyLabel;
+    QTimer             latencyOverlayTimer;
+    QThread           *pStatsThread;
+    StatsSampler      *pStatsSampler;
+    QTimer             servicesTimer;
+    bool               bServicesStarted;
+    ScorePanel        *pPrimaryPanel;/*!< The panel followed (if this is a secondary one) */
+    bool               bHasServer;/*!< false when replaying a recorded match (or on a secondary panel) */
 };
 
 #endif // SCOREPANEL_H
@@ -30,6 +30,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "utility.h"
 #include "segnapuntibasket.h"
+#include "scoredigits.h"
 
 
 /*!
@@ -41,9 +42,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
  * \brief SegnapuntiBasket::SegnapuntiBasket to show a Basket ScorePanel
  * \param myServerUrl
  * \param myLogFile
+ * \param pPrimary The primary panel (only for the secondary panels)
  */
-SegnapuntiBasket::SegnapuntiBasket(const QString &myServerUrl, QFile *myLogFile)
-    : TimedScorePanel(myServerUrl, myLogFile, Q_NULLPTR)
+SegnapuntiBasket::SegnapuntiBasket(const QString &myServerUrl, QFile *myLogFile, ScorePanel *pPrimary)
+    : TimedScorePanel(myServerUrl, myLogFile, Q_NULLPTR, pPrimary)
 {
 #ifndef Q_OS_ANDROID
     connect(this, SIGNAL(arduinoFound()),
@@ -51,10 +53,13 @@ SegnapuntiBasket::SegnapuntiBasket(const QString &myServerUrl, QFile *myLogFile)
     connect(this, SIGNAL(newTimeValue(QString)),
             this, SLOT(onNewTimeValue(QString)));
 #endif
-    connect(pPanelServerSocket, SIGNAL(textMessageReceived(QString)),
-            this, SLOT(onTextMessageReceived(QString)));
-    connect(pPanelServerSocket, SIGNAL(binaryMessageReceived(QByteArray)),
-            this, SLOT(onBinaryMessageReceived(QByteArray)));
+    // The secondary panels are fed by the primary one (see followPanel())
+    if(pPanelServerSocket) {
+        connect(pPanelServerSocket, SIGNAL(textMessageReceived(QString)),
+                this, SLOT(onTextMessageReceived(QString)));
+        connect(pPanelServerSocket, SIGNAL(binaryMessageReceived(QByteArray)),
+                this, SLOT(onBinaryMessageReceived(QByteArray)));
+    }
 
     pSettings = new QSettings("Gabriele Salvato", "Segnapunti Basket");
 
@@ -138,54 +143,29 @@ SegnapuntiBasket::onArduinoFound() {
  */
 void
 SegnapuntiBasket::buildFontSizes() {
-    QScreen *screen = QGuiApplication::primaryScreen();
-    QRect  screenGeometry = screen->geometry();
-    int width = screenGeometry.width();
-    iTeamFontSize = 100;
-    for(int i=12; i<100; i++) {
-        QFontMetrics f(QFont("Arial", i, QFont::Black));
-        int rW = f.maxWidth()*maxTeamNameLen;
-        if(rW > width/2) {
-            iTeamFontSize = i-1;
-            break;
-        }
-    }
-    iTimeoutFontSize = 100;
-    for(int i=12; i<300; i++) {
-        QFontMetrics f(QFont("Arial", i, QFont::Black));
-        int rW = f.horizontalAdvance("* * * ");
-        if(rW > width/6) {
-            iTimeoutFontSize = i-1;
-            break;
-        }
-    }
-    iBonusFontSize = 300;
-    for(int i=12; i<300; i++) {
-        QFontMetrics f(QFont("Arial", i, QFont::Black));
-        int rW = f.horizontalAdvance(" Bonus ");
-        if(rW > width/6) {
-            iBonusFontSize = i-1;
-            break;
-        }
-    }
-    iTimeFontSize = 300;
-    for(int i=12; i<300; i++) {
-        QFontMetrics f(QFont("Helvetica", i, QFont::Black));
-        int rW = f.horizontalAdvance("00:00");
-        if(rW > width/2) {
-            iTimeFontSize = i-1;
-            break;
-        }
-    }
-    iTeamFoulsFontSize = 100;
-    for(int i=12; i<300; i++) {
-        QFontMetrics f(QFont("Arial", i, QFont::Black));
-        int rW = f.horizontalAdvance("Team Fouls");
-        if(rW > width/3) {
-            iTeamFoulsFontSize = i-1;
-            break;
-        }
+    int width = panelScreenGeometry().width();
+    iTeamFontSize      = fittingFontSize("Arial", maxTeamNameLen, width/2, 100, 100);
+    iTimeoutFontSize   = fittingFontSize("Arial", "* * * ", width/6, 300, 100);
+    iBonusFontSize     = fittingFontSize("Arial", " Bonus ", width/6, 300, 300);
+    iTimeFontSize      = fittingFontSize("Helvetica", "00:00", width/2, 300, 300);
+    iTeamFoulsFontSize = fittingFontSize("Arial", "Team Fouls", width/3, 300, 100);
+}
+
+
+/*!
+ * \brief SegnapuntiBasket::resizeFonts Fit the fonts to the screen showing the panel
+ */
+void
+SegnapuntiBasket::resizeFonts() {
+    buildFontSizes();
+    for(int i=0; i<2; i++) {
+        fitTeamName(team[i]);
+        timeout[i]->setFont(QFont("Arial", iTimeoutFontSize, QFont::Black));
+        possess[i]->setFont(QFont("Times", iTimeoutFontSize, QFont::Black));
+        bonus[i]->setFont(QFont("Arial", iBonusFontSize, QFont::Black));
     }
+    timeLabel->setFont(QFont("Helvetica", iTimeFontSize, QFont::Black));
+    foulsLabel->setFont(QFont("Arial", iTeamFoulsFontSize, QFont::Black));
 }
 
 
@@ -205,14 +185,14 @@ SegnapuntiBasket::createPanelElements() {
     team[1]->setText(tr("Ospiti"));
     // Score
     for(int i=0; i<2; i++){
-        score[i] = new QLCDNumber(3);
-        score[i]->setSegmentStyle(QLCDNumber::Filled);
+        score[i] = new ScoreDigits(3);
+        score[i]->setSegmentStyle(ScoreDigits::Filled);
         score[i]->setFrameStyle(QFrame::NoFrame);
         score[i]->setPalette(pal);
         score[i]->display(188);
     }
     // Period
-    period = new QLCDNumber(2);
+    period = new ScoreDigits(2);
     period->setFrameStyle(QFrame::NoFrame);
     period->setPalette(pal);
     period->display(88);
@@ -254,7 +234,7 @@ SegnapuntiBasket::createPanelElements() {
     foulsLabel->setPalette(pal);
     foulsLabel->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
     for(int i=0; i<2; i++) {
-        teamFouls[i] = new QLCDNumber(2);
+        teamFouls[i] = new ScoreDigits(2);
         teamFouls[i]->setFrameStyle(QFrame::NoFrame);
         teamFouls[i]->setPalette(pal);
         teamFouls[i]->display(0);
@@ -271,58 +251,47 @@ SegnapuntiBasket::createPanel() {
     // The panel is a (22x24) grid
     QGridLayout *layout = new QGridLayout();
 
-    if(isMirrored) {// Reflect horizontally to respect teams position on the field
-        // Teams
-        layout->addWidget(team[1],       0,  0,  4, 12, Qt::AlignHCenter|Qt::AlignVCenter);
-        layout->addWidget(team[0],       0, 12,  4, 12, Qt::AlignHCenter|Qt::AlignVCenter);
-        // Score
-        layout->addWidget(score[1],      4,  0,  6,  6);
-        layout->addWidget(score[0],      4, 18,  6,  6);
-        // Possess
+    // Teams
+    layout->addWidget(team[0],       0,  0,  4, 12, Qt::AlignHCenter|Qt::AlignVCenter);
+    layout->addWidget(team[1],       0, 12,  4, 12, Qt::AlignHCenter|Qt::AlignVCenter);
+    // Score
+    layout->addWidget(score[0],      4,  0,  6,  6);
+    layout->addWidget(score[1],      4, 18,  6,  6);
+    // Possess
+    layout->addWidget(possess[0],    4,  6,  6,  4, Qt::AlignLeft|Qt::AlignVCenter);
+    layout->addWidget(possess[1],    4, 14,  6,  4, Qt::AlignRight|Qt::AlignVCenter);
+    // Timeouts
+    layout->addWidget(timeout[0],   12,  0,  3,  5, Qt::AlignRight|Qt::AlignVCenter);
+    layout->addWidget(timeout[1],   12, 19,  3,  5, Qt::AlignLeft|Qt::AlignVCenter);
+    // Bonus
+    layout->addWidget(bonus[0],     15,  0,  3,  5, Qt::AlignHCenter|Qt::AlignVCenter);
+    layout->addWidget(bonus[1],     15, 19,  3,  5, Qt::AlignHCenter|Qt::AlignVCenter);
+    // Team Fouls
+    layout->addWidget(teamFouls[0], 19,  3,  3,  2);
+    layout->addWidget(foulsLabel,   20,  5,  2, 15, Qt::AlignHCenter|Qt::AlignVCenter);
+    layout->addWidget(teamFouls[1], 19, 20,  3,  2);
+    // Period
+    layout->addWidget(period,            4, 10,  6,  4);
+    // Time
+    layout->addWidget(timeLabel,        10,  5, 10, 14, Qt::AlignHCenter|Qt::AlignVCenter);
+
+    return layout;
+}
+
+
+/*!
+ * \brief SegnapuntiBasket::mirrorFields The possess arrows must point to the right team
+ */
+void
+SegnapuntiBasket::mirrorFields() {
+    if(isMirrored) {
         possess[0]->setText("==>");
         possess[1]->setText("<==");
-        layout->addWidget(possess[1],    4,  6,  6,  4, Qt::AlignLeft|Qt::AlignVCenter);
-        layout->addWidget(possess[0],    4, 14,  6,  4, Qt::AlignRight|Qt::AlignVCenter);
-        // Timeouts
-        layout->addWidget(timeout[1],   12,  0,  3,  5, Qt::AlignRight|Qt::AlignVCenter);
-        layout->addWidget(timeout[0],   12, 19,  3,  5, Qt::AlignLeft|Qt::AlignVCenter);
-        // Bonus
-        layout->addWidget(bonus[1],     15,  0,  3,  5, Qt::AlignHCenter|Qt::AlignVCenter);
-        layout->addWidget(bonus[0],     15, 19,  3,  5, Qt::AlignHCenter|Qt::AlignVCenter);
-        // Team Fouls
-        layout->addWidget(teamFouls[1], 19,  3,  3,  2);
-        layout->addWidget(foulsLabel,   20,  5,  2, 15, Qt::AlignHCenter|Qt::AlignVCenter);
-        layout->addWidget(teamFouls[0], 19, 20,  3,  2);
     }
     else {
-        // Teams
-        layout->addWidget(team[0],       0,  0,  4, 12, Qt::AlignHCenter|Qt::AlignVCenter);
-        layout->addWidget(team[1],       0, 12,  4, 12, Qt::AlignHCenter|Qt::AlignVCenter);
-        // Score
-        layout->addWidget(score[0],      4,  0,  6,  6);
-        layout->addWidget(score[1],      4, 18,  6,  6);
-        // Possess
         possess[0]->setText("<==");
         possess[1]->setText("==>");
-        layout->addWidget(possess[0],    4,  6,  6,  4, Qt::AlignLeft|Qt::AlignVCenter);
-        layout->addWidget(possess[1],    4, 14,  6,  4, Qt::AlignRight|Qt::AlignVCenter);
-        // Timeouts
-        layout->addWidget(timeout[0],   12,  0,  3,  5, Qt::AlignRight|Qt::AlignVCenter);
-        layout->addWidget(timeout[1],   12, 19,  3,  5, Qt::AlignLeft|Qt::AlignVCenter);
-        // Bonus
-        layout->addWidget(bonus[0],     15,  0,  3,  5, Qt::AlignHCenter|Qt::AlignVCenter);
-        layout->addWidget(bonus[1],     15, 19,  3,  5, Qt::AlignHCenter|Qt::AlignVCenter);
-        // Team Fouls
-        layout->addWidget(teamFouls[0], 19,  3,  3,  2);
-        layout->addWidget(foulsLabel,   20,  5,  2, 15, Qt::AlignHCenter|Qt::AlignVCenter);
-        layout->addWidget(teamFouls[1], 19, 20,  3,  2);
     }
-    // Period
-    layout->addWidget(period,            4, 10,  6,  4);
-    // Time
-    layout->addWidget(timeLabel,        10,  5, 10, 14, Qt::AlignHCenter|Qt::AlignVCenter);
-
-    return layout;
 }
 
 #ifndef Q_OS_ANDROID
@@ -334,6 +303,7 @@ SegnapuntiBasket::createPanel() {
 void
 SegnapuntiBasket::onNewTimeValue(QString sTimeValue) {
     timeLabel->setText(sTimeValue);
+    refreshPanel();
 }
 #endif
 
@@ -344,9 +314,9 @@ SegnapuntiBasket::onNewTimeValue(QString sTimeValue) {
  */
 void
 SegnapuntiBasket::onBinaryMessageReceived(QByteArray baMessage) {
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("Received %1 bytes").arg(baMessage.size()));
+    LOG_INFO(LOG_PANEL,
+             logFile,
+             QString("Received %1 bytes").arg(baMessage.size()));
     ScorePanel::onBinaryMessageReceived(baMessage);
 }
 
@@ -366,33 +336,13 @@ SegnapuntiBasket::onTextMessageReceived(QString sMessage) {
     sToken = XML_Parse(sMessage, "team0");
     if(sToken != sNoData){
       team[0]->setText(sToken.left(maxTeamNameLen));
-      int width = QGuiApplication::primaryScreen()->geometry().width();
-      iVal = 100;
-      for(int i=12; i<100; i++) {
-          QFontMetrics f(QFont("Arial", i, QFont::Black));
-          int rW = f.horizontalAdvance(team[0]->text()+"  ");
-          if(rW > width/2) {
-              iVal = i-1;
-              break;
-          }
-      }
-      team[0]->setFont(QFont("Arial", iVal, QFont::Black));
+      fitTeamName(team[0]);
     }// team0
 
     sToken = XML_Parse(sMessage, "team1");
     if(sToken != sNoData){
       team[1]->setText(sToken.left(maxTeamNameLen));
-      int width = QGuiApplication::primaryScreen()->geometry().width();
-      iVal = 100;
-      for(int i=12; i<100; i++) {
-          QFontMetrics f(QFont("Arial", i, QFont::Black));
-          int rW = f.horizontalAdvance(team[1]->text()+"  ");
-          if(rW > width/2) {
-              iVal = i-1;
-              break;
-          }
-      }
-      team[1]->setFont(QFont("Arial", iVal, QFont::Black));
+      fitTeamName(team[1]);
     }// team1
 
     sToken = XML_Parse(sMessage, "period");
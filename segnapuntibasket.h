@@ -37,7 +37,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 QT_BEGIN_NAMESPACE
 class QSettings;
 class QGroupBox;
-class QLCDNumber;
+class ScoreDigits;
 class QFile;
 class QGridLayout;
 class QLayoutItem;
@@ -50,15 +50,15 @@ private:
     Q_OBJECT
 
 public:
-    explicit SegnapuntiBasket(const QString& myServerUrl, QFile *myLogFile);
+    explicit SegnapuntiBasket(const QString& myServerUrl, QFile *myLogFile, ScorePanel *pPrimary = Q_NULLPTR);
     ~SegnapuntiBasket();
     void closeEvent(QCloseEvent *event);
 
 private:
     QLabel            *team[2];
-    QLCDNumber        *score[2];
-    QLCDNumber        *period;
-    QLCDNumber        *teamFouls[2];
+    ScoreDigits       *score[2];
+    ScoreDigits       *period;
+    ScoreDigits       *teamFouls[2];
     QLabel            *timeLabel;
     QLabel            *timeout[2];
     QLabel            *bonus[2];
@@ -87,8 +87,10 @@ private slots:
 
 protected:
     void                   buildFontSizes();
+    void                   resizeFonts();
     void                   createPanelElements();
     QGridLayout           *createPanel();
+    void                   mirrorFields();
 };
 
 #endif // SEGNAPUNTIBASKET_H
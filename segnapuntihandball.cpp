@@ -21,7 +21,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QScreen>
 #include <QGridLayout>
 #include <QVBoxLayout>
-#include <QLCDNumber>
 #include <QThread>
 #include <QSettings>
 #include <QFile>
@@ -31,15 +30,17 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "utility.h"
 #include "segnapuntihandball.h"
+#include "scoredigits.h"
 
 
 /*!
  * \brief SegnapuntiHandball::SegnapuntiHandball
  * \param myServerUrl
  * \param myLogFile
+ * \param pPrimary The primary panel (only for the secondary panels)
  */
-SegnapuntiHandball::SegnapuntiHandball(const QString& myServerUrl, QFile *myLogFile)
-    : TimedScorePanel(myServerUrl, myLogFile, Q_NULLPTR)
+SegnapuntiHandball::SegnapuntiHandball(const QString& myServerUrl, QFile *myLogFile, ScorePanel *pPrimary)
+    : TimedScorePanel(myServerUrl, myLogFile, Q_NULLPTR, pPrimary)
 {
 #ifndef Q_OS_ANDROID
     connect(this, SIGNAL(arduinoFound()),
@@ -47,10 +48,13 @@ SegnapuntiHandball::SegnapuntiHandball(const QString& myServerUrl, QFile *myLogF
     connect(this, SIGNAL(newTimeValue(QString)),
             this, SLOT(onNewTimeValue(QString)));
 #endif
-    connect(pPanelServerSocket, SIGNAL(textMessageReceived(QString)),
-            this, SLOT(onTextMessageReceived(QString)));
-    connect(pPanelServerSocket, SIGNAL(binaryMessageReceived(QByteArray)),
-            this, SLOT(onBinaryMessageReceived(QByteArray)));
+    // The secondary panels are fed by the primary one (see followPanel())
+    if(pPanelServerSocket) {
+        connect(pPanelServerSocket, SIGNAL(textMessageReceived(QString)),
+                this, SLOT(onTextMessageReceived(QString)));
+        connect(pPanelServerSocket, SIGNAL(binaryMessageReceived(QByteArray)),
+                this, SLOT(onBinaryMessageReceived(QByteArray)));
+    }
 
     pSettings = new QSettings("Gabriele Salvato", "Segnapunti Handball");
 
@@ -136,36 +140,24 @@ SegnapuntiHandball::onArduinoFound() {
  */
 void
 SegnapuntiHandball::buildFontSizes() {
-    QScreen *screen = QGuiApplication::primaryScreen();
-    QRect  screenGeometry = screen->geometry();
-    int width = screenGeometry.width();
-    iTeamFontSize = 100;
-    for(int i=12; i<100; i++) {
-        QFontMetrics f(QFont("Arial", i, QFont::Black));
-        int rW = f.maxWidth()*maxTeamNameLen;
-        if(rW > width/2) {
-            iTeamFontSize = i-1;
-            break;
-        }
-    }
-    iTimeoutFontSize = 100;
-    for(int i=12; i<300; i++) {
-        QFontMetrics f(QFont("Arial", i, QFont::Black));
-        int rW = f.horizontalAdvance("* * * ");
-        if(rW > width/6) {
-            iTimeoutFontSize = i-1;
-            break;
-        }
-    }
-    iTimeFontSize = 300;
-    for(int i=12; i<300; i++) {
-        QFontMetrics f(QFont("Helvetica", i, QFont::Black));
-        int rW = f.horizontalAdvance("00:00");
-        if(rW > width/2) {
-            iTimeFontSize = i-1;
-            break;
-        }
+    int width = panelScreenGeometry().width();
+    iTeamFontSize    = fittingFontSize("Arial", maxTeamNameLen, width/2, 100, 100);
+    iTimeoutFontSize = fittingFontSize("Arial", "* * * ", width/6, 300, 100);
+    iTimeFontSize    = fittingFontSize("Helvetica", "00:00", width/2, 300, 300);
+}
+
+
+/*!
+ * \brief SegnapuntiHandball::resizeFonts Fit the fonts to the screen showing the panel
+ */
+void
+SegnapuntiHandball::resizeFonts() {
+    buildFontSizes();
+    for(int i=0; i<2; i++) {
+        fitTeamName(team[i]);
+        timeout[i]->setFont(QFont("Arial", iTimeoutFontSize, QFont::Black));
     }
+    timeLabel->setFont(QFont("Helvetica", iTimeFontSize, QFont::Black));
 }
 
 
@@ -185,14 +177,14 @@ SegnapuntiHandball::createPanelElements() {
     team[1]->setText(tr("Ospiti"));
     // Score
     for(int i=0; i<2; i++){
-        score[i] = new QLCDNumber(3);
-        score[i]->setSegmentStyle(QLCDNumber::Filled);
+        score[i] = new ScoreDigits(3);
+        score[i]->setSegmentStyle(ScoreDigits::Filled);
         score[i]->setFrameStyle(QFrame::NoFrame);
         score[i]->setPalette(pal);
         score[i]->display(188);
     }
     // Period
-    period = new QLCDNumber(2);
+    period = new ScoreDigits(2);
     period->setFrameStyle(QFrame::NoFrame);
     period->setPalette(pal);
     period->display(88);
@@ -223,28 +215,15 @@ SegnapuntiHandball::createPanel() {
     // The panel is a (22x24) grid
     QGridLayout *layout = new QGridLayout();
 
-    if(isMirrored) {// Reflect horizontally to respect teams position on the field
-        // Teams
-        layout->addWidget(team[1],       0,  0,  4, 12, Qt::AlignHCenter|Qt::AlignVCenter);
-        layout->addWidget(team[0],       0, 12,  4, 12, Qt::AlignHCenter|Qt::AlignVCenter);
-        // Score
-        layout->addWidget(score[1],      4,  0,  6,  6);
-        layout->addWidget(score[0],      4, 18,  6,  6);
-        // Timeouts
-        layout->addWidget(timeout[1],   12,  0,  3,  5, Qt::AlignRight|Qt::AlignVCenter);
-        layout->addWidget(timeout[0],   12, 19,  3,  5, Qt::AlignLeft|Qt::AlignVCenter);
-    }
-    else {
-        // Teams
-        layout->addWidget(team[0],       0,  0,  4, 12, Qt::AlignHCenter|Qt::AlignVCenter);
-        layout->addWidget(team[1],       0, 12,  4, 12, Qt::AlignHCenter|Qt::AlignVCenter);
-        // Score
-        layout->addWidget(score[0],      4,  0,  6,  6);
-        layout->addWidget(score[1],      4, 18,  6,  6);
-        // Timeouts
-        layout->addWidget(timeout[0],   12,  0,  3,  5, Qt::AlignRight|Qt::AlignVCenter);
-        layout->addWidget(timeout[1],   12, 19,  3,  5, Qt::AlignLeft|Qt::AlignVCenter);
-    }
+    // Teams
+    layout->addWidget(team[0],       0,  0,  4, 12, Qt::AlignHCenter|Qt::AlignVCenter);
+    layout->addWidget(team[1],       0, 12,  4, 12, Qt::AlignHCenter|Qt::AlignVCenter);
+    // Score
+    layout->addWidget(score[0],      4,  0,  6,  6);
+    layout->addWidget(score[1],      4, 18,  6,  6);
+    // Timeouts
+    layout->addWidget(timeout[0],   12,  0,  3,  5, Qt::AlignRight|Qt::AlignVCenter);
+    layout->addWidget(timeout[1],   12, 19,  3,  5, Qt::AlignLeft|Qt::AlignVCenter);
     // Period
     layout->addWidget(period,            4, 10,  6,  4);
     // Time
@@ -262,6 +241,7 @@ SegnapuntiHandball::createPanel() {
 void
 SegnapuntiHandball::onNewTimeValue(QString sTimeValue) {
     timeLabel->setText(sTimeValue);
+    refreshPanel();
 }
 #endif
 
@@ -272,9 +252,9 @@ SegnapuntiHandball::onNewTimeValue(QString sTimeValue) {
  */
 void
 SegnapuntiHandball::onBinaryMessageReceived(QByteArray baMessage) {
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("Received %1 bytes").arg(baMessage.size()));
+    LOG_INFO(LOG_PANEL,
+             logFile,
+             QString("Received %1 bytes").arg(baMessage.size()));
     ScorePanel::onBinaryMessageReceived(baMessage);
 }
 
@@ -293,33 +273,13 @@ SegnapuntiHandball::onTextMessageReceived(QString sMessage) {
     sToken = XML_Parse(sMessage, "team0");
     if(sToken != sNoData){
       team[0]->setText(sToken.left(maxTeamNameLen));
-      int width = QGuiApplication::primaryScreen()->geometry().width();
-      iVal = 100;
-      for(int i=12; i<100; i++) {
-          QFontMetrics f(QFont("Arial", i, QFont::Black));
-          int rW = f.horizontalAdvance(team[0]->text()+"  ");
-          if(rW > width/2) {
-              iVal = i-1;
-              break;
-          }
-      }
-      team[0]->setFont(QFont("Arial", iVal, QFont::Black));
+      fitTeamName(team[0]);
     }// team0
 
     sToken = XML_Parse(sMessage, "team1");
     if(sToken != sNoData){
       team[1]->setText(sToken.left(maxTeamNameLen));
-      int width = QGuiApplication::primaryScreen()->geometry().width();
-      iVal = 100;
-      for(int i=12; i<100; i++) {
-          QFontMetrics f(QFont("Arial", i, QFont::Black));
-          int rW = f.horizontalAdvance(team[1]->text()+"  ");
-          if(rW > width/2) {
-              iVal = i-1;
-              break;
-          }
-      }
-      team[1]->setFont(QFont("Arial", iVal, QFont::Black));
+      fitTeamName(team[1]);
     }// team1
 
     sToken = XML_Parse(sMessage, "period");
@@ -31,7 +31,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 
 QT_FORWARD_DECLARE_CLASS(QSettings)
-QT_FORWARD_DECLARE_CLASS(QLCDNumber)
+QT_FORWARD_DECLARE_CLASS(ScoreDigits)
 QT_FORWARD_DECLARE_CLASS(QFile)
 QT_FORWARD_DECLARE_CLASS(QGridLayout)
 
@@ -42,14 +42,14 @@ private:
     Q_OBJECT
 
 public:
-    SegnapuntiHandball(const QString& myServerUrl, QFile *myLogFile);
+    SegnapuntiHandball(const QString& myServerUrl, QFile *myLogFile, ScorePanel *pPrimary = Q_NULLPTR);
     ~SegnapuntiHandball();
     void closeEvent(QCloseEvent *event);
 
 private:
     QLabel            *team[2];
-    QLCDNumber        *score[2];
-    QLCDNumber        *period;
+    ScoreDigits       *score[2];
+    ScoreDigits       *period;
     QLabel            *timeLabel;
     QLabel            *timeout[2];
     QSettings         *pSettings;
@@ -76,6 +76,7 @@ private slots:
 
 protected:
     void                   buildFontSizes();
+    void                   resizeFonts();
     void                   createPanelElements();
     QGridLayout           *createPanel();
 };
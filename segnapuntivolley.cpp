@@ -27,6 +27,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QTime>
 
 #include "segnapuntivolley.h"
+#include "scoredigits.h"
 #include "timeoutwindow.h"
 #include "utility.h"
 
@@ -35,16 +36,20 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
  * \brief SegnapuntiVolley::SegnapuntiVolley
  * \param myServerUrl
  * \param myLogFile
+ * \param pPrimary The primary panel (only for the secondary panels)
  */
-SegnapuntiVolley::SegnapuntiVolley(const QString &myServerUrl, QFile *myLogFile)
-    : ScorePanel(myServerUrl, myLogFile, Q_NULLPTR)
+SegnapuntiVolley::SegnapuntiVolley(const QString &myServerUrl, QFile *myLogFile, ScorePanel *pPrimary)
+    : ScorePanel(myServerUrl, myLogFile, Q_NULLPTR, pPrimary)
     , iServizio(0)
     , pTimeoutWindow(Q_NULLPTR)
 {
-    connect(pPanelServerSocket, SIGNAL(textMessageReceived(QString)),
-            this, SLOT(onTextMessageReceived(QString)));
-    connect(pPanelServerSocket, SIGNAL(binaryMessageReceived(QByteArray)),
-            this, SLOT(onBinaryMessageReceived(QByteArray)));
+    // The secondary panels are fed by the primary one (see followPanel())
+    if(pPanelServerSocket) {
+        connect(pPanelServerSocket, SIGNAL(textMessageReceived(QString)),
+                this, SLOT(onTextMessageReceived(QString)));
+        connect(pPanelServerSocket, SIGNAL(binaryMessageReceived(QByteArray)),
+                this, SLOT(onBinaryMessageReceived(QByteArray)));
+    }
 
     pSettings = new QSettings("Gabriele Salvato", "Segnapunti Volley");
 
@@ -79,60 +84,34 @@ SegnapuntiVolley::SegnapuntiVolley(const QString &myServerUrl, QFile *myLogFile)
  */
 void
 SegnapuntiVolley::buildFontSizes() {
-    QScreen *screen = QGuiApplication::primaryScreen();
-    QRect  screenGeometry = screen->geometry();
-    int width = screenGeometry.width();
-    iTeamFontSize = 100;
-    for(int i=12; i<100; i++) {
-        QFontMetrics f(QFont("Arial", i, QFont::Black));
-        int rW = f.maxWidth()*maxTeamNameLen;
-        if(rW > width/2) {
-            iTeamFontSize = i-1;
-            break;
-        }
-    }
-    iTimeoutFontSize = 100;
-    for(int i=12; i<100; i++) {
-        QFontMetrics f(QFont("Arial", i, QFont::Black));
-        int rW = f.horizontalAdvance("Timeout");
-        if(rW > width/2) {
-            iTimeoutFontSize = i-1;
-            break;
-        }
-    }
-    iSetFontSize = 100;
-    for(int i=12; i<100; i++) {
-        QFontMetrics f(QFont("Arial", i, QFont::Black));
-        int rW = f.horizontalAdvance("Set Vinti");
-        if(rW > width/2) {
-            iSetFontSize = i-1;
-            break;
-        }
-    }
-    iServiceFontSize = 100;
-    for(int i=12; i<300; i++) {
-        QFontMetrics f(QFont("Arial", i, QFont::Black));
-        int rW = f.horizontalAdvance(" * ");
-        if(rW > width/10) {
-            iServiceFontSize = i-1;
-            break;
-        }
-    }
-    iScoreFontSize   = 100;
-    for(int i=12; i<300; i++) {
-        QFontMetrics f(QFont("Arial", i, QFont::Black));
-        int rW = f.horizontalAdvance("Punti");
-        if(rW > width/6) {
-            iScoreFontSize = i-1;
-            break;
-        }
-    }
+    int width = panelScreenGeometry().width();
+    iTeamFontSize    = fittingFontSize("Arial", maxTeamNameLen, width/2, 100, 100);
+    iTimeoutFontSize = fittingFontSize("Arial", "Timeout", width/2, 100, 100);
+    iSetFontSize     = fittingFontSize("Arial", "Set Vinti", width/2, 100, 100);
+    iServiceFontSize = fittingFontSize("Arial", " * ", width/10, 300, 100);
+    iScoreFontSize   = fittingFontSize("Arial", "Punti", width/6, 300, 100);
     int minFontSize = qMin(iScoreFontSize, iTimeoutFontSize);
     minFontSize = qMin(minFontSize, iSetFontSize);
     iScoreFontSize = iTimeoutFontSize = iSetFontSize = minFontSize;
 }
 
 
+/*!
+ * \brief SegnapuntiVolley::resizeFonts Fit the fonts to the screen showing the panel
+ */
+void
+SegnapuntiVolley::resizeFonts() {
+    buildFontSizes();
+    timeoutLabel->setFont(QFont("Arial", iTimeoutFontSize, QFont::Black));
+    setLabel->setFont(QFont("Arial", iSetFontSize, QFont::Black));
+    scoreLabel->setFont(QFont("Arial", iScoreFontSize, QFont::Black));
+    for(int i=0; i<2; i++) {
+        servizio[i]->setFont(QFont("Arial", iServiceFontSize, QFont::Black));
+        fitTeamName(team[i]);
+    }
+}
+
+
 /*!
  * \brief SegnapuntiVolley::~SegnapuntiVolley
  */
@@ -160,9 +139,9 @@ SegnapuntiVolley::closeEvent(QCloseEvent *event) {
  */
 void
 SegnapuntiVolley::onBinaryMessageReceived(QByteArray baMessage) {
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("Received %1 bytes").arg(baMessage.size()));
+    LOG_INFO(LOG_PANEL,
+             logFile,
+             QString("Received %1 bytes").arg(baMessage.size()));
     ScorePanel::onBinaryMessageReceived(baMessage);
 }
 
@@ -181,33 +160,13 @@ SegnapuntiVolley::onTextMessageReceived(QString sMessage) {
     sToken = XML_Parse(sMessage, "team0");
     if(sToken != sNoData){
       team[0]->setText(sToken.left(maxTeamNameLen));
-      int width = QGuiApplication::primaryScreen()->geometry().width();
-      iVal = 100;
-      for(int i=12; i<100; i++) {
-          QFontMetrics f(QFont("Arial", i, QFont::Black));
-          int rW = f.horizontalAdvance(team[0]->text()+"  ");
-          if(rW > width/2) {
-              iVal = i-1;
-              break;
-          }
-      }
-      team[0]->setFont(QFont("Arial", iVal, QFont::Black));
+      fitTeamName(team[0]);
     }// team0
 
     sToken = XML_Parse(sMessage, "team1");
     if(sToken != sNoData){
       team[1]->setText(sToken.left(maxTeamNameLen));
-      int width = QGuiApplication::primaryScreen()->geometry().width();
-      iVal = 100;
-      for(int i=12; i<100; i++) {
-          QFontMetrics f(QFont("Arial", i, QFont::Black));
-          int rW = f.horizontalAdvance(team[1]->text()+"  ");
-          if(rW > width/2) {
-              iVal = i-1;
-              break;
-          }
-      }
-      team[1]->setFont(QFont("Arial", iVal, QFont::Black));
+      fitTeamName(team[1]);
     }// team1
 
     sToken = XML_Parse(sMessage, "set0");
@@ -248,6 +207,7 @@ SegnapuntiVolley::onTextMessageReceived(QString sMessage) {
         iVal = sToken.toInt(&ok);
         if(!ok || iVal<0)
           iVal = 30;
+        placeOnPanelScreen(pTimeoutWindow);
         pTimeoutWindow->startTimeout(iVal*1000);
         pTimeoutWindow->showFullScreen();
     }// timeout1
@@ -309,7 +269,7 @@ SegnapuntiVolley::createPanelElements() {
     timeoutLabel->setPalette(pal);
     timeoutLabel->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
     for(int i=0; i<2; i++) {
-        timeout[i] = new QLCDNumber(1);
+        timeout[i] = new ScoreDigits(1);
         timeout[i]->setFrameStyle(QFrame::NoFrame);
         timeout[i]->setPalette(pal);
         timeout[i]->display(8);
@@ -321,7 +281,7 @@ SegnapuntiVolley::createPanelElements() {
     setLabel->setPalette(pal);
     setLabel->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
     for(int i=0; i<2; i++) {
-        set[i] = new QLCDNumber(1);
+        set[i] = new ScoreDigits(1);
         set[i]->setFrameStyle(QFrame::NoFrame);
         set[i]->setPalette(pal);
         set[i]->display(8);
@@ -333,8 +293,8 @@ SegnapuntiVolley::createPanelElements() {
     scoreLabel->setPalette(pal);
     scoreLabel->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
     for(int i=0; i<2; i++){
-        score[i] = new QLCDNumber(2);
-        score[i]->setSegmentStyle(QLCDNumber::Filled);
+        score[i] = new ScoreDigits(2);
+        score[i]->setSegmentStyle(ScoreDigits::Filled);
         score[i]->setFrameStyle(QFrame::NoFrame);
         score[i]->setPalette(pal);
         score[i]->display(88);
@@ -367,36 +327,19 @@ QGridLayout*
 SegnapuntiVolley::createPanel() {
     QGridLayout *layout = new QGridLayout();
 
-    if(isMirrored) {
-        layout->addWidget(timeout[1],    0, 2, 2, 1);
-        layout->addWidget(timeoutLabel,  0, 3, 1, 6, Qt::AlignHCenter|Qt::AlignVCenter);
-        layout->addWidget(timeout[0],    0, 9, 2, 1);
-        layout->addWidget(set[1],        2, 2, 2, 1);
-        layout->addWidget(setLabel,      2, 3, 1, 6, Qt::AlignHCenter|Qt::AlignVCenter);
-        layout->addWidget(set[0],        2, 9, 2, 1);
-        layout->addWidget(score[1],      4, 1, 4, 3);
-        layout->addWidget(servizio[1],   4, 4, 4, 1, Qt::AlignLeft|Qt::AlignVCenter);
-        layout->addWidget(scoreLabel,    4, 5, 4, 2, Qt::AlignHCenter|Qt::AlignVCenter);
-        layout->addWidget(servizio[0],   4, 7, 4, 1, Qt::AlignRight|Qt::AlignVCenter);
-        layout->addWidget(score[0],      4, 8, 4, 3);
-        layout->addWidget(team[1],       8, 0, 2, 6, Qt::AlignHCenter|Qt::AlignVCenter);
-        layout->addWidget(team[0],       8, 6, 2, 6, Qt::AlignHCenter|Qt::AlignVCenter);
-    }
-    else {
-        layout->addWidget(timeout[0],    0, 2, 2, 1);
-        layout->addWidget(timeoutLabel,  0, 3, 1, 6, Qt::AlignHCenter|Qt::AlignVCenter);
-        layout->addWidget(timeout[1],    0, 9, 2, 1);
-        layout->addWidget(set[0],        2, 2, 2, 1);
-        layout->addWidget(setLabel,      2, 3, 1, 6, Qt::AlignHCenter|Qt::AlignVCenter);
-        layout->addWidget(set[1],        2, 9, 2, 1);
-        layout->addWidget(score[0],      4, 1, 4, 3);
-        layout->addWidget(servizio[0],   4, 4, 4, 1, Qt::AlignLeft|Qt::AlignVCenter);
-        layout->addWidget(scoreLabel,    4, 5, 4, 2, Qt::AlignHCenter|Qt::AlignVCenter);
-        layout->addWidget(servizio[1],   4, 7, 4, 1, Qt::AlignRight|Qt::AlignVCenter);
-        layout->addWidget(score[1],      4, 8, 4, 3);
-        layout->addWidget(team[0],       8, 0, 2, 6, Qt::AlignHCenter|Qt::AlignVCenter);
-        layout->addWidget(team[1],       8, 6, 2, 6, Qt::AlignHCenter|Qt::AlignVCenter);
-    }
+    layout->addWidget(timeout[0],    0, 2, 2, 1);
+    layout->addWidget(timeoutLabel,  0, 3, 1, 6, Qt::AlignHCenter|Qt::AlignVCenter);
+    layout->addWidget(timeout[1],    0, 9, 2, 1);
+    layout->addWidget(set[0],        2, 2, 2, 1);
+    layout->addWidget(setLabel,      2, 3, 1, 6, Qt::AlignHCenter|Qt::AlignVCenter);
+    layout->addWidget(set[1],        2, 9, 2, 1);
+    layout->addWidget(score[0],      4, 1, 4, 3);
+    layout->addWidget(servizio[0],   4, 4, 4, 1, Qt::AlignLeft|Qt::AlignVCenter);
+    layout->addWidget(scoreLabel,    4, 5, 4, 2, Qt::AlignHCenter|Qt::AlignVCenter);
+    layout->addWidget(servizio[1],   4, 7, 4, 1, Qt::AlignRight|Qt::AlignVCenter);
+    layout->addWidget(score[1],      4, 8, 4, 3);
+    layout->addWidget(team[0],       8, 0, 2, 6, Qt::AlignHCenter|Qt::AlignVCenter);
+    layout->addWidget(team[1],       8, 6, 2, 6, Qt::AlignHCenter|Qt::AlignVCenter);
 
     return layout;
 }
@@ -405,13 +348,11 @@ SegnapuntiVolley::createPanel() {
 void
 SegnapuntiVolley::changeEvent(QEvent *event) {
      if (event->type() == QEvent::LanguageChange) {
-         #ifdef LOG_VERBOSE
-             logMessage(logFile,
-                        Q_FUNC_INFO,
-                        QString("%1  %2")
-                        .arg(setLabel->text())
-                        .arg(scoreLabel->text()));
-         #endif
+         LOG_DEBUG(LOG_PANEL,
+                   logFile,
+                   QString("%1  %2")
+                   .arg(setLabel->text())
+                   .arg(scoreLabel->text()));
          setLabel->setText(tr("Set Vinti"));
          scoreLabel->setText(tr("Punti"));
      } else
@@ -34,7 +34,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 QT_FORWARD_DECLARE_CLASS(QSettings)
 QT_FORWARD_DECLARE_CLASS(QGroupBox)
-QT_FORWARD_DECLARE_CLASS(QLCDNumber)
+QT_FORWARD_DECLARE_CLASS(ScoreDigits)
 QT_FORWARD_DECLARE_CLASS(QFile)
 QT_FORWARD_DECLARE_CLASS(QGridLayout)
 QT_FORWARD_DECLARE_CLASS(TimeoutWindow)
@@ -45,7 +45,7 @@ class SegnapuntiVolley : public ScorePanel
     Q_OBJECT
 
 public:
-    SegnapuntiVolley(const QString& myServerUrl, QFile *myLogFile);
+    SegnapuntiVolley(const QString& myServerUrl, QFile *myLogFile, ScorePanel *pPrimary = Q_NULLPTR);
     ~SegnapuntiVolley();
     void closeEvent(QCloseEvent *event);
     void changeEvent(QEvent *event);
@@ -53,12 +53,12 @@ public:
 private:
     QSettings         *pSettings;
     QLabel            *team[2];
-    QLCDNumber        *score[2];
+    ScoreDigits       *score[2];
     QLabel            *scoreLabel;
-    QLCDNumber        *set[2];
+    ScoreDigits       *set[2];
     QLabel            *setLabel;
     QLabel            *servizio[2];
-    QLCDNumber        *timeout[2];
+    ScoreDigits       *timeout[2];
     QLabel            *timeoutLabel;
     QPalette           pal;
     int                iServizio;
@@ -79,6 +79,7 @@ private slots:
 
 protected:
     void buildFontSizes();
+    void resizeFonts();
 };
 
 #endif // SEGNAPUNTIVOLLEY_H
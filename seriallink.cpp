@@ -0,0 +1,173 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QSerialPort>
+#include <QThread>
+
+#include "seriallink.h"
+#include "utility.h"
+
+
+static const char startMarker = char(0xFF);
+static const char endMarker   = char(0xFE);
+
+
+/*!
+ * \brief SerialLink::SerialLink The Arduino serial traffic, on its own thread
+ * \param myPort The (open) serial port connected to the Arduino
+ * \param myLogFile The File for message logging (if any)
+ *
+ * The SerialLink takes the ownership of the port and must be moved,
+ * together with it, into a dedicated thread. The serial data are read
+ * and decoded there (by an ArduinoDecoder). The last Time value received is published in a
+ * single (atomic) slot that the GUI thread empties with takeTime()
+ * once per frame: the game clock keeps up even when the GUI thread is
+ * busy and the intermediate values are simply overwritten.
+ * The other frames are signalled with frameReceived().
+ */
+SerialLink::SerialLink(QSerialPort *myPort, QFile *myLogFile)
+    : QObject(Q_NULLPTR)
+    , logFile(myLogFile)
+    , pSerialPort(myPort)
+    , latestTime(NO_TIME_VALUE)
+{
+    pSerialPort->setParent(this);
+}
+
+
+/*!
+ * \brief SerialLink::start Start reading the serial port
+ *
+ * To be connected to the started() signal of the serial thread.
+ */
+void
+SerialLink::start() {
+    decoder.reset();
+    connect(pSerialPort, SIGNAL(readyRead()),
+            this, SLOT(onSerialDataAvailable()));
+    // Data arrived while the port was changing thread
+    if(pSerialPort->bytesAvailable() > 0)
+        onSerialDataAvailable();
+}
+
+
+/*!
+ * \brief SerialLink::takeTime Get (and remove) the last Time value received
+ * \param pTime [out] The time in hundredths of second
+ * \return false if no new value arrived since the last call
+ *
+ * Called from the GUI thread.
+ */
+bool
+SerialLink::takeTime(quint32 *pTime) {
+    quint32 time = latestTime.fetchAndStoreAcquire(NO_TIME_VALUE);
+    if(time == NO_TIME_VALUE)
+        return false;
+    *pTime = time;
+    return true;
+}
+
+
+/*!
+ * \brief SerialLink::write Write a request to the Arduino
+ * \param requestData The (already encoded) request
+ */
+void
+SerialLink::write(QByteArray requestData) {
+    if(!pSerialPort->isOpen()) {
+        LOG_DEBUG(LOG_SERIAL,
+                  logFile,
+                  QString("Serial port %1 has been closed")
+                  .arg(pSerialPort->portName()));
+        return;
+    }
+    pSerialPort->write(requestData);
+}
+
+
+/*!
+ * \brief SerialLink::close Tell the Arduino to stop sending and close the port
+ */
+void
+SerialLink::close() {
+    if(!pSerialPort->isOpen())
+        return;
+    LOG_DEBUG(LOG_SERIAL,
+              logFile,
+              QString("Closing serial port %1")
+              .arg(pSerialPort->portName()));
+    QByteArray requestData;
+    requestData.append(startMarker);
+    requestData.append(char(4));
+    requestData.append(char(StopSending));
+    requestData.append(endMarker);
+    pSerialPort->write(requestData);
+    if(!pSerialPort->waitForBytesWritten(1000)) {// in msec
+        LOG_ERROR(LOG_SERIAL,
+                  logFile,
+                  QString("Unable to Close serial port %1")
+                  .arg(pSerialPort->portName()));
+    }
+    QThread::sleep(1);// In sec. Give Arduino the time to react
+    pSerialPort->disconnect(this);
+    pSerialPort->clear();
+    pSerialPort->close();
+}
+
+
+/*!
+ * \brief SerialLink::onSerialDataAvailable Invoked asynchronously when there are data
+ * to read from the USB port
+ *
+ * The data are read straight into the decoder ring buffer.
+ */
+void
+SerialLink::onSerialDataAvailable() {
+    while(pSerialPort->bytesAvailable() > 0) {
+        int nFree;
+        char* pWrite = decoder.writePointer(&nFree);
+        qint64 nRead = pSerialPort->read(pWrite, nFree);
+        if(nRead <= 0)
+            break;
+        decoder.commitWrite(int(nRead));
+        while(decoder.nextFrame())
+            processFrame(decoder.frame(), decoder.frameSize());
+    }
+}
+
+
+/*!
+ * \brief SerialLink::processFrame Publish the Time values, signal the other frames
+ * \param frame The decoded frame
+ * \param frameSize Its size
+ */
+void
+SerialLink::processFrame(const quint8 *frame, int frameSize) {
+    if(frameSize < 2)
+        return;
+    if(frame[1] == quint8(Time)) {
+        if(frameSize != 6) return;
+        quint32 time = 0;
+        for(int i=2; i<6; i++) {
+            time += quint32(frame[i]) << ((i-2)*8);
+        }
+        latestTime.storeRelease(time);
+        return;
+    }
+    emit frameReceived(QByteArray(reinterpret_cast<const char*>(frame), frameSize));
+}
@@ -0,0 +1,64 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef SERIALLINK_H
+#define SERIALLINK_H
+
+#include <QObject>
+#include <QAtomicInteger>
+
+#include "arduinodecoder.h"
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+QT_FORWARD_DECLARE_CLASS(QSerialPort)
+
+
+#define NO_TIME_VALUE 0xFFFFFFFF // The time slot is empty
+
+
+class SerialLink : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SerialLink(QSerialPort *myPort, QFile *myLogFile=Q_NULLPTR);
+    bool takeTime(quint32 *pTime);
+
+signals:
+    void frameReceived(QByteArray frame);/*!< Emitted for the (decoded) frames other than Time */
+
+public slots:
+    void start();
+    void write(QByteArray requestData);
+    void close();
+
+private slots:
+    void onSerialDataAvailable();
+
+private:
+    void processFrame(const quint8 *frame, int frameSize);
+
+private:
+    QFile                  *logFile;
+    QSerialPort            *pSerialPort;
+    ArduinoDecoder          decoder;
+    QAtomicInteger<quint32> latestTime;
+};
+
+#endif // SERIALLINK_H
@@ -18,6 +18,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <QCoreApplication>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QWindow>
 #include <QNetworkInterface>
 #include <QNetworkAddressEntry>
 #include <QUdpSocket>
@@ -26,8 +29,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QSettings>
 
 #include "serverdiscoverer.h"
+#include "myapplication.h"
 #include "messagewindow.h"
 #include "utility.h"
+#include "startuptrace.h"
 #include "scorepanel.h"
 #include "segnapuntivolley.h"
 #include "segnapuntibasket.h"
@@ -105,29 +110,27 @@ ServerDiscoverer::Discover() {
             connect(pDiscoverySocket, SIGNAL(readyRead()),
                     this, SLOT(onProcessDiscoveryPendingDatagrams()));
             if(!pDiscoverySocket->bind()) {
-                logMessage(logFile,
-                           Q_FUNC_INFO,
-                           QString("Unable to bind the Discovery Socket"));
+                LOG_ERROR(LOG_DISCOVERY,
+                          logFile,
+                          QString("Unable to bind the Discovery Socket"));
                 continue;
             }
             pDiscoverySocket->setMulticastInterface(iface);
             pDiscoverySocket->setSocketOption(QAbstractSocket::MulticastTtlOption, 1);
             written = pDiscoverySocket->writeDatagram(datagram.data(), datagram.size(),
                                                       discoveryAddress, discoveryPort);
-#ifdef LOG_VERBOSE_VERBOSE
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Writing %1 to %2 - interface# %3/%4 : %5")
-                       .arg(sMessage)
-                       .arg(discoveryAddress.toString())
-                       .arg(i)
-                       .arg(ifaces.count())
-                       .arg(iface.humanReadableName()));
-#endif
+            LOG_TRACE(LOG_DISCOVERY,
+                      logFile,
+                      QString("Writing %1 to %2 - interface# %3/%4 : %5")
+                      .arg(sMessage)
+                      .arg(discoveryAddress.toString())
+                      .arg(i)
+                      .arg(ifaces.count())
+                      .arg(iface.humanReadableName()));
             if(written != datagram.size()) {
-                logMessage(logFile,
-                           Q_FUNC_INFO,
-                           QString("Unable to write to Discovery Socket"));
+                LOG_ERROR(LOG_DISCOVERY,
+                          logFile,
+                          QString("Unable to write to Discovery Socket"));
             }
             else {
                 bStarted = true;
@@ -151,9 +154,9 @@ void
 ServerDiscoverer::onDiscoverySocketError(QAbstractSocket::SocketError socketError) {
     Q_UNUSED(socketError)
     QUdpSocket *pClient = qobject_cast<QUdpSocket *>(sender());
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               pClient->errorString());
+    LOG_ERROR(LOG_DISCOVERY,
+              logFile,
+              pClient->errorString());
     return;
 }
 
@@ -173,31 +176,28 @@ ServerDiscoverer::onProcessDiscoveryPendingDatagrams() {
     while(pSocket->hasPendingDatagrams()) {
         datagram.resize(int(pSocket->pendingDatagramSize()));
         if(pSocket->readDatagram(datagram.data(), datagram.size()) == -1) {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Error reading from udp socket: %1")
-                       .arg(serverUrl));
+            LOG_ERROR(LOG_DISCOVERY,
+                      logFile,
+                      QString("Error reading from udp socket: %1")
+                      .arg(serverUrl));
         }
         answer.append(datagram);
     }
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("pDiscoverySocket Received: %1")
-               .arg(answer.data()));
-#endif
+    LOG_DEBUG(LOG_DISCOVERY,
+              logFile,
+              QString("pDiscoverySocket Received: %1")
+              .arg(answer.data()));
     sToken = XML_Parse(answer.data(), "serverIP");
     if(sToken != sNoData) {
         serverList = QStringList(sToken.split(";",QString::SkipEmptyParts));
         if(serverList.isEmpty())
             return;
-#ifdef LOG_VERBOSE
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Found %1 addresses")
-                   .arg(serverList.count()));
-#endif
+        LOG_DEBUG(LOG_DISCOVERY,
+                  logFile,
+                  QString("Found %1 addresses")
+                  .arg(serverList.count()));
         // A well formed answer has been received.
+        StartupTrace::mark(logFile, QString("Server found"));
         serverConnectionTimeoutTimer.stop();
         serverConnectionTimeoutTimer.disconnect();
         // Remove all the "discovery sockets" to avoid overlapping
@@ -223,12 +223,10 @@ ServerDiscoverer::checkServerAddresses() {
             serverUrl= QString("ws://%1:%2").arg(arguments.at(0)).arg(serverPort);
             // Last Panel Type will win (is this right ?)
             panelType = arguments.at(1).toInt();
-#ifdef LOG_VERBOSE
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Trying Server URL: %1")
-                       .arg(serverUrl));
-#endif
+            LOG_DEBUG(LOG_DISCOVERY,
+                      logFile,
+                      QString("Trying Server URL: %1")
+                      .arg(serverUrl));
             pPanelServerSocket = new QWebSocket();
             serverSocketArray.append(pPanelServerSocket);
             connect(pPanelServerSocket, SIGNAL(connected()),
@@ -247,39 +245,59 @@ ServerDiscoverer::checkServerAddresses() {
  */
 void
 ServerDiscoverer::onPanelServerConnected() {
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("Connected to Server URL: %1")
-               .arg(serverUrl));
-#endif
+    LOG_DEBUG(LOG_DISCOVERY,
+              logFile,
+              QString("Connected to Server URL: %1")
+              .arg(serverUrl));
     serverConnectionTimeoutTimer.stop();
     serverConnectionTimeoutTimer.disconnect();
     QWebSocket* pSocket = qobject_cast<QWebSocket*>(sender());
     serverUrl = pSocket->requestUrl().toString();
     cleanServerSockets();
+    StartupTrace::mark(logFile, QString("Server connected"));
 
-    // Delete old Panel instance to prevent memory leaks
+    // Delete old Panel instances to prevent memory leaks
+    // (the secondary ones first: they follow the primary)
+    closeSecondaryPanels();
     if(pScorePanel) {
         pScorePanel->disconnect();
         delete pScorePanel;
         pScorePanel = Q_NULLPTR;
     }
-    if(panelType == VOLLEY_PANEL) {
-        pScorePanel = new SegnapuntiVolley(serverUrl, logFile);
-    }
-    else if(panelType == BASKET_PANEL) {
-        pScorePanel = new SegnapuntiBasket(serverUrl, logFile);
-    }
-    else if(panelType == HANDBALL_PANEL) {
-        pScorePanel = new SegnapuntiHandball(serverUrl, logFile);
-    }
+    pScorePanel = newPanel(serverUrl);
     connect(pScorePanel, SIGNAL(panelClosed()),
             this, SLOT(onPanelClosed()));
+    StartupTrace::mark(logFile, QString("Panel created"));
 
     delete pNoServerWindow;
     pNoServerWindow = Q_NULLPTR;
     pScorePanel->showFullScreen();
+
+    // The other screens show the same score, fed by the
+    // primary Panel connection, each with its own orientation
+    MyApplication* application = static_cast<MyApplication *>(QApplication::instance());
+    QList<QScreen*> screens = QGuiApplication::screens();
+    int nScreens = application->nScreens;
+    if((nScreens <= 0) || (nScreens > screens.count()))
+        nScreens = screens.count();
+    QScreen* pPrimaryScreen = pScorePanel->windowHandle() ?
+                              pScorePanel->windowHandle()->screen() :
+                              QGuiApplication::primaryScreen();
+    for(int i=0; (i<screens.count()) && (secondaryPanels.count()<nScreens-1); i++) {
+        QScreen* pScreen = screens.at(i);
+        if(pScreen == pPrimaryScreen)
+            continue;
+        ScorePanel* pSecondary = newPanel(QString(), pScorePanel);
+        pSecondary->followPanel(pScorePanel, secondaryPanels.count()+1);
+        pSecondary->setPanelScreen(pScreen);
+        pSecondary->showFullScreen();
+        secondaryPanels.append(pSecondary);
+        LOG_INFO(LOG_DISCOVERY,
+                 logFile,
+                 QString("Secondary Panel shown on %1")
+                 .arg(pScreen->name()));
+    }
+    StartupTrace::mark(logFile, QString("Panel shown"));
 }
 
 
@@ -289,12 +307,12 @@ ServerDiscoverer::onPanelServerConnected() {
  */
 void
 ServerDiscoverer::onPanelServerSocketError(QAbstractSocket::SocketError error) {
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("%1 %2 Error %3")
-               .arg(pPanelServerSocket->requestUrl().toString())
-               .arg(pPanelServerSocket->errorString())
-               .arg(error));
+    LOG_ERROR(LOG_DISCOVERY,
+              logFile,
+              QString("%1 %2 Error %3")
+              .arg(pPanelServerSocket->requestUrl().toString())
+              .arg(pPanelServerSocket->errorString())
+              .arg(error));
 }
 
 
@@ -330,6 +348,7 @@ ServerDiscoverer::onServerConnectionTimeout() {
  */
 void
 ServerDiscoverer::onPanelClosed() {
+    closeSecondaryPanels();
     if(pNoServerWindow == Q_NULLPTR) {
         pNoServerWindow = new MessageWindow(Q_NULLPTR);
         pNoServerWindow->setDisplayedText(tr("In Attesa della Connessione con il Server"));
@@ -347,16 +366,45 @@ ServerDiscoverer::onPanelClosed() {
 }
 
 
+/*!
+ * \brief ServerDiscoverer::newPanel Create the Score Panel for the discovered Server
+ * \param sUrl The Server URL (empty for the Panels following the primary one)
+ * \param pPrimary The primary Panel (only for the Panels following it)
+ * \return The new (not yet shown) Panel
+ */
+ScorePanel*
+ServerDiscoverer::newPanel(QString sUrl, ScorePanel *pPrimary) {
+    if(panelType == BASKET_PANEL)
+        return new SegnapuntiBasket(sUrl, logFile, pPrimary);
+    if(panelType == HANDBALL_PANEL)
+        return new SegnapuntiHandball(sUrl, logFile, pPrimary);
+    return new SegnapuntiVolley(sUrl, logFile, pPrimary);
+}
+
+
+/*!
+ * \brief ServerDiscoverer::closeSecondaryPanels Close the Panels on the other screens
+ */
+void
+ServerDiscoverer::closeSecondaryPanels() {
+    for(int i=0; i<secondaryPanels.count(); i++) {
+        ScorePanel* pSecondary = secondaryPanels.at(i);
+        pSecondary->disconnect();
+        pSecondary->close();
+        pSecondary->deleteLater();
+    }
+    secondaryPanels.clear();
+}
+
+
 /*!
  * \brief ServerDiscoverer::cleanDiscoverySockets
  */
 void
 ServerDiscoverer::cleanDiscoverySockets() {
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("Cleaning Discovery Sockets"));
-#endif
+    LOG_DEBUG(LOG_DISCOVERY,
+              logFile,
+              QString("Cleaning Discovery Sockets"));
     for(int i=0; i<discoverySocketArray.count(); i++) {
         QUdpSocket *pDiscovery = qobject_cast<QUdpSocket *>(discoverySocketArray.at(i));
         pDiscovery->disconnect();
@@ -367,11 +415,9 @@ ServerDiscoverer::cleanDiscoverySockets() {
         pDiscovery->deleteLater();//
     }
     discoverySocketArray.clear();
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("Done Cleaning Discovery Sockets"));
-#endif
+    LOG_DEBUG(LOG_DISCOVERY,
+              logFile,
+              QString("Done Cleaning Discovery Sockets"));
 }
 
 
@@ -380,11 +426,9 @@ ServerDiscoverer::cleanDiscoverySockets() {
  */
 void
 ServerDiscoverer::cleanServerSockets() {
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("Cleaning Server Sockets"));
-#endif
+    LOG_DEBUG(LOG_DISCOVERY,
+              logFile,
+              QString("Cleaning Server Sockets"));
     for(int i=0; i<serverSocketArray.count(); i++) {
         QWebSocket *pServer = qobject_cast<QWebSocket *>(serverSocketArray.at(i));
         pServer->disconnect();
@@ -395,10 +439,8 @@ ServerDiscoverer::cleanServerSockets() {
         pServer->deleteLater();
     }
     serverSocketArray.clear();
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("Done Cleaning Server Sockets"));
-#endif
+    LOG_DEBUG(LOG_DISCOVERY,
+              logFile,
+              QString("Done Cleaning Server Sockets"));
 }
 
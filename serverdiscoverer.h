@@ -60,6 +60,8 @@ protected:
 private:
     void cleanDiscoverySockets();
     void cleanServerSockets();
+    ScorePanel* newPanel(QString sUrl, ScorePanel *pPrimary = Q_NULLPTR);
+    void closeSecondaryPanels();
 
 private:
     QFile               *logFile;
@@ -76,6 +78,7 @@ private:
     QTimer               serverConnectionTimeoutTimer;
     MessageWindow       *pNoServerWindow;
     ScorePanel          *pScorePanel;
+    QList<ScorePanel*>   secondaryPanels;/*!< The Panels on the other screens */
 };
 
 #endif // SERVERDISCOVERER_H
@@ -0,0 +1,213 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QSettings>
+#include <QStringList>
+#include <QFile>
+
+#if defined(Q_OS_LINUX)
+    #include <stdio.h>
+    #include <unistd.h>
+    #include <errno.h>
+    #include <string.h>
+#endif
+
+#include "settingsstore.h"
+#include "utility.h"
+
+
+/*!
+ * \brief SettingsStore::SettingsStore A write-behind cache of the QSettings
+ * \param myOrganization The QSettings organization name
+ * \param myApplication The QSettings application name
+ * \param myLogFile The File for message logging (if any)
+ * \param parent The parent object
+ *
+ * All the values are read once and kept in memory. The changes are
+ * only marked as dirty and written together after SETTINGS_FLUSH_TIME ms
+ * without new changes (or at most SETTINGS_MAX_DELAY ms after the first
+ * one), so that dragging the camera sliders does not rewrite the whole
+ * configuration file on the SD card at every step.
+ * Call flush() to write the pending changes immediately (it is done
+ * anyway when the store is destroyed).
+ */
+SettingsStore::SettingsStore(QString myOrganization, QString myApplication, QFile *myLogFile, QObject *parent)
+    : QObject(parent)
+    , logFile(myLogFile)
+    , sOrganization(myOrganization)
+    , sApplication(myApplication)
+    , nAvoidedWrites(0)
+    , nFlushes(0)
+{
+    QSettings settings(sOrganization, sApplication);
+    const QStringList keys = settings.allKeys();
+    for(const QString& sKey : keys)
+        values.insert(sKey, settings.value(sKey));
+    flushTimer.setSingleShot(true);
+    connect(&flushTimer, SIGNAL(timeout()),
+            this, SLOT(flush()));
+}
+
+
+/*!
+ * \brief SettingsStore::~SettingsStore Write the pending changes (if any)
+ */
+SettingsStore::~SettingsStore() {
+    flushTimer.stop();
+    flush();
+}
+
+
+/*!
+ * \brief SettingsStore::value
+ * \param sKey The setting key
+ * \param defaultValue Returned when the setting does not exist
+ * \return The (in memory) value of the setting
+ */
+QVariant
+SettingsStore::value(const QString& sKey, const QVariant& defaultValue) const {
+    return values.value(sKey, defaultValue);
+}
+
+
+/*!
+ * \brief SettingsStore::setValue Change a setting (to be written later)
+ * \param sKey The setting key
+ * \param newValue The new value
+ */
+void
+SettingsStore::setValue(const QString& sKey, const QVariant& newValue) {
+    QMap<QString, QVariant>::const_iterator it = values.constFind(sKey);
+    if((it != values.constEnd()) && (it.value() == newValue)) {
+        nAvoidedWrites++;// Nothing changed
+        return;
+    }
+    values.insert(sKey, newValue);
+    if(dirtyKeys.contains(sKey))
+        nAvoidedWrites++;// Coalesced with the pending change
+    else
+        dirtyKeys.insert(sKey);
+    if(!dirtyTime.isValid())
+        dirtyTime.start();
+    // Debounce, but don't postpone the writing forever
+    qint64 maxWait = SETTINGS_MAX_DELAY-dirtyTime.elapsed();
+    flushTimer.start(int(qBound(qint64(0), maxWait, qint64(SETTINGS_FLUSH_TIME))));
+}
+
+
+/*!
+ * \brief SettingsStore::avoidedWrites
+ * \return The number of setValue() that did not cause a file write
+ */
+int
+SettingsStore::avoidedWrites() const {
+    return nAvoidedWrites;
+}
+
+
+/*!
+ * \brief SettingsStore::flush Write all the pending changes at once
+ */
+void
+SettingsStore::flush() {
+    flushTimer.stop();
+    if(dirtyKeys.isEmpty())
+        return;
+    if(!writeAtomically())
+        writeInPlace();
+    nFlushes++;
+    LOG_DEBUG(LOG_PANEL,
+              logFile,
+              QString("%1 setting(s) saved (flush %2, %3 writes avoided)")
+              .arg(dirtyKeys.count())
+              .arg(nFlushes)
+              .arg(nAvoidedWrites));
+    dirtyKeys.clear();
+    dirtyTime.invalidate();
+}
+
+
+/*!
+ * \brief SettingsStore::writeAtomically Write a new configuration file and
+ * replace the old one
+ * \return false if not possible (the settings will be written in place)
+ *
+ * The settings written by others (i.e. the Arduino Ids) are preserved
+ * by starting from the current file content. A power loss during the
+ * writing leaves the old file untouched.
+ */
+bool
+SettingsStore::writeAtomically() {
+#if defined(Q_OS_LINUX)
+    QString sFileName;
+    QString sTempName;
+    {
+        QSettings settings(sOrganization, sApplication);
+        sFileName = settings.fileName();
+        sTempName = sFileName + QString(".tmp");
+        QFile::remove(sTempName);
+        QSettings newSettings(sTempName, QSettings::IniFormat);
+        const QStringList keys = settings.allKeys();
+        for(const QString& sKey : keys)
+            newSettings.setValue(sKey, settings.value(sKey));
+        const QList<QString> changedKeys = dirtyKeys.values();
+        for(const QString& sKey : changedKeys)
+            newSettings.setValue(sKey, values.value(sKey));
+        newSettings.sync();
+        if(newSettings.status() != QSettings::NoError) {
+            LOG_ERROR(LOG_PANEL,
+                      logFile,
+                      QString("Unable to write %1").arg(sTempName));
+            QFile::remove(sTempName);
+            return false;
+        }
+    }
+    // Make sure the data are on the card before replacing the old file
+    QFile tempFile(sTempName);
+    if(tempFile.open(QIODevice::ReadOnly)) {
+        ::fsync(tempFile.handle());
+        tempFile.close();
+    }
+    if(::rename(QFile::encodeName(sTempName).constData(),
+                QFile::encodeName(sFileName).constData()) != 0) {
+        LOG_ERROR(LOG_PANEL,
+                  logFile,
+                  QString("Unable to rename %1: %2")
+                  .arg(sTempName)
+                  .arg(strerror(errno)));
+        QFile::remove(sTempName);
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+/*!
+ * \brief SettingsStore::writeInPlace Write the pending changes with QSettings
+ */
+void
+SettingsStore::writeInPlace() {
+    QSettings settings(sOrganization, sApplication);
+    const QList<QString> changedKeys = dirtyKeys.values();
+    for(const QString& sKey : changedKeys)
+        settings.setValue(sKey, values.value(sKey));
+    settings.sync();
+}
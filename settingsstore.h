@@ -0,0 +1,67 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef SETTINGSSTORE_H
+#define SETTINGSSTORE_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVariant>
+#include <QMap>
+#include <QSet>
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+
+
+#define SETTINGS_FLUSH_TIME  2000 // In msec (quiet time before writing the changes)
+#define SETTINGS_MAX_DELAY  10000 // In msec (max time a change may stay unwritten)
+
+
+class SettingsStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    SettingsStore(QString myOrganization, QString myApplication, QFile *myLogFile=Q_NULLPTR, QObject *parent=Q_NULLPTR);
+    ~SettingsStore();
+    QVariant value(const QString& sKey, const QVariant& defaultValue=QVariant()) const;
+    void setValue(const QString& sKey, const QVariant& newValue);
+    int avoidedWrites() const;
+
+public slots:
+    void flush();
+
+private:
+    bool writeAtomically();
+    void writeInPlace();
+
+private:
+    QFile                  *logFile;
+    QString                 sOrganization;
+    QString                 sApplication;
+    QMap<QString, QVariant> values;
+    QSet<QString>           dirtyKeys;
+    QTimer                  flushTimer;
+    QElapsedTimer           dirtyTime;
+    int                     nAvoidedWrites;
+    int                     nFlushes;
+};
+
+#endif // SETTINGSSTORE_H
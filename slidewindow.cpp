@@ -20,13 +20,23 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QDebug>
 #include <QPainter>
 #include <QApplication>
+#include <QDateTime>
 
 #include "slidewindow.h"
+#include "statssampler.h"
+
+#if (QT_VERSION < QT_VERSION_CHECK(5, 10, 0))
+    #define sizeInBytes byteCount
+#endif
 
 
 #define STEADY_SHOW_TIME       5000// Change slide time
 #define TRANSITION_TIME        3000 // Transition duration
 #define TRANSITION_GRANULARITY 30   // Steps to complete transition
+#define DECODED_SLIDES_CACHE   98304 // In KB (the decoded slides kept in memory)
+
+
+QCache<QString, QImage> SlideWindow::decodedSlides(DECODED_SLIDES_CACHE);
 
 
 /*!
@@ -118,6 +128,29 @@ SlideWindow::updateSlideList() {
 }
 
 
+/*!
+ * \brief SlideWindow::decodedSlide The decoded image of a slide
+ * \param slideInfo The slide file
+ * \return The image (decoded only once for all the screens)
+ *
+ * The images are keyed by path and modification time so that
+ * an updated slide is decoded again.
+ */
+QImage
+SlideWindow::decodedSlide(const QFileInfo& slideInfo) {
+    QString sKey = QString("%1@%2")
+                   .arg(slideInfo.absoluteFilePath())
+                   .arg(slideInfo.lastModified().toMSecsSinceEpoch());
+    QImage* pImage = decodedSlides.object(sKey);
+    if(pImage)
+        return *pImage;
+    QImage image(slideInfo.absoluteFilePath());
+    if(!image.isNull())
+        decodedSlides.insert(sKey, new QImage(image), qMax(1, int(image.sizeInBytes()/1024)));
+    return image;
+}
+
+
 /*!
  * \brief SlideWindow::addNewImage
  * \param image
@@ -132,7 +165,7 @@ SlideWindow::addNewImage(QImage image) {
         if(slideList.count() > 1) {
             iCurrentSlide += 1;
             iCurrentSlide = iCurrentSlide % slideList.count();
-            pNextImage = new QImage(slideList.at(iCurrentSlide).absoluteFilePath());
+            pNextImage = new QImage(decodedSlide(slideList.at(iCurrentSlide)));
         }
     }
     else if(pNextImage == Q_NULLPTR) {
@@ -180,6 +213,7 @@ SlideWindow::addNewImage(QImage image) {
         painter.end();
 
         setPixmap(QPixmap::fromImage(*pShownImage));
+        StatsSampler::countSlideFrame();
     }
     else {
         delete pPresentImage;
@@ -197,10 +231,10 @@ SlideWindow::startSlideShow() {
     updateSlideList();
     if(slideList.count() > 0) {
         if(pPresentImage == Q_NULLPTR) {// That's the first image...
-            addNewImage(QImage(slideList.at(0).absoluteFilePath()));
+            addNewImage(decodedSlide(slideList.at(0)));
             iCurrentSlide = 0;
             if(slideList.count() > 1) {
-                addNewImage(QImage(slideList.at(1).absoluteFilePath()));
+                addNewImage(decodedSlide(slideList.at(1)));
                 iCurrentSlide = 1;
             }
             else {// Only one image is in the directory
@@ -338,6 +372,7 @@ SlideWindow::resizeEvent(QResizeEvent *event) {
     painter.end();
 
     setPixmap(QPixmap::fromImage(*pShownImage));
+    StatsSampler::countSlideFrame();
 }
 
 
@@ -351,12 +386,12 @@ SlideWindow::onNewSlideTimer() {
         return;
     }
     if(pPresentImage == Q_NULLPTR) {// That's the first image...
-        addNewImage(QImage(slideList.at(0).absoluteFilePath()));
+        addNewImage(decodedSlide(slideList.at(0)));
         iCurrentSlide = 0;
     }
     if(pPresentImage == Q_NULLPTR) {
         if(slideList.count() > 1) {
-            addNewImage(QImage(slideList.at(1).absoluteFilePath()));
+            addNewImage(decodedSlide(slideList.at(1)));
             iCurrentSlide = 1;
         }
         else {// Only one image is in the directory
@@ -378,7 +413,7 @@ SlideWindow::onNewSlideTimer() {
         }
         iCurrentSlide += 1;
         iCurrentSlide = iCurrentSlide % slideList.count();
-        addNewImage(QImage(slideList.at(iCurrentSlide).absoluteFilePath()));
+        addNewImage(decodedSlide(slideList.at(iCurrentSlide)));
         QImage scaledNextImage = pNextImage->scaled(size(), Qt::KeepAspectRatio);
         pNextImageToShow = new QImage(size(), QImage::Format_ARGB32_Premultiplied);
 
@@ -404,6 +439,7 @@ SlideWindow::onNewSlideTimer() {
         painter.end();
 
         setPixmap(QPixmap::fromImage(*pShownImage));
+        StatsSampler::countSlideFrame();
     }
     else if (transitionType == transition_Fade) {
         showTimer.stop();
@@ -435,7 +471,7 @@ SlideWindow::onTransitionTimeElapsed() {
         }
         iCurrentSlide += 1;
         iCurrentSlide = iCurrentSlide % slideList.count();
-        addNewImage(QImage(slideList.at(iCurrentSlide).absoluteFilePath()));
+        addNewImage(decodedSlide(slideList.at(iCurrentSlide)));
 
         QImage scaledNextImage = pNextImage->scaled(size(), Qt::KeepAspectRatio);
         pNextImageToShow    = new QImage(size(), QImage::Format_ARGB32_Premultiplied);
@@ -476,4 +512,5 @@ SlideWindow::onTransitionTimeElapsed() {
         painter.end();
     }
     setPixmap(QPixmap::fromImage(*pShownImage));
+    StatsSampler::countSlideFrame();
 }
@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QTimer>
 #include <QLabel>
 #include <QFileInfoList>
+#include <QCache>
 
 #include <qevent.h>
 
@@ -55,6 +56,7 @@ public:
 private:
     void computeRegions(QRect* sourcePresent, QRect* destinationPresent, QRect* sourceNext, QRect* destinationNext);
     void updateSlideList();
+    static QImage decodedSlide(const QFileInfo& slideInfo);
 
 public slots:
     void onNewSlideTimer();
@@ -86,6 +88,8 @@ private:
 
     transitionMode transitionType;
     bool bRunning;
+
+    static QCache<QString, QImage> decodedSlides;/*!< Shared by the Slide Windows of all the screens */
 };
 
 #endif // SLIDEWINDOW_H
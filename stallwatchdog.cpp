@@ -0,0 +1,253 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QStringList>
+
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+    #include <pthread.h>
+    #include <signal.h>
+    #include <execinfo.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+#include "stallwatchdog.h"
+#include "utility.h"
+
+
+#define BACKTRACE_FRAMES 64 // Max frames captured on a stall
+#define BACKTRACE_WAIT   100// In msec (time allowed to the GUI thread to answer)
+
+
+// Stall histogram bucket lower limits (msec)
+static const int stallBuckets[] = { STALL_THRESHOLD, 500, 1000, 2000, 5000 };
+static const int nStallBuckets  = int(sizeof(stallBuckets)/sizeof(stallBuckets[0]));
+
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+// Written by the GUI thread in the signal handler
+static pthread_t             guiThread;
+static void*                 backtraceFrames[BACKTRACE_FRAMES];
+static volatile sig_atomic_t nBacktraceFrames = 0;
+static volatile sig_atomic_t bBacktraceReady  = 0;
+#endif
+
+
+/*!
+ * \brief StallWatchdog::StallWatchdog Watch the GUI event loop responsiveness
+ * \param myLogFile The File for message logging (if any)
+ * \param parent The parent object
+ *
+ * To be created in the GUI thread. Every WATCHDOG_PERIOD ms the watchdog
+ * thread queues a ping to the GUI event loop and measures how long it
+ * takes to be served. When the GUI thread does not answer within
+ * STALL_THRESHOLD ms a backtrace of the GUI thread is logged, showing
+ * where it is blocked (Linux only; link with -rdynamic for the symbol
+ * names). The stall durations are collected in a histogram that the
+ * Server can query with <getStalls>.
+ */
+StallWatchdog::StallWatchdog(QFile *myLogFile, QObject *parent)
+    : QThread(parent)
+    , logFile(myLogFile)
+    , pingTime(0)
+    , bPingPending(0)
+    , bStallReported(false)
+    , lastLatency(0)
+    , maxLatency(0)
+    , nStalls(0)
+{
+    stallHistogram.fill(0, nStallBuckets);
+    clock.start();
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+    guiThread = pthread_self();
+    // The first backtrace() loads libgcc (allocating memory):
+    // done here and not in the signal handler
+    void* warmUpFrames[2];
+    backtrace(warmUpFrames, 2);
+    struct sigaction action;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags   = SA_RESTART;
+    action.sa_handler = StallWatchdog::onBacktraceRequest;
+    sigaction(SIGUSR2, &action, Q_NULLPTR);
+#endif
+}
+
+
+/*!
+ * \brief StallWatchdog::~StallWatchdog
+ */
+StallWatchdog::~StallWatchdog() {
+    stop();
+}
+
+
+/*!
+ * \brief StallWatchdog::stop Stop watching
+ */
+void
+StallWatchdog::stop() {
+    if(!isRunning())
+        return;
+    requestInterruption();
+    wait();
+}
+
+
+/*!
+ * \brief StallWatchdog::run The watchdog loop
+ */
+void
+StallWatchdog::run() {
+    while(!isInterruptionRequested()) {
+        qint64 now = clock.elapsed();
+        if(!bPingPending.loadAcquire()) {
+            bStallReported = false;
+            pingTime.storeRelease(now);
+            bPingPending.storeRelease(1);
+            QMetaObject::invokeMethod(this, "onPing", Qt::QueuedConnection);
+        }
+        else if(!bStallReported && (now-pingTime.loadAcquire() > STALL_THRESHOLD)) {
+            bStallReported = true;
+            reportStall(now-pingTime.loadAcquire());
+        }
+        msleep(WATCHDOG_PERIOD);
+    }
+}
+
+
+/*!
+ * \brief StallWatchdog::onPing The GUI event loop served the ping
+ *
+ * Executed in the GUI thread.
+ */
+void
+StallWatchdog::onPing() {
+    lastLatency = clock.elapsed()-pingTime.loadAcquire();
+    maxLatency  = qMax(maxLatency, lastLatency);
+    bPingPending.storeRelease(0);
+    if(lastLatency <= STALL_THRESHOLD)
+        return;
+    nStalls++;
+    int iBucket = 0;
+    while((iBucket < nStallBuckets-1) && (lastLatency >= stallBuckets[iBucket+1]))
+        iBucket++;
+    stallHistogram[iBucket]++;
+    LOG_ERROR(LOG_PANEL,
+              logFile,
+              QString("GUI event loop stalled for %1 ms").arg(lastLatency));
+}
+
+
+/*!
+ * \brief StallWatchdog::reportStall Log where the GUI thread is blocked
+ * \param msecStalled For how long it has been blocked
+ *
+ * Executed in the watchdog thread.
+ */
+void
+StallWatchdog::reportStall(qint64 msecStalled) {
+    QString sBacktrace;
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+    bBacktraceReady = 0;
+    if(pthread_kill(guiThread, SIGUSR2) == 0) {
+        for(int i=0; (i<BACKTRACE_WAIT) && !bBacktraceReady; i++)
+            msleep(1);
+        // Skip the signal handler and the signal trampoline
+        if(bBacktraceReady && (int(nBacktraceFrames) > 2)) {
+            // backtrace_symbols_fd() does not allocate memory (the GUI
+            // thread could be blocked holding the allocator lock). The
+            // write end does not block: at worst the backtrace is cut.
+            int fds[2];
+            if(pipe(fds) == 0) {
+                fcntl(fds[1], F_SETFL, O_NONBLOCK);
+                backtrace_symbols_fd(backtraceFrames+2, int(nBacktraceFrames)-2, fds[1]);
+                ::close(fds[1]);
+                QByteArray baSymbols;
+                char buffer[4096];
+                ssize_t nRead;
+                while((nRead = ::read(fds[0], buffer, sizeof(buffer))) > 0)
+                    baSymbols.append(buffer, int(nRead));
+                ::close(fds[0]);
+                QList<QByteArray> symbols = baSymbols.split('\n');
+                for(int i=0; i<symbols.count(); i++) {
+                    if(!symbols.at(i).isEmpty())
+                        sBacktrace += QString("\n    #%1 %2").arg(i).arg(QString::fromLocal8Bit(symbols.at(i)));
+                }
+            }
+        }
+    }
+#endif
+    LOG_ERROR(LOG_PANEL,
+              logFile,
+              QString("GUI event loop blocked for more than %1 ms%2")
+              .arg(msecStalled)
+              .arg(sBacktrace));
+}
+
+
+/*!
+ * \brief StallWatchdog::onBacktraceRequest Capture the GUI thread backtrace
+ * \param signalNumber Unused
+ *
+ * Executed (as a signal handler) in the GUI thread.
+ */
+void
+StallWatchdog::onBacktraceRequest(int signalNumber) {
+    Q_UNUSED(signalNumber)
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+    nBacktraceFrames = backtrace(backtraceFrames, BACKTRACE_FRAMES);
+    bBacktraceReady  = 1;
+#endif
+}
+
+
+/*!
+ * \brief StallWatchdog::report The answer to the Server <getStalls> request
+ * \return "stalls,max GUI latency,last GUI latency,histogram..." where
+ * the histogram counts the stalls of 250-500, 500-1000, 1000-2000,
+ * 2000-5000 and over 5000 ms (times in msec)
+ */
+QString
+StallWatchdog::report() {
+    QStringList values;
+    values << QString::number(nStalls)
+           << QString::number(maxLatency)
+           << QString::number(lastLatency);
+    for(int i=0; i<nStallBuckets; i++)
+        values << QString::number(stallHistogram.at(i));
+    return values.join(QString(","));
+}
+
+
+/*!
+ * \brief StallWatchdog::guiLatency
+ * \return The last measured GUI event loop latency (msec)
+ */
+qint64
+StallWatchdog::guiLatency() {
+    return lastLatency;
+}
+
+
+/*!
+ * \brief StallWatchdog::maxGuiLatency
+ * \return The worst GUI event loop latency since the start (msec)
+ */
+qint64
+StallWatchdog::maxGuiLatency() {
+    return maxLatency;
+}
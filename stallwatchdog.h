@@ -0,0 +1,71 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef STALLWATCHDOG_H
+#define STALLWATCHDOG_H
+
+#include <QThread>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QVector>
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+
+
+#define WATCHDOG_PERIOD  100 // In msec (GUI event loop ping interval)
+#define STALL_THRESHOLD  250 // In msec (longer GUI latencies are stalls)
+
+
+class StallWatchdog : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit StallWatchdog(QFile *myLogFile=Q_NULLPTR, QObject *parent=Q_NULLPTR);
+    ~StallWatchdog();
+    QString report();
+    qint64 guiLatency();
+    qint64 maxGuiLatency();
+
+public slots:
+    void stop();
+
+protected:
+    void run() Q_DECL_OVERRIDE;
+
+private slots:
+    void onPing();
+
+private:
+    void reportStall(qint64 msecStalled);
+    static void onBacktraceRequest(int signalNumber);
+
+private:
+    QFile                  *logFile;
+    QElapsedTimer           clock;
+    QAtomicInteger<qint64>  pingTime;
+    QAtomicInt              bPingPending;
+    bool                    bStallReported;
+    qint64                  lastLatency;
+    qint64                  maxLatency;
+    int                     nStalls;
+    QVector<int>            stallHistogram;
+};
+
+#endif // STALLWATCHDOG_H
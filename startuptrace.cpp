@@ -0,0 +1,110 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include "startuptrace.h"
+#include "utility.h"
+
+
+/*!
+ * \class StartupTrace
+ * \brief Time the phases of the Panel startup
+ *
+ * Each phase is logged (subsystem "startup") with the time since
+ * the program start and since the previous phase: the log shows
+ * where the time to the first score on screen goes.
+ * After finish() the phases are no more logged (e.g. the ones
+ * repeated upon a Server reconnection).
+ * To be used from the GUI thread only.
+ */
+QElapsedTimer StartupTrace::startTime;
+qint64        StartupTrace::lastMark = 0;
+bool          StartupTrace::bFirstScoreShown = false;
+bool          StartupTrace::bFinished = false;
+
+
+/*!
+ * \brief StartupTrace::start To be called as soon as the program starts
+ */
+void
+StartupTrace::start() {
+    startTime.start();
+    lastMark = 0;
+    bFirstScoreShown = false;
+    bFinished = false;
+}
+
+
+/*!
+ * \brief StartupTrace::mark Log the end of a startup phase
+ * \param logFile The file for message logging (if any)
+ * \param sPhase The phase just completed
+ */
+void
+StartupTrace::mark(QFile *logFile, QString sPhase) {
+    if(bFinished)
+        return;
+    if(!startTime.isValid())
+        start();
+    qint64 now = startTime.elapsed();
+    LOG_INFO(LOG_STARTUP,
+             logFile,
+             QString("%1: %2 ms (+%3 ms)")
+             .arg(sPhase)
+             .arg(now)
+             .arg(now-lastMark));
+    lastMark = now;
+}
+
+
+/*!
+ * \brief StartupTrace::firstScoreShown Log the time to the first score on screen
+ * \param logFile The file for message logging (if any)
+ *
+ * Only the first call is logged.
+ */
+void
+StartupTrace::firstScoreShown(QFile *logFile) {
+    if(bFirstScoreShown)
+        return;
+    bFirstScoreShown = true;
+    mark(logFile, QString("First score shown"));
+    LOG_INFO(LOG_STARTUP,
+             logFile,
+             QString("Time to first score: %1 ms").arg(startTime.elapsed()));
+}
+
+
+/*!
+ * \brief StartupTrace::isFirstScoreShown
+ * \return true if the score has already been shown
+ */
+bool
+StartupTrace::isFirstScoreShown() {
+    return bFirstScoreShown;
+}
+
+
+/*!
+ * \brief StartupTrace::finish Log the end of the startup
+ * \param logFile The file for message logging (if any)
+ */
+void
+StartupTrace::finish(QFile *logFile) {
+    mark(logFile, QString("Startup completed"));
+    bFinished = true;
+}
@@ -0,0 +1,45 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <QString>
+#include <QElapsedTimer>
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+
+
+class StartupTrace
+{
+public:
+    static void start();
+    static void mark(QFile *logFile, QString sPhase);
+    static void firstScoreShown(QFile *logFile);
+    static bool isFirstScoreShown();
+    static void finish(QFile *logFile);
+
+private:
+    static QElapsedTimer startTime;
+    static qint64        lastMark;
+    static bool          bFirstScoreShown;
+    static bool          bFinished;
+};
+
+#endif // STARTUPTRACE_H
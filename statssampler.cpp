@@ -0,0 +1,246 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QTimer>
+#include <QFile>
+#include <QStorageInfo>
+#include <QStringList>
+
+#if defined(Q_OS_LINUX)
+    #include <unistd.h>
+#endif
+
+#include "statssampler.h"
+
+
+QAtomicInteger<qint64> StatsSampler::transferredBytes(0);
+QAtomicInt             StatsSampler::slideFrames(0);
+
+
+/*!
+ * \brief StatsSampler::StatsSampler Collect the Panel resource usage
+ * \param mySpotDir The Spots directory
+ * \param mySlideDir The Slides directory
+ * \param parent The parent object
+ *
+ * To be moved into its own (low priority) thread: every STATS_SAMPLE_TIME
+ * ms it reads the CPU usage and the resident memory from /proc, the free
+ * space of the media directories, the file transfer throughput and the
+ * slide show frame rate. The last sample is returned by report(), that
+ * can be called from any thread, as the answer to the Server <getStats>.
+ */
+StatsSampler::StatsSampler(QString mySpotDir, QString mySlideDir, QObject *parent)
+    : QObject(parent)
+    , sSpotDir(mySpotDir)
+    , sSlideDir(mySlideDir)
+    , pSampleTimer(Q_NULLPTR)
+    , lastSystemTotal(0)
+    , lastSystemIdle(0)
+    , lastProcessTicks(0)
+    , lastTransferred(0)
+    , lastSlideFrames(0)
+    , systemLoad(-1.0)
+    , processLoad(-1.0)
+    , rssKB(-1)
+    , freeSpotMB(-1)
+    , freeSlideMB(-1)
+    , transferKBps(0.0)
+    , slideFps(0.0)
+{
+}
+
+
+/*!
+ * \brief StatsSampler::startSampling Start the periodic sampling
+ *
+ * To be connected to the started() signal of the sampler thread
+ * so that the timer lives in that thread.
+ */
+void
+StatsSampler::startSampling() {
+    pSampleTimer = new QTimer(this);
+    connect(pSampleTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToSample()));
+    readSystemTicks(&lastSystemTotal, &lastSystemIdle);
+    readProcessTicks(&lastProcessTicks);
+    lastTransferred = transferredBytes.loadAcquire();
+    lastSlideFrames = slideFrames.loadAcquire();
+    sampleClock.start();
+    pSampleTimer->start(STATS_SAMPLE_TIME);
+}
+
+
+/*!
+ * \brief StatsSampler::addTransferredBytes Count the bytes received by the FileUpdaters
+ * \param nBytes The bytes received
+ */
+void
+StatsSampler::addTransferredBytes(qint64 nBytes) {
+    transferredBytes.fetchAndAddRelaxed(nBytes);
+}
+
+
+/*!
+ * \brief StatsSampler::countSlideFrame Count a frame shown by the slide show
+ */
+void
+StatsSampler::countSlideFrame() {
+    slideFrames.fetchAndAddRelaxed(1);
+}
+
+
+/*!
+ * \brief StatsSampler::onTimeToSample Take a new sample
+ */
+void
+StatsSampler::onTimeToSample() {
+    double seconds = double(sampleClock.restart())/1000.0;
+    if(seconds <= 0.0)
+        return;
+
+    double newSystemLoad = -1.0;
+    quint64 total, idle;
+    if(readSystemTicks(&total, &idle) && (total > lastSystemTotal)) {
+        newSystemLoad = 100.0*(1.0-double(idle-lastSystemIdle)/double(total-lastSystemTotal));
+        lastSystemTotal = total;
+        lastSystemIdle  = idle;
+    }
+
+    double newProcessLoad = -1.0;
+    quint64 ticks;
+    if(readProcessTicks(&ticks)) {
+#if defined(Q_OS_LINUX)
+        double ticksPerSecond = double(sysconf(_SC_CLK_TCK));
+#else
+        double ticksPerSecond = 100.0;
+#endif
+        newProcessLoad = 100.0*double(ticks-lastProcessTicks)/(ticksPerSecond*seconds);
+        lastProcessTicks = ticks;
+    }
+
+    qint64 newRss = readRss();
+
+    QStorageInfo spotStorage(sSpotDir);
+    QStorageInfo slideStorage(sSlideDir);
+
+    qint64 transferred = transferredBytes.loadAcquire();
+    int frames = slideFrames.loadAcquire();
+
+    QMutexLocker locker(&mutex);
+    systemLoad   = newSystemLoad;
+    processLoad  = newProcessLoad;
+    rssKB        = newRss;
+    freeSpotMB   = spotStorage.isValid()  ? spotStorage.bytesAvailable()/(1024*1024)  : -1;
+    freeSlideMB  = slideStorage.isValid() ? slideStorage.bytesAvailable()/(1024*1024) : -1;
+    transferKBps = double(transferred-lastTransferred)/1024.0/seconds;
+    slideFps     = double(frames-lastSlideFrames)/seconds;
+    lastTransferred = transferred;
+    lastSlideFrames = frames;
+}
+
+
+/*!
+ * \brief StatsSampler::report The answer to the Server <getStats> request
+ * \param guiLatency The GUI event loop latency (msec)
+ * \return "system CPU %,panel CPU %,RSS kB,GUI latency ms,free Spot MB,
+ * free Slide MB,transfer kB/s,slide fps" (-1 when not available)
+ */
+QString
+StatsSampler::report(qint64 guiLatency) {
+    QMutexLocker locker(&mutex);
+    return QString("%1,%2,%3,%4,%5,%6,%7,%8")
+            .arg(systemLoad, 0, 'f', 1)
+            .arg(processLoad, 0, 'f', 1)
+            .arg(rssKB)
+            .arg(guiLatency)
+            .arg(freeSpotMB)
+            .arg(freeSlideMB)
+            .arg(transferKBps, 0, 'f', 1)
+            .arg(slideFps, 0, 'f', 1);
+}
+
+
+/*!
+ * \brief StatsSampler::readSystemTicks Read the total CPU time from /proc/stat
+ * \param pTotal [out] all the CPU ticks
+ * \param pIdle [out] the idle (and iowait) CPU ticks
+ * \return false if not available
+ */
+bool
+StatsSampler::readSystemTicks(quint64 *pTotal, quint64 *pIdle) {
+    QFile statFile(QString("/proc/stat"));
+    if(!statFile.open(QIODevice::ReadOnly))
+        return false;
+    // cpu user nice system idle iowait irq softirq steal ...
+    QList<QByteArray> fields = statFile.readLine().simplified().split(' ');
+    if(fields.count() < 5 || fields.at(0) != QByteArray("cpu"))
+        return false;
+    quint64 total = 0;
+    for(int i=1; i<fields.count() && i<=8; i++)
+        total += fields.at(i).toULongLong();
+    *pTotal = total;
+    *pIdle  = fields.at(4).toULongLong();
+    if(fields.count() > 5)
+        *pIdle += fields.at(5).toULongLong();
+    return true;
+}
+
+
+/*!
+ * \brief StatsSampler::readProcessTicks Read the Panel CPU time from /proc/self/stat
+ * \param pTicks [out] user + system ticks
+ * \return false if not available
+ */
+bool
+StatsSampler::readProcessTicks(quint64 *pTicks) {
+    QFile statFile(QString("/proc/self/stat"));
+    if(!statFile.open(QIODevice::ReadOnly))
+        return false;
+    QByteArray baStat = statFile.readAll();
+    // The process name may contain spaces: skip it
+    int iEnd = baStat.lastIndexOf(')');
+    if(iEnd < 0)
+        return false;
+    QList<QByteArray> fields = baStat.mid(iEnd+2).simplified().split(' ');
+    // utime and stime are the fields 14 and 15 (the 12th and 13th after the name)
+    if(fields.count() < 13)
+        return false;
+    *pTicks = fields.at(11).toULongLong() + fields.at(12).toULongLong();
+    return true;
+}
+
+
+/*!
+ * \brief StatsSampler::readRss Read the resident memory from /proc/self/statm
+ * \return The resident set size in kB (-1 if not available)
+ */
+qint64
+StatsSampler::readRss() {
+    QFile statmFile(QString("/proc/self/statm"));
+    if(!statmFile.open(QIODevice::ReadOnly))
+        return -1;
+    QList<QByteArray> fields = statmFile.readAll().simplified().split(' ');
+    if(fields.count() < 2)
+        return -1;
+#if defined(Q_OS_LINUX)
+    qint64 pageSize = sysconf(_SC_PAGESIZE);
+#else
+    qint64 pageSize = 4096;
+#endif
+    return fields.at(1).toLongLong()*pageSize/1024;
+}
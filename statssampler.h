@@ -0,0 +1,79 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef STATSSAMPLER_H
+#define STATSSAMPLER_H
+
+#include <QObject>
+#include <QMutex>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+
+
+QT_FORWARD_DECLARE_CLASS(QTimer)
+
+
+#define STATS_SAMPLE_TIME 2000 // In msec
+
+
+class StatsSampler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit StatsSampler(QString mySpotDir, QString mySlideDir, QObject *parent=Q_NULLPTR);
+    QString report(qint64 guiLatency);
+    static void addTransferredBytes(qint64 nBytes);
+    static void countSlideFrame();
+
+public slots:
+    void startSampling();
+
+private slots:
+    void onTimeToSample();
+
+private:
+    bool readSystemTicks(quint64 *pTotal, quint64 *pIdle);
+    bool readProcessTicks(quint64 *pTicks);
+    qint64 readRss();
+
+private:
+    QString        sSpotDir;
+    QString        sSlideDir;
+    QTimer        *pSampleTimer;
+    QElapsedTimer  sampleClock;
+    quint64        lastSystemTotal;
+    quint64        lastSystemIdle;
+    quint64        lastProcessTicks;
+    qint64         lastTransferred;
+    int            lastSlideFrames;
+    // The last sample (protected by the mutex)
+    QMutex         mutex;
+    double         systemLoad;
+    double         processLoad;
+    qint64         rssKB;
+    qint64         freeSpotMB;
+    qint64         freeSlideMB;
+    double         transferKBps;
+    double         slideFps;
+
+    static QAtomicInteger<qint64> transferredBytes;
+    static QAtomicInt             slideFrames;
+};
+
+#endif // STATSSAMPLER_H
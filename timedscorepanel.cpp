@@ -22,6 +22,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "utility.h"
 #include "timedscorepanel.h"
+#include "arduinoprober.h"
+#include "seriallink.h"
+#include "devicemonitor.h"
+#include "myapplication.h"
+#include "startuptrace.h"
 
 
 /*!
@@ -29,17 +34,34 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
  * \param myServerUrl The Panel Server URL
  * \param myLogFile The File for message logging (if any)
  * \param parent The parent QWidget
+ * \param pPrimary The primary panel (only for the secondary panels)
  */
-TimedScorePanel::TimedScorePanel(QString myServerUrl, QFile *myLogFile, QWidget *parent)
-    : ScorePanel(myServerUrl, myLogFile, parent)
+TimedScorePanel::TimedScorePanel(QString myServerUrl, QFile *myLogFile, QWidget *parent, ScorePanel *pPrimary)
+    : ScorePanel(myServerUrl, myLogFile, parent, pPrimary)
 {
     isArduinoFound = false;
 #ifndef Q_OS_ANDROID
     // Arduino Serial Port
-    baudRate = QSerialPort::Baud115200;
-    waitTimeout = 1000;
-    responseData.clear();
-    ConnectToArduino();
+    pSerialThread  = Q_NULLPTR;
+    pSerialLink    = Q_NULLPTR;
+    pArduinoProber = Q_NULLPTR;
+    connect(&timePollTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToPollTime()));
+    deviceSettleTimer.setSingleShot(true);
+    connect(&deviceSettleTimer, SIGNAL(timeout()),
+            this, SLOT(onDeviceSettled()));
+    // The Arduino may be unplugged and plugged again during the game
+    // (the secondary panels get the time from the primary one)
+    pDeviceMonitor = Q_NULLPTR;
+    if(!pPrimary) {
+        pDeviceMonitor = new DeviceMonitor(logFile, this);
+        connect(pDeviceMonitor, SIGNAL(serialPortAdded(QString)),
+                this, SLOT(onSerialPortAdded(QString)));
+        connect(pDeviceMonitor, SIGNAL(serialPortRemoved(QString)),
+                this, SLOT(onSerialPortRemoved(QString)));
+    }
+    // The Arduino is looked for with the other services
+    // (see startServices()), when the score has been shown
 #endif
 }
 
@@ -49,181 +71,258 @@ TimedScorePanel::TimedScorePanel(QString myServerUrl, QFile *myLogFile, QWidget
  */
 TimedScorePanel::~TimedScorePanel() {
 #ifndef Q_OS_ANDROID
-    if(serialPort.isOpen()) {
-#ifdef LOG_VERBOSE
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Closing Arduino Connection"));
-#endif
-        writeArduinoSimpleCommand(char(StopSending));
-        serialPort.waitForBytesWritten(1000);// in msec
-        QThread::sleep(1);// In sec. Give Arduino the time to react
-        serialPort.clear();
-        serialPort.close();
-    }
+    if(pDeviceMonitor)
+        pDeviceMonitor->disconnect(this);
+    deviceSettleTimer.stop();
+    closeSerialThread();
 #endif
 }
 
 
 /*!
  * \brief TimedScorePanel::closeEvent for correctly handling the closing of the Panel
- * \param event Unused
+ * \param event The event
  */
 void
 TimedScorePanel::closeEvent(QCloseEvent *event) {
-    Q_UNUSED(event)
 #ifndef Q_OS_ANDROID
-    if(serialPort.isOpen()) {
-#ifdef LOG_VERBOSE
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Closing serial port %1")
-                   .arg(serialPort.portName()));
-#endif
-        writeArduinoSimpleCommand(char(StopSending));
-        if(!serialPort.waitForBytesWritten(1000)) {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Unable to Close serial port %1")
-                       .arg(serialPort.portName()));
-        }
-        QThread::sleep(1);// In sec. Give Arduino the time to react
-        serialPort.clear();
-        serialPort.close();
-    }
+    if(pDeviceMonitor)
+        pDeviceMonitor->disconnect(this);
+    deviceSettleTimer.stop();
+    closeSerialThread();
 #endif
+    // Saves the settings and closes the secondary panels too
+    ScorePanel::closeEvent(event);
 }
 
 
 #ifndef Q_OS_ANDROID
 /*!
- * \brief TimedScorePanel::ConnectToArduino Send a Message to all the serial ports available
- * to see if there is an Arduino connected to the ScorePanel
+ * \brief TimedScorePanel::startServices Start the services not needed to show the score
+ *
+ * The Arduino is not needed either: the time is shown when found.
+ */
+void
+TimedScorePanel::startServices() {
+    ScorePanel::startServices();
+    pDeviceMonitor->start();
+    ConnectToArduino();
+    StartupTrace::mark(logFile, QString("Arduino search started"));
+}
+
+
+/*!
+ * \brief TimedScorePanel::followPanel Make this panel a secondary one
+ * \param pPrimary The primary panel (talking with the Arduino)
+ * \param iScreen The screen number
+ *
+ * The time values read by the primary panel are shown here too.
+ */
+void
+TimedScorePanel::followPanel(ScorePanel *pPrimary, int iScreen) {
+    ScorePanel::followPanel(pPrimary, iScreen);
+    connect(pPrimary, SIGNAL(arduinoFound()),
+            this, SIGNAL(arduinoFound()));
+    connect(pPrimary, SIGNAL(newTimeValue(QString)),
+            this, SIGNAL(newTimeValue(QString)));
+}
+
+
+/*!
+ * \brief TimedScorePanel::ConnectToArduino Look for an Arduino connected to the ScorePanel
+ *
+ * The serial ports are probed asynchronously (and in parallel)
+ * by an ArduinoProber: the GUI is never blocked while waiting
+ * for the Arduino to reset and answer.
  */
 void
 TimedScorePanel::ConnectToArduino() {
-    // Get a list of available serial ports
-    serialPorts = QSerialPortInfo::availablePorts();
-    // Remove from the list NON tty and already opened devices
-    for(int i=0; i<serialPorts.count(); i++) {
-        serialPortinfo = serialPorts.at(i);
-        if(!serialPortinfo.portName().contains("tty"))
-            serialPorts.removeAt(i);
-        serialPort.setPortName(serialPortinfo.portName());
-        if(serialPort.isOpen())
-            serialPorts.removeAt(i);
-    }
-    // Do we have still serial ports ?
-    if(serialPorts.isEmpty()) {
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("No serial port available"));
+    pArduinoProber = new ArduinoProber(logFile, this);
+    connect(pArduinoProber, SIGNAL(arduinoFound(QSerialPort*)),
+            this, SLOT(onArduinoPortFound(QSerialPort*)));
+    connect(pArduinoProber, SIGNAL(arduinoNotFound()),
+            this, SLOT(onArduinoNotFound()));
+    MyApplication* application = static_cast<MyApplication *>(QApplication::instance());
+    pArduinoProber->startProbing(application->sArduinoPort);
+}
+
+
+/*!
+ * \brief TimedScorePanel::onArduinoNotFound Invoked when no port answered
+ *
+ * Nothing else to do: a new search will start when a serial
+ * device will be plugged in.
+ */
+void
+TimedScorePanel::onArduinoNotFound() {
+    pArduinoProber->deleteLater();
+    pArduinoProber = Q_NULLPTR;
+}
+
+
+/*!
+ * \brief TimedScorePanel::onSerialPortAdded Invoked when a serial device has been plugged in
+ * \param sPortName The new port name
+ *
+ * The port is probed after a while, to give the system the
+ * time to set the device up.
+ */
+void
+TimedScorePanel::onSerialPortAdded(QString sPortName) {
+    if(pSerialLink || pArduinoProber)
+        return;
+    LOG_INFO(LOG_SERIAL,
+             logFile,
+             QString("Serial port %1 plugged in").arg(sPortName));
+    sPluggedPortName = sPortName;
+    deviceSettleTimer.start(DEVICE_SETTLE_TIME);
+}
+
+
+/*!
+ * \brief TimedScorePanel::onDeviceSettled Look for the Arduino on the port just plugged
+ */
+void
+TimedScorePanel::onDeviceSettled() {
+    if(pSerialLink || pArduinoProber)
+        return;
+    pArduinoProber = new ArduinoProber(logFile, this);
+    connect(pArduinoProber, SIGNAL(arduinoFound(QSerialPort*)),
+            this, SLOT(onArduinoPortFound(QSerialPort*)));
+    connect(pArduinoProber, SIGNAL(arduinoNotFound()),
+            this, SLOT(onArduinoNotFound()));
+    MyApplication* application = static_cast<MyApplication *>(QApplication::instance());
+    if(!application->sArduinoPort.isEmpty())
+        pArduinoProber->startProbing(application->sArduinoPort, true);
+    else
+        pArduinoProber->startProbing(sPluggedPortName, true);
+}
+
+
+/*!
+ * \brief TimedScorePanel::onSerialPortRemoved Invoked when a serial device has been unplugged
+ * \param sPortName The name of the port removed
+ */
+void
+TimedScorePanel::onSerialPortRemoved(QString sPortName) {
+    if(!pSerialLink || (sPortName != sArduinoPortName))
+        return;
+    LOG_ERROR(LOG_SERIAL,
+              logFile,
+              QString("Arduino disconnected from %1").arg(sPortName));
+    // The port is gone: no way to stop the Arduino
+    closeSerialThread(true);
+    isArduinoFound = false;
+}
+
+
+/*!
+ * \brief TimedScorePanel::onArduinoPortFound Invoked when the Arduino answered
+ * \param pPort The (open) serial port connected to the Arduino
+ */
+void
+TimedScorePanel::onArduinoPortFound(QSerialPort* pPort) {
+    pArduinoProber->deleteLater();
+    pArduinoProber = Q_NULLPTR;
+    sArduinoPortName = pPort->portName();
+    // The serial traffic is handled in its own thread
+    pSerialThread = new QThread();
+    pSerialLink = new SerialLink(pPort, logFile);
+    // The port (a child of the link) moves with it
+    pSerialLink->moveToThread(pSerialThread);
+    connect(pSerialThread, SIGNAL(started()),
+            pSerialLink, SLOT(start()));
+    connect(pSerialThread, SIGNAL(finished()),
+            pSerialLink, SLOT(deleteLater()));
+    connect(pSerialLink, SIGNAL(frameReceived(QByteArray)),
+            this, SLOT(onSerialFrameReceived(QByteArray)));
+    pSerialThread->start(QThread::HighPriority);
+    timePollTimer.start(TIME_POLL_TIME);
+    // On reconnection the game configuration in use must be restored
+    // (onArduinoFound() sends the default one)
+    QByteArray configure = lastConfigure;
+    emit arduinoFound();
+    if(!configure.isEmpty())
+        writeSerialRequest(configure);
+}
+
+
+/*!
+ * \brief TimedScorePanel::closeSerialThread Stop the Arduino and its serial thread
+ * \param bPortLost true if the port has been unplugged (the Arduino can't be stopped)
+ */
+void
+TimedScorePanel::closeSerialThread(bool bPortLost) {
+    timePollTimer.stop();
+    if(!pSerialThread)
         return;
+    LOG_DEBUG(LOG_SERIAL,
+              logFile,
+              QString("Closing Arduino Connection"));
+    pSerialLink->disconnect(this);
+    if(!bPortLost)
+        QMetaObject::invokeMethod(pSerialLink, "close", Qt::BlockingQueuedConnection);
+    pSerialThread->quit();
+    pSerialThread->wait();
+    delete pSerialThread;
+    pSerialThread = Q_NULLPTR;
+    pSerialLink   = Q_NULLPTR;
+}
+
+
+/*!
+ * \brief TimedScorePanel::onTimeToPollTime Show the last time value received (if any)
+ *
+ * Executed once per frame: the values arrived in the meanwhile
+ * are not shown since they would be immediately overwritten.
+ */
+void
+TimedScorePanel::onTimeToPollTime() {
+    quint32 time;
+    if(!pSerialLink || !pSerialLink->takeTime(&time))
+        return;
+    // Per fare in modo che il tempo non decrementi i
+    // secondi immediatamente alla pressione del pulsante
+    if(time>6000)
+        time +=99;
+    int imin = int(time/6000);
+    int isec = int(time-quint32(imin*6000))/100;
+    // Eliminare il commento se non si vogliono
+    // visualizzare i centesimi di secondo
+    //int icent = 10*((time - isec*100)/10);
+    int icent = int(time) - isec*100;
+    QString sVal;
+    if(imin > 0) {
+        sVal = QString("%1:%2")
+                .arg(imin, 2, 10, QLatin1Char('0'))
+                .arg(isec, 2, 10, QLatin1Char('0'));
     }
-    connect(this, SIGNAL(arduinoFound()),
-            this, SLOT(onArduinoFound()));
-    // Yes we have serial ports available:
-    // Search for the one connected to Arduino
-    baudRate = QSerialPort::Baud115200;
-    waitTimeout = 1000;
-    connect(&arduinoConnectionTimer, SIGNAL(timeout()),
-            this, SLOT(onArduinoConnectionTimerTimeout()));
-
-    for(currentPort=0; currentPort<serialPorts.count(); currentPort++) {
-        serialPortinfo = serialPorts.at(currentPort);
-        serialPort.setPortName(serialPortinfo.portName());
-        serialPort.setBaudRate(baudRate);
-        serialPort.setDataBits(QSerialPort::Data8);
-        if(serialPort.open(QIODevice::ReadWrite)) {
-#ifdef LOG_VERBOSE
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Trying connection to %1")
-                       .arg(serialPortinfo.portName()));
-#endif
-            // Arduino will be reset upon a serial connectiom
-            // so give time to set it up before communicating.
-            QThread::sleep(3);// In sec.
-            serialPort.clear();
-            connect(&serialPort, SIGNAL(readyRead()),
-                    this, SLOT(onSerialDataAvailable()));
-            writeArduinoSimpleCommand(char(AreYouThere));
-            arduinoConnectionTimer.start(waitTimeout);
-            return;
-        }
-#ifdef LOG_VERBOSE
-        else {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Unable to open %1 because %2")
-                       .arg(serialPortinfo.portName())
-                       .arg(serialPort.errorString()));
-        }
-#endif
+    else {
+        sVal = QString("%1:%2")
+                .arg(isec, 2, 10, QLatin1Char('0'))
+                .arg(icent, 2, 10, QLatin1Char('0'));
     }
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("Error: No Arduino ready to use !"));
+    emit newTimeValue(sVal);
 }
 
 
 /*!
- * \brief TimedScorePanel::onArduinoFound Just a place holder:
- * the event will be handled in the derived classes
+ * \brief TimedScorePanel::onSerialFrameReceived Invoked with the Arduino frames other than Time
+ * \param frame The decoded frame
  */
 void
-TimedScorePanel::onArduinoFound() {
-    // The event is handled in the derived classes
+TimedScorePanel::onSerialFrameReceived(QByteArray frame) {
+    executeCommand(frame);
 }
 
 
 /*!
- * \brief TimedScorePanel::onArduinoConnectionTimerTimeout Invoked if no Arduino sent back
- * the rigth answere in the due time
+ * \brief TimedScorePanel::onArduinoFound Just a place holder:
+ * the event will be handled in the derived classes
  */
 void
-TimedScorePanel::onArduinoConnectionTimerTimeout() {
-    arduinoConnectionTimer.stop();
-    serialPort.disconnect();
-    serialPort.close();
-
-    for(++currentPort; currentPort<serialPorts.count(); currentPort++) {
-        serialPortinfo = serialPorts.at(currentPort);
-        serialPort.setPortName(serialPortinfo.portName());
-        serialPort.setBaudRate(baudRate);
-        serialPort.setDataBits(QSerialPort::Data8);
-        if(serialPort.open(QIODevice::ReadWrite)) {
-#ifdef LOG_VERBOSE
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Trying connection to %1")
-                       .arg(serialPortinfo.portName()));
-#endif
-            // Arduino will be reset upon a serial connectiom
-            // so give time to set it up before communicating.
-            QThread::sleep(3);
-            serialPort.clear();
-            connect(&serialPort, SIGNAL(readyRead()),
-                    this, SLOT(onSerialDataAvailable()));
-            writeArduinoSimpleCommand(char(AreYouThere));
-            arduinoConnectionTimer.start(waitTimeout);
-            return;
-        }
-#ifdef LOG_VERBOSE
-        else {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Unable to open %1 because %2")
-                       .arg(serialPortinfo.portName())
-                       .arg(serialPort.errorString()));
-        }
-#endif
-    }
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("No Arduino ready to use !"));
-#endif
+TimedScorePanel::onArduinoFound() {
+    // The event is handled in the derived classes
 }
 
 
@@ -245,83 +344,21 @@ TimedScorePanel::writeArduinoSimpleCommand(char command) {
  */
 int
 TimedScorePanel::writeSerialRequest(QByteArray requestData) {
-    if(!serialPort.isOpen()) {
-#ifdef LOG_VERBOSE
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Serial port %1 has been closed")
-                   .arg(serialPort.portName()));
-#endif
+    // Recorded even with the Arduino unplugged: it is sent on reconnection
+    if((requestData.size() > 2) && (quint8(requestData.at(2)) == quint8(Configure)))
+        lastConfigure = requestData;
+    if(!pSerialLink) {
+        LOG_DEBUG(LOG_SERIAL,
+                  logFile,
+                  QString("Serial port has been closed"));
         return -1;
     }
-    responseData.clear();
-    serialPort.write(requestData);
+    QMetaObject::invokeMethod(pSerialLink, "write", Qt::QueuedConnection,
+                              Q_ARG(QByteArray, requestData));
     return 0;
 }
 
 
-/*!
- * \brief TimedScorePanel::onSerialDataAvailable Invoked asynchronously when there are data
- * to read from the USB port
- */
-void
-TimedScorePanel::onSerialDataAvailable() {
-    QSerialPort *testPort = static_cast<QSerialPort *>(sender());
-    responseData.append(testPort->readAll());
-    while(!testPort->atEnd()) {
-        responseData.append(testPort->readAll());
-    }
-    while(responseData.count() > 0) {
-        // Do we have a complete command ?
-        int iStart = responseData.indexOf(startMarker);
-        if(iStart == -1) {
-            responseData.clear();
-            return;
-        }
-        if(iStart > 0)
-            responseData.remove(0, iStart);
-        int iEnd   = responseData.indexOf(endMarker);
-        if(iEnd == -1) return;
-        executeCommand(decodeResponse(responseData.left(responseData[1])));
-        responseData.remove(0, responseData[1]);
-    }
-}
-
-
-/*!
- * \brief TimedScorePanel::decodeResponse Decode the answer received on the USB interface
- * \param response The answer (as a QByteArray)
- * \return the decoded answer
- */
-QByteArray
-TimedScorePanel::decodeResponse(QByteArray response) {
-    QByteArray decodedResponse;
-    int iStart;
-    for(iStart=0; iStart<response.count(); iStart++) {
-        if(quint8(response[iStart]) == quint8(startMarker)) break;
-    }
-    for(int i=iStart+1; i<response.count(); i++) {
-        if(quint8(response[i]) == endMarker) {
-            break;
-        }
-        if((quint8(response[i]) == quint8(specialByte))) {
-            i++;
-            if(i<response.count()) {
-                decodedResponse.append(response[i-1]+response[i]);
-            }
-            else { // Not enough character received
-                decodedResponse.clear();
-                return decodedResponse;
-           }
-        }
-        decodedResponse.append(response[i]);
-    }
-    if(decodedResponse.count() != 0)
-        decodedResponse[0] = decodedResponse[0]-2;
-    return decodedResponse;
-}
-
-
 /*!
  * \brief TimedScorePanel::executeCommand Execute the command received from the Arduino
  * \param command
@@ -329,48 +366,10 @@ TimedScorePanel::decodeResponse(QByteArray response) {
  */
 bool
 TimedScorePanel::executeCommand(QByteArray command) {
-    if(quint8(command[1]) == quint8(AreYouThere)) {
-        arduinoConnectionTimer.stop();
-#ifdef LOG_VERBOSE
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Arduino found at: %1")
-                   .arg(serialPort.portName()));
-#endif
-        emit arduinoFound();
-        return true;
-    }
-
-    if(quint8(command[1]) == quint8(Time)) {
-        if(quint8(command[0]) != quint8(6)) return false;
-        quint32 time = 0;
-        for(int i=2; i<6; i++) {
-            time += quint32(quint8(command[i])) << ((i-2)*8);
-        }
-        // Per fare in modo che il tempo non decrementi i
-        // secondi immediatamente alla pressione del pulsante
-        if(time>6000)
-            time +=99;
-        int imin = int(time/6000);
-        int isec = int(time-quint32(imin*6000))/100;
-        // Eliminare il commento se non si vogliono
-        // visualizzare i centesimi di secondo
-        //int icent = 10*((time - isec*100)/10);
-        int icent = int(time) - isec*100;
-        QString sVal;
-        if(imin > 0) {
-            sVal = QString("%1:%2")
-                    .arg(imin, 2, 10, QLatin1Char('0'))
-                    .arg(isec, 2, 10, QLatin1Char('0'));
-        }
-        else {
-            sVal = QString("%1:%2")
-                    .arg(isec, 2, 10, QLatin1Char('0'))
-                    .arg(icent, 2, 10, QLatin1Char('0'));
-        }
-        emit newTimeValue(sVal);
+    // The Time frames are handled by onTimeToPollTime()
+    // Late answers to the ArduinoProber
+    if(quint8(command[1]) == quint8(AreYouThere))
         return true;
-    }
 
     return false;
 }
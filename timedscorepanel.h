@@ -27,14 +27,27 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "scorepanel.h"
 
+
+QT_FORWARD_DECLARE_CLASS(ArduinoProber)
+QT_FORWARD_DECLARE_CLASS(SerialLink)
+QT_FORWARD_DECLARE_CLASS(DeviceMonitor)
+
+
+#define TIME_POLL_TIME     20 // In msec (the game clock refresh period)
+#define DEVICE_SETTLE_TIME 250 // In msec (before opening a just plugged port)
+
+
 class TimedScorePanel : public ScorePanel
 {
     Q_OBJECT
 
 public:
-    TimedScorePanel(QString myServerUrl, QFile *myLogFile, QWidget *parent = Q_NULLPTR);
+    TimedScorePanel(QString myServerUrl, QFile *myLogFile, QWidget *parent = Q_NULLPTR, ScorePanel *pPrimary = Q_NULLPTR);
     ~TimedScorePanel();
     void closeEvent(QCloseEvent *event);
+#ifndef Q_OS_ANDROID
+    void followPanel(ScorePanel *pPrimary, int iScreen);
+#endif
 
 signals:
 #ifndef Q_OS_ANDROID
@@ -44,18 +57,24 @@ signals:
 
 public slots:
 #ifndef Q_OS_ANDROID
-    void onSerialDataAvailable();
-    void onArduinoConnectionTimerTimeout();
+    void onArduinoPortFound(QSerialPort* pPort);
+    void onSerialFrameReceived(QByteArray frame);
+    void onTimeToPollTime();
+    void onArduinoNotFound();
+    void onSerialPortAdded(QString sPortName);
+    void onSerialPortRemoved(QString sPortName);
+    void onDeviceSettled();
     virtual void onArduinoFound();
 #endif
 
 protected:
 #ifndef Q_OS_ANDROID
+    void startServices();
     void ConnectToArduino();
     int writeArduinoSimpleCommand(char command);
     int  writeSerialRequest(QByteArray requestData);
-    QByteArray decodeResponse(QByteArray response);
     bool executeCommand(QByteArray command);
+    void closeSerialThread(bool bPortLost=false);
 #endif
 
 protected:
@@ -69,14 +88,15 @@ protected:
     const char             ack         = char(0xFF);/*!< The acknowledge character sent to the Arduino */
 
 private:
-    QSerialPort            serialPort;
-    QSerialPortInfo        serialPortinfo;
-    QList<QSerialPortInfo> serialPorts;
-    QSerialPort::BaudRate  baudRate;
-    int                    currentPort;
-    int                    waitTimeout;
-    QByteArray             responseData;
-    QTimer                 arduinoConnectionTimer;
+    QThread               *pSerialThread;
+    SerialLink            *pSerialLink;
+    ArduinoProber         *pArduinoProber;
+    DeviceMonitor         *pDeviceMonitor;
+    QTimer                 timePollTimer;
+    QTimer                 deviceSettleTimer;
+    QString                sArduinoPortName;
+    QString                sPluggedPortName;
+    QByteArray             lastConfigure;/*!< The last Configure sent (to be repeated upon reconnection) */
 #endif
 };
 
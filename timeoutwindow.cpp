@@ -17,8 +17,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *
 */
 #include "timeoutwindow.h"
-#include <QVBoxLayout>
-#include <QResizeEvent>
+#include <QPainter>
+#include <QFontMetrics>
 #include <QGuiApplication>
 #include <QScreen>
 
@@ -26,13 +26,23 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
     #define horizontalAdvance width
 #endif
 
+#define FIRST_TIMEOUT_FONT_SIZE   48
+#define LAST_TIMEOUT_FONT_SIZE  2000
+
 
 /*!
  * \brief TimeoutWindow::TimeoutWindow A black window for timeout countdown
  * \param parent The parent QWidget
+ *
+ * The countdown is computed from a monotonic deadline and the window
+ * wakes up only at the second boundaries, when the number changes.
+ * The (huge) number is rendered once into a pixmap: the repaints
+ * just copy it.
  */
 TimeoutWindow::TimeoutWindow(QWidget *parent)
     : QWidget(parent)
+    , shownValue(-1)
+    , msecDeadline(0)
 {
     Q_UNUSED(parent);
     setMinimumSize(QSize(320, 240));
@@ -41,20 +51,24 @@ TimeoutWindow::TimeoutWindow(QWidget *parent)
     QRect  screenGeometry = screen->geometry();
     int width = screenGeometry.width();
     int height = screenGeometry.height();
-    int iFontSize = 400;
-    for(int i=48; i<2000; i++) {
-        QFontMetrics f(QFont("Arial", i, QFont::Black));
+    // The text size grows with the font size: look for the
+    // first size too large with a binary search
+    int low  = FIRST_TIMEOUT_FONT_SIZE;
+    int high = LAST_TIMEOUT_FONT_SIZE;
+    while(low < high) {
+        int size = (low+high)/2;
+        QFontMetrics f(QFont("Arial", size, QFont::Black));
         int rW = f.horizontalAdvance("88");
         int rH = f.height();
-        if((rW > width)  || (rH > height)){
-            iFontSize = i-1;
-            break;
-        }
+        if((rW > width)  || (rH > height))
+            high = size;
+        else
+            low = size+1;
     }
-
-    myLabel.setText(QString("No Text"));
-    myLabel.setAlignment(Qt::AlignCenter);
-    myLabel.setFont(QFont("Arial", iFontSize, QFont::Black));
+    int iFontSize = 400;
+    if(low < LAST_TIMEOUT_FONT_SIZE)
+        iFontSize = low-1;
+    timeFont = QFont("Arial", iFontSize, QFont::Black);
 
     QPalette pal(QWidget::palette());
     pal.setColor(QPalette::Window,        Qt::black);
@@ -64,21 +78,15 @@ TimeoutWindow::TimeoutWindow(QWidget *parent)
     pal.setColor(QPalette::Text,          Qt::yellow);
     pal.setColor(QPalette::BrightText,    Qt::white);
     setPalette(pal);
-    myLabel.setPalette(pal);
+    setAutoFillBackground(true);
 
     setWindowOpacity(0.8);
-    myLabel.setText(tr("-- No Text --"));
-    QVBoxLayout *panelLayout = new QVBoxLayout();
-    panelLayout->addWidget(&myLabel);
-    setLayout(panelLayout);
 
+    // Fired at each second boundary of the countdown
     TimerUpdate.setTimerType(Qt::PreciseTimer);
+    TimerUpdate.setSingleShot(true);
     connect(&TimerUpdate, SIGNAL(timeout()),
             this, SLOT(updateTime()));
-    TimerTimeout.setTimerType(Qt::PreciseTimer);
-    TimerTimeout.setSingleShot(true);
-    connect(&TimerTimeout, SIGNAL(timeout()),
-            this, SLOT(updateTime()));
 }
 
 
@@ -92,18 +100,60 @@ TimeoutWindow::~TimeoutWindow() {
 /*!
  * \brief TimeoutWindow::updateTime Update the time shown in the window
  * and hide the window when the countdown reach zero
+ *
+ * The next update is scheduled when the number shown will change.
  */
 void
 TimeoutWindow::updateTime() {
-    int remainingTime = TimerTimeout.remainingTime();
-    myLabel.setText(QString("%1").arg(1+(remainingTime/1000)));
-    if(remainingTime > 0)
+    qint64 remainingTime = msecDeadline - countdownClock.elapsed();
+    if(remainingTime <= 0) {
+        stopTimeout();
+        return;
+    }
+    int value = int((remainingTime+999)/1000);
+    if(value != shownValue) {
+        renderValue(value);
         update();
-    else {
-        TimerUpdate.stop();
-        TimerTimeout.stop();
-        hide();
     }
+    // Wake up again at the next second boundary
+    int msecToNext = int(remainingTime - qint64(value-1)*1000);
+    TimerUpdate.start(qMax(1, msecToNext));
+}
+
+
+/*!
+ * \brief TimeoutWindow::renderValue Draw the number to show into the pixmap
+ * \param value The number to show
+ */
+void
+TimeoutWindow::renderValue(int value) {
+    shownValue = value;
+    QString sValue = QString("%1").arg(value);
+    QFontMetrics f(timeFont);
+    QSize valueSize(f.horizontalAdvance(sValue), f.height());
+    if(valuePixmap.size() != valueSize)
+        valuePixmap = QPixmap(valueSize);
+    valuePixmap.fill(palette().color(QPalette::Window));
+    QPainter painter(&valuePixmap);
+    painter.setFont(timeFont);
+    painter.setPen(palette().color(QPalette::WindowText));
+    painter.drawText(valuePixmap.rect(), Qt::AlignCenter, sValue);
+}
+
+
+/*!
+ * \brief TimeoutWindow::paintEvent Copy the rendered number at the window center
+ * \param event Unused
+ */
+void
+TimeoutWindow::paintEvent(QPaintEvent *event) {
+    Q_UNUSED(event)
+    if(valuePixmap.isNull())
+        return;
+    QPainter painter(this);
+    QRect valueRect(valuePixmap.rect());
+    valueRect.moveCenter(rect().center());
+    painter.drawPixmap(valueRect.topLeft(), valuePixmap);
 }
 
 
@@ -113,9 +163,10 @@ TimeoutWindow::updateTime() {
  */
 void
 TimeoutWindow::startTimeout(int msecTime) {
-    TimerTimeout.start(msecTime);
-    TimerUpdate.start(100);
-    myLabel.setText(QString("%1").arg(int(0.999+(TimerTimeout.remainingTime()/1000.0))));
+    countdownClock.start();
+    msecDeadline = msecTime;
+    shownValue = -1;
+    updateTime();
     show();
 }
 
@@ -126,7 +177,5 @@ TimeoutWindow::startTimeout(int msecTime) {
 void
 TimeoutWindow::stopTimeout() {
     TimerUpdate.stop();
-    TimerTimeout.stop();
     hide();
 }
-
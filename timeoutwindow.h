@@ -22,7 +22,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QObject>
 #include <QWidget>
 #include <QTimer>
-#include <QLabel>
+#include <QElapsedTimer>
+#include <QPixmap>
+#include <QFont>
 
 class TimeoutWindow : public QWidget
 {
@@ -39,10 +41,19 @@ public:
 public slots:
     void updateTime();
 
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private:
+    void renderValue(int value);
+
 private:
-    QLabel myLabel;
-    QTimer TimerTimeout;
-    QTimer TimerUpdate;
+    QFont         timeFont;
+    QPixmap       valuePixmap; /*!< The value shown, rendered only when it changes */
+    int           shownValue;
+    QElapsedTimer countdownClock;
+    qint64        msecDeadline;/*!< The end of the countdown on the countdownClock */
+    QTimer        TimerUpdate;
 };
 
 #endif // TIMEOUTWINDOW_H
@@ -0,0 +1,44 @@
+# Copyright (C) 2016  Gabriele Salvato
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#-------------------------------------------------
+#
+# A simulated Arduino timer board (on a pseudo terminal)
+# to drive the timed Score Panels without the real hardware
+#
+#-------------------------------------------------
+
+QT += core
+QT -= gui
+
+CONFIG += c++11
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = arduinosim
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# The requests are decoded as the panel does
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp
+SOURCES += arduinosimulator.cpp
+SOURCES += ../../arduinodecoder.cpp
+
+HEADERS += arduinosimulator.h
+HEADERS += ../../arduinodecoder.h
+HEADERS += ../../utility.h
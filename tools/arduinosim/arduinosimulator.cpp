@@ -0,0 +1,472 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QSocketNotifier>
+#include <QCoreApplication>
+#include <QFile>
+#include <QTextStream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+
+#include "arduinosimulator.h"
+#include "utility.h"
+
+
+static const char startMarker = char(0xFF);
+static const char endMarker   = char(0xFE);
+static const char specialByte = char(0xFD);
+
+
+/*!
+ * \brief ArduinoSimulator::ArduinoSimulator A stand-in for the Arduino timer board
+ * \param parent The parent object
+ *
+ * It creates a pseudo terminal that the timed panels can open as if it
+ * were the Arduino serial port. It answers AreYouThere, honours
+ * Configure, Start, Stop, Start14, NewGame, StartSending and
+ * StopSending and, once configured, streams the Time (and, for Basket,
+ * the Possess) frames at the requested rate, optionally with random
+ * noise between the frames and corrupted frames.
+ * The commands start, stop, start14 and quit can also be typed on
+ * the console.
+ */
+ArduinoSimulator::ArduinoSimulator(QObject *parent)
+    : QObject(parent)
+    , masterFd(-1)
+    , slaveFd(-1)
+    , pPortNotifier(Q_NULLPTR)
+    , pConsoleNotifier(Q_NULLPTR)
+    , seed(1)
+    , noise(0.0)
+    , corruptEvery(0)
+    , bAutoStart(false)
+    , bSending(false)
+    , bRunning(false)
+    , panelType(BASKET_PANEL)
+    , periodTime(10*60*100)
+    , timeAtStart(10*60*100)
+    , msecAtStart(0)
+    , possessTime(24)
+    , possess24(24)
+    , possess14(14)
+    , possessStart(0)
+    , lastPossess(-1)
+    , nFramesSent(0)
+    , nBytesSent(0)
+    , nCorrupted(0)
+    , nDropped(0)
+    , nRequests(0)
+{
+    sendTimer.setTimerType(Qt::PreciseTimer);
+    connect(&sendTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToSend()));
+    connect(&reportTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToReport()));
+    setRate(100);
+    clock.start();
+}
+
+
+/*!
+ * \brief ArduinoSimulator::~ArduinoSimulator
+ */
+ArduinoSimulator::~ArduinoSimulator() {
+    if(!sLinkName.isEmpty())
+        QFile::remove(sLinkName);
+    if(slaveFd >= 0)
+        ::close(slaveFd);
+    if(masterFd >= 0)
+        ::close(masterFd);
+}
+
+
+/*!
+ * \brief ArduinoSimulator::open Create the pseudo terminal
+ * \param sLink A symbolic link to the terminal (if not empty)
+ * \return false on failure
+ */
+bool
+ArduinoSimulator::open(QString sLink) {
+    QTextStream err(stderr);
+    masterFd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if(masterFd < 0) {
+        err << QString("Unable to create a pseudo terminal: %1\n").arg(strerror(errno));
+        return false;
+    }
+    if((grantpt(masterFd) != 0) || (unlockpt(masterFd) != 0)) {
+        err << QString("Unable to unlock the pseudo terminal: %1\n").arg(strerror(errno));
+        return false;
+    }
+    sSlaveName = QString::fromLocal8Bit(ptsname(masterFd));
+    // Keeping the slave side open the master never reads EIO
+    // when the panel closes the port
+    slaveFd = ::open(ptsname(masterFd), O_RDWR | O_NOCTTY);
+    if(slaveFd < 0) {
+        err << QString("Unable to open %1: %2\n").arg(sSlaveName).arg(strerror(errno));
+        return false;
+    }
+    // No echo and no character translation
+    struct termios attributes;
+    tcgetattr(slaveFd, &attributes);
+    cfmakeraw(&attributes);
+    tcsetattr(slaveFd, TCSANOW, &attributes);
+
+    if(!sLink.isEmpty()) {
+        QFile::remove(sLink);
+        if(QFile::link(sSlaveName, sLink))
+            sLinkName = sLink;
+        else
+            err << QString("Unable to create the link %1\n").arg(sLink);
+    }
+
+    pPortNotifier = new QSocketNotifier(masterFd, QSocketNotifier::Read, this);
+    connect(pPortNotifier, SIGNAL(activated(int)),
+            this, SLOT(onPortReadable()));
+    pConsoleNotifier = new QSocketNotifier(STDIN_FILENO, QSocketNotifier::Read, this);
+    connect(pConsoleNotifier, SIGNAL(activated(int)),
+            this, SLOT(onConsoleReadable()));
+    reportTimer.start(SIM_REPORT_TIME);
+    return true;
+}
+
+
+/*!
+ * \brief ArduinoSimulator::portName
+ * \return The port the panel has to open
+ */
+QString
+ArduinoSimulator::portName() {
+    return sLinkName.isEmpty() ? sSlaveName : sLinkName;
+}
+
+
+/*!
+ * \brief ArduinoSimulator::setRate
+ * \param hz The Time frames sent per second
+ */
+void
+ArduinoSimulator::setRate(int hz) {
+    sendTimer.start(qMax(1, 1000/qMax(1, hz)));
+}
+
+
+/*!
+ * \brief ArduinoSimulator::setNoise
+ * \param probability The probability of junk bytes after each frame
+ */
+void
+ArduinoSimulator::setNoise(double probability) {
+    noise = probability;
+}
+
+
+/*!
+ * \brief ArduinoSimulator::setCorruptEvery
+ * \param nFrames Corrupt a byte every that many frames (0 = never)
+ */
+void
+ArduinoSimulator::setCorruptEvery(int nFrames) {
+    corruptEvery = nFrames;
+}
+
+
+/*!
+ * \brief ArduinoSimulator::setAutoStart
+ * \param bAuto Start the clock as soon as configured
+ */
+void
+ArduinoSimulator::setAutoStart(bool bAuto) {
+    bAutoStart = bAuto;
+}
+
+
+/*!
+ * \brief ArduinoSimulator::remainingTime
+ * \return The game time left (in hundredths of second)
+ */
+quint32
+ArduinoSimulator::remainingTime() {
+    if(!bRunning)
+        return timeAtStart;
+    qint64 elapsed = (clock.elapsed()-msecAtStart)/10;
+    if(elapsed >= qint64(timeAtStart)) {
+        bRunning    = false;
+        timeAtStart = 0;
+        return 0;
+    }
+    return timeAtStart-quint32(elapsed);
+}
+
+
+/*!
+ * \brief ArduinoSimulator::startClock Start (or resume) the game clock
+ */
+void
+ArduinoSimulator::startClock() {
+    if(bRunning)
+        return;
+    msecAtStart  = clock.elapsed();
+    possessStart = msecAtStart;
+    bRunning     = true;
+}
+
+
+/*!
+ * \brief ArduinoSimulator::start14 Restart the possession time from 14 s
+ */
+void
+ArduinoSimulator::start14() {
+    stopClock();
+    possessTime = possess14;
+    startClock();
+}
+
+
+/*!
+ * \brief ArduinoSimulator::stopClock Stop the game clock
+ */
+void
+ArduinoSimulator::stopClock() {
+    if(!bRunning)
+        return;
+    qint64 now = clock.elapsed();
+    timeAtStart = remainingTime();
+    possessTime = qMax(0, possessTime-int((now-possessStart)/1000));
+    bRunning = false;
+}
+
+
+/*!
+ * \brief ArduinoSimulator::onPortReadable Read the panel requests
+ */
+void
+ArduinoSimulator::onPortReadable() {
+    for(;;) {
+        int nFree;
+        char* pWrite = decoder.writePointer(&nFree);
+        ssize_t nRead = ::read(masterFd, pWrite, size_t(nFree));
+        if(nRead <= 0)
+            break;
+        decoder.commitWrite(int(nRead));
+        while(decoder.nextFrame())
+            executeCommand(decoder.frame(), decoder.frameSize());
+    }
+}
+
+
+/*!
+ * \brief ArduinoSimulator::executeCommand Execute a request of the panel
+ * \param frame The decoded frame
+ * \param frameSize Its size
+ */
+void
+ArduinoSimulator::executeCommand(const quint8 *frame, int frameSize) {
+    QTextStream out(stdout);
+    if(frameSize < 2)
+        return;
+    nRequests++;
+    quint8 command = frame[1];
+    if(command == quint8(AreYouThere)) {
+        out << QString("AreYouThere\n");
+        sendFrame(QByteArray(1, char(AreYouThere)));
+    }
+    else if(command == quint8(Configure)) {
+        if(frameSize < 5)
+            return;
+        panelType  = frame[2];
+        periodTime = 100*(quint32(frame[3]) | (quint32(frame[4]) << 8));
+        if((panelType == BASKET_PANEL) && (frameSize >= 9)) {
+            possess24 = int(frame[5]) | (int(frame[6]) << 8);
+            possess14 = int(frame[7]) | (int(frame[8]) << 8);
+        }
+        bRunning    = false;
+        timeAtStart = periodTime;
+        possessTime = possess24;
+        lastPossess = -1;
+        bSending    = true;
+        out << QString("Configure: panel %1, period %2 s\n")
+               .arg(panelType)
+               .arg(periodTime/100);
+        if(bAutoStart)
+            startClock();
+    }
+    else if(command == quint8(Start)) {
+        out << QString("Start\n");
+        startClock();
+    }
+    else if(command == quint8(Stop)) {
+        out << QString("Stop\n");
+        stopClock();
+    }
+    else if(command == quint8(Start14)) {
+        out << QString("Start14\n");
+        start14();
+    }
+    else if(command == quint8(NewGame)) {
+        out << QString("NewGame\n");
+        bRunning    = false;
+        timeAtStart = periodTime;
+        possessTime = possess24;
+    }
+    else if(command == quint8(StartSending)) {
+        bSending = true;
+    }
+    else if(command == quint8(StopSending)) {
+        out << QString("StopSending\n");
+        bSending = false;
+    }
+    else {
+        out << QString("Unknown command 0x%1\n").arg(command, 2, 16, QLatin1Char('0'));
+    }
+}
+
+
+/*!
+ * \brief ArduinoSimulator::onTimeToSend Stream the clock values
+ */
+void
+ArduinoSimulator::onTimeToSend() {
+    if(!bSending)
+        return;
+    quint32 time = remainingTime();
+    QByteArray body;
+    body.append(char(Time));
+    for(int i=0; i<4; i++)
+        body.append(char((time >> (8*i)) & 0xFF));
+    sendFrame(body);
+
+    if(panelType == BASKET_PANEL) {
+        int possess = possessTime;
+        if(bRunning)
+            possess = qMax(0, possessTime-int((clock.elapsed()-possessStart)/1000));
+        if(possess != lastPossess) {
+            lastPossess = possess;
+            body.clear();
+            body.append(char(Possess));
+            body.append(char(possess));
+            sendFrame(body);
+        }
+    }
+}
+
+
+/*!
+ * \brief ArduinoSimulator::sendFrame Encode and send a frame (with the requested noise)
+ * \param body Command and data
+ */
+void
+ArduinoSimulator::sendFrame(const QByteArray& body) {
+    QByteArray frame;
+    frame.append(startMarker);
+    frame.append(char(0));// The length, set below
+    for(int i=0; i<body.size(); i++) {
+        quint8 byte = quint8(body.at(i));
+        if(byte >= quint8(specialByte)) {
+            frame.append(specialByte);
+            frame.append(char(byte-quint8(specialByte)));
+        }
+        else
+            frame.append(char(byte));
+    }
+    frame.append(endMarker);
+    frame[1] = char(frame.size());
+
+    seed = seed*1103515245u + 12345u;
+    nFramesSent++;
+    if((corruptEvery > 0) && (nFramesSent % quint64(corruptEvery) == 0)) {
+        frame[int((seed >> 8) % quint32(frame.size()))] = char(seed >> 16);
+        nCorrupted++;
+    }
+    if((noise > 0.0) && (double((seed >> 8) & 0xFFFF)/65536.0 < noise)) {
+        int nJunk = 1 + int((seed >> 4) & 3);
+        for(int i=0; i<nJunk; i++) {
+            seed = seed*1103515245u + 12345u;
+            frame.append(char(seed >> 16));
+        }
+    }
+    writeBytes(frame);
+}
+
+
+/*!
+ * \brief ArduinoSimulator::writeBytes Write to the pseudo terminal
+ * \param data The bytes to send
+ *
+ * When nobody reads the port the terminal buffer fills up:
+ * the frames that do not fit are dropped.
+ */
+void
+ArduinoSimulator::writeBytes(const QByteArray& data) {
+    ssize_t nWritten = ::write(masterFd, data.constData(), size_t(data.size()));
+    if(nWritten != ssize_t(data.size())) {
+        nDropped++;
+        return;
+    }
+    nBytesSent += quint64(nWritten);
+}
+
+
+/*!
+ * \brief ArduinoSimulator::onConsoleReadable The commands typed on the console
+ */
+void
+ArduinoSimulator::onConsoleReadable() {
+    char buffer[256];
+    ssize_t nRead = ::read(STDIN_FILENO, buffer, sizeof(buffer)-1);
+    if(nRead <= 0) {// No console (e.g. in CI)
+        pConsoleNotifier->setEnabled(false);
+        return;
+    }
+    const QStringList commands = QString::fromLocal8Bit(buffer, int(nRead))
+                                 .simplified()
+                                 .split(" ", QString::SkipEmptyParts);
+    for(const QString& sCommand : commands) {
+        if(sCommand == QString("start"))
+            startClock();
+        else if(sCommand == QString("stop"))
+            stopClock();
+        else if(sCommand == QString("start14"))
+            start14();
+        else if(sCommand == QString("quit"))
+            QCoreApplication::quit();
+    }
+}
+
+
+/*!
+ * \brief ArduinoSimulator::onTimeToReport Print what has been sent
+ */
+void
+ArduinoSimulator::onTimeToReport() {
+    QTextStream out(stdout);
+    quint32 time = remainingTime();
+    out << QString("%1 time %2:%3  frames %4  bytes %5  corrupted %6  dropped %7  requests %8\n")
+           .arg(bRunning ? "running" : "stopped")
+           .arg(time/6000, 2, 10, QLatin1Char('0'))
+           .arg((time/100)%60, 2, 10, QLatin1Char('0'))
+           .arg(nFramesSent)
+           .arg(nBytesSent)
+           .arg(nCorrupted)
+           .arg(nDropped)
+           .arg(nRequests);
+}
@@ -0,0 +1,99 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef ARDUINOSIMULATOR_H
+#define ARDUINOSIMULATOR_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include "arduinodecoder.h"
+
+
+QT_FORWARD_DECLARE_CLASS(QSocketNotifier)
+
+
+#define SIM_REPORT_TIME 5000 // In msec
+
+
+class ArduinoSimulator : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ArduinoSimulator(QObject *parent=Q_NULLPTR);
+    ~ArduinoSimulator();
+    bool open(QString sLinkName);
+    QString portName();
+    void setRate(int hz);
+    void setNoise(double probability);
+    void setCorruptEvery(int nFrames);
+    void setAutoStart(bool bAuto);
+
+public slots:
+    void startClock();
+    void start14();
+    void stopClock();
+
+private slots:
+    void onPortReadable();
+    void onConsoleReadable();
+    void onTimeToSend();
+    void onTimeToReport();
+
+private:
+    void executeCommand(const quint8 *frame, int frameSize);
+    void sendFrame(const QByteArray& body);
+    void writeBytes(const QByteArray& data);
+    quint32 remainingTime();
+
+private:
+    int               masterFd;
+    int               slaveFd;
+    QString           sSlaveName;
+    QString           sLinkName;
+    QSocketNotifier  *pPortNotifier;
+    QSocketNotifier  *pConsoleNotifier;
+    ArduinoDecoder    decoder;
+    QTimer            sendTimer;
+    QTimer            reportTimer;
+    QElapsedTimer     clock;
+    quint32           seed;
+    double            noise;
+    int               corruptEvery;
+    bool              bAutoStart;
+    bool              bSending;
+    bool              bRunning;
+    int               panelType;
+    quint32           periodTime;  // In hundredths of second
+    quint32           timeAtStart; // Remaining time when the clock was started
+    qint64            msecAtStart;
+    int               possessTime; // In seconds
+    int               possess24;
+    int               possess14;
+    qint64            possessStart;
+    int               lastPossess;
+    quint64           nFramesSent;
+    quint64           nBytesSent;
+    quint64           nCorrupted;
+    quint64           nDropped;
+    quint64           nRequests;
+};
+
+#endif // ARDUINOSIMULATOR_H
@@ -0,0 +1,78 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QTimer>
+
+#include "arduinosimulator.h"
+
+
+/*!
+ * \brief main A simulated Arduino timer board on a pseudo terminal
+ *
+ * <pre>arduinosim --rate 100 --autostart</pre>
+ * and then
+ * <pre>panelChooser --arduino /tmp/ttyArduinoSim</pre>
+ * the Basket and Handball panels will find the simulated Arduino
+ * and show its clock.
+ *
+ * <pre>arduinosim --rate 100 --noise 0.01 --corrupt 50 --autostart --duration 60</pre>
+ * also stresses the panel frame decoder.
+ */
+int
+main(int argc, char *argv[]) {
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("arduinosim");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("A simulated Arduino timer board for the timed Score Panels");
+    parser.addHelpOption();
+    QCommandLineOption linkOption("link", "Symbolic link to the pseudo terminal.", "path", "/tmp/ttyArduinoSim");
+    QCommandLineOption rateOption("rate", "Time frames per second.", "hz", "100");
+    QCommandLineOption noiseOption("noise", "Probability of junk bytes after a frame.", "p", "0");
+    QCommandLineOption corruptOption("corrupt", "Corrupt a frame every n (0 = never).", "n", "0");
+    QCommandLineOption autoStartOption("autostart", "Start the clock as soon as configured.");
+    QCommandLineOption durationOption("duration", "Quit after s seconds.", "s", "0");
+    parser.addOption(linkOption);
+    parser.addOption(rateOption);
+    parser.addOption(noiseOption);
+    parser.addOption(corruptOption);
+    parser.addOption(autoStartOption);
+    parser.addOption(durationOption);
+    parser.process(a);
+
+    ArduinoSimulator simulator;
+    if(!simulator.open(parser.value(linkOption)))
+        return 1;
+    simulator.setRate(parser.value(rateOption).toInt());
+    simulator.setNoise(parser.value(noiseOption).toDouble());
+    simulator.setCorruptEvery(parser.value(corruptOption).toInt());
+    simulator.setAutoStart(parser.isSet(autoStartOption));
+
+    QTextStream out(stdout);
+    out << QString("Simulated Arduino on %1\n").arg(simulator.portName());
+    out.flush();
+
+    int duration = parser.value(durationOption).toInt();
+    if(duration > 0)
+        QTimer::singleShot(duration*1000, &a, SLOT(quit()));
+
+    return a.exec();
+}
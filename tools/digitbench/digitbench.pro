@@ -0,0 +1,40 @@
+# Copyright (C) 2016  Gabriele Salvato
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#-------------------------------------------------
+#
+# Repaint time of the score digits:
+# QLCDNumber against the ScoreDigits glyph atlas
+#
+#-------------------------------------------------
+
+QT += core
+QT += gui
+QT += widgets
+
+CONFIG += c++11
+CONFIG -= app_bundle
+
+TARGET = digitbench
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp
+SOURCES += ../../scoredigits.cpp
+
+HEADERS += ../../scoredigits.h
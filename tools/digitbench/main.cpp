@@ -0,0 +1,159 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QLCDNumber>
+#include <QVector>
+#include <algorithm>
+
+#include "scoredigits.h"
+
+
+/*!
+ * \brief prepare Give a score display the panel look and show it
+ * \param pDisplay The display
+ * \param width Its width
+ * \param height Its height
+ */
+static void
+prepare(QWidget *pDisplay, int width, int height) {
+    QPalette pal = pDisplay->palette();
+    pal.setColor(QPalette::Window,     Qt::black);
+    pal.setColor(QPalette::WindowText, Qt::yellow);
+    pDisplay->setPalette(pal);
+    pDisplay->setAutoFillBackground(true);
+    pDisplay->setFixedSize(width, height);
+    pDisplay->show();
+    QApplication::processEvents();
+}
+
+
+/*!
+ * \brief paintPending Paint all the pending updates now
+ */
+static void
+paintPending() {
+    QApplication::sendPostedEvents();
+    QApplication::processEvents();
+}
+
+
+/*!
+ * \brief report Show the statistics of the measured times
+ * \param sName The display measured
+ * \param times The update times (in ns)
+ */
+static void
+report(QString sName, QVector<qint64> times) {
+    std::sort(times.begin(), times.end());
+    qint64 total = 0;
+    for(int i=0; i<times.count(); i++)
+        total += times.at(i);
+    QTextStream(stdout) << QString("%1: mean %2 us, median %3 us, 95% %4 us, max %5 us\n")
+                           .arg(sName, -12)
+                           .arg(double(total)/times.count()/1000.0, 0, 'f', 1)
+                           .arg(double(times.at(times.count()/2))/1000.0, 0, 'f', 1)
+                           .arg(double(times.at(times.count()*95/100))/1000.0, 0, 'f', 1)
+                           .arg(double(times.last())/1000.0, 0, 'f', 1);
+}
+
+
+/*!
+ * \brief main Measure the time to show a new score
+ *
+ * <pre>digitbench --width 640 --height 360 --digits 3 --updates 2000</pre>
+ * shows a score growing by 1, 2 or 3 points at a time on a QLCDNumber
+ * and on a ScoreDigits of the same size (a full HD panel score is about
+ * 640x360), painting each change before the next one.
+ * It may also run without a display with <pre>-platform offscreen</pre>.
+ */
+int
+main(int argc, char *argv[]) {
+    QApplication a(argc, argv);
+    QApplication::setApplicationName("digitbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Repaint time of QLCDNumber against ScoreDigits");
+    parser.addHelpOption();
+    QCommandLineOption widthOption("width", "Display width.", "pixels", "640");
+    QCommandLineOption heightOption("height", "Display height.", "pixels", "360");
+    QCommandLineOption digitsOption("digits", "Number of digits.", "n", "3");
+    QCommandLineOption updatesOption("updates", "Number of score changes.", "n", "2000");
+    parser.addOption(widthOption);
+    parser.addOption(heightOption);
+    parser.addOption(digitsOption);
+    parser.addOption(updatesOption);
+    parser.process(a);
+
+    int width   = parser.value(widthOption).toInt();
+    int height  = parser.value(heightOption).toInt();
+    int nDigits = qBound(1, parser.value(digitsOption).toInt(), 9);
+    int nUpdates= qMax(1, parser.value(updatesOption).toInt());
+    int maxValue = 1;
+    for(int i=0; i<nDigits; i++)
+        maxValue *= 10;
+
+    QElapsedTimer timer;
+    QVector<qint64> lcdTimes;
+    QVector<qint64> atlasTimes;
+
+    QLCDNumber lcd(nDigits);
+    lcd.setSegmentStyle(QLCDNumber::Filled);
+    lcd.setFrameStyle(QFrame::NoFrame);
+    prepare(&lcd, width, height);
+    int value = 0;
+    for(int i=0; i<nUpdates; i++) {
+        value = (value + i%3 + 1) % maxValue;
+        timer.start();
+        lcd.display(value);
+        paintPending();
+        lcdTimes.append(timer.nsecsElapsed());
+    }
+    lcd.hide();
+
+    ScoreDigits digits(nDigits);
+    digits.setSegmentStyle(ScoreDigits::Filled);
+    digits.setFrameStyle(QFrame::NoFrame);
+    timer.start();
+    prepare(&digits, width, height);
+    qint64 firstPaint = timer.nsecsElapsed();
+    value = 0;
+    for(int i=0; i<nUpdates; i++) {
+        value = (value + i%3 + 1) % maxValue;
+        timer.start();
+        digits.display(value);
+        paintPending();
+        atlasTimes.append(timer.nsecsElapsed());
+    }
+    digits.hide();
+
+    QTextStream(stdout) << QString("%1 updates of a %2 digits %3x%4 display\n")
+                           .arg(nUpdates)
+                           .arg(nDigits)
+                           .arg(width)
+                           .arg(height);
+    report("QLCDNumber", lcdTimes);
+    report("ScoreDigits", atlasTimes);
+    QTextStream(stdout) << QString("ScoreDigits first paint (with the atlas): %1 us, %2 atlas rendered\n")
+                           .arg(double(firstPaint)/1000.0, 0, 'f', 1)
+                           .arg(ScoreDigits::atlasCount());
+    return 0;
+}
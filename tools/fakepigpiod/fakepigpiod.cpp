@@ -0,0 +1,231 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QThread>
+#include <QtEndian>
+
+#include "fakepigpiod.h"
+
+
+// The pigpiod socket commands (see pigpio.h)
+#define PI_CMD_PFS   7
+#define PI_CMD_SERVO 8
+
+#define PIGPIOD_MESSAGE_SIZE 16
+
+#define PULSE_WIDTH_AT_M90 600.0  // In us
+#define PULSE_WIDTH_AT_P90 2200.0 // In us
+
+
+/*!
+ * \brief FakePigpiod::FakePigpiod A pigpio daemon answering to everything
+ * \param parent The parent object
+ *
+ * Every command gets a successful answer. The servo (and PWM frequency)
+ * commands are counted and, when verbose, printed with the servo angle
+ * so that the camera motion can be followed. Every FAKE_REPORT_TIME ms
+ * the number of commands and of socket reads (i.e. batches), the max
+ * time between two servo updates and the max pulse width step are shown.
+ */
+FakePigpiod::FakePigpiod(QObject *parent)
+    : QObject(parent)
+    , pServer(Q_NULLPTR)
+    , replyDelay(0)
+    , bVerbose(false)
+    , nCommands(0)
+    , nBatches(0)
+    , nServo(0)
+    , nPfs(0)
+    , maxInterval(0)
+    , maxPulseStep(0)
+{
+    clock.start();
+    connect(&reportTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToReport()));
+}
+
+
+/*!
+ * \brief FakePigpiod::~FakePigpiod
+ */
+FakePigpiod::~FakePigpiod() {
+    onTimeToReport();
+}
+
+
+/*!
+ * \brief FakePigpiod::listen Start accepting the connections
+ * \param port The port to listen to (8888 is the pigpiod one)
+ * \return false if the port is not available
+ */
+bool
+FakePigpiod::listen(quint16 port) {
+    pServer = new QTcpServer(this);
+    if(!pServer->listen(QHostAddress::Any, port)) {
+        QTextStream(stderr) << QString("Unable to listen on port %1: %2\n")
+                               .arg(port)
+                               .arg(pServer->errorString());
+        return false;
+    }
+    connect(pServer, SIGNAL(newConnection()),
+            this, SLOT(onNewConnection()));
+    reportTimer.start(FAKE_REPORT_TIME);
+    return true;
+}
+
+
+/*!
+ * \brief FakePigpiod::setReplyDelay Simulate a slow daemon
+ * \param msec The time spent on each batch of commands
+ */
+void
+FakePigpiod::setReplyDelay(int msec) {
+    replyDelay = qMax(0, msec);
+}
+
+
+/*!
+ * \brief FakePigpiod::setVerbose Print every command received
+ * \param bVerbose
+ */
+void
+FakePigpiod::setVerbose(bool bVerbose) {
+    this->bVerbose = bVerbose;
+}
+
+
+/*!
+ * \brief FakePigpiod::onNewConnection A new client
+ */
+void
+FakePigpiod::onNewConnection() {
+    while(pServer->hasPendingConnections()) {
+        QTcpSocket* pClient = pServer->nextPendingConnection();
+        buffers.insert(pClient, QByteArray());
+        connect(pClient, SIGNAL(readyRead()),
+                this, SLOT(onCommandsAvailable()));
+        connect(pClient, SIGNAL(disconnected()),
+                this, SLOT(onClientDisconnected()));
+        QTextStream(stdout) << QString("Client connected from %1\n")
+                               .arg(pClient->peerAddress().toString());
+    }
+}
+
+
+/*!
+ * \brief FakePigpiod::onClientDisconnected
+ */
+void
+FakePigpiod::onClientDisconnected() {
+    QTcpSocket* pClient = qobject_cast<QTcpSocket*>(sender());
+    if(!pClient)
+        return;
+    buffers.remove(pClient);
+    pClient->deleteLater();
+    QTextStream(stdout) << QString("Client disconnected\n");
+}
+
+
+/*!
+ * \brief FakePigpiod::onCommandsAvailable Answer all the complete commands received
+ */
+void
+FakePigpiod::onCommandsAvailable() {
+    QTcpSocket* pClient = qobject_cast<QTcpSocket*>(sender());
+    if(!pClient || !buffers.contains(pClient))
+        return;
+    QByteArray& buffer = buffers[pClient];
+    buffer.append(pClient->readAll());
+    nBatches++;
+    // A busy daemon (the client must not pile up the commands)
+    if(replyDelay > 0)
+        QThread::msleep(ulong(replyDelay));
+    while(buffer.size() >= PIGPIOD_MESSAGE_SIZE) {
+        executeCommand(pClient, reinterpret_cast<const uchar*>(buffer.constData()));
+        buffer.remove(0, PIGPIOD_MESSAGE_SIZE);
+    }
+}
+
+
+/*!
+ * \brief FakePigpiod::executeCommand Account for a command and answer it
+ * \param pClient The client that sent the command
+ * \param pCommand The 16 bytes of the command
+ */
+void
+FakePigpiod::executeCommand(QTcpSocket *pClient, const uchar *pCommand) {
+    quint32 command = qFromLittleEndian<quint32>(pCommand);
+    quint32 p1      = qFromLittleEndian<quint32>(pCommand+4);
+    quint32 p2      = qFromLittleEndian<quint32>(pCommand+8);
+    nCommands++;
+    qint64 now = clock.elapsed();
+    if(command == PI_CMD_SERVO) {
+        nServo++;
+        if(lastServoTime.contains(p1)) {
+            maxInterval  = qMax(maxInterval, now-lastServoTime.value(p1));
+            quint32 last = lastPulseWidth.value(p1);
+            maxPulseStep = qMax(maxPulseStep, (p2 > last) ? p2-last : last-p2);
+        }
+        lastServoTime.insert(p1, now);
+        lastPulseWidth.insert(p1, p2);
+        if(bVerbose) {
+            double angle = (double(p2)-PULSE_WIDTH_AT_M90)*180.0/(PULSE_WIDTH_AT_P90-PULSE_WIDTH_AT_M90)-90.0;
+            QTextStream(stdout) << QString("%1 SERVO gpio=%2 pulse=%3us angle=%4\n")
+                                   .arg(now, 8)
+                                   .arg(p1)
+                                   .arg(p2)
+                                   .arg(angle, 0, 'f', 1);
+        }
+    }
+    else if(command == PI_CMD_PFS) {
+        nPfs++;
+        if(bVerbose) {
+            QTextStream(stdout) << QString("%1 PFS   gpio=%2 frequency=%3Hz\n")
+                                   .arg(now, 8)
+                                   .arg(p1)
+                                   .arg(p2);
+        }
+        if(p2 == 0)// Motion ended: the next one starts afresh
+            lastServoTime.remove(p1);
+    }
+    // The answer repeats the command with the result in place of p3
+    quint32 reply[4];
+    reply[0] = qToLittleEndian(command);
+    reply[1] = qToLittleEndian(p1);
+    reply[2] = qToLittleEndian(p2);
+    reply[3] = 0;
+    pClient->write(reinterpret_cast<const char*>(reply), PIGPIOD_MESSAGE_SIZE);
+}
+
+
+/*!
+ * \brief FakePigpiod::onTimeToReport Show the statistics
+ */
+void
+FakePigpiod::onTimeToReport() {
+    QTextStream(stdout) << QString("%1 commands (%2 servo, %3 pfs) in %4 batches, max servo interval %5 ms, max pulse step %6 us\n")
+                           .arg(nCommands)
+                           .arg(nServo)
+                           .arg(nPfs)
+                           .arg(nBatches)
+                           .arg(maxInterval)
+                           .arg(maxPulseStep);
+}
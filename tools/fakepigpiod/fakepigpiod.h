@@ -0,0 +1,72 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef FAKEPIGPIOD_H
+#define FAKEPIGPIOD_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QMap>
+
+
+QT_FORWARD_DECLARE_CLASS(QTcpServer)
+QT_FORWARD_DECLARE_CLASS(QTcpSocket)
+
+
+#define FAKE_REPORT_TIME 5000 // In msec
+
+
+class FakePigpiod : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FakePigpiod(QObject *parent=Q_NULLPTR);
+    ~FakePigpiod();
+    bool listen(quint16 port);
+    void setReplyDelay(int msec);
+    void setVerbose(bool bVerbose);
+
+private slots:
+    void onNewConnection();
+    void onCommandsAvailable();
+    void onClientDisconnected();
+    void onTimeToReport();
+
+private:
+    void executeCommand(QTcpSocket *pClient, const uchar *pCommand);
+
+private:
+    QTcpServer                   *pServer;
+    QMap<QTcpSocket*, QByteArray> buffers;
+    QMap<unsigned, qint64>        lastServoTime;
+    QMap<unsigned, quint32>       lastPulseWidth;
+    QTimer                        reportTimer;
+    QElapsedTimer                 clock;
+    int                           replyDelay;
+    bool                          bVerbose;
+    quint64                       nCommands;
+    quint64                       nBatches;
+    quint64                       nServo;
+    quint64                       nPfs;
+    qint64                        maxInterval;
+    quint32                       maxPulseStep;
+};
+
+#endif // FAKEPIGPIOD_H
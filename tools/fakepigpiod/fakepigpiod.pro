@@ -0,0 +1,39 @@
+# Copyright (C) 2016  Gabriele Salvato
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#-------------------------------------------------
+#
+# A stand-in pigpio daemon (on port 8888) to watch
+# the camera servo commands sent by the Score Panels
+#
+#-------------------------------------------------
+
+QT += core
+QT += network
+QT -= gui
+
+CONFIG += c++11
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = fakepigpiod
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += main.cpp
+SOURCES += fakepigpiod.cpp
+
+HEADERS += fakepigpiod.h
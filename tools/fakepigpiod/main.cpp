@@ -0,0 +1,73 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QTimer>
+
+#include "fakepigpiod.h"
+
+
+/*!
+ * \brief main A stand-in pigpio daemon for the camera servos
+ *
+ * <pre>fakepigpiod --verbose</pre>
+ * and then
+ * <pre>panelChooser --pigpiod localhost</pre>
+ * moving the pan & tilt sliders of the Controller shows the servo
+ * commands the panel sends.
+ *
+ * <pre>fakepigpiod --delay 50</pre>
+ * simulates a slow daemon: the servo interval grows but the
+ * commands must not pile up.
+ */
+int
+main(int argc, char *argv[]) {
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("fakepigpiod");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("A stand-in pigpio daemon for the Score Panel camera servos");
+    parser.addHelpOption();
+    QCommandLineOption portOption("port", "The port to listen to.", "port", "8888");
+    QCommandLineOption delayOption("delay", "Time spent on each batch of commands.", "ms", "0");
+    QCommandLineOption verboseOption("verbose", "Print every command received.");
+    QCommandLineOption durationOption("duration", "Quit after s seconds.", "s", "0");
+    parser.addOption(portOption);
+    parser.addOption(delayOption);
+    parser.addOption(verboseOption);
+    parser.addOption(durationOption);
+    parser.process(a);
+
+    FakePigpiod daemon;
+    if(!daemon.listen(quint16(parser.value(portOption).toUInt())))
+        return 1;
+    daemon.setReplyDelay(parser.value(delayOption).toInt());
+    daemon.setVerbose(parser.isSet(verboseOption));
+
+    QTextStream out(stdout);
+    out << QString("Fake pigpiod listening on port %1\n").arg(parser.value(portOption));
+    out.flush();
+
+    int duration = parser.value(durationOption).toInt();
+    if(duration > 0)
+        QTimer::singleShot(duration*1000, &a, SLOT(quit()));
+
+    return a.exec();
+}
@@ -0,0 +1,533 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QWebSocketServer>
+#include <QWebSocket>
+#include <QNetworkInterface>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+
+#include "fakeserver.h"
+#include "loadsimulator.h"
+#include "utility.h"
+
+
+#define DISCOVERY_PORT    45453
+#define SERVER_PORT       45454
+#define SPOT_UPDATE_PORT  45455
+#define SLIDE_UPDATE_PORT 45456
+
+#define FILE_HEADER_SIZE  1024 // As expected by the FileUpdater
+
+
+/*!
+ * \brief FakeServer::FakeServer A stand-in for the Score Controller
+ * \param myPanelType The Panel to ask for (VOLLEY_PANEL, BASKET_PANEL or HANDBALL_PANEL)
+ * \param parent The parent object
+ *
+ * It answers the discovery multicast, serves the status WebSocket
+ * and the Spot and Slide update ports exactly as the real Server
+ * does, and plays a scripted game pushing events at a given rate.
+ */
+FakeServer::FakeServer(int myPanelType, QObject *parent)
+    : QObject(parent)
+    , panelType(myPanelType)
+    , pPanelServer(Q_NULLPTR)
+    , pSpotServer(Q_NULLPTR)
+    , pSlideServer(Q_NULLPTR)
+    , iSequence(0)
+    , period(1)
+    , iService(0)
+{
+    for(int i=0; i<2; i++) {
+        score[i]   = 0;
+        set[i]     = 0;
+        timeout[i] = 0;
+        fouls[i]   = 0;
+    }
+    clock.start();
+    connect(&eventTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToSendEvent()));
+    connect(&dropTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToDropPanels()));
+}
+
+
+/*!
+ * \brief FakeServer::~FakeServer
+ */
+FakeServer::~FakeServer() {
+    eventTimer.stop();
+    dropTimer.stop();
+    if(pPanelServer) pPanelServer->close();
+    if(pSpotServer)  pSpotServer->close();
+    if(pSlideServer) pSlideServer->close();
+    qDeleteAll(panelClients);
+    qDeleteAll(fileClients);
+}
+
+
+/*!
+ * \brief FakeServer::start Start listening on all the Server ports
+ * \return true on success
+ */
+bool
+FakeServer::start() {
+    if(!discoverySocket.bind(QHostAddress::AnyIPv4, DISCOVERY_PORT,
+                             QUdpSocket::ShareAddress|QUdpSocket::ReuseAddressHint)) {
+        logMessage(Q_NULLPTR,
+                   Q_FUNC_INFO,
+                   QString("Unable to bind the Discovery Port"));
+        return false;
+    }
+    discoverySocket.joinMulticastGroup(QHostAddress("224.0.0.1"));
+    connect(&discoverySocket, SIGNAL(readyRead()),
+            this, SLOT(onDiscoveryDatagrams()));
+
+    pPanelServer = new QWebSocketServer(QString("FakePanelServer"),
+                                        QWebSocketServer::NonSecureMode, this);
+    pSpotServer  = new QWebSocketServer(QString("FakeSpotServer"),
+                                        QWebSocketServer::NonSecureMode, this);
+    pSlideServer = new QWebSocketServer(QString("FakeSlideServer"),
+                                        QWebSocketServer::NonSecureMode, this);
+    if(!pPanelServer->listen(QHostAddress::Any, SERVER_PORT) ||
+       !pSpotServer->listen(QHostAddress::Any, SPOT_UPDATE_PORT) ||
+       !pSlideServer->listen(QHostAddress::Any, SLIDE_UPDATE_PORT))
+    {
+        logMessage(Q_NULLPTR,
+                   Q_FUNC_INFO,
+                   QString("Unable to listen on the Server Ports"));
+        return false;
+    }
+    connect(pPanelServer, SIGNAL(newConnection()),
+            this, SLOT(onNewPanelConnection()));
+    connect(pSpotServer, SIGNAL(newConnection()),
+            this, SLOT(onNewFileConnection()));
+    connect(pSlideServer, SIGNAL(newConnection()),
+            this, SLOT(onNewFileConnection()));
+    return true;
+}
+
+
+/*!
+ * \brief FakeServer::setMediaDirs Set the folders with the files to serve
+ * \param sMySpotDir The Spots folder
+ * \param sMySlideDir The Slides folder
+ */
+void
+FakeServer::setMediaDirs(QString sMySpotDir, QString sMySlideDir) {
+    sSpotDir  = sMySpotDir;
+    sSlideDir = sMySlideDir;
+    if(!sSpotDir.isEmpty() && !sSpotDir.endsWith("/"))
+        sSpotDir += "/";
+    if(!sSlideDir.isEmpty() && !sSlideDir.endsWith("/"))
+        sSlideDir += "/";
+}
+
+
+/*!
+ * \brief FakeServer::setEventRate Set the rate of the game events
+ * \param eventsPerSecond The number of events per second (0 to stop)
+ */
+void
+FakeServer::setEventRate(double eventsPerSecond) {
+    eventTimer.stop();
+    if(eventsPerSecond > 0.0) {
+        eventTimer.setTimerType(Qt::PreciseTimer);
+        eventTimer.start(qMax(1, int(1000.0/eventsPerSecond)));
+    }
+}
+
+
+/*!
+ * \brief FakeServer::setDropInterval Periodically drop all the panel connections
+ * \param msecInterval The interval (0 to never drop)
+ *
+ * Useful to measure how long the panels take to come back.
+ */
+void
+FakeServer::setDropInterval(int msecInterval) {
+    dropTimer.stop();
+    if(msecInterval > 0)
+        dropTimer.start(msecInterval);
+}
+
+
+/*!
+ * \brief FakeServer::elapsedNsec
+ * \return The nanoseconds elapsed since the Server creation
+ */
+qint64
+FakeServer::elapsedNsec() {
+    return clock.nsecsElapsed();
+}
+
+
+/*!
+ * \brief FakeServer::eventSentTime
+ * \param sequence The event sequence number
+ * \return The time (see elapsedNsec()) the event has been sent or -1
+ */
+qint64
+FakeServer::eventSentTime(int sequence) {
+    return sentTime.value(sequence, -1);
+}
+
+
+/*!
+ * \brief FakeServer::connectedPanels
+ * \return The number of panels presently connected
+ */
+int
+FakeServer::connectedPanels() {
+    return panelClients.count();
+}
+
+
+/*!
+ * \brief FakeServer::onDiscoveryDatagrams Answer the "<getServer>" multicasts
+ */
+void
+FakeServer::onDiscoveryDatagrams() {
+    QString sAddresses;
+    QList<QHostAddress> addresses = QNetworkInterface::allAddresses();
+    for(int i=0; i<addresses.count(); i++) {
+        if(addresses.at(i).protocol() == QAbstractSocket::IPv4Protocol)
+            sAddresses += QString("%1,%2;").arg(addresses.at(i).toString()).arg(panelType);
+    }
+    QByteArray answer = QString("<serverIP>%1</serverIP>").arg(sAddresses).toUtf8();
+    while(discoverySocket.hasPendingDatagrams()) {
+        QByteArray datagram;
+        QHostAddress sender;
+        quint16 senderPort;
+        datagram.resize(int(discoverySocket.pendingDatagramSize()));
+        discoverySocket.readDatagram(datagram.data(), datagram.size(), &sender, &senderPort);
+        QString sToken = XML_Parse(QString(datagram), "getServer");
+        if(sToken == QString("NoData"))
+            continue;
+        logMessage(Q_NULLPTR,
+                   Q_FUNC_INFO,
+                   QString("Discovery from %1 (%2)").arg(sToken).arg(sender.toString()));
+        discoverySocket.writeDatagram(answer, sender, senderPort);
+    }
+}
+
+
+/*!
+ * \brief FakeServer::onNewPanelConnection A Panel connected to the status port
+ */
+void
+FakeServer::onNewPanelConnection() {
+    while(pPanelServer->hasPendingConnections()) {
+        QWebSocket *pClient = pPanelServer->nextPendingConnection();
+        panelClients.append(pClient);
+        connect(pClient, SIGNAL(textMessageReceived(QString)),
+                this, SLOT(onPanelTextMessage(QString)));
+        connect(pClient, SIGNAL(disconnected()),
+                this, SLOT(onPanelDisconnected()));
+    }
+}
+
+
+/*!
+ * \brief FakeServer::onPanelTextMessage Answer the Panel requests
+ * \param sMessage The received message
+ */
+void
+FakeServer::onPanelTextMessage(QString sMessage) {
+    QWebSocket *pClient = qobject_cast<QWebSocket *>(sender());
+    if(!pClient)
+        return;
+    if(XML_Parse(sMessage, "getStatus") != QString("NoData"))
+        pClient->sendTextMessage(buildStatus());
+    // A real Panel tells when an event reached the screen
+    QString sToken = XML_Parse(sMessage, "painted");
+    if(sToken != QString("NoData")) {
+        qint64 sent = eventSentTime(sToken.toInt());
+        if(sent >= 0)
+            paintedLatencies.append(clock.nsecsElapsed()-sent);
+    }
+    sToken = XML_Parse(sMessage, "latency");
+    if(sToken != QString("NoData")) {
+        logMessage(Q_NULLPTR,
+                   Q_FUNC_INFO,
+                   QString("%1 latency: %2")
+                   .arg(pClient->peerAddress().toString())
+                   .arg(sToken));
+    }
+}
+
+
+/*!
+ * \brief FakeServer::paintLatencies
+ * \return The times (nsec) from sending an event to its painting
+ * on the real Panels
+ */
+QVector<qint64>
+FakeServer::paintLatencies() {
+    return paintedLatencies;
+}
+
+
+/*!
+ * \brief FakeServer::onPanelDisconnected A Panel went away
+ */
+void
+FakeServer::onPanelDisconnected() {
+    QWebSocket *pClient = qobject_cast<QWebSocket *>(sender());
+    if(!pClient)
+        return;
+    panelClients.removeAll(pClient);
+    pClient->disconnect();
+    pClient->deleteLater();
+}
+
+
+/*!
+ * \brief FakeServer::onNewFileConnection A FileUpdater connected to a media port
+ */
+void
+FakeServer::onNewFileConnection() {
+    QWebSocketServer *pServer = qobject_cast<QWebSocketServer *>(sender());
+    while(pServer->hasPendingConnections()) {
+        QWebSocket *pClient = pServer->nextPendingConnection();
+        if(pServer == pSpotServer) {
+            pClient->setProperty("mediaDir", sSpotDir);
+            pClient->setProperty("nameFilters", QStringList() << "*.mp4" << "*.MP4");
+        }
+        else {
+            pClient->setProperty("mediaDir", sSlideDir);
+            pClient->setProperty("nameFilters", QStringList()
+                                 << "*.jpg" << "*.jpeg" << "*.png"
+                                 << "*.JPG" << "*.JPEG" << "*.PNG");
+        }
+        fileClients.append(pClient);
+        connect(pClient, SIGNAL(textMessageReceived(QString)),
+                this, SLOT(onFileTextMessage(QString)));
+        connect(pClient, SIGNAL(disconnected()),
+                this, SLOT(onFileClientDisconnected()));
+    }
+}
+
+
+/*!
+ * \brief FakeServer::onFileTextMessage Serve the file list and the file chunks
+ * \param sMessage The received message
+ */
+void
+FakeServer::onFileTextMessage(QString sMessage) {
+    QWebSocket *pClient = qobject_cast<QWebSocket *>(sender());
+    if(!pClient)
+        return;
+    QString sDir = pClient->property("mediaDir").toString();
+    if(XML_Parse(sMessage, "send_file_list") != QString("NoData")) {
+        pClient->sendTextMessage(buildFileList(sDir, pClient->property("nameFilters").toStringList()));
+        return;
+    }
+    QString sToken = XML_Parse(sMessage, "get");
+    if(sToken != QString("NoData"))
+        sendFileChunk(pClient, sToken);
+}
+
+
+/*!
+ * \brief FakeServer::onFileClientDisconnected A FileUpdater went away
+ */
+void
+FakeServer::onFileClientDisconnected() {
+    QWebSocket *pClient = qobject_cast<QWebSocket *>(sender());
+    if(!pClient)
+        return;
+    fileClients.removeAll(pClient);
+    pClient->disconnect();
+    pClient->deleteLater();
+}
+
+
+/*!
+ * \brief FakeServer::buildFileList
+ * \param sDir The folder to list
+ * \param nameFilters The files to include
+ * \return The "<file_list>" message
+ */
+QString
+FakeServer::buildFileList(QString sDir, QStringList nameFilters) {
+    QString sList;
+    if(!sDir.isEmpty()) {
+        QDir dir(sDir);
+        dir.setNameFilters(nameFilters);
+        dir.setFilter(QDir::Files);
+        QFileInfoList fileList = dir.entryInfoList();
+        for(int i=0; i<fileList.count(); i++) {
+            sList += QString("%1;%2,")
+                     .arg(fileList.at(i).fileName())
+                     .arg(fileList.at(i).size());
+        }
+    }
+    return QString("<file_list>%1</file_list>").arg(sList);
+}
+
+
+/*!
+ * \brief FakeServer::sendFileChunk Answer a "<get>name,offset,size</get>" request
+ * \param pClient The requesting FileUpdater
+ * \param sArguments The request arguments
+ *
+ * The first chunk of a file is preceded by a FILE_HEADER_SIZE bytes
+ * header with the file name and its size.
+ */
+void
+FakeServer::sendFileChunk(QWebSocket *pClient, QString sArguments) {
+    QStringList arguments = sArguments.split(",", QString::SkipEmptyParts);
+    if(arguments.count() < 3)
+        return;
+    QString sFileName = arguments.at(0);
+    qint64 offset     = arguments.at(1).toLongLong();
+    qint64 chunkSize  = arguments.at(2).toLongLong();
+    QFile file(pClient->property("mediaDir").toString() + sFileName);
+    if(!file.open(QIODevice::ReadOnly)) {
+        logMessage(Q_NULLPTR,
+                   Q_FUNC_INFO,
+                   QString("Unable to open %1").arg(file.fileName()));
+        return;
+    }
+    QByteArray baMessage;
+    if(offset == 0) {
+        baMessage = QString("%1,%2").arg(sFileName).arg(file.size()).toUtf8();
+        baMessage.append(QByteArray(FILE_HEADER_SIZE-baMessage.size(), '\0'));
+    }
+    file.seek(offset);
+    baMessage.append(file.read(chunkSize));
+    file.close();
+    pClient->sendBinaryMessage(baMessage);
+}
+
+
+/*!
+ * \brief FakeServer::onTimeToSendEvent Push the next game event to all the Panels
+ */
+void
+FakeServer::onTimeToSendEvent() {
+    QString sMessage = buildNextEvent();
+    sentTime.insert(iSequence, clock.nsecsElapsed());
+    // Keep only the recent history
+    sentTime.remove(iSequence-10000);
+    for(int i=0; i<panelClients.count(); i++)
+        panelClients.at(i)->sendTextMessage(sMessage);
+}
+
+
+/*!
+ * \brief FakeServer::onTimeToDropPanels Drop all the Panel connections
+ */
+void
+FakeServer::onTimeToDropPanels() {
+    logMessage(Q_NULLPTR,
+               Q_FUNC_INFO,
+               QString("Dropping %1 panels").arg(panelClients.count()));
+    QList<QWebSocket *> clients = panelClients;
+    panelClients.clear();
+    for(int i=0; i<clients.count(); i++) {
+        clients.at(i)->disconnect();
+        clients.at(i)->abort();
+        clients.at(i)->deleteLater();
+    }
+}
+
+
+/*!
+ * \brief FakeServer::buildStatus
+ * \return The full Panel status (as answer to a "<getStatus>")
+ */
+QString
+FakeServer::buildStatus() {
+    QString sMessage;
+    sMessage = QString("<team0>Locali</team0><team1>Ospiti</team1>");
+    for(int i=0; i<2; i++) {
+        sMessage += QString("<score%1>%2</score%1>").arg(i).arg(score[i]);
+        sMessage += QString("<timeout%1>%2</timeout%1>").arg(i).arg(timeout[i]);
+    }
+    if(panelType == VOLLEY_PANEL) {
+        for(int i=0; i<2; i++)
+            sMessage += QString("<set%1>%2</set%1>").arg(i).arg(set[i]);
+        sMessage += QString("<servizio>%1</servizio>").arg(iService);
+    }
+    else {
+        sMessage += QString("<period>%1,%2</period>").arg(period).arg(panelType == BASKET_PANEL ? 10 : 30);
+    }
+    if(panelType == BASKET_PANEL) {
+        for(int i=0; i<2; i++) {
+            sMessage += QString("<fauls%1>%2</fauls%1>").arg(i).arg(fouls[i]);
+            sMessage += QString("<bonus%1>%2</bonus%1>").arg(i).arg(fouls[i] > 4 ? 1 : 0);
+        }
+        sMessage += QString("<possess>%1</possess>").arg(iService);
+    }
+    return sMessage;
+}
+
+
+/*!
+ * \brief FakeServer::buildNextEvent Play the next step of the scripted game
+ * \return The message to send to the Panels
+ *
+ * Each event is tagged with a sequence number ("<seq>") used by the
+ * real Panels (that answer with a "<painted>" as requested by "<stamp>")
+ * to measure the latency. The "<stamp>" is the sending time on the host
+ * monotonic clock: the headless panels, in other processes, measure
+ * their latency from it.
+ */
+QString
+FakeServer::buildNextEvent() {
+    iSequence++;
+    int iTeam = qrand() % 2;
+    QString sMessage;
+    if(panelType == VOLLEY_PANEL) {
+        score[iTeam]++;
+        iService = iTeam;
+        if(score[iTeam] >= 25) {
+            set[iTeam] = (set[iTeam]+1) % 4;
+            score[0] = score[1] = 0;
+            sMessage += QString("<set%1>%2</set%1><score%3>0</score%3>")
+                        .arg(iTeam).arg(set[iTeam]).arg(1-iTeam);
+        }
+        sMessage += QString("<score%1>%2</score%1><servizio>%3</servizio>")
+                    .arg(iTeam).arg(score[iTeam]).arg(iService);
+    }
+    else if(panelType == BASKET_PANEL) {
+        if(qrand() % 4 == 0) {
+            fouls[iTeam] = (fouls[iTeam]+1) % 10;
+            sMessage += QString("<fauls%1>%2</fauls%1><bonus%1>%3</bonus%1>")
+                        .arg(iTeam).arg(fouls[iTeam]).arg(fouls[iTeam] > 4 ? 1 : 0);
+        }
+        else {
+            score[iTeam] = (score[iTeam] + 1 + qrand()%3) % 1000;
+            iService = 1-iTeam;
+            sMessage += QString("<score%1>%2</score%1><possess>%3</possess>")
+                        .arg(iTeam).arg(score[iTeam]).arg(iService);
+        }
+    }
+    else {
+        score[iTeam] = (score[iTeam]+1) % 1000;
+        sMessage += QString("<score%1>%2</score%1>").arg(iTeam).arg(score[iTeam]);
+    }
+    sMessage += QString("<seq>%1</seq><stamp>%2</stamp>")
+                .arg(iSequence)
+                .arg(LoadSimulator::monotonicNsec());
+    return sMessage;
+}
@@ -0,0 +1,93 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef FAKESERVER_H
+#define FAKESERVER_H
+
+#include <QObject>
+#include <QUdpSocket>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QVector>
+#include <QList>
+
+
+QT_FORWARD_DECLARE_CLASS(QWebSocketServer)
+QT_FORWARD_DECLARE_CLASS(QWebSocket)
+
+
+class FakeServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FakeServer(int myPanelType, QObject *parent=Q_NULLPTR);
+    ~FakeServer();
+    bool start();
+    void setMediaDirs(QString sMySpotDir, QString sMySlideDir);
+    void setEventRate(double eventsPerSecond);
+    void setDropInterval(int msecInterval);
+    qint64 elapsedNsec();
+    qint64 eventSentTime(int sequence);
+    int connectedPanels();
+    QVector<qint64> paintLatencies();
+
+private slots:
+    void onDiscoveryDatagrams();
+    void onNewPanelConnection();
+    void onPanelTextMessage(QString sMessage);
+    void onPanelDisconnected();
+    void onNewFileConnection();
+    void onFileTextMessage(QString sMessage);
+    void onFileClientDisconnected();
+    void onTimeToSendEvent();
+    void onTimeToDropPanels();
+
+private:
+    QString buildStatus();
+    QString buildNextEvent();
+    QString buildFileList(QString sDir, QStringList nameFilters);
+    void sendFileChunk(QWebSocket *pClient, QString sArguments);
+
+private:
+    int                 panelType;
+    QString             sSpotDir;
+    QString             sSlideDir;
+    QUdpSocket          discoverySocket;
+    QWebSocketServer   *pPanelServer;
+    QWebSocketServer   *pSpotServer;
+    QWebSocketServer   *pSlideServer;
+    QList<QWebSocket *> panelClients;
+    QList<QWebSocket *> fileClients;
+    QTimer              eventTimer;
+    QTimer              dropTimer;
+    QElapsedTimer       clock;
+    QHash<int, qint64>  sentTime;
+    QVector<qint64>     paintedLatencies;
+    int                 iSequence;
+    // The simulated game
+    int                 score[2];
+    int                 set[2];
+    int                 timeout[2];
+    int                 fouls[2];
+    int                 period;
+    int                 iService;
+};
+
+#endif // FAKESERVER_H
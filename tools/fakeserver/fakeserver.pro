@@ -0,0 +1,52 @@
+# Copyright (C) 2016  Gabriele Salvato
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#-------------------------------------------------
+#
+# A stand-in Panel Server (and panel load simulator)
+# to drive the Score Panels without the real Controller
+#
+#-------------------------------------------------
+
+QT += core
+QT += network
+QT += websockets
+QT -= gui
+
+CONFIG += c++11
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = fakeserver
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# The simulated panels use the very same transport of the real ones
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp
+SOURCES += fakeserver.cpp
+SOURCES += loadsimulator.cpp
+SOURCES += ../../panelconnection.cpp
+SOURCES += ../../utility.cpp
+SOURCES += ../../asynclogger.cpp
+
+HEADERS += fakeserver.h
+HEADERS += loadsimulator.h
+HEADERS += ../../panelconnection.h
+HEADERS += ../../utility.h
+HEADERS += ../../asynclogger.h
+HEADERS += ../../logformat.h
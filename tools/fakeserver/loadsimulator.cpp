@@ -0,0 +1,479 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QWebSocket>
+#include <QTextStream>
+#include <QCoreApplication>
+#include <QProcess>
+#include <QSocketNotifier>
+#include <QDeadlineTimer>
+#include <algorithm>
+
+#include "loadsimulator.h"
+#include "fakeserver.h"
+#include "panelconnection.h"
+#include "utility.h"
+
+
+#define SERVER_PORT      45454
+#define SPOT_UPDATE_PORT 45455
+#define CHUNK_SIZE       512*1024
+#define CLIENT_STOP_TIME 10000 // In msec (max time for a client process to report)
+
+
+/*!
+ * \brief FakePanelClient::FakePanelClient
+ * \param sHost The Server host
+ * \param pMySimulator The simulator collecting the statistics
+ * \param bFetchFiles true if the client has to download the Spots
+ */
+FakePanelClient::FakePanelClient(QString sHost, LoadSimulator *pMySimulator, bool bFetchFiles)
+    : QObject(Q_NULLPTR)
+    , sServerHost(sHost)
+    , pSimulator(pMySimulator)
+    , pConnection(Q_NULLPTR)
+    , pFileSocket(Q_NULLPTR)
+    , bFetchFiles(bFetchFiles)
+    , bFilesFetched(false)
+    , disconnectionTime(-1)
+    , bytesReceived(0)
+{
+    connect(&refreshTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToRefreshStatus()));
+}
+
+
+/*!
+ * \brief FakePanelClient::~FakePanelClient
+ */
+FakePanelClient::~FakePanelClient() {
+    refreshTimer.stop();
+    if(pFileSocket) {
+        pFileSocket->disconnect();
+        delete pFileSocket;
+    }
+    if(pConnection) {
+        pConnection->disconnect();
+        delete pConnection;
+    }
+}
+
+
+/*!
+ * \brief FakePanelClient::start Connect to the Server
+ */
+void
+FakePanelClient::start() {
+    pConnection = new PanelConnection(QUrl(QString("ws://%1:%2").arg(sServerHost).arg(SERVER_PORT)));
+    connect(pConnection, SIGNAL(connected()),
+            this, SLOT(onConnected()));
+    connect(pConnection, SIGNAL(disconnected()),
+            this, SLOT(onDisconnected()));
+    connect(pConnection, SIGNAL(textMessageReceived(QString)),
+            this, SLOT(onTextMessageReceived(QString)));
+    pConnection->open();
+}
+
+
+/*!
+ * \brief FakePanelClient::onConnected As the ScorePanel does: ask the status
+ * and start the Spot updater
+ */
+void
+FakePanelClient::onConnected() {
+    if(disconnectionTime >= 0) {
+        pSimulator->addReconnectTime(LoadSimulator::monotonicNsec()-disconnectionTime);
+        disconnectionTime = -1;
+    }
+    pConnection->sendTextMessage(QString("<getStatus>FakePanel</getStatus>"));
+    refreshTimer.start(qrand()%2000+3000);
+    if(bFetchFiles && !bFilesFetched && !pFileSocket) {
+        pFileSocket = new QWebSocket();
+        connect(pFileSocket, SIGNAL(connected()),
+                this, SLOT(onFileSocketConnected()));
+        connect(pFileSocket, SIGNAL(textMessageReceived(QString)),
+                this, SLOT(onFileTextMessage(QString)));
+        connect(pFileSocket, SIGNAL(binaryMessageReceived(QByteArray)),
+                this, SLOT(onFileBinaryMessage(QByteArray)));
+        pFileSocket->open(QUrl(QString("ws://%1:%2").arg(sServerHost).arg(SPOT_UPDATE_PORT)));
+    }
+}
+
+
+/*!
+ * \brief FakePanelClient::onDisconnected
+ */
+void
+FakePanelClient::onDisconnected() {
+    refreshTimer.stop();
+    disconnectionTime = LoadSimulator::monotonicNsec();
+}
+
+
+/*!
+ * \brief FakePanelClient::onTextMessageReceived Measure the event latency
+ * \param sMessage The received message
+ *
+ * The latency is measured from the sending time carried by the event
+ * ("<stamp>", on the host monotonic clock).
+ */
+void
+FakePanelClient::onTextMessageReceived(QString sMessage) {
+    qint64 now = LoadSimulator::monotonicNsec();
+    refreshTimer.start(qrand()%2000+3000);
+    QString sToken = XML_Parse(sMessage, "stamp");
+    if(sToken == QString("NoData"))
+        return;
+    bool bOk;
+    qint64 sent = sToken.toLongLong(&bOk);
+    if(bOk)
+        pSimulator->addLatency(now-sent);
+}
+
+
+/*!
+ * \brief FakePanelClient::onTimeToRefreshStatus
+ */
+void
+FakePanelClient::onTimeToRefreshStatus() {
+    pConnection->sendTextMessage(QString("<getStatus>FakePanel</getStatus>"));
+}
+
+
+/*!
+ * \brief FakePanelClient::onFileSocketConnected
+ */
+void
+FakePanelClient::onFileSocketConnected() {
+    pFileSocket->sendTextMessage(QString("<send_file_list>1</send_file_list>"));
+}
+
+
+/*!
+ * \brief FakePanelClient::onFileTextMessage Get the list of files to download
+ * \param sMessage The "<file_list>" message
+ */
+void
+FakePanelClient::onFileTextMessage(QString sMessage) {
+    QString sToken = XML_Parse(sMessage, "file_list");
+    if(sToken == QString("NoData"))
+        return;
+    QStringList fileList = sToken.split(",", QString::SkipEmptyParts);
+    for(int i=0; i<fileList.count(); i++) {
+        QStringList fileInfo = fileList.at(i).split(";", QString::SkipEmptyParts);
+        if(fileInfo.count() > 1) {
+            fileNames.append(fileInfo.at(0));
+            fileSizes.append(fileInfo.at(1).toLongLong());
+        }
+    }
+    bytesReceived = 0;
+    askNextFile();
+}
+
+
+/*!
+ * \brief FakePanelClient::onFileBinaryMessage A chunk arrived (it is thrown away)
+ * \param baMessage The chunk
+ */
+void
+FakePanelClient::onFileBinaryMessage(QByteArray baMessage) {
+    qint64 now = LoadSimulator::monotonicNsec();
+    qint64 size = baMessage.size();
+    if(bytesReceived == 0)
+        size -= 1024;// The header
+    bytesReceived += size;
+    pSimulator->addTransfer(baMessage.size(), now, now);
+    if(bytesReceived >= fileSizes.first()) {
+        fileNames.removeFirst();
+        fileSizes.removeFirst();
+        bytesReceived = 0;
+    }
+    askNextFile();
+}
+
+
+/*!
+ * \brief FakePanelClient::askNextFile Ask the next chunk (if any)
+ */
+void
+FakePanelClient::askNextFile() {
+    if(fileNames.isEmpty()) {
+        bFilesFetched = true;
+        pFileSocket->disconnect();
+        pFileSocket->close();
+        pFileSocket->deleteLater();
+        pFileSocket = Q_NULLPTR;
+        return;
+    }
+    pSimulator->addTransfer(0, LoadSimulator::monotonicNsec(), -1);
+    pFileSocket->sendTextMessage(QString("<get>%1,%2,%3</get>")
+                                 .arg(fileNames.first())
+                                 .arg(bytesReceived)
+                                 .arg(CHUNK_SIZE));
+}
+
+
+/*!
+ * \brief LoadSimulator::LoadSimulator Many headless panels hitting the Server
+ * \param pMyServer The (in process) Server (Q_NULLPTR in a client process)
+ * \param parent The parent object
+ *
+ * The clients run in separate processes (with their own event loops),
+ * so that what is measured is the Server and the network, not the
+ * queueing of the Server event loop. Each process collects its samples,
+ * all on the host monotonic clock, and hands them over when stopped.
+ */
+LoadSimulator::LoadSimulator(FakeServer *pMyServer, QObject *parent)
+    : QObject(parent)
+    , pServer(pMyServer)
+    , pQuitNotifier(Q_NULLPTR)
+    , nClientsStarted(0)
+    , bytesTransferred(0)
+    , transferStart(-1)
+    , transferEnd(-1)
+{
+}
+
+
+/*!
+ * \brief LoadSimulator::~LoadSimulator
+ */
+LoadSimulator::~LoadSimulator() {
+    stop();
+    qDeleteAll(clients);
+    clients.clear();
+}
+
+
+/*!
+ * \brief LoadSimulator::monotonicNsec The clock shared by all the processes of the host
+ * \return The monotonic clock time (in ns)
+ */
+qint64
+LoadSimulator::monotonicNsec() {
+    return QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs();
+}
+
+
+/*!
+ * \brief LoadSimulator::start Launch the client processes
+ * \param nClients The total number of clients
+ * \param sHost The Server host
+ * \param bFetchFiles true to make every client download the Spots
+ * \param nProcesses The number of client processes
+ *
+ * Each process is this same program started with --client-only.
+ */
+void
+LoadSimulator::start(int nClients, QString sHost, bool bFetchFiles, int nProcesses) {
+    nClientsStarted = nClients;
+    nProcesses = qBound(1, nProcesses, nClients);
+    for(int i=0; i<nProcesses; i++) {
+        int nProcessClients = nClients/nProcesses + (i < nClients%nProcesses ? 1 : 0);
+        QStringList arguments;
+        arguments << "--client-only"
+                  << "--clients" << QString::number(nProcessClients)
+                  << "--host" << sHost;
+        if(bFetchFiles)
+            arguments << "--fetch";
+        QProcess *pProcess = new QProcess(this);
+        // The samples come on stdout, the logs go on our stderr
+        pProcess->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        pProcess->start(QCoreApplication::applicationFilePath(), arguments);
+        clientProcesses.append(pProcess);
+    }
+}
+
+
+/*!
+ * \brief LoadSimulator::startClients Create and connect the clients of this process
+ * \param nClients The number of clients
+ * \param sHost The Server host
+ * \param bFetchFiles true to make every client download the Spots
+ *
+ * The clients stop when something (or the end of file) arrives on stdin.
+ */
+void
+LoadSimulator::startClients(int nClients, QString sHost, bool bFetchFiles) {
+    nClientsStarted = nClients;
+    for(int i=0; i<nClients; i++) {
+        FakePanelClient *pClient = new FakePanelClient(sHost, this, bFetchFiles);
+        clients.append(pClient);
+        pClient->start();
+    }
+    pQuitNotifier = new QSocketNotifier(0, QSocketNotifier::Read, this);
+    connect(pQuitNotifier, SIGNAL(activated(int)),
+            this, SLOT(onQuitRequest()));
+}
+
+
+/*!
+ * \brief LoadSimulator::onQuitRequest The launching process asked to stop
+ */
+void
+LoadSimulator::onQuitRequest() {
+    pQuitNotifier->setEnabled(false);
+    QCoreApplication::quit();
+}
+
+
+/*!
+ * \brief LoadSimulator::stop Stop the client processes and collect their samples
+ */
+void
+LoadSimulator::stop() {
+    for(QProcess *pProcess : clientProcesses) {
+        pProcess->write("quit\n");
+        pProcess->closeWriteChannel();
+    }
+    for(QProcess *pProcess : clientProcesses) {
+        if(!pProcess->waitForFinished(CLIENT_STOP_TIME)) {
+            QTextStream(stderr) << "A client process did not report: killed" << endl;
+            pProcess->kill();
+            pProcess->waitForFinished();
+        }
+        readSamples(pProcess->readAllStandardOutput());
+        delete pProcess;
+    }
+    clientProcesses.clear();
+}
+
+
+/*!
+ * \brief LoadSimulator::printSamples Hand the samples over to the launching process
+ *
+ * One sample per line: "L ns" (latency), "R ns" (reconnection time)
+ * or "T bytes start end" (transfer).
+ */
+void
+LoadSimulator::printSamples() {
+    QTextStream out(stdout);
+    for(qint64 latency : latencies)
+        out << "L " << latency << "\n";
+    for(qint64 reconnectTime : reconnectTimes)
+        out << "R " << reconnectTime << "\n";
+    if(bytesTransferred > 0)
+        out << "T " << bytesTransferred << " " << transferStart << " " << transferEnd << "\n";
+    out.flush();
+}
+
+
+/*!
+ * \brief LoadSimulator::readSamples Add the samples of a client process
+ * \param baSamples The process output (see printSamples())
+ */
+void
+LoadSimulator::readSamples(QByteArray baSamples) {
+    const QList<QByteArray> lines = baSamples.split('\n');
+    for(const QByteArray& baLine : lines) {
+        QList<QByteArray> fields = baLine.trimmed().split(' ');
+        if((fields.count() == 2) && (fields.at(0) == "L"))
+            addLatency(fields.at(1).toLongLong());
+        else if((fields.count() == 2) && (fields.at(0) == "R"))
+            addReconnectTime(fields.at(1).toLongLong());
+        else if((fields.count() == 4) && (fields.at(0) == "T")) {
+            addTransfer(fields.at(1).toLongLong(), fields.at(2).toLongLong(), fields.at(3).toLongLong());
+        }
+    }
+}
+
+
+/*!
+ * \brief LoadSimulator::addLatency
+ * \param nsecLatency Time from the event sent to its reception
+ */
+void
+LoadSimulator::addLatency(qint64 nsecLatency) {
+    latencies.append(nsecLatency);
+}
+
+
+/*!
+ * \brief LoadSimulator::addReconnectTime
+ * \param nsecTime Time from a disconnection to the new connection
+ */
+void
+LoadSimulator::addReconnectTime(qint64 nsecTime) {
+    reconnectTimes.append(nsecTime);
+}
+
+
+/*!
+ * \brief LoadSimulator::addTransfer
+ * \param bytes The bytes received
+ * \param nsecStart When the request has been sent
+ * \param nsecEnd When the bytes arrived (-1 if not yet)
+ */
+void
+LoadSimulator::addTransfer(qint64 bytes, qint64 nsecStart, qint64 nsecEnd) {
+    bytesTransferred += bytes;
+    if(transferStart < 0 || nsecStart < transferStart)
+        transferStart = nsecStart;
+    if(nsecEnd > transferEnd)
+        transferEnd = nsecEnd;
+}
+
+
+/*!
+ * \brief LoadSimulator::report Stop the clients and print the collected statistics on stdout
+ */
+void
+LoadSimulator::report() {
+    int nConnected = pServer->connectedPanels();
+    stop();
+    QTextStream out(stdout);
+    out << "Panels connected: " << nConnected
+        << "/" << nClientsStarted << endl;
+    printPercentiles(QString("Status update latency"), latencies);
+    printPercentiles(QString("Reconnection time"), reconnectTimes);
+    if(!pServer->paintLatencies().isEmpty())
+        printPercentiles(QString("Event to paint (real panels)"), pServer->paintLatencies());
+    if(bytesTransferred > 0 && transferEnd > transferStart) {
+        double seconds = double(transferEnd-transferStart)*1.0e-9;
+        out << QString("Transfer: %1 MB in %2 s (%3 MB/s)")
+               .arg(double(bytesTransferred)/1.0e6, 0, 'f', 1)
+               .arg(seconds, 0, 'f', 2)
+               .arg(double(bytesTransferred)/1.0e6/seconds, 0, 'f', 2)
+            << endl;
+    }
+}
+
+
+/*!
+ * \brief LoadSimulator::printPercentiles
+ * \param sTitle What we are reporting
+ * \param values The samples (in ns)
+ */
+void
+LoadSimulator::printPercentiles(QString sTitle, QVector<qint64> values) {
+    QTextStream out(stdout);
+    if(values.isEmpty()) {
+        out << sTitle << ": no samples" << endl;
+        return;
+    }
+    std::sort(values.begin(), values.end());
+    int n = values.count();
+    out << QString("%1 (%2 samples) [ms]: p50=%3 p90=%4 p99=%5 max=%6")
+           .arg(sTitle)
+           .arg(n)
+           .arg(double(values.at(n*50/100))*1.0e-6, 0, 'f', 3)
+           .arg(double(values.at(n*90/100))*1.0e-6, 0, 'f', 3)
+           .arg(double(values.at(n*99/100))*1.0e-6, 0, 'f', 3)
+           .arg(double(values.last())*1.0e-6, 0, 'f', 3)
+        << endl;
+}
@@ -0,0 +1,116 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef LOADSIMULATOR_H
+#define LOADSIMULATOR_H
+
+#include <QObject>
+#include <QUrl>
+#include <QTimer>
+#include <QVector>
+#include <QList>
+
+
+QT_FORWARD_DECLARE_CLASS(QWebSocket)
+QT_FORWARD_DECLARE_CLASS(QProcess)
+QT_FORWARD_DECLARE_CLASS(QSocketNotifier)
+QT_FORWARD_DECLARE_CLASS(PanelConnection)
+QT_FORWARD_DECLARE_CLASS(FakeServer)
+QT_FORWARD_DECLARE_CLASS(LoadSimulator)
+
+
+/*!
+ * \brief A headless Score Panel: it speaks the Panel protocol
+ * but shows nothing.
+ */
+class FakePanelClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    FakePanelClient(QString sHost, LoadSimulator *pMySimulator, bool bFetchFiles);
+    ~FakePanelClient();
+    void start();
+
+private slots:
+    void onConnected();
+    void onDisconnected();
+    void onTextMessageReceived(QString sMessage);
+    void onTimeToRefreshStatus();
+    void onFileSocketConnected();
+    void onFileTextMessage(QString sMessage);
+    void onFileBinaryMessage(QByteArray baMessage);
+
+private:
+    void askNextFile();
+
+private:
+    QString          sServerHost;
+    LoadSimulator   *pSimulator;
+    PanelConnection *pConnection;
+    QWebSocket      *pFileSocket;
+    QTimer           refreshTimer;
+    bool             bFetchFiles;
+    bool             bFilesFetched;
+    qint64           disconnectionTime;
+    QStringList      fileNames;
+    QList<qint64>    fileSizes;
+    qint64           bytesReceived;
+};
+
+
+class LoadSimulator : public QObject
+{
+    Q_OBJECT
+
+public:
+    LoadSimulator(FakeServer *pMyServer, QObject *parent=Q_NULLPTR);
+    ~LoadSimulator();
+    void start(int nClients, QString sHost, bool bFetchFiles, int nProcesses);
+    void startClients(int nClients, QString sHost, bool bFetchFiles);
+    void stop();
+    void report();
+    void printSamples();
+    static qint64 monotonicNsec();
+
+public:
+    void addLatency(qint64 nsecLatency);
+    void addReconnectTime(qint64 nsecTime);
+    void addTransfer(qint64 bytes, qint64 nsecStart, qint64 nsecEnd);
+
+private slots:
+    void onQuitRequest();
+
+private:
+    void readSamples(QByteArray baSamples);
+    void printPercentiles(QString sTitle, QVector<qint64> values);
+
+private:
+    FakeServer               *pServer;
+    QList<FakePanelClient *>  clients;
+    QList<QProcess *>         clientProcesses;
+    QSocketNotifier          *pQuitNotifier;
+    int                       nClientsStarted;
+    QVector<qint64>           latencies;
+    QVector<qint64>           reconnectTimes;
+    qint64                    bytesTransferred;
+    qint64                    transferStart;
+    qint64                    transferEnd;
+};
+
+#endif // LOADSIMULATOR_H
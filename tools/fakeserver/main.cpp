@@ -0,0 +1,118 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTimer>
+#include <QTime>
+#include <QThread>
+
+#include "fakeserver.h"
+#include "loadsimulator.h"
+#include "utility.h"
+#include "asynclogger.h"
+
+
+/*!
+ * \brief main A stand-in Panel Server
+ *
+ * <pre>fakeserver --panel basket --rate 5 --spots ~/spots --slides ~/slides</pre>
+ * drives the real panels of the network (they will find it with the usual
+ * discovery multicast).
+ *
+ * <pre>fakeserver --clients 300 --rate 10 --drop-every 20 --fetch --duration 120</pre>
+ * also launches 300 headless panels against it (spread over
+ * --client-processes processes) and, at the end, prints the status
+ * update latency percentiles, the reconnection times and the file
+ * transfer throughput.
+ */
+int
+main(int argc, char *argv[]) {
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("fakeserver");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("A stand-in Score Panel Server and panel load simulator");
+    parser.addHelpOption();
+    QCommandLineOption panelOption("panel", "Panel to drive: volley, basket or handball.", "panel", "volley");
+    QCommandLineOption rateOption("rate", "Game events per second.", "rate", "1");
+    QCommandLineOption spotOption("spots", "Folder with the Spots to serve.", "dir");
+    QCommandLineOption slideOption("slides", "Folder with the Slides to serve.", "dir");
+    QCommandLineOption clientsOption("clients", "Number of headless panels to launch.", "n", "0");
+    QCommandLineOption hostOption("host", "Server host for the headless panels.", "host", "127.0.0.1");
+    QCommandLineOption fetchOption("fetch", "Headless panels download the Spots.");
+    QCommandLineOption dropOption("drop-every", "Drop all the panel connections every s seconds.", "s", "0");
+    QCommandLineOption durationOption("duration", "Quit (and report) after s seconds.", "s", "0");
+    QCommandLineOption processesOption("client-processes", "Processes running the headless panels.", "n",
+                                       QString::number(QThread::idealThreadCount()));
+    QCommandLineOption clientOnlyOption("client-only", "Run only the headless panels (a client process).");
+    parser.addOption(panelOption);
+    parser.addOption(rateOption);
+    parser.addOption(spotOption);
+    parser.addOption(slideOption);
+    parser.addOption(clientsOption);
+    parser.addOption(hostOption);
+    parser.addOption(fetchOption);
+    parser.addOption(dropOption);
+    parser.addOption(durationOption);
+    parser.addOption(processesOption);
+    parser.addOption(clientOnlyOption);
+    parser.process(a);
+
+    QTime time(QTime::currentTime());
+    qsrand(uint(time.msecsSinceStartOfDay()) ^ uint(QCoreApplication::applicationPid()));
+
+    int nClients = parser.value(clientsOption).toInt();
+    if(parser.isSet(clientOnlyOption)) {
+        // Launched by the load simulator: the samples go back on stdout
+        LoadSimulator clientSimulator(Q_NULLPTR);
+        clientSimulator.startClients(nClients, parser.value(hostOption), parser.isSet(fetchOption));
+        int result = a.exec();
+        AsyncLogger::shutdown();
+        clientSimulator.printSamples();
+        return result;
+    }
+
+    int panelType = VOLLEY_PANEL;
+    if(parser.value(panelOption) == QString("basket"))
+        panelType = BASKET_PANEL;
+    else if(parser.value(panelOption) == QString("handball"))
+        panelType = HANDBALL_PANEL;
+
+    FakeServer server(panelType);
+    server.setMediaDirs(parser.value(spotOption), parser.value(slideOption));
+    if(!server.start())
+        return 1;
+    server.setEventRate(parser.value(rateOption).toDouble());
+    server.setDropInterval(parser.value(dropOption).toInt()*1000);
+
+    LoadSimulator simulator(&server);
+    if(nClients > 0)
+        simulator.start(nClients, parser.value(hostOption), parser.isSet(fetchOption),
+                        parser.value(processesOption).toInt());
+
+    int duration = parser.value(durationOption).toInt();
+    if(duration > 0)
+        QTimer::singleShot(duration*1000, &a, SLOT(quit()));
+
+    int result = a.exec();
+    AsyncLogger::shutdown();
+    if(nClients > 0 || !server.paintLatencies().isEmpty())
+        simulator.report();
+    return result;
+}
@@ -0,0 +1,286 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QGridLayout>
+#include <QVBoxLayout>
+#include <QLabel>
+#include <QVector>
+#include <algorithm>
+
+#include "scoredigits.h"
+#include "panelcompositor.h"
+
+
+/*!
+ * \brief The fields of a basket like panel
+ */
+struct panelFields {
+    QLabel      *team[2];
+    ScoreDigits *score[2];
+    QLabel      *possess[2];
+    QLabel      *timeout[2];
+    QLabel      *bonus[2];
+    ScoreDigits *teamFouls[2];
+    QLabel      *foulsLabel;
+    ScoreDigits *period;
+    QLabel      *timeLabel;
+};
+
+
+/*!
+ * \brief newLabel A panel label
+ * \param sText The label text
+ * \param pointSize The font size
+ * \return The new label
+ */
+static QLabel*
+newLabel(QString sText, int pointSize) {
+    QLabel* pLabel = new QLabel(sText);
+    pLabel->setFont(QFont("Arial", pointSize, QFont::Black));
+    pLabel->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+    return pLabel;
+}
+
+
+/*!
+ * \brief createFields Create the fields of the panel
+ * \param pFields The fields
+ */
+static void
+createFields(panelFields *pFields) {
+    for(int i=0; i<2; i++) {
+        pFields->team[i]      = newLabel(i ? "Ospiti" : "Locali", 48);
+        pFields->score[i]     = new ScoreDigits(3);
+        pFields->score[i]->setFrameStyle(QFrame::NoFrame);
+        pFields->score[i]->display(88);
+        pFields->possess[i]   = newLabel(i ? "==>" : "<==", 40);
+        pFields->timeout[i]   = newLabel("* * *", 40);
+        pFields->bonus[i]     = newLabel(" Bonus ", 40);
+        pFields->teamFouls[i] = new ScoreDigits(2);
+        pFields->teamFouls[i]->setFrameStyle(QFrame::NoFrame);
+        pFields->teamFouls[i]->display(4);
+    }
+    pFields->foulsLabel = newLabel("Team Fouls", 40);
+    pFields->period     = new ScoreDigits(2);
+    pFields->period->setFrameStyle(QFrame::NoFrame);
+    pFields->period->display(2);
+    pFields->timeLabel  = newLabel("10:00", 120);
+}
+
+
+/*!
+ * \brief createGrid The (22x24) grid of the panel
+ * \param pFields The panel fields
+ * \param bMirrored true to place them reflected (as the panels did before)
+ * \return The new grid
+ */
+static QGridLayout*
+createGrid(panelFields *pFields, bool bMirrored) {
+    int l = bMirrored ? 1 : 0; // The team on the left
+    int r = 1 - l;
+    QGridLayout *layout = new QGridLayout();
+    layout->addWidget(pFields->team[l],       0,  0,  4, 12, Qt::AlignHCenter|Qt::AlignVCenter);
+    layout->addWidget(pFields->team[r],       0, 12,  4, 12, Qt::AlignHCenter|Qt::AlignVCenter);
+    layout->addWidget(pFields->score[l],      4,  0,  6,  6);
+    layout->addWidget(pFields->score[r],      4, 18,  6,  6);
+    layout->addWidget(pFields->possess[l],    4,  6,  6,  4, Qt::AlignLeft|Qt::AlignVCenter);
+    layout->addWidget(pFields->possess[r],    4, 14,  6,  4, Qt::AlignRight|Qt::AlignVCenter);
+    layout->addWidget(pFields->timeout[l],   12,  0,  3,  5, Qt::AlignRight|Qt::AlignVCenter);
+    layout->addWidget(pFields->timeout[r],   12, 19,  3,  5, Qt::AlignLeft|Qt::AlignVCenter);
+    layout->addWidget(pFields->bonus[l],     15,  0,  3,  5, Qt::AlignHCenter|Qt::AlignVCenter);
+    layout->addWidget(pFields->bonus[r],     15, 19,  3,  5, Qt::AlignHCenter|Qt::AlignVCenter);
+    layout->addWidget(pFields->teamFouls[l], 19,  3,  3,  2);
+    layout->addWidget(pFields->foulsLabel,   20,  5,  2, 15, Qt::AlignHCenter|Qt::AlignVCenter);
+    layout->addWidget(pFields->teamFouls[r], 19, 20,  3,  2);
+    layout->addWidget(pFields->period,        4, 10,  6,  4);
+    layout->addWidget(pFields->timeLabel,    10,  5, 10, 14, Qt::AlignHCenter|Qt::AlignVCenter);
+    return layout;
+}
+
+
+/*!
+ * \brief reflectGrid The in place reflection done by ScorePanel::applyOrientation()
+ * \param pGrid The panel grid
+ * \param bMirrored true to reflect the panel
+ */
+static void
+reflectGrid(QGridLayout *pGrid, bool bMirrored) {
+    pGrid->setOriginCorner(bMirrored ? Qt::TopRightCorner : Qt::TopLeftCorner);
+    for(int i=0; i<pGrid->count(); i++) {
+        QLayoutItem* pItem = pGrid->itemAt(i);
+        Qt::Alignment alignment = pItem->alignment();
+        if(alignment & (Qt::AlignLeft|Qt::AlignRight))
+            pItem->setAlignment(alignment ^ (Qt::AlignLeft|Qt::AlignRight));
+    }
+    pGrid->invalidate();
+}
+
+
+/*!
+ * \brief preparePanel Give a panel its look and show it
+ * \param pPanel The panel
+ * \param width Its width
+ * \param height Its height
+ */
+static void
+preparePanel(QWidget *pPanel, int width, int height) {
+    QPalette pal = pPanel->palette();
+    pal.setColor(QPalette::Window,     Qt::black);
+    pal.setColor(QPalette::WindowText, Qt::yellow);
+    pPanel->setPalette(pal);
+    pPanel->setAutoFillBackground(true);
+    pPanel->setFixedSize(width, height);
+    pPanel->show();
+    QApplication::processEvents();
+}
+
+
+/*!
+ * \brief paintPending Lay out and paint all the pending updates now
+ */
+static void
+paintPending() {
+    QApplication::sendPostedEvents();
+    QApplication::processEvents();
+}
+
+
+/*!
+ * \brief report Show the statistics of the measured times
+ * \param sName The reflection measured
+ * \param times The reflection times (in ns)
+ */
+static void
+report(QString sName, QVector<qint64> times) {
+    std::sort(times.begin(), times.end());
+    qint64 total = 0;
+    for(int i=0; i<times.count(); i++)
+        total += times.at(i);
+    QTextStream(stdout) << QString("%1: mean %2 us, median %3 us, 95% %4 us, max %5 us\n")
+                           .arg(sName, -22)
+                           .arg(double(total)/times.count()/1000.0, 0, 'f', 1)
+                           .arg(double(times.at(times.count()/2))/1000.0, 0, 'f', 1)
+                           .arg(double(times.at(times.count()*95/100))/1000.0, 0, 'f', 1)
+                           .arg(double(times.last())/1000.0, 0, 'f', 1);
+}
+
+
+/*!
+ * \brief main Measure the time to reflect a score panel
+ *
+ * <pre>flipbench --width 1920 --height 1080 --flips 200</pre>
+ * reflects a basket like panel again and again:
+ * - rebuilding its layout (as setOrientation did before);
+ * - reflecting its grid in place;
+ * - switching the precomputed cells of a PanelCompositor.
+ * The first two are measured both with and without the relayout and
+ * repaint that follow. It may also run without a display with
+ * <pre>-platform offscreen</pre>.
+ */
+int
+main(int argc, char *argv[]) {
+    QApplication a(argc, argv);
+    QApplication::setApplicationName("flipbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Time to reflect a score panel");
+    parser.addHelpOption();
+    QCommandLineOption widthOption("width", "Panel width.", "pixels", "1920");
+    QCommandLineOption heightOption("height", "Panel height.", "pixels", "1080");
+    QCommandLineOption flipsOption("flips", "Number of reflections.", "n", "200");
+    parser.addOption(widthOption);
+    parser.addOption(heightOption);
+    parser.addOption(flipsOption);
+    parser.process(a);
+
+    int width   = parser.value(widthOption).toInt();
+    int height  = parser.value(heightOption).toInt();
+    int nFlips  = qMax(1, parser.value(flipsOption).toInt());
+
+    QElapsedTimer timer;
+    QVector<qint64> rebuildTimes;
+    QVector<qint64> rebuildPaintTimes;
+    QVector<qint64> reflectTimes;
+    QVector<qint64> reflectPaintTimes;
+    QVector<qint64> compositorTimes;
+
+    panelFields fields;
+    createFields(&fields);
+
+    // The panel rebuilt on every reflection
+    QWidget window;
+    window.setLayout(new QVBoxLayout());
+    preparePanel(&window, width, height);
+    QWidget* pPanel = Q_NULLPTR;
+    for(int i=0; i<=nFlips; i++) {
+        bool bMirrored = (i % 2) != 0;
+        timer.start();
+        QWidget* pOldPanel = pPanel;
+        pPanel = new QWidget(&window);
+        QVBoxLayout *panelLayout = new QVBoxLayout();
+        panelLayout->addLayout(createGrid(&fields, bMirrored));
+        pPanel->setLayout(panelLayout);
+        window.layout()->addWidget(pPanel);
+        delete pOldPanel;
+        qint64 rebuildTime = timer.nsecsElapsed();
+        paintPending();
+        if(i == 0)// The first one is just the panel creation
+            continue;
+        rebuildTimes.append(rebuildTime);
+        rebuildPaintTimes.append(timer.nsecsElapsed());
+    }
+
+    // The panel reflected in place
+    QGridLayout* pGrid = qobject_cast<QGridLayout*>(pPanel->layout()->itemAt(0)->layout());
+    for(int i=0; i<nFlips; i++) {
+        bool bMirrored = (i % 2) == 0;
+        timer.start();
+        reflectGrid(pGrid, bMirrored);
+        qint64 reflectTime = timer.nsecsElapsed();
+        paintPending();
+        reflectTimes.append(reflectTime);
+        reflectPaintTimes.append(timer.nsecsElapsed());
+    }
+    window.hide();
+
+    // The panel drawn by a PanelCompositor
+    PanelCompositor compositor;
+    compositor.setFields(createGrid(&fields, false));
+    preparePanel(&compositor, width, height);
+    for(int i=0; i<nFlips; i++) {
+        timer.start();
+        compositor.setMirrored((i % 2) == 0);
+        paintPending();
+        compositorTimes.append(timer.nsecsElapsed());
+    }
+
+    QTextStream(stdout) << QString("%1 reflections of a %2x%3 panel\n")
+                           .arg(nFlips)
+                           .arg(width)
+                           .arg(height);
+    report("Rebuild", rebuildTimes);
+    report("Rebuild + paint", rebuildPaintTimes);
+    report("In place", reflectTimes);
+    report("In place + paint", reflectPaintTimes);
+    report("Compositor + paint", compositorTimes);
+    return 0;
+}
@@ -0,0 +1,167 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QDataStream>
+#include <QDateTime>
+#include <QHash>
+#include <QPair>
+#include <QTextStream>
+
+#include "logformat.h"
+
+
+/*!
+ * \brief statusName The readable QDataStream status
+ */
+static QString
+statusName(QDataStream::Status status) {
+    switch(status) {
+    case QDataStream::Ok:              return QString("ok");
+    case QDataStream::ReadPastEnd:     return QString("truncated record");
+    case QDataStream::ReadCorruptData: return QString("corrupt record");
+    default:                           return QString("read error");
+    }
+}
+
+
+/*!
+ * \brief decodeFile Print a binary log file as text
+ * \param sFileName The binary log
+ * \param out Where to print
+ * \return false if the file is not a valid binary log
+ *
+ * The decoding stops at the first record that cannot be read
+ * (a truncated last record, as after a crash, is not an error).
+ */
+static bool
+decodeFile(const QString& sFileName, QTextStream& out) {
+    QTextStream err(stderr);
+    QFile file(sFileName);
+    if(!file.open(QIODevice::ReadOnly)) {
+        err << QString("Unable to open %1: %2\n").arg(sFileName).arg(file.errorString());
+        return false;
+    }
+    if(file.read(int(qstrlen(LOG_BINARY_MAGIC))) != QByteArray(LOG_BINARY_MAGIC)) {
+        err << QString("%1 is not a binary Score Panel log\n").arg(sFileName);
+        return false;
+    }
+    QDataStream in(&file);
+    in.setByteOrder(QDataStream::LittleEndian);
+    // message id -> (function, format)
+    QHash<quint32, QPair<QString, QString> > formats;
+    const int nSubsystems = int(sizeof(logSubsystemNames)/sizeof(logSubsystemNames[0]));
+    while(!in.atEnd()) {
+        qint64 recordPos = file.pos();
+        quint8 type;
+        in >> type;
+        if(type == LOG_RECORD_FORMAT) {
+            quint32 messageId;
+            QByteArray baFunction, baFormat;
+            in >> messageId >> baFunction >> baFormat;
+            if(in.status() != QDataStream::Ok) {
+                err << QString("%1: %2 (format) at offset %3, stopped there\n")
+                       .arg(sFileName).arg(statusName(in.status())).arg(recordPos);
+                return in.status() == QDataStream::ReadPastEnd;
+            }
+            formats.insert(messageId, qMakePair(QString::fromUtf8(baFunction),
+                                                QString::fromUtf8(baFormat)));
+        }
+        else if(type == LOG_RECORD_MESSAGE) {
+            qint64  msecTime;
+            quint8  subsystem;
+            quint32 messageId;
+            quint8  argc;
+            in >> msecTime >> subsystem >> messageId >> argc;
+            QStringList args;
+            for(int i=0; i<argc; i++) {
+                QByteArray baArg;
+                in >> baArg;
+                args.append(QString::fromUtf8(baArg));
+            }
+            if(in.status() != QDataStream::Ok) {
+                err << QString("%1: %2 (message) at offset %3, stopped there\n")
+                       .arg(sFileName).arg(statusName(in.status())).arg(recordPos);
+                return in.status() == QDataStream::ReadPastEnd;
+            }
+            QString sFunctionName, sMessage;
+            if(messageId == LOG_TEXT_ID) {
+                sFunctionName = args.value(0);
+                sMessage      = args.value(1);
+            }
+            else if(formats.contains(messageId)) {
+                sFunctionName = formats.value(messageId).first;
+                sMessage      = formatLogMessage(formats.value(messageId).second, args);
+            }
+            else {
+                sFunctionName = QString("?");
+                sMessage      = QString("Unknown message %1: %2")
+                                .arg(messageId)
+                                .arg(args.join(QString(", ")));
+            }
+            QString sSubsystem;
+            if(subsystem < nSubsystems)
+                sSubsystem = QString("[%1] ").arg(logSubsystemNames[subsystem]);
+            out << QDateTime::fromMSecsSinceEpoch(msecTime).toString()
+                << QString(" - ")
+                << sSubsystem
+                << sFunctionName
+                << QString(" - ")
+                << sMessage
+                << QString("\n");
+        }
+        else {
+            err << QString("%1: unknown record type %2 at offset %3, giving up\n")
+                   .arg(sFileName).arg(type).arg(recordPos);
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/*!
+ * \brief main Convert the binary Score Panel logs to text
+ *
+ * <pre>logdecoder score_panel.bin.2 score_panel.bin.1 score_panel.bin</pre>
+ * prints the three generations in chronological order.
+ */
+int
+main(int argc, char *argv[]) {
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("logdecoder");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Converts the binary Score Panel logs to text");
+    parser.addHelpOption();
+    parser.addPositionalArgument("files", "The binary log files.", "files...");
+    parser.process(a);
+
+    if(parser.positionalArguments().isEmpty())
+        parser.showHelp(1);
+
+    QTextStream out(stdout);
+    int result = 0;
+    for(const QString& sFileName : parser.positionalArguments()) {
+        if(!decodeFile(sFileName, out))
+            result = 1;
+    }
+    return result;
+}
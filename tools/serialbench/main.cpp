@@ -0,0 +1,245 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+#include "arduinodecoder.h"
+
+
+static const char startMarker = char(0xFF);
+static const char endMarker   = char(0xFE);
+static const char specialByte = char(0xFD);
+
+static const quint8 timeCommand    = 0x41;
+static const quint8 possessCommand = 0x42;
+
+
+/*!
+ * \brief nextRandom A small (and repeatable) pseudo random generator
+ */
+static quint32
+nextRandom(quint32 *pSeed) {
+    *pSeed = *pSeed*1103515245u + 12345u;
+    return (*pSeed >> 8);
+}
+
+
+/*!
+ * \brief appendFrame Encode a frame as the Arduino does
+ * \param stream Where to append the frame
+ * \param body Command and data
+ */
+static void
+appendFrame(QByteArray& stream, const QByteArray& body) {
+    QByteArray encoded;
+    for(int i=0; i<body.size(); i++) {
+        quint8 byte = quint8(body.at(i));
+        if(byte >= quint8(specialByte)) {
+            encoded.append(specialByte);
+            encoded.append(char(byte-quint8(specialByte)));
+        }
+        else
+            encoded.append(char(byte));
+    }
+    stream.append(startMarker);
+    stream.append(char(encoded.size()+3));
+    stream.append(encoded);
+    stream.append(endMarker);
+}
+
+
+/*!
+ * \brief makeStream Build a synthetic Arduino byte stream
+ * \param nFrames The number of frames
+ * \param corruptEvery Corrupt a byte every that many frames (0 = never)
+ * \param pValidFrames [out] The frames left intact
+ * \return The byte stream
+ *
+ * Mostly Time frames (with random values, many of them need escaping)
+ * and, every 10 frames, a Possess frame.
+ */
+static QByteArray
+makeStream(int nFrames, int corruptEvery, int *pValidFrames) {
+    QByteArray stream;
+    quint32 seed = 1;
+    *pValidFrames = 0;
+    for(int i=0; i<nFrames; i++) {
+        QByteArray body;
+        if(i % 10 == 9) {
+            body.append(char(possessCommand));
+            body.append(char(nextRandom(&seed) & 0xFF));
+        }
+        else {
+            quint32 time = nextRandom(&seed);
+            body.append(char(timeCommand));
+            for(int j=0; j<4; j++)
+                body.append(char((time >> (8*j)) & 0xFF));
+        }
+        int iFrameStart = stream.size();
+        appendFrame(stream, body);
+        if((corruptEvery > 0) && (i % corruptEvery == corruptEvery-1)) {
+            int iByte = iFrameStart + int(nextRandom(&seed) % quint32(stream.size()-iFrameStart));
+            stream[iByte] = char(nextRandom(&seed) & 0xFF);
+        }
+        else
+            (*pValidFrames)++;
+    }
+    return stream;
+}
+
+
+/*!
+ * \brief legacyDecode The decoding formerly done in TimedScorePanel::onSerialDataAvailable()
+ * \return The number of frames decoded
+ */
+static int
+legacyDecode(const QByteArray& stream, int chunkSize) {
+    int nFrames = 0;
+    QByteArray responseData;
+    for(int iChunk=0; iChunk<stream.size(); iChunk+=chunkSize) {
+        responseData.append(stream.mid(iChunk, chunkSize));
+        while(responseData.count() > 0) {
+            int iStart = responseData.indexOf(startMarker);
+            if(iStart == -1) {
+                responseData.clear();
+                break;
+            }
+            if(iStart > 0)
+                responseData.remove(0, iStart);
+            int iEnd = responseData.indexOf(endMarker);
+            if(iEnd == -1) break;
+            int length = quint8(responseData.at(1));
+            if(length < 1) length = 1;// The old code looped forever here
+            QByteArray response = responseData.left(length);
+            QByteArray decodedResponse;
+            for(int i=1; i<response.count(); i++) {
+                if(response.at(i) == endMarker)
+                    break;
+                if(response.at(i) == specialByte) {
+                    i++;
+                    if(i<response.count())
+                        decodedResponse.append(char(response.at(i-1)+response.at(i)));
+                }
+                decodedResponse.append(response.at(i));
+            }
+            if(decodedResponse.count() > 1)
+                nFrames++;
+            responseData.remove(0, length);
+        }
+    }
+    return nFrames;
+}
+
+
+/*!
+ * \brief ringDecode The ArduinoDecoder, fed as by SerialLink
+ * \param pResyncs [out] The decoder resynchronizations
+ * \return The number of frames decoded
+ */
+static int
+ringDecode(const QByteArray& stream, int chunkSize, quint64 *pResyncs) {
+    ArduinoDecoder decoder;
+    const char* data = stream.constData();
+    int iByte = 0;
+    int checksum = 0;
+    while(iByte < stream.size()) {
+        iByte += decoder.feed(data+iByte, qMin(chunkSize, stream.size()-iByte));
+        while(decoder.nextFrame())
+            checksum += decoder.frame()[1];
+    }
+    Q_UNUSED(checksum)
+    *pResyncs = decoder.resyncs();
+    return int(decoder.frames());
+}
+
+
+/*!
+ * \brief main Measure the Arduino frame decoder throughput
+ *
+ * The same synthetic stream, delivered in chunks as the serial port
+ * does, is decoded by the old QByteArray based code and by the
+ * ArduinoDecoder.
+ */
+int
+main(int argc, char *argv[]) {
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("serialbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Throughput benchmark of the Arduino frame decoder");
+    parser.addHelpOption();
+    QCommandLineOption framesOption("frames", "Frames in the stream (default 1000000).", "n", "1000000");
+    QCommandLineOption chunkOption("chunk", "Bytes delivered at a time (default 32).", "n", "32");
+    QCommandLineOption corruptOption("corrupt", "Corrupt a frame every n (default 0 = never).", "n", "0");
+    QCommandLineOption repeatOption("repeat", "Runs of each decoder (default 5).", "n", "5");
+    parser.addOption(framesOption);
+    parser.addOption(chunkOption);
+    parser.addOption(corruptOption);
+    parser.addOption(repeatOption);
+    parser.process(a);
+
+    int nFrames      = qMax(1, parser.value(framesOption).toInt());
+    int chunkSize    = qMax(1, parser.value(chunkOption).toInt());
+    int corruptEvery = qMax(0, parser.value(corruptOption).toInt());
+    int nRepeat      = qMax(1, parser.value(repeatOption).toInt());
+
+    QTextStream out(stdout);
+    int nValid;
+    QByteArray stream = makeStream(nFrames, corruptEvery, &nValid);
+    out << QString("Stream: %1 frames (%2 intact), %3 bytes, %4 bytes per read\n")
+           .arg(nFrames).arg(nValid).arg(stream.size()).arg(chunkSize);
+
+    QElapsedTimer timer;
+    qint64 bestLegacy = -1, bestRing = -1;
+    int nLegacyFrames = 0, nRingFrames = 0;
+    quint64 nResyncs = 0;
+    for(int i=0; i<nRepeat; i++) {
+        timer.start();
+        nLegacyFrames = legacyDecode(stream, chunkSize);
+        qint64 elapsed = timer.nsecsElapsed();
+        if((bestLegacy < 0) || (elapsed < bestLegacy)) bestLegacy = elapsed;
+
+        timer.start();
+        nRingFrames = ringDecode(stream, chunkSize, &nResyncs);
+        elapsed = timer.nsecsElapsed();
+        if((bestRing < 0) || (elapsed < bestRing)) bestRing = elapsed;
+    }
+
+    double mBytes = double(stream.size())/(1024.0*1024.0);
+    out << QString("Legacy decoder: %1 frames, %2 MB/s, %3 ns/frame\n")
+           .arg(nLegacyFrames)
+           .arg(mBytes/(double(bestLegacy)*1.0e-9), 0, 'f', 1)
+           .arg(double(bestLegacy)/double(nFrames), 0, 'f', 1);
+    out << QString("Ring decoder  : %1 frames, %2 MB/s, %3 ns/frame, %4 resyncs\n")
+           .arg(nRingFrames)
+           .arg(mBytes/(double(bestRing)*1.0e-9), 0, 'f', 1)
+           .arg(double(bestRing)/double(nFrames), 0, 'f', 1)
+           .arg(nResyncs);
+    out << QString("Speedup       : %1x\n")
+           .arg(double(bestLegacy)/double(qMax(qint64(1), bestRing)), 0, 'f', 2);
+
+    // Without corruption every frame must be decoded
+    if((corruptEvery == 0) && (nRingFrames != nFrames)) {
+        out << QString("ERROR: %1 frames expected\n").arg(nFrames);
+        return 1;
+    }
+    return 0;
+}
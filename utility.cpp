@@ -16,11 +16,79 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *
 */
-#include <QTextStream>
-#include <QDateTime>
-#include <QDebug>
+#include <QAtomicInt>
+#include <QStringList>
+#include <QHash>
 
 #include "utility.h"
+#include "asynclogger.h"
+#include "logformat.h"
+
+
+// The runtime log level of each subsystem
+static QBasicAtomicInt logLevels[LOG_SUBSYSTEMS] = {
+    Q_BASIC_ATOMIC_INITIALIZER(LOG_COMPILED_LEVEL),// LOG_DISCOVERY
+    Q_BASIC_ATOMIC_INITIALIZER(LOG_COMPILED_LEVEL),// LOG_UPDATER
+    Q_BASIC_ATOMIC_INITIALIZER(LOG_COMPILED_LEVEL),// LOG_SLIDES
+    Q_BASIC_ATOMIC_INITIALIZER(LOG_COMPILED_LEVEL),// LOG_SERIAL
+    Q_BASIC_ATOMIC_INITIALIZER(LOG_COMPILED_LEVEL),// LOG_PANEL
+    Q_BASIC_ATOMIC_INITIALIZER(LOG_COMPILED_LEVEL) // LOG_STARTUP
+};
+static const char* levelNames[LOG_LEVEL_TRACE+2] = {
+    "off", "error", "info", "debug", "trace"
+};
+
+
+/*!
+ * \brief The tags of the last message parsed (in each thread)
+ *
+ * The panels look for many tokens in the same message (and, with more
+ * screens, more panels look for the same tokens): the message is
+ * scanned only once.
+ */
+struct parsedMessage {
+    QString             sMessage;
+    QHash<QString, int> startTags;/*!< First position after each "<tag>" */
+    QHash<QString, int> endTags;  /*!< First position of each "</tag>" */
+};
+static thread_local parsedMessage lastParsed;
+
+
+/*!
+ * \brief parseTags Find the first position of every tag in a message
+ * \param sMessage The message
+ * \param parsed Where to store the tag positions
+ */
+static void
+parseTags(const QString& sMessage, parsedMessage& parsed) {
+    parsed.sMessage = sMessage;
+    parsed.startTags.clear();
+    parsed.endTags.clear();
+    int len = sMessage.length();
+    int pos = sMessage.indexOf(QChar('<'));
+    while(pos >= 0) {
+        int i = pos+1;
+        while((i < len) && (sMessage.at(i) != QChar('<')) && (sMessage.at(i) != QChar('>')))
+            i++;
+        if(i >= len)
+            break;
+        if(sMessage.at(i) == QChar('<')) {// Not a tag: try from here
+            pos = i;
+            continue;
+        }
+        if((i > pos+1) && (sMessage.at(pos+1) == QChar('/'))) {
+            QString sTag = sMessage.mid(pos+2, i-pos-2);
+            if(!parsed.endTags.contains(sTag))
+                parsed.endTags.insert(sTag, pos);
+        }
+        else {
+            QString sTag = sMessage.mid(pos+1, i-pos-1);
+            if(!parsed.startTags.contains(sTag))
+                parsed.startTags.insert(sTag, i+1);
+        }
+        pos = sMessage.indexOf(QChar('<'), i+1);
+    }
+}
 
 
 /*!
@@ -28,30 +96,23 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
  * \param input_string: the string to parse
  * \param token: the token to look for
  * \return XML_Parse("<score>1</score>","score") will return QString("1") or QString() on error
+ *
+ * The text between the first "<token>" and the first "</token>".
  */
 QString
 XML_Parse(QString input_string, QString token) {
-    QString start_token, end_token, result = QString("NoData");
-    start_token = "<" + token + ">";
-    end_token = "</" + token + ">";
-
-    int start_pos=-1, end_pos=-1, len=0;
-
-    start_pos = input_string.indexOf(start_token);
-    end_pos   = input_string.indexOf(end_token);
-
-    if(start_pos < 0 || end_pos < 0) {
-        result = QString("NoData");
-    } else {
-        start_pos += start_token.length();
-        len = end_pos - start_pos;
-        if(len>0)
-            result = input_string.mid(start_pos, len);
-        else
-            result = "";
-    }
+    if(input_string != lastParsed.sMessage)
+        parseTags(input_string, lastParsed);
+
+    int start_pos = lastParsed.startTags.value(token, -1);
+    int end_pos   = lastParsed.endTags.value(token, -1);
 
-    return result;
+    if(start_pos < 0 || end_pos < 0)
+        return QString("NoData");
+    int len = end_pos - start_pos;
+    if(len > 0)
+        return input_string.mid(start_pos, len);
+    return QString("");
 }
 
 
@@ -60,26 +121,111 @@ XML_Parse(QString input_string, QString token) {
  * \param logFile The file where to write the log
  * \param sFunctionName The Function which requested to write the message
  * \param sMessage The informative message
+ *
+ * The message is only queued: the AsyncLogger thread will write it.
  */
 void
 logMessage(QFile *logFile, QString sFunctionName, QString sMessage) {
-    QDateTime dateTime;
-    QString sDebugMessage = dateTime.currentDateTime().toString() +
-                            QString(" - ") +
-                            sFunctionName +
-                            QString(" - ") +
-                            sMessage;
-    if(logFile) {
-        if(logFile->isOpen()) {
-            logFile->write(sDebugMessage.toUtf8().data());
-            logFile->write("\n");
-            logFile->flush();
+    AsyncLogger::instance()->enqueue(logFile, sFunctionName, sMessage);
+}
+
+
+/*!
+ * \brief isLogEnabled Check the runtime log level
+ * \param subsystem The subsystem (LOG_DISCOVERY ... LOG_STARTUP)
+ * \param level The message level (LOG_LEVEL_ERROR ... LOG_LEVEL_TRACE)
+ * \return true if the message has to be written
+ *
+ * Used by the LOG_ERROR ... LOG_TRACE macros.
+ */
+bool
+isLogEnabled(int subsystem, int level) {
+    if(subsystem < 0 || subsystem >= LOG_SUBSYSTEMS)
+        return true;
+    return level <= logLevels[subsystem].loadAcquire();
+}
+
+
+/*!
+ * \brief setLogLevel Change the log level of a subsystem
+ * \param subsystem The subsystem (LOG_DISCOVERY ... LOG_STARTUP)
+ * \param level The new level (LOG_LEVEL_OFF ... LOG_LEVEL_TRACE)
+ *
+ * Levels above LOG_COMPILED_LEVEL have no effect: their
+ * messages have been removed at compile time.
+ */
+void
+setLogLevel(int subsystem, int level) {
+    if(subsystem < 0 || subsystem >= LOG_SUBSYSTEMS)
+        return;
+    logLevels[subsystem].storeRelease(qBound(LOG_LEVEL_OFF, level, LOG_LEVEL_TRACE));
+}
+
+
+/*!
+ * \brief setLogLevels Change the log levels from a string
+ * \param sLevels A comma separated list of subsystem=level
+ * \return false if the string contains errors
+ *
+ * setLogLevels("all=error,serial=debug") writes only the errors
+ * but for the Arduino communication.
+ * The levels are: off, error, info, debug and trace.
+ */
+bool
+setLogLevels(QString sLevels) {
+    bool bOk = true;
+    QStringList items = sLevels.split(",", QString::SkipEmptyParts);
+    for(const QString& sItem : items) {
+        QStringList pair = sItem.trimmed().split("=");
+        if(pair.count() != 2) {
+            bOk = false;
+            continue;
         }
-        else
-            qDebug() << sDebugMessage;
+        QString sSubsystem = pair.at(0).trimmed().toLower();
+        QString sLevel     = pair.at(1).trimmed().toLower();
+        int level = LOG_LEVEL_OFF-1;
+        for(int i=LOG_LEVEL_OFF; i<=LOG_LEVEL_TRACE; i++) {
+            if(sLevel == QString(levelNames[i+1]))
+                level = i;
+        }
+        if(level < LOG_LEVEL_OFF) {
+            bOk = false;
+            continue;
+        }
+        bool bFound = false;
+        for(int i=0; i<LOG_SUBSYSTEMS; i++) {
+            if(sSubsystem == QString("all") || sSubsystem == QString(logSubsystemNames[i])) {
+                setLogLevel(i, level);
+                bFound = true;
+            }
+        }
+        if(!bFound)
+            bOk = false;
     }
-    else
-        qDebug() << sDebugMessage;
+    return bOk;
 }
 
 
+/*!
+ * \brief logFormatId Register the format of a LOG_RECORD() call site
+ * \param sFunctionName The Function logging the record
+ * \param sFormat The message with %1, %2... placeholders
+ * \return The message id
+ */
+quint32
+logFormatId(const char* sFunctionName, const char* sFormat) {
+    return AsyncLogger::registerFormat(sFunctionName, sFormat);
+}
+
+
+/*!
+ * \brief logRecord Log a record (see LOG_RECORD())
+ * \param logFile The file where to write the log
+ * \param subsystem The subsystem logging the record
+ * \param messageId The record format
+ * \param args The record arguments
+ */
+void
+logRecord(QFile *logFile, int subsystem, quint32 messageId, const QStringList& args) {
+    AsyncLogger::instance()->enqueueRecord(logFile, subsystem, messageId, args);
+}
@@ -20,11 +20,55 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define UTILITY_H
 
 #include <QString>
+#include <QStringList>
 #include <QFile>
 
-//#define LOG_MESG
-//#define LOG_VERBOSE
-//#define LOG_VERBOSE_VERBOSE
+//#define LOG_MESG            // Write the log on a file
+//#define LOG_VERBOSE         // Compile in the LOG_DEBUG messages
+//#define LOG_VERBOSE_VERBOSE // Compile in the LOG_TRACE messages too
+
+// Log levels
+#define LOG_LEVEL_OFF   -1
+#define LOG_LEVEL_ERROR  0
+#define LOG_LEVEL_INFO   1
+#define LOG_LEVEL_DEBUG  2
+#define LOG_LEVEL_TRACE  3
+
+// The most verbose level compiled in: the calls above it generate no code
+#ifndef LOG_COMPILED_LEVEL
+    #if defined(LOG_VERBOSE_VERBOSE)
+        #define LOG_COMPILED_LEVEL LOG_LEVEL_TRACE
+    #elif defined(LOG_VERBOSE)
+        #define LOG_COMPILED_LEVEL LOG_LEVEL_DEBUG
+    #else
+        #define LOG_COMPILED_LEVEL LOG_LEVEL_INFO
+    #endif
+#endif
+
+// The message is built only if it is going to be written
+#define LOG_AT(level, subsystem, logFile, sMessage) \
+    do { \
+        if(((level) <= LOG_COMPILED_LEVEL) && isLogEnabled((subsystem), (level))) \
+            logMessage((logFile), Q_FUNC_INFO, (sMessage)); \
+    } while(0)
+#define LOG_ERROR(subsystem, logFile, sMessage) LOG_AT(LOG_LEVEL_ERROR, subsystem, logFile, sMessage)
+#define LOG_INFO(subsystem, logFile, sMessage)  LOG_AT(LOG_LEVEL_INFO,  subsystem, logFile, sMessage)
+#define LOG_DEBUG(subsystem, logFile, sMessage) LOG_AT(LOG_LEVEL_DEBUG, subsystem, logFile, sMessage)
+#define LOG_TRACE(subsystem, logFile, sMessage) LOG_AT(LOG_LEVEL_TRACE, subsystem, logFile, sMessage)
+
+// The fast path for the frequent messages: sFormat must be a string
+// literal with %1, %2... placeholders for the arguments. Neither the
+// message text nor the time string are built by the caller and, with
+// the binary log format, they are not built at all.
+#define LOG_RECORD(level, subsystem, logFile, sFormat, ...) \
+    do { \
+        if(((level) <= LOG_COMPILED_LEVEL) && isLogEnabled((subsystem), (level))) { \
+            static const quint32 messageId = logFormatId(Q_FUNC_INFO, sFormat); \
+            QStringList logArgs; \
+            collectLogArgs(logArgs, __VA_ARGS__); \
+            logRecord((logFile), (subsystem), messageId, logArgs); \
+        } \
+    } while(0)
 
 #define VOLLEY_PANEL   0
 #define FIRST_PANEL  VOLLEY_PANEL
@@ -48,7 +92,37 @@ enum commands {
 };
 
 
+enum logSubsystems {
+    LOG_DISCOVERY = 0,
+    LOG_UPDATER   = 1,
+    LOG_SLIDES    = 2,
+    LOG_SERIAL    = 3,
+    LOG_PANEL     = 4,
+    LOG_STARTUP   = 5,
+    LOG_SUBSYSTEMS
+};
+
+
 QString XML_Parse(QString input_string, QString token);
 void logMessage(QFile *logFile, QString sFunctionName, QString sMessage);
+bool isLogEnabled(int subsystem, int level);
+void setLogLevel(int subsystem, int level);
+bool setLogLevels(QString sLevels);
+quint32 logFormatId(const char* sFunctionName, const char* sFormat);
+void logRecord(QFile *logFile, int subsystem, quint32 messageId, const QStringList& args);
+
+
+// Conversion of the LOG_RECORD() arguments
+inline QString logArg(const QString& sArg) { return sArg; }
+inline QString logArg(const char* sArg) { return QString(sArg); }
+template <typename T>
+inline QString logArg(T value) { return QString::number(value); }
+
+inline void collectLogArgs(QStringList&) {}
+template <typename T, typename... Rest>
+inline void collectLogArgs(QStringList& args, const T& first, const Rest&... rest) {
+    args.append(logArg(first));
+    collectLogArgs(args, rest...);
+}
 
 #endif // UTILITY_H